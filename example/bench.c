@@ -0,0 +1,140 @@
+#include "cutest.h"
+#include <string.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// example.bench_simple
+///////////////////////////////////////////////////////////////////////////////
+
+//! [DEFINE_SIMPLE_BENCHMARK]
+TEST(example, bench_simple)
+{
+    volatile unsigned long sum = 0;
+
+    /*
+     * The statement after `TEST_BENCHMARK_LOOP` is repeated until the
+     * measurement is long enough. Code outside the loop is not measured.
+     */
+    TEST_BENCHMARK_LOOP
+    {
+        sum += 1;
+    }
+}
+//! [DEFINE_SIMPLE_BENCHMARK]
+
+///////////////////////////////////////////////////////////////////////////////
+// example.bench_complexity
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_FIXTURE_SETUP(example_bench)
+{
+}
+
+TEST_FIXTURE_TEARDOWN(example_bench)
+{
+}
+
+//! [DEFINE_COMPLEXITY_BENCHMARK]
+/*
+ * Each parameter is the input size of one benchmark instance.
+ */
+TEST_PARAMETERIZED_DEFINE(example_bench, complexity, unsigned long, 64, 128, 256, 512);
+
+TEST_P(example_bench, complexity)
+{
+    unsigned long n = TEST_GET_PARAM();
+
+    /* Tell cutest the input size, so the complexity can be estimated. */
+    cutest_benchmark_set_complexity_n(n);
+
+    /* Fail if the measured complexity grows faster than O(N^2). */
+    cutest_benchmark_expect_complexity(CUTEST_COMPLEXITY_N2);
+
+    TEST_BENCHMARK_LOOP
+    {
+        volatile unsigned long sum = 0;
+        unsigned long i, j;
+        for (i = 0; i < n; i++)
+        {
+            for (j = 0; j < n; j++)
+            {
+                sum += i ^ j;
+            }
+        }
+    }
+}
+//! [DEFINE_COMPLEXITY_BENCHMARK]
+
+///////////////////////////////////////////////////////////////////////////////
+// example.bench_parallel
+///////////////////////////////////////////////////////////////////////////////
+
+//! [DEFINE_PARALLEL_BENCHMARK]
+static void _example_bench_parallel(void* arg, unsigned idx, unsigned long iterations)
+{
+    volatile unsigned long* counters = arg;
+
+    /* Each thread do `iterations` operations. */
+    unsigned long i;
+    for (i = 0; i < iterations; i++)
+    {
+        counters[idx * 16] += i;
+    }
+}
+
+TEST(example, bench_parallel)
+{
+    /* Counters are spread out to avoid false sharing. */
+    static unsigned long s_counters[64 * 16];
+
+    /* 0 means up to the number of online processors. */
+    cutest_benchmark_parallel(_example_bench_parallel, s_counters, 0);
+}
+//! [DEFINE_PARALLEL_BENCHMARK]
+
+///////////////////////////////////////////////////////////////////////////////
+// example.bench_histogram
+///////////////////////////////////////////////////////////////////////////////
+
+//! [DEFINE_HISTOGRAM]
+TEST(example, bench_histogram)
+{
+    volatile unsigned long sum = 0;
+
+    unsigned long i, j;
+    for (i = 0; i < 1000; i++)
+    {
+        cutest_porting_timespec_t t1, t2;
+        cutest_porting_clock_gettime(&t1);
+
+        /* The operation to measure. */
+        for (j = 0; j < i; j++)
+        {
+            sum += j;
+        }
+
+        cutest_porting_clock_gettime(&t2);
+        cutest_hist_record((unsigned long)((t2.tv_sec - t1.tv_sec) * 1000000000 + (t2.tv_nsec - t1.tv_nsec)));
+    }
+}
+//! [DEFINE_HISTOGRAM]
+
+///////////////////////////////////////////////////////////////////////////////
+// example.bench_counter
+///////////////////////////////////////////////////////////////////////////////
+
+//! [DEFINE_COUNTER]
+TEST(example, bench_counter)
+{
+    static char s_src[4096], s_dst[4096];
+    unsigned long bytes = 0;
+
+    TEST_BENCHMARK_LOOP
+    {
+        memcpy(s_dst, s_src, sizeof(s_src));
+        bytes += sizeof(s_src);
+    }
+
+    /* Reported as bytes/s. */
+    cutest_counter_set("bytes", (double)bytes, CUTEST_COUNTER_RATE);
+}
+//! [DEFINE_COUNTER]
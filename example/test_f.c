@@ -17,3 +17,26 @@ TEST_F(example, test_f_1)
 {
 	ASSERT_EQ_INT(0, 0);
 }
+
+//! [DEFINE_THREAD_SAFE_FIXTURE]
+TEST_FIXTURE_THREAD_SAFE(example_pipeline);
+
+TEST_FIXTURE_SETUP(example_pipeline)
+{
+	/* May run on a helper thread while the previous test is running. */
+	FILE* file = tmpfile();
+	ASSERT_NE_PTR(file, NULL);
+	cutest_fixture_set_data(file);
+}
+
+TEST_FIXTURE_TEARDOWN(example_pipeline)
+{
+	fclose((FILE*)cutest_fixture_get_data());
+}
+
+TEST_F(example_pipeline, write)
+{
+	FILE* file = cutest_fixture_get_data();
+	ASSERT_GE_INT(fputs("hello", file), 0);
+}
+//! [DEFINE_THREAD_SAFE_FIXTURE]
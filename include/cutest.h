@@ -184,6 +184,10 @@ extern "C" {
  * @example test_p.c
  * A example for parameterized test #TEST_P().
  */
+/**
+ * @example bench.c
+ * A example for benchmark by #TEST_BENCHMARK_LOOP.
+ */
 
 /**
  * @defgroup TEST_DEFINE Define Test
@@ -246,6 +250,38 @@ extern "C" {
 #define TEST_FIXTURE_TEARDOWN(fixture)    \
     static void s_cutest_fixture_teardown_##fixture(void)
 
+/**
+ * @brief Mark the setup and teardown of test fixture as thread safe.
+ *
+ * The setup of a test in this fixture may run on a helper thread while the
+ * previous test is running, and its teardown may run on a helper thread while
+ * the next test is running. This hides the cost of fixtures that spend most
+ * of their time on I/O, such as creating and deleting database files.
+ *
+ * A thread safe fixture must not share state between tests through global
+ * variables. Keep per-test state by #cutest_fixture_set_data() instead.
+ *
+ * Hooks are called from the main thread in the usual order, so they do not
+ * bracket a fixture stage running on helper thread:
+ * + `before_setup` and `after_setup` are called when the test starts, after a
+ *   setup prepared on helper thread has already finished.
+ * + `after_teardown` is called when the teardown is collected, which may be
+ *   after the next test has run.
+ *
+ * The result of a test is held until its teardown is collected, along with the
+ * output of tests after it, so every test is reported once and in order.
+ *
+ * @note Do not use it for fixtures whose tests run benchmarks, the helper
+ *   threads compete for CPU with them.
+ * @snippet test_f.c DEFINE_THREAD_SAFE_FIXTURE
+ * @param [in] fixture  The name of fixture
+ */
+#define TEST_FIXTURE_THREAD_SAFE(fixture)  \
+    TEST_INITIALIZER(cutest_usertest_thread_safe_##fixture) {\
+        cutest_fixture_set_thread_safe(#fixture);\
+    }\
+    typedef int u_cutest_thread_safe_##fixture
+
 /**
  * @brief Get parameterized data
  * @snippet test_p.c GET_PARAMETERIZED_DATA
@@ -723,6 +759,7 @@ typedef struct cutest_case
     {
         const char*                     fixture_name;   /**< suit name. */
         const char*                     case_name;      /**< case name. */
+        const char*                     module_name;    /**< Name of shared library it is loaded from, NULL if built in. */
     } info;
 
     struct
@@ -736,6 +773,9 @@ typedef struct cutest_case
     {
         unsigned long                   mask;           /**< Internal mask. */
         unsigned long                   randkey;        /**< Random key. */
+        void*                           fixture_data;   /**< See #cutest_fixture_set_data(). */
+        char*                           tmpdir;         /**< See #cutest_tmpdir(). NULL if not created. */
+        unsigned long                   sampled_out;    /**< Non-zero if left out by `--test_param_sample`. */
     } data;
 
     struct
@@ -745,6 +785,27 @@ typedef struct cutest_case
         void*                           param_data;     /**< Data passed to #cutest_case_t::stage::body */
         unsigned long                   param_idx;      /**< Index passed to #cutest_case_t::stage::body */
     } parameterized;
+
+    struct
+    {
+        unsigned long                   iterations;     /**< Iterations of last measurement. 0 if not a benchmark. */
+        double                          ns_per_op;      /**< Average cost of one iteration in nanoseconds. */
+        double                          spread;         /**< (max - min) / average of samples in percent. Negative if unknown. */
+        unsigned long                   cold_iterations;/**< Iterations of cold cache measurement. 0 if not measured. */
+        double                          cold_ns_per_op; /**< Average cost of one iteration with cold cache. */
+        unsigned long                   complexity_n;   /**< Input size. See #cutest_benchmark_set_complexity_n(). */
+        int                             complexity;     /**< Expected complexity. See #cutest_complexity_t. */
+    } benchmark;
+
+    struct
+    {
+        unsigned long                   count;          /**< The number of values recorded by #cutest_hist_record(). */
+        unsigned long                   p50;            /**< 50th percentile. */
+        unsigned long                   p90;            /**< 90th percentile. */
+        unsigned long                   p99;            /**< 99th percentile. */
+        unsigned long                   p999;           /**< 99.9th percentile. */
+        unsigned long                   max;            /**< Maximum value. */
+    } histogram;
 } cutest_case_t;
 
 /**
@@ -1333,6 +1394,52 @@ CUTEST_API void cutest_unregister_case(
  * @}
  */
 
+/**
+ * @defgroup TEST_ASSERTION_PERFORMANCE Performance Assertion
+ *
+ * Guard gross performance regressions in ordinary tests. The statement is
+ * repeated until one round lasts at least 1 millisecond, and the fastest of 5
+ * rounds is compared with the bound. Use `_L` to refer to the measured time
+ * and `_R` to refer to the bound, both in nanoseconds.
+ *
+ * ```c
+ * ASSERT_FASTER_THAN(lookup(table, key), 100);
+ * ASSERT_FASTER_THAN_REF(lookup(table, key), linear_search(table, key), 0.1);
+ * ASSERT_THROUGHPUT_AT_LEAST(lookup(table, key), 1000000, "%f ns", _L);
+ * ```
+ *
+ * The bounds are relaxed by 10 times under AddressSanitizer and
+ * ThreadSanitizer, and 100 times under Valgrind.
+ *
+ * @{
+ */
+
+/**
+ * @brief \p stmt takes at most \p ns nanoseconds.
+ */
+#define ASSERT_FASTER_THAN(stmt, ns, ...)   \
+    ASSERT_TEMPLATE_PERF(stmt, (void)0, (double)(ns), __VA_ARGS__)
+
+/**
+ * @brief \p stmt takes at most \p ratio times of \p ref.
+ *
+ * Both statements are timed the same way in the same run, so machine speed is
+ * cancelled out.
+ */
+#define ASSERT_FASTER_THAN_REF(stmt, ref, ratio, ...)   \
+    ASSERT_TEMPLATE_PERF(stmt, TEST_INTERNAL_PERF_MEASURE(ref),\
+        cutest_internal_perf_result() * (ratio), __VA_ARGS__)
+
+/**
+ * @brief \p stmt can be executed at least \p ops times per second.
+ */
+#define ASSERT_THROUGHPUT_AT_LEAST(stmt, ops, ...)  \
+    ASSERT_TEMPLATE_PERF(stmt, (void)0, 1000000000.0 / (double)(ops), __VA_ARGS__)
+
+/**
+ * @}
+ */
+
 /**
  * Group: TEST_ASSERTION
  * @}
@@ -1449,12 +1556,44 @@ CUTEST_API void cutest_unregister_case(
  */
 #define ASSERT_TEMPLATE(TYPE, OP, a, b, fmt, ...) \
     do {\
-        TYPE _L = (a); TYPE _R = (b);\
-        if (cutest_internal_compare(#TYPE, (const void*)&_L, (const void*)&_R) OP 0) {\
+        if (cutest_internal_flight_enabled) {\
+            static const cutest_internal_location_t _loc = { __FILE__, __LINE__ };\
+            cutest_internal_flight_assert(&_loc);\
+        }\
+        {\
+            TYPE _L = (a); TYPE _R = (b);\
+            if (cutest_internal_compare(#TYPE, (const void*)&_L, (const void*)&_R) OP 0) {\
+                break;\
+            }\
+            cutest_internal_dump(__FILE__, __LINE__, \
+                #TYPE, #OP, #a, #b, (const void*)&_L, (const void*)&_R);\
+            TEST_INTERNAL_SELECT(TEST_INTERNAL_NONE, cutest_internal_printf, fmt)(fmt, ##__VA_ARGS__);\
+            if (cutest_internal_break_on_failure()) {\
+                TEST_DEBUGBREAK;\
+            }\
+            cutest_internal_assert_failure();\
+        }\
+    } TEST_MSVC_WARNNING_GUARD(while (0), 4127)
+
+/**
+ * @brief Performance assertion template.
+ * @warning It is for internal usage.
+ * @param[in] stmt  The statement to measure.
+ * @param[in] pre   Statement to run before evaluate \p bound.
+ * @param[in] bound Expression of bound in nanoseconds.
+ * @param[in] fmt   Extra print format when assert failure.
+ * @param[in] ...   Print arguments.
+ */
+#define ASSERT_TEMPLATE_PERF(stmt, pre, bound, fmt, ...) \
+    do {\
+        double _L, _R;\
+        pre;\
+        _R = (bound);\
+        TEST_INTERNAL_PERF_MEASURE(stmt);\
+        _L = cutest_internal_perf_result();\
+        if (cutest_internal_perf_check(__FILE__, __LINE__, #stmt, _L, _R, TEST_INTERNAL_SANITIZER)) {\
             break;\
         }\
-        cutest_internal_dump(__FILE__, __LINE__, \
-            #TYPE, #OP, #a, #b, (const void*)&_L, (const void*)&_R);\
         TEST_INTERNAL_SELECT(TEST_INTERNAL_NONE, cutest_internal_printf, fmt)(fmt, ##__VA_ARGS__);\
         if (cutest_internal_break_on_failure()) {\
             TEST_DEBUGBREAK;\
@@ -1464,6 +1603,24 @@ CUTEST_API void cutest_unregister_case(
 
 /** @cond */
 
+#define TEST_INTERNAL_PERF_MEASURE(stmt)    \
+    while (cutest_internal_perf_loop()) { stmt; }
+
+/**
+ * @def TEST_INTERNAL_SANITIZER
+ * @brief Whether the test is built with a sanitizer that slows code down.
+ */
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#   define TEST_INTERNAL_SANITIZER  1
+#elif defined(__has_feature)
+#   if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#       define TEST_INTERNAL_SANITIZER  1
+#   endif
+#endif
+#if !defined(TEST_INTERNAL_SANITIZER)
+#   define TEST_INTERNAL_SANITIZER  0
+#endif
+
 #define TEST_INTERNAL_SELECT(a, b, ...)  \
     TEST_JOIN(TEST_INTERNAL_SELECT_, TEST_BARG(__VA_ARGS__))(a, b)
 
@@ -1592,6 +1749,31 @@ CUTEST_API void cutest_internal_printf(
     ...
 );
 
+/**
+ * @brief Drive the measurement of performance assertion.
+ * @return              Non-zero if the statement should run one more time.
+ */
+CUTEST_API int cutest_internal_perf_loop(void);
+
+/**
+ * @brief Get the result of last performance measurement.
+ * @return              The fastest time of one execution in nanoseconds.
+ */
+CUTEST_API double cutest_internal_perf_result(void);
+
+/**
+ * @brief Check the result of performance assertion, print message on failure.
+ * @param[in] file      The file name.
+ * @param[in] line      The line number.
+ * @param[in] stmt      The measured statement.
+ * @param[in] ns        The measured time in nanoseconds.
+ * @param[in] bound_ns  The bound in nanoseconds.
+ * @param[in] sanitizer Whether the caller is built with sanitizer.
+ * @return              Non-zero if passed.
+ */
+CUTEST_API int cutest_internal_perf_check(const char* file, int line, const char* stmt,
+    double ns, double bound_ns, int sanitizer);
+
 /**
  * @brief Check if `--test_break_on_failure` is set.
  * @return              Boolean.
@@ -1605,6 +1787,30 @@ CUTEST_API int cutest_internal_break_on_failure(void);
  */
 CUTEST_API void cutest_internal_assert_failure(void);
 
+/**
+ * @brief Location of an assertion.
+ * @warning It is for internal usage.
+ */
+typedef struct cutest_internal_location
+{
+    const char*                         file;           /**< File name. */
+    int                                 line;           /**< Line number. */
+} cutest_internal_location_t;
+
+/**
+ * @brief Non-zero if flight recorder is enabled, so assertions only call
+ *   cutest_internal_flight_assert() when needed.
+ * @warning It is for internal usage.
+ */
+CUTEST_API extern volatile int cutest_internal_flight_enabled;
+
+/**
+ * @brief Record location of assertion in flight recorder.
+ * @warning It is for internal usage.
+ * @param[in] loc   Location of assertion, file and line are published together.
+ */
+CUTEST_API void cutest_internal_flight_assert(const cutest_internal_location_t* loc);
+
 /** @endcond */
 
 /**
@@ -1636,6 +1842,8 @@ typedef struct cutest_hook
 
     /**
      * @brief Hook before #TEST_FIXTURE_SETUP() is called
+     * @note For #TEST_FIXTURE_THREAD_SAFE() fixtures, the setup may already
+     *   have run on helper thread.
      * @param[in] fixture   Fixture name
      */
     void(*before_setup)(const char* fixture);
@@ -1704,6 +1912,35 @@ CUTEST_API const char* cutest_get_current_fixture(void);
  */
 CUTEST_API const char* cutest_get_current_test(void);
 
+/**
+ * @brief Get random seed of current run.
+ * @note Seed random data of tests with it, so `--test_random_seed` can
+ *   reproduce a failure found by `--test_repeat_until_fail`.
+ * @return              The seed, between 0 and 99999.
+ */
+CUTEST_API unsigned long cutest_random_seed(void);
+
+/**
+ * @brief Mark fixture as thread safe.
+ * @warning Use #TEST_FIXTURE_THREAD_SAFE().
+ * @param[in] fixture_name  The name of fixture.
+ */
+CUTEST_API void cutest_fixture_set_thread_safe(const char* fixture_name);
+
+/**
+ * @brief Attach \p data to current test, so setup, test body and teardown
+ *   can share it without global variables.
+ * @note It is reset to NULL before setup.
+ * @param[in] data      User defined data.
+ */
+CUTEST_API void cutest_fixture_set_data(void* data);
+
+/**
+ * @brief Get data attached by #cutest_fixture_set_data().
+ * @return              User defined data.
+ */
+CUTEST_API void* cutest_fixture_get_data(void);
+
 /**
  * @brief Skip current test case.
  * @note This function only has affect in setup stage.
@@ -1716,6 +1953,630 @@ CUTEST_API void cutest_skip_test(void);
  * @}
  */
 
+/**
+ * @defgroup TEST_TMPDIR Temporary Files
+ *
+ * Scratch space for tests that need files, without ad-hoc names under `/tmp`
+ * that collide between parallel runs and are left behind on failure.
+ *
+ * @{
+ */
+
+/**
+ * @brief Get scratch directory of current test case.
+ *
+ * The directory is created on first call, unique to the case, and removed
+ * with everything in it after teardown, even if the case failed. It is placed
+ * under `$TEST_TMPDIR` if set, otherwise in `/dev/shm` if writable, so it is
+ * not slowed down by overlay file systems of containers.
+ *
+ * @note Can be called in setup, test body and teardown.
+ * @return              Path of the directory.
+ */
+CUTEST_API const char* cutest_tmpdir(void);
+
+/**
+ * @brief Create an anonymous file for tests that only need a file descriptor.
+ *
+ * It is backed by `memfd_create()` on Linux and by `tmpfile()` elsewhere, so
+ * nothing is left on disk. Use `fileno()` to get the descriptor, and close it
+ * with `fclose()`.
+ *
+ * @param[in] name      Name for debugging, shown in `/proc/self/fd`. Can be NULL.
+ * @return              File opened for reading and writing.
+ */
+CUTEST_API FILE* cutest_memfile(const char* name);
+
+/**
+ * Group: TEST_TMPDIR
+ * @}
+ */
+
+/**
+ * @defgroup TEST_RESOURCE Test Data
+ *
+ * Large read only test data shared by many tests. Each file is mapped once
+ * per process and the same view is returned to every test, instead of every
+ * test reading and parsing its own copy.
+ *
+ * Files are looked up in the directory given by `--test_resource_dir`. Map
+ * them early with `--test_resource_preload` to share the mapping with child
+ * processes, and use `--test_resource_prefetch` to read them into page cache
+ * at once. The size of each mapped file and the number of tests used it are
+ * listed in the report.
+ *
+ * @{
+ */
+
+/**
+ * @brief A mapped file.
+ */
+typedef struct cutest_resource
+{
+    const char*                         name;           /**< Name given to #cutest_resource_map(). */
+    const void*                         data;           /**< Content of file. Do not write. */
+    size_t                              size;           /**< Size of file in bytes. */
+} cutest_resource_t;
+
+/**
+ * @brief Map test data file \p name read only.
+ * @note The mapping is valid until #cutest_run_tests() returns.
+ * @param[in] name      File name, relative to `--test_resource_dir`.
+ * @return              The mapped file, or NULL if failed.
+ */
+CUTEST_API const cutest_resource_t* cutest_resource_map(const char* name);
+
+/**
+ * Group: TEST_RESOURCE
+ * @}
+ */
+
+/**
+ * @defgroup TEST_EMBED Embedded Files
+ *
+ * Files embedded into test programs by the CMake function `cutest_embed_file()`:
+ *
+ * ```cmake
+ * cutest_embed_file(TARGET foo_test NAME vectors INPUT data/vectors.bin COMPRESS)
+ * ```
+ *
+ * ```c
+ * TEST_EMBED_DECLARE(vectors);
+ *
+ * TEST(foo, vectors) {
+ *     size_t size;
+ *     const void* data = cutest_embed_data(&vectors, &size);
+ * }
+ * ```
+ *
+ * The generator `cutest_embed` uses `.incbin` with GCC and Clang, C23
+ * `#embed` if supported, and an array initializer otherwise. With `COMPRESS`
+ * the file is stored LZ4 compressed and decompressed on first access.
+ *
+ * @{
+ */
+
+/**
+ * @brief An embedded file.
+ * @warning Defined by generated code, do not touch.
+ */
+typedef struct cutest_embed
+{
+    const unsigned char*                data;           /**< Stored bytes, followed by NUL. */
+    size_t                              size;           /**< Size of stored bytes. */
+    size_t                              raw_size;       /**< Size of file. */
+    int                                 compressed;     /**< Whether stored bytes are LZ4 block. */
+    void*                               cache;          /**< Decompressed file. */
+    volatile long                       state;          /**< Decompression state. */
+    struct cutest_embed*                next;           /**< Next decompressed file, to free them. */
+} cutest_embed_t;
+
+/**
+ * @brief Declare embedded file \p name.
+ */
+#if defined(__cplusplus)
+#   define TEST_EMBED_DECLARE(name)     extern "C" cutest_embed_t name
+#else
+#   define TEST_EMBED_DECLARE(name)     extern cutest_embed_t name
+#endif
+
+/**
+ * @brief Get content of embedded file, decompressed if needed.
+ * @note The content is always followed by NUL, so text files can be used as
+ *   C string.
+ * @note Decompressed content is freed when cutest_run_tests() returns, or
+ *   when a module of `--test_watch` is reloaded.
+ * @param[in] embed     Embedded file.
+ * @param[out] size     Size of file. Can be NULL.
+ * @return              Content of file.
+ */
+CUTEST_API const void* cutest_embed_data(cutest_embed_t* embed, size_t* size);
+
+/**
+ * Group: TEST_EMBED
+ * @}
+ */
+
+/**
+ * @defgroup TEST_GUARD_MALLOC Guard Malloc
+ *
+ * A cheap overrun and use-after-free detector in the style of electric-fence,
+ * for suites that can not afford AddressSanitizer on every run.
+ *
+ * With `--test_guard_malloc=N`, one of every N allocations made through
+ * #cutest_guard_malloc() in a test is placed at the end of a page, and
+ * inaccessible pages are put around it. Freed memory is made inaccessible and
+ * not reused until all other slots are used. A read or write out of bounds,
+ * or after free, faults immediately, and the fault is reported as failure of
+ * the running test:
+ *
+ * ```
+ * foo.bar:guard malloc failure:
+ *             heap-buffer-overflow: address 0x7f0000001000 is 0 bytes after 16-byte region 0x7f0000000ff0
+ * ```
+ *
+ * Only allocations not larger than one page are guarded, and overflow within
+ * the 16 bytes alignment padding is not detected. Other allocations go to the
+ * C library.
+ *
+ * To route the code under test to the guard allocator, define
+ * `CUTEST_GUARD_MALLOC_OVERRIDE` before including `cutest.h`, then `malloc()`,
+ * `calloc()`, `realloc()` and `free()` in that file are replaced.
+ *
+ * @note Only available on Linux now. On other platforms they are the same as
+ *   the C library functions.
+ *
+ * @{
+ */
+
+/**
+ * @brief Same as `malloc()`, but may be guarded.
+ * @param[in] size      Size in bytes.
+ * @return              Allocated memory.
+ */
+CUTEST_API void* cutest_guard_malloc(size_t size);
+
+/**
+ * @brief Same as `calloc()`, but may be guarded.
+ * @param[in] nmemb     The number of elements.
+ * @param[in] size      Size of each element.
+ * @return              Allocated memory.
+ */
+CUTEST_API void* cutest_guard_calloc(size_t nmemb, size_t size);
+
+/**
+ * @brief Same as `realloc()`, but may be guarded.
+ * @param[in] ptr       Memory to resize.
+ * @param[in] size      New size in bytes.
+ * @return              Allocated memory.
+ */
+CUTEST_API void* cutest_guard_realloc(void* ptr, size_t size);
+
+/**
+ * @brief Free memory allocated by #cutest_guard_malloc(),
+ *   #cutest_guard_calloc() or #cutest_guard_realloc().
+ * @param[in] ptr       Memory to free.
+ */
+CUTEST_API void cutest_guard_free(void* ptr);
+
+/**
+ * Group: TEST_GUARD_MALLOC
+ * @}
+ */
+
+/**
+ * @defgroup TEST_MONITOR Monitor
+ *
+ * With `--test_monitor=PATH`, the runner maps PATH into memory and keeps a
+ * status board there: what each worker is running and since when, the result
+ * counters, the latest failures and the slowest cases so far. Anything can
+ * attach read-only and watch a long run without tailing logs, like
+ * `cutest_top`:
+ *
+ * ```
+ * cutest_top /dev/shm/my_test.board
+ * ```
+ *
+ * The runner never blocks on readers. Every part of the board is guarded by a
+ * sequence number that is odd while the part is being written, so a reader
+ * copies the part, and retries if the sequence number is odd or changed.
+ *
+ * All times are from #cutest_porting_clock_gettime(), which is
+ * `CLOCK_MONOTONIC` on Linux.
+ *
+ * @note Only available on Linux now.
+ *
+ * @{
+ */
+
+/**
+ * @brief Magic number at the beginning of a status board.
+ */
+#define CUTEST_MONITOR_MAGIC        0x4354534dUL
+
+/**
+ * @brief Layout version of status board.
+ */
+#define CUTEST_MONITOR_VERSION      1
+
+/**
+ * @brief The maximum number of workers on a status board.
+ */
+#define CUTEST_MONITOR_WORKERS      16
+
+/**
+ * @brief The number of latest failures and slowest cases kept.
+ */
+#define CUTEST_MONITOR_RECORDS      8
+
+/**
+ * @brief Case name longer than this is truncated.
+ */
+#define CUTEST_MONITOR_NAME_SIZE    128
+
+/**
+ * @brief A finished case on status board.
+ */
+typedef struct cutest_monitor_record
+{
+    char                    name[CUTEST_MONITOR_NAME_SIZE]; /**< Case name. */
+    unsigned long           elapsed_ms;                     /**< Time cost in milliseconds. */
+} cutest_monitor_record_t;
+
+/**
+ * @brief What a worker is doing.
+ */
+typedef struct cutest_monitor_worker
+{
+    volatile unsigned long  seq;                            /**< Sequence number, odd while writing. */
+    unsigned long           pid;                            /**< Process ID, 0 if unused. */
+    unsigned long           tv_sec;                         /**< Start time of current case. */
+    unsigned long           tv_nsec;                        /**< Start time of current case. */
+    char                    name[CUTEST_MONITOR_NAME_SIZE]; /**< Current case, empty if idle. */
+} cutest_monitor_worker_t;
+
+/**
+ * @brief Status board shared with monitors.
+ */
+typedef struct cutest_monitor_board
+{
+    unsigned long           magic;                          /**< #CUTEST_MONITOR_MAGIC */
+    unsigned long           version;                        /**< #CUTEST_MONITOR_VERSION */
+    unsigned long           pid;                            /**< Process ID of runner. */
+
+    volatile unsigned long  seq;                            /**< Sequence number of fields below, odd while writing. */
+    unsigned long           finished;                       /**< Whether the run is finished. */
+    unsigned long           total;                          /**< The number of running cases. */
+    unsigned long           disabled;                       /**< The number of disabled cases. */
+    unsigned long           success;                        /**< The number of success cases. */
+    unsigned long           skipped;                        /**< The number of skipped cases. */
+    unsigned long           failed;                         /**< The number of failed cases. */
+    unsigned long           repeat;                         /**< How many times to repeat. */
+    unsigned long           repeated;                       /**< How many times already repeated. */
+    unsigned long           failure_cnt;                    /**< Latest failure is `failures[(failure_cnt - 1) % CUTEST_MONITOR_RECORDS]`. */
+    cutest_monitor_record_t failures[CUTEST_MONITOR_RECORDS];
+    cutest_monitor_record_t slowest[CUTEST_MONITOR_RECORDS];/**< Slowest first. */
+
+    cutest_monitor_worker_t workers[CUTEST_MONITOR_WORKERS];
+} cutest_monitor_board_t;
+
+/**
+ * Group: TEST_MONITOR
+ * @}
+ */
+
+/**
+ * @defgroup TEST_FLIGHT Flight Recorder
+ *
+ * With `--test_flight_recorder=PATH`, the runner maps PATH into memory and
+ * keeps a ring of recent events there: run and case begin and end, stage
+ * transitions and failures, plus the location of the last assertion. The
+ * file survives the runner, so after it dies of stack overflow, OOM killer or
+ * corrupted heap, it still tells what was running:
+ *
+ * ```
+ * cutest_top --flight=/tmp/my_test.flight
+ * ```
+ *
+ * With `--test_benchmark_isolate`, the parent process prints the last events
+ * of a child process that terminated abnormally.
+ *
+ * Recording an event is a few stores and one fence, so it is cheap enough to
+ * leave on. Each event is valid only if its `seq` is its position in the ring
+ * plus one, which is written last.
+ *
+ * The location of the last assertion is a seqlock. The writer takes its `seq`
+ * from even to odd with compare-and-swap, so assertions on other threads wait
+ * for it, then fences, copies the file name if it differs from the last one,
+ * stores the line, fences again and makes `seq` even. Readers retry until they
+ * see the same even `seq` before and after copying it.
+ *
+ * @note Only available on Linux now.
+ *
+ * @{
+ */
+
+/**
+ * @brief Magic number at the beginning of a flight recorder.
+ */
+#define CUTEST_FLIGHT_MAGIC         0x43544652UL
+
+/**
+ * @brief Layout version of flight recorder.
+ */
+#define CUTEST_FLIGHT_VERSION       2
+
+/**
+ * @brief The number of events in the ring, power of 2.
+ */
+#define CUTEST_FLIGHT_EVENTS        256
+
+/**
+ * @brief Name longer than this is truncated.
+ */
+#define CUTEST_FLIGHT_NAME_SIZE     96
+
+/**
+ * @brief Event type.
+ */
+typedef enum cutest_flight_type
+{
+    CUTEST_FLIGHT_RUN_BEGIN = 1,    /**< `name` is program, `data` is process ID. */
+    CUTEST_FLIGHT_RUN_END,          /**< `data` is the number of failed cases. */
+    CUTEST_FLIGHT_CASE_BEGIN,       /**< `name` is case. */
+    CUTEST_FLIGHT_CASE_END,         /**< `name` is case, `data` is 0 if success, 1 if failed, 2 if skipped. */
+    CUTEST_FLIGHT_SETUP,            /**< Setup stage begin. */
+    CUTEST_FLIGHT_BODY,             /**< Test body begin. */
+    CUTEST_FLIGHT_TEARDOWN,         /**< Teardown stage begin. */
+    CUTEST_FLIGHT_FAILURE,          /**< `name` is file, `data` is line of failed assertion. */
+} cutest_flight_type_t;
+
+/**
+ * @brief An event.
+ */
+typedef struct cutest_flight_event
+{
+    volatile unsigned long  seq;                            /**< Position in ring plus one, 0 while writing. */
+    unsigned long           type;                           /**< #cutest_flight_type_t */
+    unsigned long           data;                           /**< Depends on type. */
+    unsigned long           tv_sec;                         /**< Time of event. */
+    unsigned long           tv_nsec;                        /**< Time of event. */
+    char                    name[CUTEST_FLIGHT_NAME_SIZE];  /**< Depends on type, may be empty. */
+} cutest_flight_event_t;
+
+/**
+ * @brief Location of the last assertion.
+ */
+typedef struct cutest_flight_assert
+{
+    volatile long           seq;                            /**< Seqlock, odd while being written. */
+    unsigned long           line;                           /**< Line of last assertion. */
+    char                    file[CUTEST_FLIGHT_NAME_SIZE];  /**< File of last assertion. */
+} cutest_flight_assert_t;
+
+/**
+ * @brief Flight recorder file.
+ */
+typedef struct cutest_flight_recorder
+{
+    unsigned long           magic;                          /**< #CUTEST_FLIGHT_MAGIC */
+    unsigned long           version;                        /**< #CUTEST_FLIGHT_VERSION */
+    unsigned long           pid;                            /**< Process ID of runner. */
+    volatile long           head;                           /**< The number of events recorded. */
+
+    cutest_flight_assert_t  last_assert;                    /**< Last assertion. */
+
+    cutest_flight_event_t   events[CUTEST_FLIGHT_EVENTS];   /**< Latest is `events[(head - 1) % CUTEST_FLIGHT_EVENTS]`. */
+} cutest_flight_recorder_t;
+
+/**
+ * Group: TEST_FLIGHT
+ * @}
+ */
+
+/**
+ * @defgroup TEST_BENCHMARK Benchmark
+ *
+ * Any test can measure its hot path by #TEST_BENCHMARK_LOOP. The loop body is
+ * repeated until the measurement lasts at least `--test_benchmark_min_time`
+ * milliseconds, and the average cost of one iteration is printed when the
+ * test finishes.
+ *
+ * @snippet bench.c DEFINE_SIMPLE_BENCHMARK
+ *
+ * ## Asymptotic complexity
+ *
+ * A parameterized benchmark may tell cutest the input size of each instance by
+ * #cutest_benchmark_set_complexity_n(). After all instances are finished, the
+ * measured times are fitted against O(1), O(logN), O(N), O(NlogN), O(N^2) and
+ * O(N^3) by least squares of relative error, and the best fitting class is
+ * reported with its RMS error. A faster growing class must fit clearly better,
+ * with less than 2/3 of the error, to be taken over a slower growing one.
+ *
+ * @snippet bench.c DEFINE_COMPLEXITY_BENCHMARK
+ *
+ * If the best fitting class grows faster than the expected one, the last
+ * instance of the parameterized test is marked as failure.
+ *
+ * ## Multi-threaded benchmark
+ *
+ * #cutest_benchmark_parallel() runs a function on 1, 2, 4, ... threads up to
+ * the given limit. All threads are pinned to different cores and start
+ * together, and the result is printed as a scaling table of aggregate
+ * throughput, per-thread latency and parallel efficiency.
+ *
+ * @snippet bench.c DEFINE_PARALLEL_BENCHMARK
+ *
+ * ## Latency histogram
+ *
+ * Averages hide the tail. #cutest_hist_record() records values, such as the
+ * latency of each request, into a log-linear histogram of current test. The
+ * p50, p90, p99, p99.9 and maximum value are printed when the test finishes.
+ *
+ * @snippet bench.c DEFINE_HISTOGRAM
+ *
+ * ## Counters
+ *
+ * #cutest_counter_set() attaches a named value to current test, such as bytes
+ * or items processed. With #CUTEST_COUNTER_RATE the value is divided by the
+ * measured time, so it is reported as bytes/s or items/s.
+ *
+ * @snippet bench.c DEFINE_COUNTER
+ *
+ * ## Cold cache
+ *
+ * The loop of #TEST_BENCHMARK_LOOP keeps its data in cache, so it measures the
+ * warm case. With `--test_benchmark_cold_cache` the loop body is then run again
+ * one iteration at a time, and CPU caches are evicted before each iteration by
+ * writing through a buffer larger than the last level cache. The eviction is
+ * not timed. `--test_benchmark_cold_tlb` also walks a large address space at
+ * page stride to evict TLB entries. Both warm and cold results are printed.
+ *
+ * The builtin buffer is 64 MiB. If the last level cache is larger, provide a
+ * bigger one by #cutest_benchmark_set_evict_buffer().
+ *
+ * ## Autotune
+ *
+ * A parameterized benchmark can describe a configuration space, such as block
+ * sizes, with one configuration per parameter. With `--test_autotune` the
+ * instances that finished the normal run are measured again round by round,
+ * the slower half is dropped after each round and the survivors get twice as
+ * many samples in the next round. The last survivor is printed with the 95%
+ * confidence interval of its mean time. `--test_autotune_output=PATH` also
+ * writes it as `fixture.case.index`, `fixture.case.value`,
+ * `fixture.case.ns_per_op` and `fixture.case.ci95` lines.
+ *
+ * @{
+ */
+
+/**
+ * @brief Asymptotic complexity classes.
+ */
+typedef enum cutest_complexity
+{
+    CUTEST_COMPLEXITY_AUTO,     /**< No expectation, only report. */
+    CUTEST_COMPLEXITY_1,        /**< O(1) */
+    CUTEST_COMPLEXITY_LOGN,     /**< O(logN) */
+    CUTEST_COMPLEXITY_N,        /**< O(N) */
+    CUTEST_COMPLEXITY_NLOGN,    /**< O(NlogN) */
+    CUTEST_COMPLEXITY_N2,       /**< O(N^2) */
+    CUTEST_COMPLEXITY_N3,       /**< O(N^3) */
+} cutest_complexity_t;
+
+/**
+ * @brief Repeat the following statement until the measurement is stable.
+ * @snippet bench.c DEFINE_SIMPLE_BENCHMARK
+ */
+#define TEST_BENCHMARK_LOOP \
+    while (cutest_benchmark_loop())
+
+/**
+ * @brief Drive the benchmark loop.
+ * @warning Use #TEST_BENCHMARK_LOOP.
+ * @return  Non-zero if the loop body should run one more time.
+ */
+CUTEST_API int cutest_benchmark_loop(void);
+
+/**
+ * @brief Set the input size of current benchmark.
+ * @note This function is available in test body.
+ * @param[in] n - Input size.
+ */
+CUTEST_API void cutest_benchmark_set_complexity_n(unsigned long n);
+
+/**
+ * @brief Set the expected complexity of current parameterized benchmark.
+ * @note This function is available in test body.
+ * @param[in] complexity - Expected complexity.
+ */
+CUTEST_API void cutest_benchmark_expect_complexity(cutest_complexity_t complexity);
+
+/**
+ * @brief Use \p buf instead of the builtin buffer to evict CPU caches.
+ *
+ * The buffer should be at least twice the size of last level cache. Its
+ * content is overwritten.
+ *
+ * @param[in] buf - The buffer. Use NULL to restore the builtin one.
+ * @param[in] size - The size of \p buf in bytes.
+ */
+CUTEST_API void cutest_benchmark_set_evict_buffer(void* buf, unsigned long size);
+
+/**
+ * @brief Flags of #cutest_counter_set(). They can be combined by `|`.
+ */
+typedef enum cutest_counter_flag
+{
+    /**
+     * @brief Report the value as is.
+     */
+    CUTEST_COUNTER_DEFAULT          = 0x00,
+
+    /**
+     * @brief Divide by elapsed seconds.
+     * For benchmark it is the time of all #TEST_BENCHMARK_LOOP batches or
+     * #cutest_benchmark_parallel() rounds. Otherwise it is the time of the
+     * whole test.
+     */
+    CUTEST_COUNTER_RATE             = 0x01,
+
+    /**
+     * @brief Divide by the number of benchmark iterations.
+     */
+    CUTEST_COUNTER_AVG_ITERATIONS   = 0x02,
+
+    /**
+     * @brief Divide by the number of threads of last benchmark measurement.
+     */
+    CUTEST_COUNTER_PER_THREAD       = 0x04,
+} cutest_counter_flag_t;
+
+/**
+ * @brief Set a counter of current test. Set a counter again overwrites it.
+ * @note This function is available in test body.
+ * @param[in] name - Counter name. At most 31 characters are kept.
+ * @param[in] value - Counter value.
+ * @param[in] flags - Bit-OR of #cutest_counter_flag_t.
+ */
+CUTEST_API void cutest_counter_set(const char* name, double value, int flags);
+
+/**
+ * @brief Record \p value into the histogram of current test.
+ *
+ * The histogram has bounded memory and relative error less than 1/32.
+ * Recording is lock free and can be called from any thread, values from all
+ * threads are merged when the test finishes.
+ *
+ * @note This function is available in test body.
+ * @param[in] value - The value to record, e.g. latency in nanoseconds.
+ */
+CUTEST_API void cutest_hist_record(unsigned long value);
+
+/**
+ * @brief Multi-threaded benchmark body.
+ * @param[in] arg - User defined argument.
+ * @param[in] idx - Thread index, start from 0.
+ * @param[in] iterations - How many operations this thread should do.
+ */
+typedef void (*cutest_benchmark_parallel_fn)(void* arg, unsigned idx, unsigned long iterations);
+
+/**
+ * @brief Run \p fn on 1, 2, 4, ... threads and print the scaling table.
+ * @note This function is available in test body.
+ * @note If thread support is disabled, only one thread is used.
+ * @param[in] fn - Benchmark body.
+ * @param[in] arg - User defined argument passed to \p fn.
+ * @param[in] max_threads - The maximum number of threads. Use 0 for the
+ *   number of online processors.
+ */
+CUTEST_API void cutest_benchmark_parallel(cutest_benchmark_parallel_fn fn, void* arg,
+    unsigned max_threads);
+
+/**
+ * Group: TEST_BENCHMARK
+ * @}
+ */
+
 /**
  * @defgroup TEST_PORTING Porting
  *
@@ -1744,6 +2605,7 @@ CUTEST_API void cutest_skip_test(void);
  * | cutest_porting_cvfprintf       | CUTEST_PORTING_CVFPRINTF      |
  * | cutest_porting_gettid          | CUTEST_PORTING_GETTID         |
  * | cutest_porting_setjmp          | CUTEST_PORTING_SETJMP         |
+ * | cutest_porting_thread_*        | CUTEST_PORTING_THREAD         |
  *
  * @{
  */
@@ -1919,6 +2781,59 @@ void cutest_porting_setjmp(cutest_porting_setjmp_fn execute, void* data);
  * @}
  */
 
+/**
+ * @defgroup TEST_PORTING_SYSTEM_API_THREAD thread
+ *
+ * Threads run fixtures of #TEST_FIXTURE_THREAD_SAFE() ahead,
+ * #cutest_benchmark_parallel() and `--test_repeat_until_fail`. If your system
+ * does not support multithread, define `CUTEST_NO_THREADS` instead.
+ *
+ * Thread local storage is `__thread` by default. Define `CUTEST_THREAD_LOCAL`
+ * to the storage class of your compiler if it is not supported.
+ *
+ * @{
+ */
+
+/**
+ * @brief Start a thread that calls \p fn with \p arg.
+ * @return Handle of the thread, or NULL if failed.
+ */
+void* cutest_porting_thread_create(void (*fn)(void* arg), void* arg);
+
+/**
+ * @brief Wait for the thread created by #cutest_porting_thread_create() to
+ *   exit, and release it.
+ */
+void cutest_porting_thread_join(void* thr);
+
+/**
+ * @brief Give up the CPU so other threads can run.
+ */
+void cutest_porting_thread_yield(void);
+
+/**
+ * @brief Get the number of CPUs this process can run on.
+ */
+unsigned cutest_porting_thread_cpu_count(void);
+
+/**
+ * @brief Atomically add \p val to \p dst, with full memory barrier.
+ * @return The new value.
+ */
+long cutest_porting_thread_atomic_add(volatile long* dst, long val);
+
+/**
+ * @brief Atomically set \p dst to \p val if it equals to \p expect, with
+ *   full memory barrier.
+ * @return Non-zero if success.
+ */
+int cutest_porting_thread_atomic_cas(volatile long* dst, long expect, long val);
+
+/**
+ * END GROUP: TEST_PORTING_SYSTEM_API_THREAD
+ * @}
+ */
+
 /**
  * Group: TEST_PORTING_SYSTEM_API
  * @}
@@ -1964,4 +2879,17 @@ int cutest_porting_compare_floating_number(int type, const void* v1, const void*
 #ifdef __cplusplus
 }
 #endif
+
+/**
+ * @brief Replace the C library allocator by #cutest_guard_malloc() and
+ *   friends in the file including this header.
+ */
+#if defined(CUTEST_GUARD_MALLOC_OVERRIDE) && !defined(CUTEST_BUILDING_DLL)
+#   include <stdlib.h>
+#   define malloc(size)         cutest_guard_malloc(size)
+#   define calloc(nmemb, size)  cutest_guard_calloc(nmemb, size)
+#   define realloc(ptr, size)   cutest_guard_realloc(ptr, size)
+#   define free(ptr)            cutest_guard_free(ptr)
+#endif
+
 #endif
@@ -2,8 +2,14 @@
 #   define _WIN32_WINNT   0x0600
 #endif
 
+/* For CPU affinity. */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#   define _GNU_SOURCE
+#endif
+
 #define CUTEST_BUILDING_DLL
 #include "cutest.h"
+#include <stdlib.h>
 
 /*
  * Before Visual Studio 2015, there is a bug that a `do { } while (0)` will triger C4127 warning
@@ -78,6 +84,7 @@
 #   define CUTEST_PORTING_ABORT
 #   define CUTEST_PORTING_GETTID
 #   define CUTEST_PORTING_CVFPRINTF
+#   define CUTEST_PORTING_THREAD
 #endif
 
 /**
@@ -300,6 +307,83 @@ static char* cutest_porting_strchr(const char* s, int c)
     return *(unsigned char*)r == (unsigned char)c ? r : 0;
 }
 
+static char* cutest_porting_strstr(const char* h, const char* n)
+{
+    unsigned long n_sz = cutest_porting_strlen(n);
+    for (; *h != '\0'; h++)
+    {
+        if (cutest_porting_strncmp(h, n, n_sz) == 0)
+        {
+            return (char*)h;
+        }
+    }
+    return n_sz == 0 ? (char*)h : NULL;
+}
+
+/**
+ * @brief Square root by Newton's method.
+ * @param[in] x     Non-negative value.
+ */
+static double cutest_porting_sqrt(double x)
+{
+    double r = x > 1 ? x : 1;
+    double prev = 0;
+
+    if (x <= 0)
+    {
+        return 0;
+    }
+
+    while (r != prev)
+    {
+        prev = r;
+        r = (r + x / r) / 2;
+        if (r >= prev)
+        {
+            break;
+        }
+    }
+
+    return r;
+}
+
+/**
+ * @brief Binary logarithm.
+ * @param[in] x     Value not less than 1.
+ */
+static double cutest_porting_log2(double x)
+{
+    double ret = 0;
+    double bit = 1;
+    int i;
+
+    if (x <= 1)
+    {
+        return 0;
+    }
+
+    /* Integer part. */
+    while (x >= 2)
+    {
+        x /= 2;
+        ret += 1;
+    }
+
+    /* Fraction part, one bit each round. */
+    for (i = 0; i < 32; i++)
+    {
+        x = x * x;
+        bit /= 2;
+        if (x >= 2)
+        {
+            x /= 2;
+            ret += bit;
+        }
+    }
+
+    return ret;
+}
+
 /**
  * @{
  * BEG: cutest_porting_clock_gettime()
@@ -1742,7 +1826,7 @@ static int cutest_timestamp_dif(const cutest_porting_timespec_t* t1,
     tmp_dif.tv_sec = large_t->tv_sec - little_t->tv_sec;
     if (large_t->tv_nsec < little_t->tv_nsec)
     {
-        tmp_dif.tv_nsec = little_t->tv_nsec - large_t->tv_nsec;
+        tmp_dif.tv_nsec = 1000000000 - (little_t->tv_nsec - large_t->tv_nsec);
         tmp_dif.tv_sec--;
     }
     else
@@ -1762,1753 +1846,8481 @@ static int cutest_timestamp_dif(const cutest_porting_timespec_t* t1,
     return t1 == little_t ? -1 : 1;
 }
 
-/************************************************************************/
-/* test                                                                 */
-/************************************************************************/
-
-#define COLOR_GREEN(str)                    "@G" str "@D"
-#define COLOR_RED(str)                      "@R" str "@D"
-#define COLOR_YELLO(str)                    "@Y" str "@D"
-
-#define MASK_FAILURE                        (0x01 << 0x00)
-#define MASK_SKIPPED                        (0x01 << 0x01)
-#define SET_MASK(val, mask)                 do { (val) |= (mask); } while (0)
-#define HAS_MASK(val, mask)                 ((val) & (mask))
-
-#define MAX_RAND                            99999
-
 /**
- * @brief microseconds in one second
+ * @brief Get the distance between two timestamp in nanoseconds.
+ * @param [in] t1       timestamp t1
+ * @param [in] t2       timestamp t2
+ * @return              Nanoseconds.
  */
-#define USEC_IN_SEC                         (1 * 1000 * 1000)
+static double cutest_timestamp_dif_ns(const cutest_porting_timespec_t* t1,
+    const cutest_porting_timespec_t* t2)
+{
+    cutest_porting_timespec_t tv_diff;
+    cutest_timestamp_dif(t1, t2, &tv_diff);
+    return (double)tv_diff.tv_sec * 1000000000.0 + (double)tv_diff.tv_nsec;
+}
 
-#define CONTAINER_OF(ptr, TYPE, member) \
-    ((TYPE*)((char*)(ptr) - (char*)&((TYPE*)0)->member))
+///////////////////////////////////////////////////////////////////////////////
+// Thread
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(CUTEST_NO_THREADS) || defined(CUTEST_PORTING_THREAD)
+/* Do nothing */
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
 
 /**
- * @brief Create compare context for \p TYPE.
- * @param[in] TYPE  Data type.
+ * @def CUTEST_THREAD_LOCAL
+ * @brief Thread local storage class. Define it to porting.
  */
-#define TEST_GENERATE_NATIVE_COMPARE(NAME, TYPE)  \
-    TEST_GENERATE_TEMPLATE_COMPARE(NAME, TYPE, _cutest_smart_print_int)
-
-#define TEST_GENERATE_TEMPLATE_COMPARE(NAME, TYPE, PRINT)   \
-    static int _test_cmp_##NAME(TYPE* addr1, TYPE* addr2) {\
-        TYPE v1 = *addr1;\
-        TYPE v2 = *addr2;\
-        if (v1 == v2) {\
-            return 0;\
-        }\
-        return v1 < v2 ? -1 : 1;\
-    }\
-    static int _test_print_##NAME(FILE* file, TYPE* addr) {\
-        int is_signed = ((TYPE)(-1)) < ((TYPE)1);\
-        return PRINT(file, addr, sizeof(TYPE), is_signed);\
-    }\
-    static cutest_type_info_t NAME = {\
-        { NULL, NULL, NULL }, #TYPE,\
-        (cutest_custom_type_cmp_fn)_test_cmp_##NAME,\
-        (cutest_custom_type_dump_fn)_test_print_##NAME,\
-    }
+#if defined(CUTEST_THREAD_LOCAL)
+/* Do nothing */
+#elif defined(CUTEST_NO_THREADS)
+#   define CUTEST_THREAD_LOCAL
+#elif defined(_MSC_VER)
+#   define CUTEST_THREAD_LOCAL  __declspec(thread)
+#else
+#   define CUTEST_THREAD_LOCAL  __thread
+#endif
 
-typedef struct test_case_info
+typedef struct cutest_thread
 {
-    char                        fmt_name[256];  /**< Formatted name. */
-    unsigned long               fmt_name_sz;    /**< The length of formatted name, not include NULL termainator. */
+    void            (*fn)(void* arg);   /**< Thread body. */
+    void*           arg;                /**< Argument of thread body. */
+#if defined(CUTEST_NO_THREADS)
+#elif defined(CUTEST_PORTING_THREAD)
+    void*           handle;
+#elif defined(_WIN32)
+    HANDLE          handle;
+#else
+    pthread_t       handle;
+#endif
+} cutest_thread_t;
 
-    cutest_case_t*              test_case;      /**< Test case. */
+#if defined(CUTEST_NO_THREADS)
 
-    cutest_porting_timespec_t   tv_case_beg;    /**< Start time. */
-    cutest_porting_timespec_t   tv_case_end;    /**< End time. */
-} test_case_info_t;
+static unsigned cutest_thread_cpu_count(void)
+{
+    return 1;
+}
 
-typedef struct fixture_run_helper
+static void cutest_thread_create(cutest_thread_t* thr)
 {
-    test_case_info_t*           info;
-    int                         ret;
-} fixture_run_helper_t;
+    thr->fn(thr->arg);
+}
 
-typedef struct test_case_helper
+static void cutest_thread_join(cutest_thread_t* thr)
 {
-    test_case_info_t*           info;
-    int                         ret;
-} test_case_helper_t;
+    (void)thr;
+}
 
-typedef struct test_run_parameterized_helper
+static void cutest_thread_pin(unsigned idx)
 {
-    test_case_info_t*           info;
-} test_run_parameterized_helper_t;
+    (void)idx;
+}
 
-typedef struct test_ctx
+static void cutest_thread_yield(void)
 {
-    cutest_map_t                    case_table;                     /**< Cases in map */
-    cutest_map_t                    type_table;                     /**< Type table. */
+}
 
-    struct
-    {
-        void*                       tid;                            /**< Thread ID */
-        cutest_case_t*              cur_node;                       /**< Current running test case node. */
-    } runtime;
+static long cutest_atomic_add(volatile long* dst, long val)
+{
+    return *dst += val;
+}
 
-    struct
+/**
+ * @brief Set \p dst to \p val if it equals to \p expect.
+ * @return Non-zero if success.
+ */
+static int cutest_atomic_cas(volatile long* dst, long expect, long val)
+{
+    if (*dst != expect)
     {
-        struct
-        {
-            unsigned                total;                          /**< The number of total running cases */
-            unsigned                disabled;                       /**< The number of disabled cases */
-            unsigned                success;                        /**< The number of success cases */
-            unsigned                skipped;                        /**< The number of skipped cases */
-            unsigned                failed;                         /**< The number of failed cases */
-        } result;
+        return 0;
+    }
+    *dst = val;
+    return 1;
+}
 
-        struct
-        {
-            unsigned long           repeat;                         /**< How many times need to repeat */
-            unsigned long           repeated;                       /**< How many times already repeated */
-        } repeat;
-    } counter;
+#elif defined(CUTEST_PORTING_THREAD)
 
-    struct
-    {
-        test_str_t                  pattern;                         /**< `--test_filter` */
-    } filter;
+static unsigned cutest_thread_cpu_count(void)
+{
+    unsigned cnt = cutest_porting_thread_cpu_count();
+    return cnt != 0 ? cnt : 1;
+}
 
-    struct
+static void cutest_thread_create(cutest_thread_t* thr)
+{
+    if ((thr->handle = cutest_porting_thread_create(thr->fn, thr->arg)) == NULL)
     {
-        unsigned                    break_on_failure : 1;           /**< DebugBreak when failure */
-        unsigned                    no_print_time : 1;              /**< Whether to print execution cost time */
-        unsigned                    also_run_disabled_tests : 1;    /**< Also run disabled tests */
-        unsigned                    shuffle : 1;                    /**< Randomize running cases */
-    } mask;
+        cutest_abort("cutest_porting_thread_create() failed.\n");
+    }
+}
 
-    struct
-    {
-        cutest_porting_jmpbuf_t*    addr;                           /**< Jump address. */
-        cutest_porting_longjmp_fn   func;                           /**< Long jump function. */
-    } jmp;
+static void cutest_thread_join(cutest_thread_t* thr)
+{
+    cutest_porting_thread_join(thr->handle);
+}
 
-    FILE*                           out;
-    const cutest_hook_t*            hook;
-} test_ctx_t;
+static void cutest_thread_pin(unsigned idx)
+{
+    (void)idx;
+}
 
-static int _cutest_on_cmp_case(const cutest_map_node_t* key1, const cutest_map_node_t* key2, void* arg)
+static void cutest_thread_yield(void)
 {
-    (void)arg;
-    int ret;
+    cutest_porting_thread_yield();
+}
 
-    cutest_case_t* t1 = CONTAINER_OF(key1, cutest_case_t, node);
-    cutest_case_t* t2 = CONTAINER_OF(key2, cutest_case_t, node);
+static long cutest_atomic_add(volatile long* dst, long val)
+{
+    return cutest_porting_thread_atomic_add(dst, val);
+}
 
-    /* randkey always go first. */
-    if (t1->data.randkey < t2->data.randkey)
+static int cutest_atomic_cas(volatile long* dst, long expect, long val)
+{
+    return cutest_porting_thread_atomic_cas(dst, expect, val);
+}
+
+#elif defined(_WIN32)
+
+static unsigned cutest_thread_cpu_count(void)
+{
+    DWORD_PTR process_mask, system_mask;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask))
     {
-        return -1;
+        return 1;
     }
-    if (t1->data.randkey > t2->data.randkey)
+
+    unsigned cnt = 0;
+    for (; process_mask != 0; process_mask &= process_mask - 1)
     {
-        return 1;
+        cnt++;
     }
+    return cnt != 0 ? cnt : 1;
+}
 
-    if ((ret = cutest_porting_strcmp(t1->info.fixture_name, t2->info.fixture_name)) != 0)
+static DWORD WINAPI _cutest_thread_proxy(LPVOID lpThreadParameter)
+{
+    cutest_thread_t* thr = lpThreadParameter;
+    thr->fn(thr->arg);
+    return 0;
+}
+
+static void cutest_thread_create(cutest_thread_t* thr)
+{
+    if ((thr->handle = CreateThread(NULL, 0, _cutest_thread_proxy, thr, 0, NULL)) == NULL)
     {
-        return ret;
+        cutest_abort("CreateThread() failed: %lu.\n", (unsigned long)GetLastError());
     }
+}
 
-    if ((ret = cutest_porting_strcmp(t1->info.case_name, t2->info.case_name)) != 0)
+static void cutest_thread_join(cutest_thread_t* thr)
+{
+    WaitForSingleObject(thr->handle, INFINITE);
+    CloseHandle(thr->handle);
+}
+
+/**
+ * @brief Pin calling thread to the `idx`-th CPU that the process is allowed to run on.
+ */
+static void cutest_thread_pin(unsigned idx)
+{
+    DWORD_PTR process_mask, system_mask;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) || process_mask == 0)
     {
-        return ret;
+        return;
     }
 
-    if (t1->parameterized.param_idx == t2->parameterized.param_idx)
+    idx %= cutest_thread_cpu_count();
+    for (;; process_mask &= process_mask - 1)
     {
-        return 0;
+        if (idx-- == 0)
+        {
+            SetThreadAffinityMask(GetCurrentThread(), process_mask & (~process_mask + 1));
+            return;
+        }
     }
-    return t1->parameterized.param_idx < t2->parameterized.param_idx ? -1 : 1;
 }
 
-static int _cutest_on_cmp_type(const cutest_map_node_t* key1, const cutest_map_node_t* key2, void* arg)
+static void cutest_thread_yield(void)
 {
-    (void)arg;
-    cutest_type_info_t* t1 = CONTAINER_OF(key1, cutest_type_info_t, node);
-    cutest_type_info_t* t2 = CONTAINER_OF(key2, cutest_type_info_t, node);
+    SwitchToThread();
+}
 
-    return cutest_porting_strcmp(t1->type_name, t2->type_name);
+static long cutest_atomic_add(volatile long* dst, long val)
+{
+    return InterlockedExchangeAdd(dst, val) + val;
 }
 
-static test_ctx_t g_test_ctx = {
-    CUTEST_MAP_INIT(_cutest_on_cmp_case, NULL),                         /* .case_table */
-    CUTEST_MAP_INIT(_cutest_on_cmp_type, NULL),                         /* .type_table */
-    { NULL, NULL },                                                     /* .runtime */
-    { { 0, 0, 0, 0, 0 }, { 0, 0 } },                                    /* .counter */
-    { { NULL, 0 } },                                                    /* .filter */
-    { 0, 0, 0, 0 },                                                     /* .mask */
-    { NULL, NULL },                                                     /* .jmp */
-    NULL,                                                               /* .out */
-    NULL,                                                               /* .hook */
-};
+static int cutest_atomic_cas(volatile long* dst, long expect, long val)
+{
+    return InterlockedCompareExchange(dst, val, expect) == expect;
+}
 
-static const char* s_test_help_encoded =
-"This program contains tests written using cutest. You can use the\n"
-"following command line flags to control its behavior:\n"
-"\n"
-"Test Selection:\n"
-"  " COLOR_GREEN("--test_list_tests") "\n"
-"      List the names of all tests instead of running them. The name of\n"
-"      TEST(Foo, Bar) is \"Foo.Bar\".\n"
-"  " COLOR_GREEN("--test_list_types") "\n"
-"      List the names of all support types.\n"
-"  " COLOR_GREEN("--test_filter=") COLOR_YELLO("POSTIVE_PATTERNS[") COLOR_GREEN("-") COLOR_YELLO("NEGATIVE_PATTERNS]") "\n"
-"      Run only the tests whose name matches one of the positive patterns but\n"
-"      none of the negative patterns. '?' matches any single character; '*'\n"
-"      matches any substring; ':' separates two patterns.\n"
-"  " COLOR_GREEN("--test_also_run_disabled_tests") "\n"
-"      Run all disabled tests too.\n"
-"\n"
-"Test Execution:\n"
-"  " COLOR_GREEN("--test_repeat=") COLOR_YELLO("[COUNT]") "\n"
-"      Run the tests repeatedly; use a negative count to repeat forever.\n"
-"  " COLOR_GREEN("--test_shuffle") "\n"
-"      Randomize tests' orders on every iteration.\n"
-"  " COLOR_GREEN("--test_random_seed=") COLOR_YELLO("[NUMBER]") "\n"
-"      Random number seed to use for shuffling test orders (between 0 and\n"
-"      " TEST_STRINGIFY(MAX_RAND) ". By default a seed based on the current time is used for shuffle).\n"
-"\n"
-"Test Output:\n"
-"  " COLOR_GREEN("--test_print_time=") COLOR_YELLO("(") COLOR_GREEN("0") COLOR_YELLO("|") COLOR_GREEN("1") COLOR_YELLO(")") "\n"
-"      Don't print the elapsed time of each test.\n"
-"\n"
-"Assertion Behavior:\n"
-"  " COLOR_GREEN("--test_break_on_failure") "\n"
-"      Turn assertion failures into debugger break-points.\n"
-;
+#else
 
-/**
- * @brief Check if `str` match `pat`
- * @return bool
- */
-static int _cutest_pattern_match(const char* pat, unsigned long pat_sz,
-    const char* str, unsigned long str_sz)
+#if !defined(__GNUC__) && !defined(__clang__)
+#   error "no atomic builtins, define CUTEST_PORTING_THREAD or CUTEST_NO_THREADS"
+#endif
+
+static unsigned cutest_thread_cpu_count(void)
 {
-    const char* name = str;
-    const char* const name_begin = name;
-    const char* const name_end = name + str_sz;
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    if (sched_getaffinity(0, sizeof(cpuset), &cpuset) == 0)
+    {
+        return (unsigned)CPU_COUNT(&cpuset);
+    }
+#endif
 
-    const char* pattern = pat;
-    const char* pattern_end = pat + pat_sz;
-    const char* pattern_next = pattern;
-    const char* name_next = name;
+    long cnt = sysconf(_SC_NPROCESSORS_ONLN);
+    return cnt > 0 ? (unsigned)cnt : 1;
+}
 
-    while (pattern < pattern_end || name < name_end)
+static void* _cutest_thread_proxy(void* arg)
+{
+    cutest_thread_t* thr = arg;
+    thr->fn(thr->arg);
+    return NULL;
+}
+
+static void cutest_thread_create(cutest_thread_t* thr)
+{
+    int errcode = pthread_create(&thr->handle, NULL, _cutest_thread_proxy, thr);
+    if (errcode != 0)
     {
-        if (pattern < pattern_end)
-        {
-            switch (*pattern)
-            {
-            default:  // Match an ordinary character.
-                if (name < name_end && *name == *pattern)
-                {
-                    ++pattern;
-                    ++name;
-                    continue;
-                }
-                break;
-            case '?':  // Match any single character.
-                if (name < name_end)
-                {
-                    ++pattern;
-                    ++name;
-                    continue;
-                }
-                break;
-            case '*':
-                // Match zero or more characters. Start by skipping over the wildcard
-                // and matching zero characters from name. If that fails, restart and
-                // match one more character than the last attempt.
-                pattern_next = pattern;
-                name_next = name + 1;
-                ++pattern;
-                continue;
-            }
-        }
-        // Failed to match a character. Restart if possible.
-        if (name_begin < name_next && name_next <= name_end)
-        {
-            pattern = pattern_next;
-            name = name_next;
-            continue;
-        }
-        return 0;
+        cutest_abort("pthread_create() failed: %d.\n", errcode);
     }
-    return 1;
+}
+
+static void cutest_thread_join(cutest_thread_t* thr)
+{
+    pthread_join(thr->handle, NULL);
 }
 
 /**
- * @return true if this test will run, false if not.
+ * @brief Pin calling thread to the `idx`-th CPU that the process is allowed to
+ *   run on. Other POSIX systems do not pin.
  */
-static int _cutest_check_pattern(const char* str, unsigned long str_sz)
+static void cutest_thread_pin(unsigned idx)
 {
-    test_str_t k, v = g_test_ctx.filter.pattern;
-
-    /* If no pattern, run this test. */
-    if (v.ptr == NULL)
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    if (sched_getaffinity(0, sizeof(cpuset), &cpuset) != 0)
     {
-        return 1;
+        return;
     }
 
-    unsigned long cnt_positive_patterns = 0;
-    int flag_match_positive_pattern = 0;
-
-    /* Split patterns by `:` */
-    while (_cutest_str_split(&v, &k, &v, ":", 0) == 0)
-    {
-        /* If it is a positive pattern. */
-        if (k.ptr[0] != '-')
-        {
-            cnt_positive_patterns++;
+    idx %= (unsigned)CPU_COUNT(&cpuset);
 
-            /* Record if it match any of positive pattern */
-            if (_cutest_pattern_match(k.ptr, k.len, str, str_sz))
-            {
-                flag_match_positive_pattern = 1;
-            }
-        }
-        else if (_cutest_pattern_match(k.ptr + 1, k.len - 1, str, str_sz))
-        {/* If match negative pattern, don't run. */
-            return 0;
-        }
-    }
-    if (v.ptr[0] != '-')
+    int cpu;
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
     {
-        cnt_positive_patterns++;
-        if (_cutest_pattern_match(v.ptr, v.len, str, str_sz))
+        if (CPU_ISSET(cpu, &cpuset) && idx-- == 0)
         {
-            flag_match_positive_pattern = 1;
+            CPU_ZERO(&cpuset);
+            CPU_SET(cpu, &cpuset);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+            return;
         }
     }
-    else if (_cutest_pattern_match(v.ptr + 1, v.len - 1, str, str_sz))
-    {
-        return 0;
-    }
-
-    return cnt_positive_patterns ? flag_match_positive_pattern : 1;
+#else
+    (void)idx;
+#endif
 }
 
-/**
- * @return bool
- */
-static int _cutest_check_disable(const char* name)
+static void cutest_thread_yield(void)
 {
-    return !g_test_ctx.mask.also_run_disabled_tests &&
-        (cutest_porting_strncmp("DISABLED_", name, 9) == 0);
+    sched_yield();
 }
 
-static int _cutest_print_encoded(const char* str)
+static long cutest_atomic_add(volatile long* dst, long val)
 {
-    int ret = 0;
-    cutest_porting_color_t color = CUTEST_COLOR_DEFAULT;
-
-    for (;;)
-    {
-        const char* p = cutest_porting_strchr(str, '@');
-        if (p == NULL)
-        {
-            ret += cutest_porting_cfprintf(g_test_ctx.out, color, "%s", str);
-            return ret;
-        }
+    return __atomic_add_fetch(dst, val, __ATOMIC_SEQ_CST);
+}
 
-        ret += cutest_porting_cfprintf(g_test_ctx.out, color, "%.*s",
-            (int)(p - str), str);
+static int cutest_atomic_cas(volatile long* dst, long expect, long val)
+{
+    return __atomic_compare_exchange_n(dst, &expect, val, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
 
-        const char ch = p[1];
-        str = p + 2;
+#endif
 
-        switch (ch)
-        {
-        case '@':
-            ret += cutest_porting_cfprintf(g_test_ctx.out, color, "@");
-            break;
-        case 'D':
-            color = 0;
-            break;
-        case 'R':
-            color = CUTEST_COLOR_RED;
-            break;
-        case 'G':
-            color = CUTEST_COLOR_GREEN;
-            break;
-        case 'Y':
-            color = CUTEST_COLOR_YELLOW;
-            break;
-        default:
-            --str;
-            break;
-        }
-    }
-}
+///////////////////////////////////////////////////////////////////////////////
+// Process
+///////////////////////////////////////////////////////////////////////////////
 
-static void _cutest_hook_before_fixture_setup(cutest_case_t* test_case)
+/**
+ * @brief Read the first line of a small text file, like files in procfs.
+ * @return 0 if success.
+ */
+static int cutest_read_first_line(const char* path, char* buf, unsigned long size)
 {
-    if (g_test_ctx.hook == NULL || g_test_ctx.hook->before_setup == NULL)
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
     {
-        return;
+        return -1;
     }
-    g_test_ctx.hook->before_setup(test_case->info.fixture_name);
-}
 
-static void _cutest_hook_after_fixture_setup(cutest_case_t* test_case, int ret)
-{
-    if (g_test_ctx.hook == NULL || g_test_ctx.hook->after_setup == NULL)
+    char* line = fgets(buf, (int)size, file);
+    fclose(file);
+    if (line == NULL)
     {
-        return;
+        return -1;
     }
-    g_test_ctx.hook->after_setup(test_case->info.fixture_name, ret);
-}
 
-static void _cutest_run_case_set_jmp(cutest_porting_jmpbuf_t* buf,
-                                     cutest_porting_longjmp_fn fn_longjmp)
-{
-    g_test_ctx.jmp.addr = buf;
-    g_test_ctx.jmp.func = fn_longjmp;
+    unsigned long len = cutest_porting_strlen(buf);
+    while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r'))
+    {
+        buf[--len] = '\0';
+    }
+    return 0;
 }
 
-static void _cutest_fixture_run_setup_jmp(cutest_porting_jmpbuf_t* buf,
-    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
-{
-    fixture_run_helper_t* helper = data;
-    test_case_info_t* info = helper->info;
+#if defined(_WIN32)
 
-    _cutest_run_case_set_jmp(buf, fn_longjmp);
+#include <windows.h>
 
-    if (val != 0)
-    {
-        SET_MASK(info->test_case->data.mask, val);
-        goto after_setup;
-    }
+static struct
+{
+    DWORD_PTR   affinity;
+    int         priority;
+} s_cutest_process_saved;
 
-    _cutest_hook_before_fixture_setup(info->test_case);
-    info->test_case->stage.setup();
+/**
+ * @brief Pin calling thread to the CPU it is running on.
+ * @return 0 if success.
+ */
+static int cutest_affinity_pin_current(void)
+{
+    DWORD_PTR mask = (DWORD_PTR)1 << GetCurrentProcessorNumber();
+    s_cutest_process_saved.affinity = SetThreadAffinityMask(GetCurrentThread(), mask);
+    return s_cutest_process_saved.affinity != 0 ? 0 : -1;
+}
 
-after_setup:
-    _cutest_hook_after_fixture_setup(info->test_case, val);
-    helper->ret = val;
+static void cutest_affinity_restore(void)
+{
+    SetThreadAffinityMask(GetCurrentThread(), s_cutest_process_saved.affinity);
 }
 
 /**
- * @brief Run setup stage.
- * @param[in] test_case The test case to run.
- * @return              0 if success, otherwise failure.
+ * @brief Raise priority of calling thread.
+ * @return 0 if success.
  */
-static int _cutest_fixture_run_setup(test_case_info_t* info)
+static int cutest_priority_raise(void)
 {
-    if (info->test_case->stage.setup == NULL)
-    {
-        return 0;
-    }
+    s_cutest_process_saved.priority = GetThreadPriority(GetCurrentThread());
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST) ? 0 : -1;
+}
 
-    fixture_run_helper_t helper = { info, 0 };
-    cutest_porting_setjmp(_cutest_fixture_run_setup_jmp, &helper);
-    return helper.ret;
+static void cutest_priority_restore(void)
+{
+    SetThreadPriority(GetCurrentThread(), s_cutest_process_saved.priority);
 }
 
-static void _cutest_hook_before_test(test_case_info_t* info)
+/**
+ * @brief Run \p fn in a child process and receive \p size bytes of \p result.
+ * @return 0 if success, -1 if not supported, 1 if child terminated abnormally.
+ */
+static int cutest_process_isolate(FILE* out, void (*fn)(void*), void* arg, void* result, unsigned long size)
 {
-    cutest_case_t* test_case = info->test_case;
-    if (g_test_ctx.hook == NULL || g_test_ctx.hook->before_test == NULL)
-    {
-        return;
-    }
+    (void)out; (void)fn; (void)arg; (void)result; (void)size;
+    return -1;
+}
 
-    unsigned long fixture_sz = cutest_porting_strlen(test_case->info.fixture_name);
-    g_test_ctx.hook->before_test(test_case->info.fixture_name, info->fmt_name + fixture_sz);
+/**
+ * @brief Run \p fn in a child process with stdout and stderr redirected to
+ *   \p log, and return without waiting. The child exits with return value
+ *   of \p fn.
+ * @return Process ID of child, or 0 if not supported or failed.
+ */
+static unsigned long cutest_process_spawn(FILE* out, FILE* log, int (*fn)(void*), void* arg)
+{
+    (void)out; (void)log; (void)fn; (void)arg;
+    return 0;
 }
 
-static void _cutest_hook_after_test(test_case_info_t* info, int ret)
+/**
+ * @brief Wait for any child process to exit.
+ * @param[out] code - Exit code, or 128 plus signal number if killed.
+ * @return Process ID of child, or 0 if there is no child.
+ */
+static unsigned long cutest_process_wait_any(int* code)
 {
-    cutest_case_t* test_case = info->test_case;
-    if (g_test_ctx.hook == NULL || g_test_ctx.hook->after_test == NULL)
-    {
-        return;
-    }
+    (void)code;
+    return 0;
+}
 
-    unsigned long fixture_sz = cutest_porting_strlen(test_case->info.fixture_name);
-    g_test_ctx.hook->after_test(test_case->info.fixture_name, info->fmt_name + fixture_sz, ret);
+/**
+ * @brief Kill child process \p pid and reap it.
+ */
+static void cutest_process_kill(unsigned long pid)
+{
+    (void)pid;
 }
 
-static void _cutest_hook_before_teardown(cutest_case_t* test_case)
+/**
+ * @brief Reserve \p size bytes of read-only address space whose pages share
+ *   one physical zero page, so touching them fills TLB but not cache.
+ * @return The address, or NULL if not supported.
+ */
+static void* cutest_vm_map_zero(unsigned long size)
 {
-    if (g_test_ctx.hook == NULL || g_test_ctx.hook->before_teardown == NULL)
-    {
-        return;
-    }
+    (void)size;
+    return NULL;
+}
 
-    g_test_ctx.hook->before_teardown(test_case->info.fixture_name);
+/**
+ * @brief Reserve \p size bytes of inaccessible address space.
+ * @return The address, or NULL if not supported.
+ */
+static void* cutest_vm_reserve(unsigned long size)
+{
+    (void)size;
+    return NULL;
 }
 
-static void _cutest_hook_after_teardown(cutest_case_t* test_case, int ret)
+/**
+ * @brief Make pages readable and writable, or inaccessible.
+ * @return 0 if success.
+ */
+static int cutest_vm_protect(void* addr, unsigned long size, int accessible)
 {
-    if (g_test_ctx.hook == NULL || g_test_ctx.hook->after_teardown == NULL)
-    {
-        return;
-    }
-    g_test_ctx.hook->after_teardown(test_case->info.fixture_name, ret);
+    (void)addr; (void)size; (void)accessible;
+    return -1;
 }
 
-static void _cutest_hook_before_all_test(int argc, char* argv[])
+static unsigned long cutest_vm_page_size(void)
 {
-    if (g_test_ctx.hook == NULL || g_test_ctx.hook->before_all_test == NULL)
-    {
-        return;
-    }
-    g_test_ctx.hook->before_all_test(argc, argv);
+    return 4096;
 }
 
-static void _cutest_hook_after_all_test(void)
+/**
+ * @brief Call \p fn on invalid memory access. If \p fn returns, the fault is
+ *   handed to the previous handler.
+ * @return 0 if success, -1 if not supported.
+ */
+static int cutest_fault_handler_install(void (*fn)(void* addr))
 {
-    if (g_test_ctx.hook == NULL || g_test_ctx.hook->after_all_test == NULL)
-    {
-        return;
-    }
-    g_test_ctx.hook->after_all_test();
+    (void)fn;
+    return -1;
 }
 
-static void _cutest_fixture_run_teardown_jmp(cutest_porting_jmpbuf_t* buf,
-    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
+static void cutest_fault_handler_uninstall(void)
 {
-    test_case_info_t* info = data;
+}
 
-    _cutest_run_case_set_jmp(buf, fn_longjmp);
+static unsigned long cutest_process_id(void)
+{
+    return GetCurrentProcessId();
+}
 
-    if (val != 0)
-    {
-        SET_MASK(info->test_case->data.mask, val);
-        goto after_teardown;
-    }
+/**
+ * @brief Create file \p path of \p size bytes and map it shared and zero filled.
+ * @return The address, or NULL if not supported.
+ */
+static void* cutest_shm_create(const char* path, unsigned long size)
+{
+    (void)path; (void)size;
+    return NULL;
+}
 
-    _cutest_hook_before_teardown(info->test_case);
-    info->test_case->stage.teardown();
+static void cutest_shm_destroy(void* addr, unsigned long size)
+{
+    (void)addr; (void)size;
+}
 
-after_teardown:
-    _cutest_hook_after_teardown(info->test_case, val);
+/**
+ * @brief Order memory access to shared memory, for other processes.
+ */
+static void cutest_shm_fence(void)
+{
 }
 
-static void _cutest_fixture_run_teardown(test_case_info_t* info)
+/**
+ * @brief Listen on Unix domain socket \p path. A stale socket file at \p path
+ *   is replaced, any other file makes it fail.
+ * @return The socket, or -1 if failed or not supported.
+ */
+static int cutest_daemon_listen(const char* path)
 {
-    if (info->test_case->stage.teardown == NULL)
-    {
-        return;
-    }
+    (void)path;
+    return -1;
+}
 
-    cutest_porting_setjmp(_cutest_fixture_run_teardown_jmp, info);
+/**
+ * @brief Wait for a request: NUL terminated strings ending with an empty
+ *   string, and the descriptor the client wants output on. A client that
+ *   does not finish its request in a few seconds is dropped.
+ * @return The connection, or -1 if the request is broken.
+ */
+static int cutest_daemon_accept(int listener, char* buf, unsigned long size, int* out_fd)
+{
+    (void)listener; (void)buf; (void)size; (void)out_fd;
+    return -1;
 }
 
-static void _cutest_finishlize(test_case_info_t* info)
+/**
+ * @brief Call \p fn in a child process with output redirected to \p out_fd,
+ *   and send its exit code to the client.
+ * @return The exit code.
+ */
+static int cutest_daemon_serve(int listener, int conn, int out_fd, FILE* out, int (*fn)(void*), void* arg)
 {
-    cutest_porting_clock_gettime(&info->tv_case_end);
+    (void)listener; (void)conn; (void)out_fd; (void)out; (void)fn; (void)arg;
+    return -1;
+}
 
-    cutest_porting_timespec_t tv_diff;
-    cutest_timestamp_dif(&info->tv_case_beg, &info->tv_case_end, &tv_diff);
+static void cutest_daemon_close(int fd, const char* path)
+{
+    (void)fd; (void)path;
+}
 
-    if (HAS_MASK(info->test_case->data.mask, MASK_FAILURE))
-    {
-        g_test_ctx.counter.result.failed++;
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_RED, "[  FAILED  ]");
-    }
-    else if (HAS_MASK(info->test_case->data.mask, MASK_SKIPPED))
-    {
-        g_test_ctx.counter.result.skipped++;
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW, "[   SKIP   ]");
-    }
-    else
-    {
-        g_test_ctx.counter.result.success++;
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[       OK ]");
-    }
+#elif defined(__linux__)
 
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s", info->fmt_name);
-    if (!g_test_ctx.mask.no_print_time)
-    {
-        unsigned long take_time = (unsigned long)(tv_diff.tv_sec * 1000 + tv_diff.tv_nsec / 1000000);
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " (%lu ms)", take_time);
-    }
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
-}
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 
-static void _cutest_run_case_normal_body_jmp(cutest_porting_jmpbuf_t* buf,
-    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
+static struct
 {
-    test_case_helper_t* helper = data;
-    test_case_info_t* info = helper->info;
-
-    _cutest_run_case_set_jmp(buf, fn_longjmp);
+    cpu_set_t   affinity;
+    int         priority;
+} s_cutest_process_saved;
 
-    if (val != 0)
+static int cutest_affinity_pin_current(void)
+{
+    int cpu = sched_getcpu();
+    if (cpu < 0 || sched_getaffinity(0, sizeof(s_cutest_process_saved.affinity), &s_cutest_process_saved.affinity) != 0)
     {
-        SET_MASK(info->test_case->data.mask, val);
-        goto after_body;
+        return -1;
     }
 
-    _cutest_hook_before_test(info);
-    info->test_case->stage.body(NULL, 0);
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    return sched_setaffinity(0, sizeof(cpuset), &cpuset);
+}
 
-after_body:
-    _cutest_hook_after_test(info, val);
-    helper->ret = val;
+static void cutest_affinity_restore(void)
+{
+    sched_setaffinity(0, sizeof(s_cutest_process_saved.affinity), &s_cutest_process_saved.affinity);
 }
 
-static int _cutest_run_case_normal_body(test_case_info_t* info)
+static int cutest_priority_raise(void)
 {
-    test_case_helper_t helper = { info, 0 };
-    cutest_porting_setjmp(_cutest_run_case_normal_body_jmp, &helper);
-    return helper.ret;
+    s_cutest_process_saved.priority = getpriority(PRIO_PROCESS, 0);
+    return setpriority(PRIO_PROCESS, 0, -20);
 }
 
-/**
- * @return  1 if need to process, 0 to stop.
- */
-static int _cutest_run_prepare(test_case_info_t* info)
+static void cutest_priority_restore(void)
 {
-    /* Check if need to run this test case */
-    if (!_cutest_check_pattern(info->fmt_name, info->fmt_name_sz))
+    setpriority(PRIO_PROCESS, 0, s_cutest_process_saved.priority);
+}
+
+static int cutest_process_isolate(FILE* out, void (*fn)(void*), void* arg, void* result, unsigned long size)
+{
+    int fd[2];
+    if (pipe(fd) != 0)
     {
-        return 1;
+        return -1;
     }
-    g_test_ctx.counter.result.total++;
 
-    /* check if this test is disabled */
-    if (_cutest_check_disable(info->test_case->info.case_name))
+    /* Avoid duplicate buffered content. */
+    fflush(out);
+
+    pid_t pid = fork();
+    if (pid < 0)
     {
-        g_test_ctx.counter.result.disabled++;
-        return 1;
+        close(fd[0]);
+        close(fd[1]);
+        return -1;
     }
 
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ RUN      ]");
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s\n", info->fmt_name);
+    if (pid == 0)
+    {
+        close(fd[0]);
+        fn(arg);
+        fflush(out);
 
-    /* record start time */
-    cutest_porting_clock_gettime(&info->tv_case_beg);
-    return 0;
-}
+        const char* pos = result;
+        unsigned long left = size;
+        while (left > 0)
+        {
+            ssize_t n = write(fd[1], pos, left);
+            if (n <= 0)
+            {
+                _exit(EXIT_FAILURE);
+            }
+            pos += n;
+            left -= (unsigned long)n;
+        }
+        _exit(EXIT_SUCCESS);
+    }
 
-static unsigned long _cutest_get_test_fmt_name_normal(char* buf, unsigned long len, cutest_case_t* test_case)
-{
-    unsigned long fixture_len = cutest_porting_strlen(test_case->info.fixture_name);
-    unsigned long case_name_len = cutest_porting_strlen(test_case->info.case_name);
+    close(fd[1]);
 
-    /* Write fixture */
-    if (len <= fixture_len + 1)
+    char* pos = result;
+    unsigned long left = size;
+    while (left > 0)
     {
-        cutest_porting_memcpy(buf, test_case->info.fixture_name, len - 1);
-        goto finish;
+        ssize_t n = read(fd[0], pos, left);
+        if (n <= 0)
+        {
+            break;
+        }
+        pos += n;
+        left -= (unsigned long)n;
     }
-    cutest_porting_memcpy(buf, test_case->info.fixture_name, fixture_len);
+    close(fd[0]);
 
-    /*  Write dot */
-    buf[fixture_len] = '.';
-    if (len == fixture_len + 2)
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
     {
-        goto finish;
     }
 
-    /* Write case_name */
-    unsigned long left_size = len - fixture_len - 1;
-    unsigned long copy_size = left_size < case_name_len ? left_size : case_name_len;
-    cutest_porting_memcpy(buf + fixture_len + 1, test_case->info.case_name, copy_size);
-    buf[fixture_len + 1 + case_name_len] = '\0';
-
-finish:
-    buf[len - 1] = '\0';
-    return fixture_len + 1 + case_name_len;
+    return (left == 0 && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) ? 0 : 1;
 }
 
-static void _cutest_run_case_normal(cutest_case_t* test_case)
+static unsigned long cutest_process_spawn(FILE* out, FILE* log, int (*fn)(void*), void* arg)
 {
-    test_case_info_t info;
-    unsigned long ret = _cutest_get_test_fmt_name_normal(info.fmt_name, sizeof(info.fmt_name), test_case);
-    if (ret >= sizeof(info.fmt_name))
-    {
-        cutest_abort("");
-        return;
-    }
-    info.fmt_name_sz = ret;
-    info.test_case = test_case;
+    fflush(out);
+    fflush(stdout);
+    fflush(stderr);
 
-    if (_cutest_run_prepare(&info) != 0)
+    pid_t pid = fork();
+    if (pid < 0)
     {
-        return;
+        return 0;
     }
 
-    /* setup */
-    if (_cutest_fixture_run_setup(&info) != 0)
+    if (pid == 0)
     {
-        goto cleanup;
-    }
+        dup2(fileno(log), STDOUT_FILENO);
+        dup2(fileno(log), STDERR_FILENO);
 
-    _cutest_run_case_normal_body(&info);
-    _cutest_fixture_run_teardown(&info);
+        int code = fn(arg);
+        fflush(log);
+        fflush(stdout);
+        fflush(stderr);
+        _exit(code);
+    }
 
-cleanup:
-    _cutest_finishlize(&info);
+    return (unsigned long)pid;
 }
 
-static void _cutest_run_case_parameterized_body_jmp(cutest_porting_jmpbuf_t* buf,
-    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
+static unsigned long cutest_process_wait_any(int* code)
 {
-    test_run_parameterized_helper_t* helper = data;
-    test_case_info_t* info = helper->info;
-    cutest_case_t* test_case = info->test_case;
-
-    _cutest_run_case_set_jmp(buf, fn_longjmp);
-
-    if (val != 0)
+    int status = 0;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, 0)) < 0 && errno == EINTR)
     {
-        SET_MASK(info->test_case->data.mask, val);
-        goto after_body;
+    }
+    if (pid <= 0)
+    {
+        return 0;
     }
 
-    info->test_case->stage.body(test_case->parameterized.param_data, test_case->parameterized.param_idx);
-
-after_body:
-    _cutest_hook_after_test(info, val);
-}
-
-static void _cutest_run_case_parameterized_body(test_case_info_t* info)
-{
-    _cutest_hook_before_test(info);
-
-    test_run_parameterized_helper_t helper = { info };
-    cutest_porting_setjmp(_cutest_run_case_parameterized_body_jmp, &helper);
+    *code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return (unsigned long)pid;
 }
 
-static void _cutest_run_case_parameterized_idx(test_case_info_t* info)
+static void cutest_process_kill(unsigned long pid)
 {
-    if (_cutest_run_prepare(info) != 0)
+    int status = 0;
+    kill((pid_t)pid, SIGKILL);
+    while (waitpid((pid_t)pid, &status, 0) < 0 && errno == EINTR)
     {
-        return;
     }
+}
 
-    /* setup */
-    if (_cutest_fixture_run_setup(info) != 0)
+static void* cutest_vm_map_zero(unsigned long size)
+{
+    void* addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED)
     {
-        goto cleanup;
+        return NULL;
     }
 
-    _cutest_run_case_parameterized_body(info);
-    _cutest_fixture_run_teardown(info);
-
-cleanup:
-    _cutest_finishlize(info);
+    /* Huge pages would cover the whole range with a few TLB entries. */
+#if defined(MADV_NOHUGEPAGE)
+    madvise(addr, size, MADV_NOHUGEPAGE);
+#endif
+    return addr;
 }
 
-static unsigned long _cutest_get_test_fmt_name_parameter(char* buf, unsigned long len, cutest_case_t* test_case)
+static void* cutest_vm_reserve(unsigned long size)
 {
-    char num_buf[32];
+    void* addr = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return addr != MAP_FAILED ? addr : NULL;
+}
 
-    cutest_porting_ultoa(num_buf, test_case->parameterized.param_idx);
-    unsigned long num_len = cutest_porting_strlen(num_buf);
+static int cutest_vm_protect(void* addr, unsigned long size, int accessible)
+{
+    return mprotect(addr, size, accessible ? PROT_READ | PROT_WRITE : PROT_NONE);
+}
 
-    unsigned long ret = _cutest_get_test_fmt_name_normal(buf, len, test_case);
-    if (ret >= len - num_len - 1)
-    {
-        goto finish;
-    }
+static unsigned long cutest_vm_page_size(void)
+{
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (unsigned long)size : 4096;
+}
 
-    buf[ret] = '/';
-    cutest_porting_memcpy(buf + ret + 1, num_buf, num_len + 1);
+static struct
+{
+    void                (*fn)(void* addr);
+    struct sigaction    old_segv;
+    struct sigaction    old_bus;
+} s_cutest_fault;
 
-finish:
-    return ret + 1 + num_len;
+static void _cutest_on_fault(int sig, siginfo_t* info, void* ucontext)
+{
+    (void)ucontext;
+    s_cutest_fault.fn(info->si_addr);
+
+    /* Not our business, let the previous handler deal with it. */
+    sigaction(sig, sig == SIGSEGV ? &s_cutest_fault.old_segv : &s_cutest_fault.old_bus, NULL);
 }
 
-static void _cutest_run_case_parameterized(cutest_case_t* test_case)
+static int cutest_fault_handler_install(void (*fn)(void* addr))
 {
-    test_case_info_t info;
-    info.test_case = test_case;
+    struct sigaction act;
+    cutest_porting_memset(&act, 0, sizeof(act));
+    sigemptyset(&act.sa_mask);
+    act.sa_sigaction = _cutest_on_fault;
+    /* The handler may long jump out, so do not block the signal. */
+    act.sa_flags = SA_SIGINFO | SA_NODEFER;
 
-    unsigned long ret = _cutest_get_test_fmt_name_parameter(info.fmt_name, sizeof(info.fmt_name), test_case);
-    if (ret >= sizeof(info.fmt_name))
+    s_cutest_fault.fn = fn;
+    if (sigaction(SIGSEGV, &act, &s_cutest_fault.old_segv) != 0)
     {
-        cutest_abort("name too long.\n");
-        return;
+        return -1;
     }
-    info.fmt_name_sz = ret;
+    if (sigaction(SIGBUS, &act, &s_cutest_fault.old_bus) != 0)
+    {
+        sigaction(SIGSEGV, &s_cutest_fault.old_segv, NULL);
+        return -1;
+    }
+    return 0;
+}
 
-    _cutest_run_case_parameterized_idx(&info);
+static void cutest_fault_handler_uninstall(void)
+{
+    sigaction(SIGSEGV, &s_cutest_fault.old_segv, NULL);
+    sigaction(SIGBUS, &s_cutest_fault.old_bus, NULL);
 }
 
-/**
- * run test case.
- * the target case was set to `g_test_ctx.runtime.cur_case`
- */
-static void _cutest_run_case(cutest_case_t* test_case)
+static unsigned long cutest_process_id(void)
 {
-    test_case->data.mask = 0;
+    return (unsigned long)getpid();
+}
 
-    if (test_case->parameterized.type_name != NULL)
+static void* cutest_shm_create(const char* path, unsigned long size)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
     {
-        _cutest_run_case_parameterized(test_case);
-        return;
+        return NULL;
     }
 
-    _cutest_run_case_normal(test_case);
+    void* addr = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0)
+    {
+        addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    return addr != MAP_FAILED ? addr : NULL;
 }
 
-static void _cutest_reset_all_test_mask(void)
+static void cutest_shm_destroy(void* addr, unsigned long size)
 {
-    cutest_porting_memset(&g_test_ctx.counter.result, 0, sizeof(g_test_ctx.counter.result));
+    munmap(addr, size);
+}
 
-    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
-    for (; it != NULL; it = cutest_map_next(it))
+static void cutest_shm_fence(void)
+{
+    __sync_synchronize();
+}
+
+static int cutest_daemon_listen(const char* path)
+{
+    struct sockaddr_un addr;
+    if (cutest_porting_strlen(path) >= sizeof(addr.sun_path))
     {
-        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
-        test_case->data.mask = 0;
+        return -1;
+    }
+    cutest_porting_memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    cutest_porting_memcpy(addr.sun_path, path, cutest_porting_strlen(path) + 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    /* Left over by a daemon that was killed. Anything else is not ours to remove. */
+    struct stat st;
+    if (lstat(path, &st) == 0)
+    {
+        if (!S_ISSOCK(st.st_mode))
+        {
+            close(fd);
+            errno = EEXIST;
+            return -1;
+        }
+        unlink(path);
+    }
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 16) != 0)
+    {
+        close(fd);
+        return -1;
     }
+    return fd;
 }
 
-static void _cutest_show_report_failed(void)
+static int cutest_daemon_accept(int listener, char* buf, unsigned long size, int* out_fd)
 {
-    char buffer[512];
+    int conn = accept(listener, NULL, NULL);
+    if (conn < 0)
+    {
+        return -1;
+    }
 
-    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
-    for (; it != NULL; it = cutest_map_next(it))
+    /* Requests are served one by one, so a stalled client must not block the rest. */
+    struct timeval tv = { 5, 0 };
+    setsockopt(conn, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    *out_fd = -1;
+    unsigned long len = 0;
+    while (len < 2 || buf[len - 1] != '\0' || buf[len - 2] != '\0')
     {
-        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
-        if (!HAS_MASK(test_case->data.mask, MASK_FAILURE))
+        union
         {
-            continue;
+            struct cmsghdr  hdr;
+            char            buf[CMSG_SPACE(sizeof(int))];
+        } ctl;
+        struct iovec iov = { buf + len, size - len };
+        struct msghdr msg;
+        cutest_porting_memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = ctl.buf;
+        msg.msg_controllen = sizeof(ctl.buf);
+
+        ssize_t n = len < size ? recvmsg(conn, &msg, MSG_CMSG_CLOEXEC) : 0;
+        if (n <= 0)
+        {
+            break;
         }
+        len += (unsigned long)n;
 
-        if (test_case->parameterized.type_name == NULL)
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS && *out_fd < 0)
         {
-            _cutest_get_test_fmt_name_normal(buffer, sizeof(buffer), test_case);
+            cutest_porting_memcpy(out_fd, CMSG_DATA(cmsg), sizeof(int));
         }
-        else
+    }
+
+    if (len < 2 || buf[len - 1] != '\0' || buf[len - 2] != '\0' || *out_fd < 0)
+    {
+        if (*out_fd >= 0)
         {
-            _cutest_get_test_fmt_name_parameter(buffer, sizeof(buffer), test_case);
+            close(*out_fd);
         }
-
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_RED, "[  FAILED  ]");
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s\n", buffer);
+        close(conn);
+        return -1;
     }
+    return conn;
 }
 
-static void _cutest_show_report(const cutest_porting_timespec_t* tv_total_start,
-    const cutest_porting_timespec_t* tv_total_end)
+static int cutest_daemon_serve(int listener, int conn, int out_fd, FILE* out, int (*fn)(void*), void* arg)
 {
-    cutest_porting_timespec_t tv_diff;
-    cutest_timestamp_dif(tv_total_start, tv_total_end, &tv_diff);
+    fflush(out);
+    fflush(stdout);
+    fflush(stderr);
 
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "[==========]");
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %u/%u test case%s ran.",
-        g_test_ctx.counter.result.total,
-        (unsigned)g_test_ctx.case_table.size,
-        g_test_ctx.counter.result.total > 1 ? "s" : "");
-    if (!g_test_ctx.mask.no_print_time)
+    /* Without \p fn, only acknowledge the request. */
+    int code = 0;
+    pid_t pid = 0;
+    if (fn != NULL && (pid = fork()) == 0)
     {
-        unsigned long take_time = (unsigned long)(tv_diff.tv_sec * 1000 + tv_diff.tv_nsec / 1000000);
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " (%lu ms total)", take_time);
-    }
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
+        close(listener);
+        close(conn);
+        dup2(out_fd, STDOUT_FILENO);
+        dup2(out_fd, STDERR_FILENO);
+        close(out_fd);
 
-    if (g_test_ctx.counter.result.disabled != 0)
-    {
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ DISABLED ]");
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %u test%s.\n",
-            g_test_ctx.counter.result.disabled,
-            g_test_ctx.counter.result.disabled > 1 ? "s" : "");
+        code = fn(arg);
+        fflush(out);
+        fflush(stdout);
+        _exit(code);
     }
-    if (g_test_ctx.counter.result.skipped != 0)
+
+    if (pid < 0)
     {
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW,"[ BYPASSED ]");
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %u test%s.\n",
-            g_test_ctx.counter.result.skipped,
-            g_test_ctx.counter.result.skipped > 1 ? "s" : "");
+        code = 1;
     }
-    if (g_test_ctx.counter.result.success != 0)
+    else if (pid > 0)
     {
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[  PASSED  ]");
-        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %u test%s.\n",
-            g_test_ctx.counter.result.success,
-            g_test_ctx.counter.result.success > 1 ? "s" : "");
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        {
+        }
+        code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
     }
 
-    /* don't show failed tests if every test was success */
-    if (g_test_ctx.counter.result.failed == 0)
+    close(out_fd);
+    char buf[16];
+    int len = snprintf(buf, sizeof(buf), "%d\n", code);
+    if (send(conn, buf, (size_t)len, MSG_NOSIGNAL) < 0)
     {
-        return;
+        /* Client is gone. */
     }
-
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_RED, "[  FAILED  ]");
-    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT,
-        " %u test%s, listed below:\n", g_test_ctx.counter.result.failed, g_test_ctx.counter.result.failed > 1 ? "s" : "");
-    _cutest_show_report_failed();
+    close(conn);
+    return code;
 }
 
-static int _cutest_setup_arg_pattern(char* user_pattern)
+static void cutest_daemon_close(int fd, const char* path)
 {
-    g_test_ctx.filter.pattern = _cutest_str(user_pattern);
-    return 0;
+    close(fd);
+    unlink(path);
 }
 
-/**
- * @return The length of whole string, including double quotation marks.
- */
-static unsigned long _cutest_parameterized_parser_peek_string(const char* str)
+#else
+
+static int cutest_affinity_pin_current(void)
 {
-    CUTEST_PORTING_ASSERT(str[0] == '"');
+    return -1;
+}
 
-    unsigned long pos = 1;
-    int flag_escape = 0;
+static void cutest_affinity_restore(void)
+{
+}
 
-    /* Find valid double quotation marks. */
-    for (; str[pos] != 0; pos++)
-    {
-        char c = str[pos];
-        if (flag_escape)
-        {
-            flag_escape = 0;
-            continue;
-        }
+static int cutest_priority_raise(void)
+{
+    return -1;
+}
 
-        switch (c)
-        {
-        case '\\':
-            flag_escape = 1;
-            break;
+static void cutest_priority_restore(void)
+{
+}
 
-        case '"':
-            return pos + 1;
-        }
-    }
+static int cutest_process_isolate(FILE* out, void (*fn)(void*), void* arg, void* result, unsigned long size)
+{
+    (void)out; (void)fn; (void)arg; (void)result; (void)size;
+    return -1;
+}
 
-    CUTEST_PORTING_ASSERT(!"string not end with quote");
+static unsigned long cutest_process_spawn(FILE* out, FILE* log, int (*fn)(void*), void* arg)
+{
+    (void)out; (void)log; (void)fn; (void)arg;
     return 0;
 }
 
-static unsigned long _cutest_parameterized_parser_peek_struct(const char* str)
+static unsigned long cutest_process_wait_any(int* code)
 {
-    CUTEST_PORTING_ASSERT(str[0] == '{');
-
-    unsigned long pos = 1;
-    unsigned long left_bracket = 1;
+    (void)code;
+    return 0;
+}
 
-    for (; str[pos] != '\0'; pos++)
-    {
-        char c = str[pos];
-        switch (c)
-        {
-        case '"':
-            pos += _cutest_parameterized_parser_peek_string(str + pos) - 1;
-            break;
+static void cutest_process_kill(unsigned long pid)
+{
+    (void)pid;
+}
 
-        case '{':
-            left_bracket++;
-            break;
+static void* cutest_vm_map_zero(unsigned long size)
+{
+    (void)size;
+    return NULL;
+}
 
-        case '}':
-            left_bracket--;
-            if (left_bracket == 0)
-            {
-                return pos + 1;
-            }
+/**
+ * @brief Reserve \p size bytes of inaccessible address space.
+ * @return The address, or NULL if not supported.
+ */
+static void* cutest_vm_reserve(unsigned long size)
+{
+    (void)size;
+    return NULL;
+}
 
-        default:
-            break;
-        }
-    }
+/**
+ * @brief Make pages readable and writable, or inaccessible.
+ * @return 0 if success.
+ */
+static int cutest_vm_protect(void* addr, unsigned long size, int accessible)
+{
+    (void)addr; (void)size; (void)accessible;
+    return -1;
+}
 
-    CUTEST_PORTING_ASSERT_P(str[pos] != '\0', "unbalanced struct: %s", str);
-    return 0;
+static unsigned long cutest_vm_page_size(void)
+{
+    return 4096;
 }
 
 /**
- * @brief Parser static initialize code into sequence of tokens.
- * @param[in] code  Initialize code.
- * @param[in] idx   Index of element we want.
- * @param[out] len  The length of element code in bytes.
- * @return          The position of element code.
+ * @brief Call \p fn on invalid memory access. If \p fn returns, the fault is
+ *   handed to the previous handler.
+ * @return 0 if success, -1 if not supported.
  */
-static const char* _cutest_parameterized_parser(const char* code, unsigned long idx, int* len)
+static int cutest_fault_handler_install(void (*fn)(void* addr))
 {
-    const char* str = code;
-    unsigned long pos = 0;
-
-    for (; code[pos] != '\0'; pos++)
-    {
-        char c = code[pos];
-        switch (c)
-        {
-        case '"':
-            pos += _cutest_parameterized_parser_peek_string(code + pos) - 1;
-            break;
+    (void)fn;
+    return -1;
+}
 
-        case ' ':
-            break;
+static void cutest_fault_handler_uninstall(void)
+{
+}
 
-        case '{':
-            pos += _cutest_parameterized_parser_peek_struct(code + pos) - 1;
-            break;
-
-        case ',':
-            if (idx == 0)
-            {
-                goto finish;
-            }
-            else
-            {
-                idx--;
-                str = code + pos + 1;
-                while (*str == ' ')
-                {
-                    str++;
-                }
-            }
-            break;
+static unsigned long cutest_process_id(void)
+{
+    return 0;
+}
 
-        default:
-            break;
-        }
-    }
+static void* cutest_shm_create(const char* path, unsigned long size)
+{
+    (void)path; (void)size;
+    return NULL;
+}
 
-finish:
-    *len = (int)(code + pos - str);
-    return str;
+static void cutest_shm_destroy(void* addr, unsigned long size)
+{
+    (void)addr; (void)size;
 }
 
-static void _cutest_list_tests_print_name(const cutest_case_t* test_case)
+static void cutest_shm_fence(void)
 {
-    const char* case_name = test_case->info.case_name;
+}
 
-    if (test_case->parameterized.type_name == NULL)
-    {
-        cutest_porting_fprintf(g_test_ctx.out, "  %s\n", case_name);
-        return;
-    }
+static int cutest_daemon_listen(const char* path)
+{
+    (void)path;
+    return -1;
+}
 
-    const char* type_name = test_case->parameterized.type_name;
-    unsigned long parameterized_idx = test_case->parameterized.param_idx;
+static int cutest_daemon_accept(int listener, char* buf, unsigned long size, int* out_fd)
+{
+    (void)listener; (void)buf; (void)size; (void)out_fd;
+    return -1;
+}
 
-    int len = 0;;
-    const char* str = _cutest_parameterized_parser(test_case->parameterized.test_data_cstr, parameterized_idx, &len);
+static int cutest_daemon_serve(int listener, int conn, int out_fd, FILE* out, int (*fn)(void*), void* arg)
+{
+    (void)listener; (void)conn; (void)out_fd; (void)out; (void)fn; (void)arg;
+    return -1;
+}
 
-    cutest_porting_fprintf(g_test_ctx.out, "  %s/%u  # <%s> %.*s\n",
-        case_name, (unsigned)parameterized_idx, type_name, len, str);
+static void cutest_daemon_close(int fd, const char* path)
+{
+    (void)fd; (void)path;
 }
 
-static void _cutest_list_tests(void)
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Backtrace
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @def CUTEST_RETURN_ADDRESS
+ * @brief Return address of current function, or NULL if not supported.
+ */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#   define CUTEST_RETURN_ADDRESS()  _ReturnAddress()
+#elif defined(__GNUC__) || defined(__clang__)
+#   define CUTEST_RETURN_ADDRESS()  __builtin_return_address(0)
+#else
+#   define CUTEST_RETURN_ADDRESS()  NULL
+#endif
+
+/**
+ * @brief Where a code address comes from.
+ */
+typedef struct cutest_backtrace_symbol
 {
-    const char* last_class_name = "";
+    const char*     module;     /**< Path of module, or NULL if unknown. */
+    const void*     bias;       /**< Module load bias, `addr - bias` is the address in the module file. */
+    const char*     name;       /**< Nearest exported symbol, or NULL if unknown. */
+    const void*     addr;       /**< Address of symbol. */
+} cutest_backtrace_symbol_t;
 
-    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
-    for (; it != NULL; it = cutest_map_next(it))
-    {
-        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+#if defined(_WIN32)
 
-        /* some compiler will make same string with different address */
-        if (last_class_name != test_case->info.fixture_name
-            && cutest_porting_strcmp(last_class_name, test_case->info.fixture_name) != 0)
-        {
-            last_class_name = test_case->info.fixture_name;
-            cutest_porting_fprintf(g_test_ctx.out, "%s.\n", last_class_name);
-        }
-        _cutest_list_tests_print_name(test_case);
-    }
-}
+#include <windows.h>
 
-static void _cutest_list_types(void)
+/**
+ * @brief Capture return addresses of calling thread. Symbols are not
+ *   resolved, so it is cheap enough to call on every failure.
+ * @return The number of frames written to \p frames.
+ */
+static unsigned cutest_backtrace_capture(void** frames, unsigned size)
 {
-    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.type_table);
-    for (; it != NULL; it = cutest_map_next(it))
-    {
-        cutest_type_info_t* type_info = CONTAINER_OF(it, cutest_type_info_t, node);
-        cutest_porting_fprintf(g_test_ctx.out, "%s\n", type_info->type_name);
-    }
+    return CaptureStackBackTrace(0, size, frames, NULL);
 }
 
-static int _cutest_setup_arg_repeat(const char* str)
+/**
+ * @brief Find module and symbol of \p frame. This is slow.
+ * @return 0 if success.
+ */
+static int cutest_backtrace_symbolize(const void* frame, cutest_backtrace_symbol_t* sym)
 {
-    unsigned long repeat;
-    if (cutest_porting_atoul(str, &repeat) != 0)
+    static char path[MAX_PATH];
+
+    HMODULE module;
+    if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+        (LPCSTR)frame, &module))
     {
-        return 1 << 8 | 1;
+        return -1;
+    }
+    if (GetModuleFileNameA(module, path, sizeof(path)) == 0)
+    {
+        return -1;
     }
 
-    g_test_ctx.counter.repeat.repeat = repeat;
+    /* Symbol names are in PDB, leave them to offline tools. */
+    sym->module = path;
+    sym->bias = module;
+    sym->name = NULL;
+    sym->addr = NULL;
     return 0;
 }
 
-static int _cutest_setup_arg_print_time(const char* str)
+/**
+ * @brief Write build-id of the module loaded with \p bias as hex string.
+ * @return The length of build-id string, 0 if not found.
+ */
+static unsigned cutest_backtrace_build_id(const void* bias, char* buf, unsigned size)
 {
-    unsigned long val = 1;
-    if (cutest_porting_atoul(str, &val) != 0)
-    {
-        return 1 << 8 | 1;
-    }
-
-    g_test_ctx.mask.no_print_time = !val;
+    (void)bias; (void)buf; (void)size;
     return 0;
 }
 
-static void _cutest_srand(unsigned long s)
+#elif defined(__linux__) && defined(__GLIBC__)
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <link.h>
+
+static unsigned cutest_backtrace_capture(void** frames, unsigned size)
 {
-    s = s % (MAX_RAND + 1);
-    cutest_porting_srand(s);
+    int n = backtrace(frames, (int)size);
+    return n > 0 ? (unsigned)n : 0;
 }
 
-static int _cutest_setup_arg_random_seed(const char* str)
+static int cutest_backtrace_symbolize(const void* frame, cutest_backtrace_symbol_t* sym)
 {
-    unsigned long val = 0;
-    if (cutest_porting_atoul(str, &val) != 0)
-    {
-        return 1 << 8 | 1;
-    }
-
-    if (val > MAX_RAND)
+    Dl_info info;
+    struct link_map* map = NULL;
+    if (dladdr1(frame, &info, (void**)&map, RTLD_DL_LINKMAP) == 0 || map == NULL)
     {
-        return 1 << 8 | 1;
+        return -1;
     }
 
-    _cutest_srand(val);
+    sym->module = info.dli_fname;
+    sym->bias = (const void*)map->l_addr;
+    sym->name = info.dli_sname;
+    sym->addr = info.dli_saddr;
     return 0;
 }
 
-static void _cutest_shuffle_cases(void)
+typedef struct cutest_backtrace_build_id_helper
 {
-    cutest_map_node_t* it;
-    while ((it = cutest_map_begin(&g_test_ctx.case_table)) != NULL)
-    {
-        cutest_case_t* tc = CONTAINER_OF(it, cutest_case_t, node);
-        if (tc->data.randkey != 0)
-        {
-            break;
-        }
-
-        cutest_map_erase(&g_test_ctx.case_table, it);
-        tc->data.randkey = cutest_porting_rand(MAX_RAND + 1);
-        cutest_map_insert(&g_test_ctx.case_table, it);
-    }
-}
+    const void*     bias;
+    char*           buf;
+    unsigned        size;
+    unsigned        len;
+} cutest_backtrace_build_id_helper_t;
 
-static void _cutest_undo_shuffle_cases(void)
+static int _cutest_backtrace_on_phdr(struct dl_phdr_info* info, size_t info_size, void* arg)
 {
-    cutest_map_node_t* it;
+    (void)info_size;
+    cutest_backtrace_build_id_helper_t* helper = arg;
+    if ((const void*)info->dlpi_addr != helper->bias)
+    {
+        return 0;
+    }
 
-    while ((it = cutest_map_end(&g_test_ctx.case_table)) != NULL)
+    ElfW(Half) i;
+    for (i = 0; i < info->dlpi_phnum; i++)
     {
-        cutest_case_t* tc = CONTAINER_OF(it, cutest_case_t, node);
-        if (tc->data.randkey == 0)
+        const ElfW(Phdr)* phdr = &info->dlpi_phdr[i];
+        if (phdr->p_type != PT_NOTE)
         {
-            break;
+            continue;
         }
 
-        cutest_map_erase(&g_test_ctx.case_table, it);
-        tc->data.randkey = 0;
-        cutest_map_insert(&g_test_ctx.case_table, it);
+        const char* pos = (const char*)(info->dlpi_addr + phdr->p_vaddr);
+        const char* end = pos + phdr->p_memsz;
+        while (pos + sizeof(ElfW(Nhdr)) <= end)
+        {
+            const ElfW(Nhdr)* note = (const ElfW(Nhdr)*)pos;
+            const unsigned char* desc = (const unsigned char*)(note + 1) + ((note->n_namesz + 3) & ~3U);
+            pos = (const char*)desc + ((note->n_descsz + 3) & ~3U);
+
+            if (note->n_type != NT_GNU_BUILD_ID || note->n_namesz != 4
+                || cutest_porting_memcmp(note + 1, "GNU", 4) != 0)
+            {
+                continue;
+            }
+
+            static const char* hex = "0123456789abcdef";
+            ElfW(Word) j;
+            for (j = 0; j < note->n_descsz && helper->len + 2 < helper->size; j++)
+            {
+                helper->buf[helper->len++] = hex[desc[j] >> 4];
+                helper->buf[helper->len++] = hex[desc[j] & 0x0f];
+            }
+            helper->buf[helper->len] = '\0';
+            return 1;
+        }
     }
+
+    return 1;
 }
 
-static int _cutest_smart_print_int(FILE* stream, const void* addr,
-    unsigned width, int is_signed)
+static unsigned cutest_backtrace_build_id(const void* bias, char* buf, unsigned size)
 {
-    if (is_signed)
+    cutest_backtrace_build_id_helper_t helper = { bias, buf, size, 0 };
+    if (size == 0)
     {
-        if (width == sizeof(char))
-        {
-            int val = *(char*)addr;
-            return cutest_porting_fprintf(stream, "%d", val);
-        }
+        return 0;
+    }
+    dl_iterate_phdr(_cutest_backtrace_on_phdr, &helper);
+    return helper.len;
+}
 
-        if (width == sizeof(short))
-        {
-            int val = *(short*)addr;
-            return cutest_porting_fprintf(stream, "%d", val);
-        }
+#else
 
-        if (width == sizeof(int))
-        {
-            return cutest_porting_fprintf(stream, "%d", *(int*)addr);
-        }
+static unsigned cutest_backtrace_capture(void** frames, unsigned size)
+{
+    (void)frames; (void)size;
+    return 0;
+}
 
-        if (width == sizeof(long))
-        {
-            return cutest_porting_fprintf(stream, "%ld", *(long*)addr);
-        }
+static int cutest_backtrace_symbolize(const void* frame, cutest_backtrace_symbol_t* sym)
+{
+    (void)frame; (void)sym;
+    return -1;
+}
+
+static unsigned cutest_backtrace_build_id(const void* bias, char* buf, unsigned size)
+{
+    (void)bias; (void)buf; (void)size;
+    return 0;
+}
 
-#if !defined(CUTEST_NO_C99_SUPPORT)
-        if (width == sizeof(long long))
-        {
-            return cutest_porting_fprintf(stream, "%lld", *(long long*)addr);
-        }
 #endif
-    }
-    else
-    {
-        if (width == sizeof(unsigned char))
-        {
-            unsigned val = *(unsigned char*)addr;
-            return cutest_porting_fprintf(stream, "%u", val);
-        }
 
-        if (width == sizeof(unsigned short))
-        {
-            unsigned val = *(unsigned short*)addr;
-            return cutest_porting_fprintf(stream, "%u", val);
-        }
+///////////////////////////////////////////////////////////////////////////////
+// Module
+///////////////////////////////////////////////////////////////////////////////
 
-        if (width == sizeof(unsigned int))
-        {
-            return cutest_porting_fprintf(stream, "%u", *(unsigned*)addr);
-        }
+#if defined(_WIN32)
 
-        if (width == sizeof(unsigned long))
-        {
-            return cutest_porting_fprintf(stream, "%lu", *(unsigned long*)addr);
-        }
+#include <windows.h>
 
-#if !defined(CUTEST_NO_C99_SUPPORT)
-        if (width == sizeof(unsigned long long))
-        {
-            return cutest_porting_fprintf(stream, "%llu", *(unsigned long long*)addr);
-        }
-#endif
-    }
+/**
+ * @brief Load shared library \p path. Constructors in it register test cases.
+ * @return Handle, or NULL if failed.
+ */
+static void* cutest_module_open(const char* path)
+{
+    return (void*)LoadLibraryA(path);
+}
 
-    CUTEST_PORTING_ASSERT_P(!"error", "width of %u does not match any native size", width);
-    return 0;
+static void cutest_module_close(void* handle)
+{
+    FreeLibrary((HMODULE)handle);
 }
 
-static int _cutest_print_char(FILE* stream, const void* addr,
-    unsigned width, int is_signed)
+/**
+ * @return Reason of last failure of #cutest_module_open().
+ */
+static const char* cutest_module_error(void)
 {
-    (void)width; (void)is_signed;
-    return cutest_porting_fprintf(stream, "%c", *(char*)addr);
+    return "LoadLibrary() failed";
 }
 
-TEST_GENERATE_TEMPLATE_COMPARE(s_type_info_char, char, _cutest_print_char);
-TEST_GENERATE_TEMPLATE_COMPARE(s_type_info_signed_char, signed char, _cutest_print_char);
-TEST_GENERATE_TEMPLATE_COMPARE(s_type_info_unsigned_char, unsigned char, _cutest_print_char);
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_short, short);
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_unsigned_short, unsigned short);
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_int, int);
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_unsigned_int, unsigned int);
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_long, long);
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_unsigned_long, unsigned long);
+/**
+ * @brief Start watching for files rewritten in directory of \p path.
+ * @param[in,out] fd - Watcher, created if negative.
+ * @return Watch descriptor, or -1 if not supported.
+ */
+static int cutest_watch_add(int* fd, const char* path)
+{
+    (void)fd; (void)path;
+    return -1;
+}
+
+/**
+ * @brief Wait for a file to be rewritten.
+ * @param[in] timeout_ms - Negative to wait forever.
+ * @param[out] wd - Watch descriptor of directory.
+ * @param[out] name - Name of file in the directory.
+ * @return 0 if a file is rewritten, -1 if timeout or failed.
+ */
+static int cutest_watch_wait(int fd, long timeout_ms, int* wd, char* name, unsigned long size)
+{
+    (void)fd; (void)timeout_ms; (void)wd; (void)name; (void)size;
+    return -1;
+}
+
+#elif defined(__linux__)
+
+#include <dlfcn.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+static void* cutest_module_open(const char* path)
+{
+    return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+}
+
+static void cutest_module_close(void* handle)
+{
+    dlclose(handle);
+}
+
+static const char* cutest_module_error(void)
+{
+    const char* err = dlerror();
+    return err != NULL ? err : "dlopen() failed";
+}
+
+static int cutest_watch_add(int* fd, const char* path)
+{
+    if (*fd < 0 && (*fd = inotify_init1(IN_CLOEXEC)) < 0)
+    {
+        return -1;
+    }
+
+    /* Linkers replace the file, so watch the directory instead. */
+    char dir[4096];
+    const char* slash = NULL;
+    const char* pos;
+    for (pos = path; *pos != '\0'; pos++)
+    {
+        if (*pos == '/')
+        {
+            slash = pos;
+        }
+    }
+    unsigned long len = slash != NULL ? (unsigned long)(slash - path) : 0;
+    if (len >= sizeof(dir))
+    {
+        return -1;
+    }
+    if (slash == NULL)
+    {
+        dir[len++] = '.';
+    }
+    else if (len == 0)
+    {
+        dir[len++] = '/';
+    }
+    else
+    {
+        cutest_porting_memcpy(dir, path, len);
+    }
+    dir[len] = '\0';
+
+    return inotify_add_watch(*fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+}
+
+static int cutest_watch_wait(int fd, long timeout_ms, int* wd, char* name, unsigned long size)
+{
+    static struct
+    {
+        char            buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        unsigned long   pos;
+        unsigned long   len;
+    } s_events;
+
+    while (s_events.pos >= s_events.len)
+    {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, timeout_ms < 0 ? -1 : (int)timeout_ms) <= 0)
+        {
+            return -1;
+        }
+
+        ssize_t n = read(fd, s_events.buf, sizeof(s_events.buf));
+        if (n <= 0)
+        {
+            return -1;
+        }
+        s_events.pos = 0;
+        s_events.len = (unsigned long)n;
+    }
+
+    const struct inotify_event* event = (const struct inotify_event*)(s_events.buf + s_events.pos);
+    s_events.pos += sizeof(struct inotify_event) + event->len;
+
+    *wd = event->wd;
+    unsigned long len = event->len != 0 ? cutest_porting_strlen(event->name) : 0;
+    if (len >= size)
+    {
+        len = size - 1;
+    }
+    cutest_porting_memcpy(name, event->name, len);
+    name[len] = '\0';
+    return 0;
+}
+
+#else
+
+static void* cutest_module_open(const char* path)
+{
+    (void)path;
+    return NULL;
+}
+
+static void cutest_module_close(void* handle)
+{
+    (void)handle;
+}
+
+static const char* cutest_module_error(void)
+{
+    return "not supported";
+}
+
+static int cutest_watch_add(int* fd, const char* path)
+{
+    (void)fd; (void)path;
+    return -1;
+}
+
+static int cutest_watch_wait(int fd, long timeout_ms, int* wd, char* name, unsigned long size)
+{
+    (void)fd; (void)timeout_ms; (void)wd; (void)name; (void)size;
+    return -1;
+}
 
-#if !defined(CUTEST_NO_C99_SUPPORT)
-#include <stdint.h>
-#include <stddef.h>
-#if !defined(CUTEST_NO_LONGLONG_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_long_long, long long);
-#endif
-#if !defined(CUTEST_NO_ULONGLONG_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_unsigned_long_long, unsigned long long);
-#endif
-#if !defined(CUTEST_NO_INT8_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_int8_t, int8_t);
-#endif
-#if !defined(CUTEST_NO_UINT8_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_uint8_t, uint8_t);
-#endif
-#if !defined(CUTEST_NO_INT16_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_int16_t, int16_t);
-#endif
-#if !defined(CUTEST_NO_UINT16_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_uint16_t, uint16_t);
-#endif
-#if !defined(CUTEST_NO_INT32_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_int32_t, int32_t);
-#endif
-#if !defined(CUTEST_NO_UINT32_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_uint32_t, uint32_t);
-#endif
-#if !defined(CUTEST_NO_INT64_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_int64_t, int64_t);
-#endif
-#if !defined(CUTEST_NO_UINT64_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_uint64_t, uint64_t);
-#endif
-#if !defined(CUTEST_NO_SIZE_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_size_t, size_t);
-#endif
-#if !defined(CUTEST_NO_PTRDIFF_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_ptrdiff_t, ptrdiff_t);
-#endif
-#if !defined(CUTEST_NO_INTPTR_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_intptr_t, intptr_t);
-#endif
-#if !defined(CUTEST_NO_UINTPTR_SUPPORT)
-TEST_GENERATE_NATIVE_COMPARE(s_type_info_uintptr_t, uintptr_t);
-#endif
 #endif
 
-static int _cutest_cmp_ptr(const void** addr1, const void** addr2)
+///////////////////////////////////////////////////////////////////////////////
+// Temporary File
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+/**
+ * @brief Create a unique directory named after \p prefix, under `TEST_TMPDIR`
+ *   if set, or in memory backed file system if there is one.
+ * @return Path in malloc()-ed memory, or NULL if failed.
+ */
+static char* cutest_tmpdir_create(const char* prefix)
 {
-    const void* t_addr1 = *addr1;
-    const void* t_addr2 = *addr2;
+    static volatile LONG s_counter = 0;
 
-    const char* v1 = (const char*)t_addr1;
-    const char* v2 = (const char*)t_addr2;
+    char base[MAX_PATH];
+    DWORD len = GetEnvironmentVariableA("TEST_TMPDIR", base, sizeof(base));
+    if (len == 0 || len >= sizeof(base))
+    {
+        len = GetTempPathA(sizeof(base), base);
+        if (len == 0 || len >= sizeof(base))
+        {
+            return NULL;
+        }
+    }
+    while (len != 0 && (base[len - 1] == '\\' || base[len - 1] == '/'))
+    {
+        base[--len] = '\0';
+    }
 
-    if (v1 == v2)
+    unsigned long size = len + cutest_porting_strlen(prefix) + 32;
+    char* path = malloc(size);
+    if (path == NULL)
     {
-        return 0;
+        return NULL;
     }
-    return v1 < v2 ? -1 : 1;
+
+    int retry;
+    for (retry = 0; retry < 100; retry++)
+    {
+        snprintf(path, size, "%s\\%s.%lu.%ld", base, prefix,
+            (unsigned long)GetCurrentProcessId(), (long)InterlockedIncrement(&s_counter));
+        if (CreateDirectoryA(path, NULL))
+        {
+            return path;
+        }
+        if (GetLastError() != ERROR_ALREADY_EXISTS)
+        {
+            break;
+        }
+    }
+    free(path);
+    return NULL;
 }
 
-static int _cutest_print_ptr(FILE* file, const void** addr)
+/**
+ * @brief Remove directory \p path and everything in it.
+ */
+static void cutest_tmpdir_remove(const char* path)
 {
-    return cutest_porting_fprintf(file, "%p", *addr);
+    unsigned long len = cutest_porting_strlen(path);
+    char* pattern = malloc(len + 3);
+    if (pattern == NULL)
+    {
+        return;
+    }
+    snprintf(pattern, len + 3, "%s\\*", path);
+
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    free(pattern);
+    if (find != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            if (cutest_porting_strcmp(data.cFileName, ".") == 0 || cutest_porting_strcmp(data.cFileName, "..") == 0)
+            {
+                continue;
+            }
+
+            unsigned long size = len + cutest_porting_strlen(data.cFileName) + 2;
+            char* child = malloc(size);
+            if (child == NULL)
+            {
+                continue;
+            }
+            snprintf(child, size, "%s\\%s", path, data.cFileName);
+            if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                && !(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+            {
+                cutest_tmpdir_remove(child);
+            }
+            else
+            {
+                SetFileAttributesA(child, FILE_ATTRIBUTE_NORMAL);
+                DeleteFileA(child);
+            }
+            free(child);
+        } while (FindNextFileA(find, &data));
+        FindClose(find);
+    }
+
+    RemoveDirectoryA(path);
 }
 
-static cutest_type_info_t s_type_info_ptr = {
-    { NULL, NULL, NULL }, "const void*",
-    (cutest_custom_type_cmp_fn)_cutest_cmp_ptr,
-    (cutest_custom_type_dump_fn)_cutest_print_ptr,
-};
+/**
+ * @brief Open an anonymous file that lives in memory if possible.
+ * @return File opened for reading and writing, or NULL if failed.
+ */
+static FILE* cutest_memfile_open(const char* name)
+{
+    (void)name;
+    return tmpfile();
+}
 
-static int _cutest_cmp_str(const char** addr1, const char** addr2)
+#elif defined(__linux__)
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static char* cutest_tmpdir_create(const char* prefix)
 {
-    const char* v1 = *addr1;
-    const char* v2 = *addr2;
-    return cutest_porting_strcmp(v1, v2);
+    const char* base = getenv("TEST_TMPDIR");
+    if (base == NULL || *base == '\0')
+    {
+        /* Container overlay file systems are slow, prefer tmpfs. */
+        base = access("/dev/shm", W_OK | X_OK) == 0 ? "/dev/shm" : getenv("TMPDIR");
+    }
+    if (base == NULL || *base == '\0')
+    {
+        base = "/tmp";
+    }
+
+    unsigned long size = cutest_porting_strlen(base) + cutest_porting_strlen(prefix) + 32;
+    char* path = malloc(size);
+    if (path == NULL)
+    {
+        return NULL;
+    }
+
+    snprintf(path, size, "%s/%s.%ld.XXXXXX", base, prefix, (long)getpid());
+    if (mkdtemp(path) == NULL)
+    {
+        free(path);
+        return NULL;
+    }
+    return path;
 }
 
-static int _cutest_print_str(FILE* file, const char** addr)
+static void _cutest_tmpdir_remove_at(int dirfd, const char* name)
 {
-    const char* v = *addr;
-    return cutest_porting_fprintf(file, "%s", v);
+    if (unlinkat(dirfd, name, 0) == 0 || (errno != EISDIR && errno != EPERM))
+    {
+        return;
+    }
+
+    /* Do not follow symbolic links out of the directory. */
+    int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+    DIR* dir = fdopendir(fd);
+    if (dir == NULL)
+    {
+        close(fd);
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (cutest_porting_strcmp(entry->d_name, ".") == 0 || cutest_porting_strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+        _cutest_tmpdir_remove_at(fd, entry->d_name);
+    }
+    closedir(dir);
+
+    unlinkat(dirfd, name, AT_REMOVEDIR);
 }
 
-static cutest_type_info_t s_type_info_str = {
-    { NULL, NULL, NULL }, "const char*",
-    (cutest_custom_type_cmp_fn)_cutest_cmp_str,
-    (cutest_custom_type_dump_fn)_cutest_print_str,
-};
+static void cutest_tmpdir_remove(const char* path)
+{
+    _cutest_tmpdir_remove_at(AT_FDCWD, path);
+}
 
-static int _cutest_cmp_float(const float* addr1, const float* addr2)
+static FILE* cutest_memfile_open(const char* name)
 {
-    return cutest_porting_compare_floating_number(0, addr1, addr2);
+#if defined(MFD_CLOEXEC)
+    int fd = memfd_create(name, MFD_CLOEXEC);
+    if (fd >= 0)
+    {
+        FILE* file = fdopen(fd, "w+");
+        if (file != NULL)
+        {
+            return file;
+        }
+        close(fd);
+    }
+#else
+    (void)name;
+#endif
+    return tmpfile();
+}
+
+#else
+
+static char* cutest_tmpdir_create(const char* prefix)
+{
+    (void)prefix;
+    return NULL;
+}
+
+static void cutest_tmpdir_remove(const char* path)
+{
+    (void)path;
+}
+
+static FILE* cutest_memfile_open(const char* name)
+{
+    (void)name;
+    return tmpfile();
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// File Mapping
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+/**
+ * @brief Map file \p path read only.
+ * @param[in] prefetch - Read the whole file into page cache now.
+ * @param[out] size - Size of file.
+ * @return Address of mapping, or NULL if failed.
+ */
+static void* cutest_file_map(const char* path, int prefetch, size_t* size)
+{
+    (void)prefetch;
+    static const char s_empty[1] = { 0 };
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return NULL;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || (ULONGLONG)file_size.QuadPart > (SIZE_T)-1)
+    {
+        CloseHandle(file);
+        return NULL;
+    }
+    if (file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        *size = 0;
+        return (void*)s_empty;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        return NULL;
+    }
+
+    void* addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (addr == NULL)
+    {
+        return NULL;
+    }
+    *size = (size_t)file_size.QuadPart;
+    return addr;
+}
+
+/**
+ * @brief Unmap file mapped by #cutest_file_map().
+ */
+static void cutest_file_unmap(void* addr, size_t size)
+{
+    if (size != 0)
+    {
+        UnmapViewOfFile(addr);
+    }
+}
+
+#elif defined(__linux__)
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static void* cutest_file_map(const char* path, int prefetch, size_t* size)
+{
+    static const char s_empty[1] = { 0 };
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_size == 0)
+    {
+        close(fd);
+        *size = 0;
+        return (void*)s_empty;
+    }
+
+    int flags = MAP_PRIVATE;
+#if defined(MAP_POPULATE)
+    if (prefetch)
+    {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void* addr = mmap(NULL, (size_t)st.st_size, PROT_READ, flags, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    if (prefetch)
+    {
+        madvise(addr, (size_t)st.st_size, MADV_WILLNEED);
+    }
+    *size = (size_t)st.st_size;
+    return addr;
+}
+
+static void cutest_file_unmap(void* addr, size_t size)
+{
+    if (size != 0)
+    {
+        munmap(addr, size);
+    }
+}
+
+#else
+
+static void* cutest_file_map(const char* path, int prefetch, size_t* size)
+{
+    (void)prefetch;
+
+    FILE* file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        return NULL;
+    }
+
+    /* No mapping, read it into memory. */
+    char* addr = NULL;
+    size_t len = 0, cap = 0;
+    for (;;)
+    {
+        if (len == cap)
+        {
+            cap = cap != 0 ? cap * 2 : 4096;
+            char* tmp = realloc(addr, cap);
+            if (tmp == NULL)
+            {
+                free(addr);
+                fclose(file);
+                return NULL;
+            }
+            addr = tmp;
+        }
+
+        size_t n = fread(addr + len, 1, cap - len, file);
+        if (n == 0)
+        {
+            break;
+        }
+        len += n;
+    }
+    fclose(file);
+
+    *size = len;
+    return addr;
+}
+
+static void cutest_file_unmap(void* addr, size_t size)
+{
+    (void)size;
+    free(addr);
+}
+
+#endif
+
+/************************************************************************/
+/* test                                                                 */
+/************************************************************************/
+
+#define COLOR_GREEN(str)                    "@G" str "@D"
+#define COLOR_RED(str)                      "@R" str "@D"
+#define COLOR_YELLO(str)                    "@Y" str "@D"
+
+#define MASK_FAILURE                        (0x01 << 0x00)
+#define MASK_SKIPPED                        (0x01 << 0x01)
+#define MASK_BIGO_VISITED                   (0x01 << 0x02)
+#define MASK_AUTOTUNE_VISITED               (0x01 << 0x03)
+#define SET_MASK(val, mask)                 do { (val) |= (mask); } while (0)
+#define HAS_MASK(val, mask)                 ((val) & (mask))
+
+#define MAX_RAND                            99999
+
+/**
+ * @brief microseconds in one second
+ */
+#define USEC_IN_SEC                         (1 * 1000 * 1000)
+
+/**
+ * @brief Default value of `--test_benchmark_min_time`.
+ */
+#define BENCHMARK_DEFAULT_MIN_TIME_MS       100
+
+/**
+ * @brief A faster growing complexity class is only reported when its RMS
+ *   error is less than the one of a slower growing class divided by this.
+ */
+#define BENCHMARK_BIGO_MARGIN               1.5
+
+/**
+ * @brief The maximum number of concurrent iterations of `--test_repeat_until_fail`.
+ */
+#define REPEAT_MAX_JOBS                     64
+
+/**
+ * @brief Seed stride between iterations of `--test_repeat_until_fail`. It is
+ *   coprime to `MAX_RAND + 1`, so iterations do not share seeds.
+ */
+#define REPEAT_SEED_STRIDE                  7919
+
+/**
+ * @brief The maximum number of threads #cutest_benchmark_parallel() can use.
+ */
+#define BENCHMARK_MAX_THREADS               64
+
+/**
+ * @brief Size of builtin cache eviction buffer.
+ */
+#define BENCHMARK_EVICT_BUFFER_SIZE         (64 * 1024 * 1024)
+
+/**
+ * @brief Stride of cache eviction. Smaller than any real cache line.
+ */
+#define BENCHMARK_EVICT_CACHE_STRIDE        32
+
+/**
+ * @brief Stride of TLB eviction.
+ */
+#define BENCHMARK_EVICT_PAGE_STRIDE         4096
+
+/**
+ * @brief Address space walked by TLB eviction. More pages than any TLB.
+ */
+#define BENCHMARK_EVICT_TLB_SPAN            (64 * 1024 * 1024)
+
+/**
+ * @brief Minimum and maximum iterations of cold measurement.
+ */
+#define BENCHMARK_COLD_MIN_ITERATIONS       5
+#define BENCHMARK_COLD_MAX_ITERATIONS       1000
+
+/**
+ * @brief The number of slots of guard malloc. Each slot is one page, with
+ *   guard pages on both sides.
+ */
+#define GUARD_SLOT_COUNT                    256
+
+/**
+ * @brief Alignment of guarded allocation. Overflow smaller than it is not
+ *   detected.
+ */
+#define GUARD_ALIGNMENT                     16
+
+/**
+ * @brief Default value of `--test_guard_malloc`.
+ */
+#define GUARD_DEFAULT_SAMPLE_RATE           100
+
+/**
+ * @brief A failed parameterized instance is always sampled by
+ *   `--test_param_sample` in this many following runs.
+ */
+#define PARAM_SAMPLE_HISTORY_RUNS           20
+
+/**
+ * @brief The maximum number of fixtures marked by #TEST_FIXTURE_THREAD_SAFE().
+ */
+#define PIPELINE_MAX_FIXTURES               64
+
+/**
+ * @brief The maximum number of configurations in one autotune family.
+ */
+#define AUTOTUNE_MAX_CANDIDATES             256
+
+/**
+ * @brief Samples of each survivor in the first autotune round. It doubles
+ *   every round, up to #AUTOTUNE_MAX_ROUND_SAMPLES.
+ */
+#define AUTOTUNE_ROUND_SAMPLES              3
+#define AUTOTUNE_MAX_ROUND_SAMPLES          48
+
+/**
+ * @brief Rounds of performance assertion. The fastest round is used.
+ */
+#define PERF_ROUNDS                         5
+
+/**
+ * @brief Minimum time of one round of performance assertion, in nanoseconds.
+ */
+#define PERF_ROUND_MIN_NS                   (1 * 1000 * 1000)
+
+/**
+ * @brief Performance bounds are multiplied by this under sanitizers.
+ */
+#define PERF_RELAX_SANITIZER                10
+
+/**
+ * @brief Performance bounds are multiplied by this under Valgrind.
+ */
+#define PERF_RELAX_VALGRIND                 100
+
+/**
+ * @brief Histogram precision. Each power of two range is split into
+ *   `2^HIST_SUB_BUCKET_BITS` linear buckets, so the relative error is less
+ *   than `1/2^HIST_SUB_BUCKET_BITS`.
+ */
+#define HIST_SUB_BUCKET_BITS                5
+#define HIST_SUB_BUCKET_COUNT               (1UL << HIST_SUB_BUCKET_BITS)
+#define HIST_BUCKET_COUNT                   \
+    ((sizeof(unsigned long) * 8 - HIST_SUB_BUCKET_BITS + 1) * HIST_SUB_BUCKET_COUNT)
+
+/**
+ * @brief Threads record into different shards to reduce contention.
+ */
+#define HIST_SHARD_COUNT                    4
+
+/**
+ * @brief The maximum number of counters for each test.
+ */
+#define COUNTER_MAX                         16
+
+/**
+ * @brief Counter name longer than this is truncated.
+ */
+#define COUNTER_NAME_SIZE                   32
+
+/**
+ * @brief The maximum number of frames captured on failure.
+ */
+#define BACKTRACE_MAX_FRAMES                32
+
+/**
+ * @brief Limits of one request to test daemon.
+ */
+#define DAEMON_REQUEST_SIZE                 8192
+#define DAEMON_MAX_ARGS                     128
+
+/**
+ * @brief The maximum number of modules given by `--test_load` and `--test_watch`.
+ */
+#define MODULE_MAX_COUNT                    32
+
+/**
+ * @brief The maximum length of module name, which prefixes its cases.
+ */
+#define MODULE_NAME_SIZE                    64
+
+/**
+ * @brief Space for names of failed cases of one module, which run first after
+ *   reload.
+ */
+#define MODULE_FAILED_SIZE                  4096
+
+/**
+ * @brief Wait until no more change for this long before reload, as linkers
+ *   write in several steps.
+ */
+#define WATCH_SETTLE_MS                     100
+
+/**
+ * @brief The maximum number of files mapped by #cutest_resource_map().
+ */
+#define RESOURCE_MAX_COUNT                  64
+
+#define CONTAINER_OF(ptr, TYPE, member) \
+    ((TYPE*)((char*)(ptr) - (char*)&((TYPE*)0)->member))
+
+/**
+ * @brief Create compare context for \p TYPE.
+ * @param[in] TYPE  Data type.
+ */
+#define TEST_GENERATE_NATIVE_COMPARE(NAME, TYPE)  \
+    TEST_GENERATE_TEMPLATE_COMPARE(NAME, TYPE, _cutest_smart_print_int)
+
+#define TEST_GENERATE_TEMPLATE_COMPARE(NAME, TYPE, PRINT)   \
+    static int _test_cmp_##NAME(TYPE* addr1, TYPE* addr2) {\
+        TYPE v1 = *addr1;\
+        TYPE v2 = *addr2;\
+        if (v1 == v2) {\
+            return 0;\
+        }\
+        return v1 < v2 ? -1 : 1;\
+    }\
+    static int _test_print_##NAME(FILE* file, TYPE* addr) {\
+        int is_signed = ((TYPE)(-1)) < ((TYPE)1);\
+        return PRINT(file, addr, sizeof(TYPE), is_signed);\
+    }\
+    static cutest_type_info_t NAME = {\
+        { NULL, NULL, NULL }, #TYPE,\
+        (cutest_custom_type_cmp_fn)_test_cmp_##NAME,\
+        (cutest_custom_type_dump_fn)_test_print_##NAME,\
+    }
+
+typedef struct test_case_info
+{
+    char                        fmt_name[256];  /**< Formatted name. */
+    unsigned long               fmt_name_sz;    /**< The length of formatted name, not include NULL termainator. */
+
+    cutest_case_t*              test_case;      /**< Test case. */
+
+    cutest_porting_timespec_t   tv_case_beg;    /**< Start time. */
+    cutest_porting_timespec_t   tv_case_end;    /**< End time. */
+} test_case_info_t;
+
+typedef struct fixture_run_helper
+{
+    test_case_info_t*           info;
+    int                         ret;
+} fixture_run_helper_t;
+
+typedef struct test_case_helper
+{
+    test_case_info_t*           info;
+    int                         ret;
+} test_case_helper_t;
+
+typedef struct test_run_parameterized_helper
+{
+    test_case_info_t*           info;
+} test_run_parameterized_helper_t;
+
+typedef struct test_ctx
+{
+    cutest_map_t                    case_table;                     /**< Cases in map */
+    cutest_map_t                    type_table;                     /**< Type table. */
+
+    struct
+    {
+        void*                       tid;                            /**< Thread ID */
+        cutest_case_t*              cur_node;                       /**< Current running test case node. */
+        unsigned long               seed;                           /**< `--test_random_seed` of current run. */
+    } runtime;
+
+    struct
+    {
+        struct
+        {
+            unsigned                total;                          /**< The number of total running cases */
+            unsigned                disabled;                       /**< The number of disabled cases */
+            unsigned                success;                        /**< The number of success cases */
+            unsigned                skipped;                        /**< The number of skipped cases */
+            unsigned                failed;                         /**< The number of failed cases */
+        } result;
+
+        struct
+        {
+            unsigned long           repeat;                         /**< How many times need to repeat */
+            unsigned long           repeated;                       /**< How many times already repeated */
+            unsigned long           until_fail;                     /**< `--test_repeat_until_fail`, 0 if disabled. */
+            unsigned                jobs;                           /**< `--test_repeat_jobs`, 0 for CPU count. */
+        } repeat;
+    } counter;
+
+    struct
+    {
+        test_str_t                  pattern;                         /**< `--test_filter` */
+    } filter;
+
+    struct
+    {
+        unsigned                    break_on_failure : 1;           /**< DebugBreak when failure */
+        unsigned                    no_print_time : 1;              /**< Whether to print execution cost time */
+        unsigned                    also_run_disabled_tests : 1;    /**< Also run disabled tests */
+        unsigned                    shuffle : 1;                    /**< Randomize running cases */
+        unsigned                    benchmark_priority : 1;         /**< Raise priority when measuring */
+        unsigned                    benchmark_isolate : 1;          /**< Run each test in a child process */
+        unsigned                    benchmark_cold_cache : 1;       /**< Also measure with cold cache */
+        unsigned                    benchmark_cold_tlb : 1;         /**< Also evict TLB in cold measurement */
+        unsigned                    autotune : 1;                   /**< Tune parameterized benchmarks */
+        unsigned                    backtrace : 1;                  /**< Capture backtrace on failure */
+        unsigned                    list_tests : 1;                 /**< List tests after loading modules */
+    } mask;
+
+    struct
+    {
+        cutest_porting_jmpbuf_t*    addr;                           /**< Jump address. */
+        cutest_porting_longjmp_fn   func;                           /**< Long jump function. */
+    } jmp;
+
+    struct
+    {
+        unsigned long               min_time_ms;                    /**< `--test_benchmark_min_time` */
+        unsigned long               repetitions;                    /**< `--test_benchmark_repetitions` */
+        int                         running;                        /**< Whether #TEST_BENCHMARK_LOOP is running. */
+        unsigned long               batch;                          /**< Iterations in current batch. */
+        unsigned long               done;                           /**< Finished iterations in current batch. */
+        cutest_porting_timespec_t   tv_beg;                         /**< Start time of current batch. */
+        unsigned long               repeated;                       /**< Finished repetitions. */
+        double                      sum_ns_per_op;                  /**< Sum of ns/op of finished repetitions. */
+        double                      calibration_ns_per_op;          /**< ns/op of last long enough calibration batch, 0 if none. */
+        unsigned long               samples;                        /**< The number of samples for spread. */
+        double                      sample_min;                     /**< The minimum ns/op sample. */
+        double                      sample_max;                     /**< The maximum ns/op sample. */
+        int                         env_checked;                    /**< Whether environment is checked. */
+        int                         pinned;                         /**< Whether current thread is pinned. */
+        int                         prioritized;                    /**< Whether priority is raised. */
+        int                         isolate_warned;                 /**< Whether isolation failure is reported. */
+        double                      total_ns;                       /**< Time of all measurements in current test. */
+        double                      total_iterations;               /**< Iterations of all measurements in current test. */
+        unsigned                    threads;                        /**< Threads of last measurement. */
+        int                         cold;                           /**< Whether measuring with cold cache. */
+        unsigned long               cold_done;                      /**< Finished cold iterations. */
+        double                      cold_sum_ns;                    /**< Sum of cold iteration time. */
+        cutest_porting_timespec_t   tv_cold_beg;                    /**< Start time of cold measurement. */
+        int                         evict_warned;                   /**< Whether eviction buffer size is checked. */
+        const char*                 autotune_output;                /**< `--test_autotune_output` */
+    } benchmark;
+
+    struct
+    {
+        unsigned long               sample_rate;                    /**< `--test_guard_malloc`, 0 if disabled. */
+        int                         installed;                      /**< Whether fault handler is installed. */
+    } guard;
+
+    struct
+    {
+        const char*                 path;                           /**< `--test_monitor` */
+        cutest_monitor_board_t*     board;                          /**< Status board, NULL if not published. */
+        unsigned                    worker;                         /**< Our slot on status board. */
+    } monitor;
+
+    struct
+    {
+        const char*                 path;                           /**< `--test_flight_recorder` */
+        cutest_flight_recorder_t*   recorder;                       /**< NULL if not recording. */
+        const char*                 assert_file;                    /**< File name last copied to recorder, guarded by its `seq`. */
+    } flight;
+
+    struct
+    {
+        const char*                 path;                           /**< `--test_daemon` */
+    } daemon;
+
+    struct
+    {
+        int                         running;                        /**< Whether performance assertion is measuring. */
+        unsigned long               batch;                          /**< Iterations in current round. */
+        unsigned long               done;                           /**< Finished iterations in current round. */
+        unsigned                    rounds;                         /**< Finished rounds. */
+        double                      best;                           /**< Fastest ns/op of finished rounds. */
+        cutest_porting_timespec_t   tv_beg;                         /**< Start time of current round. */
+    } perf;
+
+    FILE*                           out;
+    const cutest_hook_t*            hook;
+} test_ctx_t;
+
+static int _cutest_on_cmp_case(const cutest_map_node_t* key1, const cutest_map_node_t* key2, void* arg)
+{
+    (void)arg;
+    int ret;
+
+    cutest_case_t* t1 = CONTAINER_OF(key1, cutest_case_t, node);
+    cutest_case_t* t2 = CONTAINER_OF(key2, cutest_case_t, node);
+
+    /* randkey always go first. */
+    if (t1->data.randkey < t2->data.randkey)
+    {
+        return -1;
+    }
+    if (t1->data.randkey > t2->data.randkey)
+    {
+        return 1;
+    }
+
+    /* Built in cases go first, then cases of each module. */
+    if (t1->info.module_name != t2->info.module_name)
+    {
+        if (t1->info.module_name == NULL || t2->info.module_name == NULL)
+        {
+            return t1->info.module_name == NULL ? -1 : 1;
+        }
+        if ((ret = cutest_porting_strcmp(t1->info.module_name, t2->info.module_name)) != 0)
+        {
+            return ret;
+        }
+    }
+
+    if ((ret = cutest_porting_strcmp(t1->info.fixture_name, t2->info.fixture_name)) != 0)
+    {
+        return ret;
+    }
+
+    if ((ret = cutest_porting_strcmp(t1->info.case_name, t2->info.case_name)) != 0)
+    {
+        return ret;
+    }
+
+    if (t1->parameterized.param_idx == t2->parameterized.param_idx)
+    {
+        return 0;
+    }
+    return t1->parameterized.param_idx < t2->parameterized.param_idx ? -1 : 1;
+}
+
+static int _cutest_on_cmp_type(const cutest_map_node_t* key1, const cutest_map_node_t* key2, void* arg)
+{
+    (void)arg;
+    cutest_type_info_t* t1 = CONTAINER_OF(key1, cutest_type_info_t, node);
+    cutest_type_info_t* t2 = CONTAINER_OF(key2, cutest_type_info_t, node);
+
+    return cutest_porting_strcmp(t1->type_name, t2->type_name);
+}
+
+static test_ctx_t g_test_ctx = {
+    CUTEST_MAP_INIT(_cutest_on_cmp_case, NULL),                         /* .case_table */
+    CUTEST_MAP_INIT(_cutest_on_cmp_type, NULL),                         /* .type_table */
+    { NULL, NULL, 0 },                                                  /* .runtime */
+    { { 0, 0, 0, 0, 0 }, { 0, 0, 0, 0 } },                              /* .counter */
+    { { NULL, 0 } },                                                    /* .filter */
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },                                /* .mask */
+    { NULL, NULL },                                                     /* .jmp */
+    { 0, 0, 0, 0, 0, { 0, 0 }, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, { 0, 0 }, 0, NULL },                                   /* .benchmark */
+    { 0, 0 },                                                           /* .guard */
+    { NULL, NULL, 0 },                                                  /* .monitor */
+    { NULL, NULL, NULL },                                               /* .flight */
+    { NULL },                                                           /* .daemon */
+    { 0, 0, 0, 0, 0, { 0, 0 } },                                        /* .perf */
+    NULL,                                                               /* .out */
+    NULL,                                                               /* .hook */
+};
+
+static const char* s_test_help_encoded =
+"This program contains tests written using cutest. You can use the\n"
+"following command line flags to control its behavior:\n"
+"\n"
+"Test Selection:\n"
+"  " COLOR_GREEN("--test_list_tests") "\n"
+"      List the names of all tests instead of running them. The name of\n"
+"      TEST(Foo, Bar) is \"Foo.Bar\".\n"
+"  " COLOR_GREEN("--test_list_types") "\n"
+"      List the names of all support types.\n"
+"  " COLOR_GREEN("--test_filter=") COLOR_YELLO("POSTIVE_PATTERNS[") COLOR_GREEN("-") COLOR_YELLO("NEGATIVE_PATTERNS]") "\n"
+"      Run only the tests whose name matches one of the positive patterns but\n"
+"      none of the negative patterns. '?' matches any single character; '*'\n"
+"      matches any substring; ':' separates two patterns.\n"
+"  " COLOR_GREEN("--test_also_run_disabled_tests") "\n"
+"      Run all disabled tests too.\n"
+"  " COLOR_GREEN("--test_load=") COLOR_YELLO("[PATH]") "\n"
+"      Also run tests from shared library PATH. They are named after the\n"
+"      library, e.g. \"foo.Foo.Bar\" for TEST(Foo, Bar) in libfoo.so. Build it\n"
+"      with hidden visibility if it shares test names with this program. Can\n"
+"      be given more than once.\n"
+"  " COLOR_GREEN("--test_param_sample=") COLOR_YELLO("[COUNT|PERCENT%]") "\n"
+"      Run only COUNT instances, or PERCENT% of instances, of each\n"
+"      parameterized test. The sample depends on --test_random_seed. With\n"
+"      --test_param_history the seed of the first run is kept and the sample\n"
+"      moves on every run, so all instances are covered over successive runs.\n"
+"  " COLOR_GREEN("--test_param_sample_shard=") COLOR_YELLO("[INDEX/TOTAL]") "\n"
+"      This is shard INDEX of TOTAL shards running the same sampled run. Each\n"
+"      shard takes a different sample, if all shards use the same seed.\n"
+"  " COLOR_GREEN("--test_param_history=") COLOR_YELLO("[PATH]") "\n"
+"      Count runs and remember failed instances in file PATH. Instances failed\n"
+"      in the last " TEST_STRINGIFY(PARAM_SAMPLE_HISTORY_RUNS) " runs are always sampled.\n"
+"\n"
+"Test Execution:\n"
+"  " COLOR_GREEN("--test_repeat=") COLOR_YELLO("[COUNT]") "\n"
+"      Run the tests repeatedly; use a negative count to repeat forever.\n"
+"  " COLOR_GREEN("--test_repeat_until_fail=") COLOR_YELLO("[COUNT]") "\n"
+"      Run the tests up to COUNT times in concurrent child processes, each\n"
+"      with its own random seed, and stop all of them at the first failure.\n"
+"      Output and seed of the failed iteration are printed, run it again with\n"
+"      --test_random_seed to reproduce.\n"
+"  " COLOR_GREEN("--test_repeat_jobs=") COLOR_YELLO("[NUMBER]") "\n"
+"      Number of concurrent iterations of --test_repeat_until_fail. By default\n"
+"      it is the number of CPUs.\n"
+"  " COLOR_GREEN("--test_shuffle") "\n"
+"      Randomize tests' orders on every iteration.\n"
+"  " COLOR_GREEN("--test_random_seed=") COLOR_YELLO("[NUMBER]") "\n"
+"      Random number seed to use for shuffling test orders (between 0 and\n"
+"      " TEST_STRINGIFY(MAX_RAND) ". By default a seed based on the current time is used for shuffle).\n"
+"  " COLOR_GREEN("--test_watch=") COLOR_YELLO("[PATH]") "\n"
+"      Like --test_load, and after the run, run tests of PATH again, failed\n"
+"      ones first, whenever it is rebuilt. Can be given more than once.\n"
+"  " COLOR_GREEN("--test_daemon=") COLOR_YELLO("[PATH]") "\n"
+"      Run global setup once, then serve cutest_client on Unix domain socket\n"
+"      PATH. Each request runs in a child process forked from the ready\n"
+"      state, with the arguments and output of the client. Requests are\n"
+"      served one at a time. An existing socket at PATH is replaced, any other\n"
+"      file is kept and the daemon is not started.\n"
+"  " COLOR_GREEN("--test_resource_dir=") COLOR_YELLO("[DIR]") "\n"
+"      Look for files of cutest_resource_map() in DIR instead of current\n"
+"      directory.\n"
+"  " COLOR_GREEN("--test_resource_preload=") COLOR_YELLO("[NAME]") "\n"
+"      Map resource NAME before running any test, so child processes share\n"
+"      it. Can be given more than once.\n"
+"  " COLOR_GREEN("--test_resource_prefetch") "\n"
+"      Read whole resource files into memory when they are mapped.\n"
+"\n"
+"Benchmark:\n"
+"  " COLOR_GREEN("--test_benchmark_min_time=") COLOR_YELLO("[MS]") "\n"
+"      Minimum time in milliseconds to measure each benchmark (default\n"
+"      " TEST_STRINGIFY(BENCHMARK_DEFAULT_MIN_TIME_MS) ").\n"
+"  " COLOR_GREEN("--test_benchmark_repetitions=") COLOR_YELLO("[COUNT]") "\n"
+"      Measure each benchmark COUNT times and report the average and spread.\n"
+"  " COLOR_GREEN("--test_benchmark_priority") "\n"
+"      Raise the priority of the benchmark thread while measuring.\n"
+"  " COLOR_GREEN("--test_benchmark_isolate") "\n"
+"      Run each test in a fresh child process, so heap and cache state of\n"
+"      previous tests does not affect the result. Hooks are called in the\n"
+"      child process.\n"
+"  " COLOR_GREEN("--test_benchmark_cold_cache") "\n"
+"      After the normal (warm) measurement, also measure single iterations\n"
+"      with CPU caches evicted before each one, and report both results.\n"
+"  " COLOR_GREEN("--test_benchmark_cold_tlb") "\n"
+"      Like --test_benchmark_cold_cache, and also evict TLB entries.\n"
+"  " COLOR_GREEN("--test_autotune") "\n"
+"      Find the fastest instance of each parameterized benchmark by\n"
+"      successive halving: survivors are measured again and again, and the\n"
+"      slower half is dropped every round.\n"
+"  " COLOR_GREEN("--test_autotune_output=") COLOR_YELLO("[PATH]") "\n"
+"      Also write the best configurations to PATH as `key=value' lines.\n"
+"\n"
+"Memory Check:\n"
+"  " COLOR_GREEN("--test_guard_malloc") COLOR_YELLO("[=N]") "\n"
+"      Place one of every N allocations made by cutest_guard_malloc() in a\n"
+"      test against inaccessible pages, and keep freed ones inaccessible for a\n"
+"      while. Overflow and use after free fail the test (default N is\n"
+"      " TEST_STRINGIFY(GUARD_DEFAULT_SAMPLE_RATE) ", use 1 to check every allocation).\n"
+"\n"
+"Test Output:\n"
+"  " COLOR_GREEN("--test_print_time=") COLOR_YELLO("(") COLOR_GREEN("0") COLOR_YELLO("|") COLOR_GREEN("1") COLOR_YELLO(")") "\n"
+"      Don't print the elapsed time of each test.\n"
+"  " COLOR_GREEN("--test_monitor=") COLOR_YELLO("[PATH]") "\n"
+"      Publish running cases and results to a status board in file PATH\n"
+"      (e.g. under /dev/shm), which can be watched by cutest_top.\n"
+"  " COLOR_GREEN("--test_flight_recorder=") COLOR_YELLO("[PATH]") "\n"
+"      Keep recent events in file PATH, so `cutest_top --flight=PATH' can\n"
+"      tell what was running after the program died.\n"
+"\n"
+"Assertion Behavior:\n"
+"  " COLOR_GREEN("--test_break_on_failure") "\n"
+"      Turn assertion failures into debugger break-points.\n"
+"  " COLOR_GREEN("--test_backtrace") "\n"
+"      Capture a backtrace on assertion failure. Symbols are resolved when the\n"
+"      result is printed, together with module offsets and build-id for\n"
+"      offline symbolization.\n"
+;
+
+/**
+ * @brief Check if `str` match `pat`
+ * @return bool
+ */
+static int _cutest_pattern_match(const char* pat, unsigned long pat_sz,
+    const char* str, unsigned long str_sz)
+{
+    const char* name = str;
+    const char* const name_begin = name;
+    const char* const name_end = name + str_sz;
+
+    const char* pattern = pat;
+    const char* pattern_end = pat + pat_sz;
+    const char* pattern_next = pattern;
+    const char* name_next = name;
+
+    while (pattern < pattern_end || name < name_end)
+    {
+        if (pattern < pattern_end)
+        {
+            switch (*pattern)
+            {
+            default:  // Match an ordinary character.
+                if (name < name_end && *name == *pattern)
+                {
+                    ++pattern;
+                    ++name;
+                    continue;
+                }
+                break;
+            case '?':  // Match any single character.
+                if (name < name_end)
+                {
+                    ++pattern;
+                    ++name;
+                    continue;
+                }
+                break;
+            case '*':
+                // Match zero or more characters. Start by skipping over the wildcard
+                // and matching zero characters from name. If that fails, restart and
+                // match one more character than the last attempt.
+                pattern_next = pattern;
+                name_next = name + 1;
+                ++pattern;
+                continue;
+            }
+        }
+        // Failed to match a character. Restart if possible.
+        if (name_begin < name_next && name_next <= name_end)
+        {
+            pattern = pattern_next;
+            name = name_next;
+            continue;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @return true if this test will run, false if not.
+ */
+static int _cutest_check_pattern(const char* str, unsigned long str_sz)
+{
+    test_str_t k, v = g_test_ctx.filter.pattern;
+
+    /* If no pattern, run this test. */
+    if (v.ptr == NULL)
+    {
+        return 1;
+    }
+
+    unsigned long cnt_positive_patterns = 0;
+    int flag_match_positive_pattern = 0;
+
+    /* Split patterns by `:` */
+    while (_cutest_str_split(&v, &k, &v, ":", 0) == 0)
+    {
+        /* If it is a positive pattern. */
+        if (k.ptr[0] != '-')
+        {
+            cnt_positive_patterns++;
+
+            /* Record if it match any of positive pattern */
+            if (_cutest_pattern_match(k.ptr, k.len, str, str_sz))
+            {
+                flag_match_positive_pattern = 1;
+            }
+        }
+        else if (_cutest_pattern_match(k.ptr + 1, k.len - 1, str, str_sz))
+        {/* If match negative pattern, don't run. */
+            return 0;
+        }
+    }
+    if (v.ptr[0] != '-')
+    {
+        cnt_positive_patterns++;
+        if (_cutest_pattern_match(v.ptr, v.len, str, str_sz))
+        {
+            flag_match_positive_pattern = 1;
+        }
+    }
+    else if (_cutest_pattern_match(v.ptr + 1, v.len - 1, str, str_sz))
+    {
+        return 0;
+    }
+
+    return cnt_positive_patterns ? flag_match_positive_pattern : 1;
+}
+
+/**
+ * @return bool
+ */
+static int _cutest_check_disable(const char* name)
+{
+    return !g_test_ctx.mask.also_run_disabled_tests &&
+        (cutest_porting_strncmp("DISABLED_", name, 9) == 0);
+}
+
+static int _cutest_print_encoded(const char* str)
+{
+    int ret = 0;
+    cutest_porting_color_t color = CUTEST_COLOR_DEFAULT;
+
+    for (;;)
+    {
+        const char* p = cutest_porting_strchr(str, '@');
+        if (p == NULL)
+        {
+            ret += cutest_porting_cfprintf(g_test_ctx.out, color, "%s", str);
+            return ret;
+        }
+
+        ret += cutest_porting_cfprintf(g_test_ctx.out, color, "%.*s",
+            (int)(p - str), str);
+
+        const char ch = p[1];
+        str = p + 2;
+
+        switch (ch)
+        {
+        case '@':
+            ret += cutest_porting_cfprintf(g_test_ctx.out, color, "@");
+            break;
+        case 'D':
+            color = 0;
+            break;
+        case 'R':
+            color = CUTEST_COLOR_RED;
+            break;
+        case 'G':
+            color = CUTEST_COLOR_GREEN;
+            break;
+        case 'Y':
+            color = CUTEST_COLOR_YELLOW;
+            break;
+        default:
+            --str;
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Copy \p src to flight recorder, keep the tail if too long, which is
+ *   the interesting part of file path.
+ */
+static void _cutest_flight_copy_name(char* dst, const char* src, int keep_tail)
+{
+    unsigned long len = cutest_porting_strlen(src);
+    if (len >= CUTEST_FLIGHT_NAME_SIZE)
+    {
+        if (keep_tail)
+        {
+            src += len - (CUTEST_FLIGHT_NAME_SIZE - 1);
+        }
+        len = CUTEST_FLIGHT_NAME_SIZE - 1;
+    }
+    cutest_porting_memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+/**
+ * @brief Record an event in flight recorder.
+ * @param[in] name - Can be NULL.
+ */
+static void _cutest_flight_record(unsigned long type, unsigned long data, const char* name)
+{
+    cutest_flight_recorder_t* recorder = g_test_ctx.flight.recorder;
+    if (recorder == NULL)
+    {
+        return;
+    }
+
+    /* Helper threads of pipelined fixtures record too. */
+    unsigned long pos = (unsigned long)cutest_atomic_add(&recorder->head, 1) - 1;
+    cutest_flight_event_t* event = &recorder->events[pos % CUTEST_FLIGHT_EVENTS];
+
+    event->seq = 0;
+    cutest_shm_fence();
+
+    cutest_porting_timespec_t tv;
+    cutest_porting_clock_gettime(&tv);
+    event->type = type;
+    event->data = data;
+    event->tv_sec = (unsigned long)tv.tv_sec;
+    event->tv_nsec = (unsigned long)tv.tv_nsec;
+    if (name != NULL)
+    {
+        _cutest_flight_copy_name(event->name, name, type == CUTEST_FLIGHT_FAILURE);
+    }
+    else
+    {
+        event->name[0] = '\0';
+    }
+
+    cutest_shm_fence();
+    event->seq = pos + 1;
+}
+
+static void _cutest_hook_before_fixture_setup(cutest_case_t* test_case)
+{
+    if (g_test_ctx.hook == NULL || g_test_ctx.hook->before_setup == NULL)
+    {
+        return;
+    }
+    g_test_ctx.hook->before_setup(test_case->info.fixture_name);
+}
+
+static void _cutest_hook_after_fixture_setup(cutest_case_t* test_case, int ret)
+{
+    if (g_test_ctx.hook == NULL || g_test_ctx.hook->after_setup == NULL)
+    {
+        return;
+    }
+    g_test_ctx.hook->after_setup(test_case->info.fixture_name, ret);
+}
+
+typedef struct test_backtrace
+{
+    void*                           frames[BACKTRACE_MAX_FRAMES];   /**< Return addresses, innermost first. */
+    unsigned                        size;                           /**< The number of frames. */
+} test_backtrace_t;
+
+/**
+ * @brief Raw backtrace of the failure in current test. It is symbolized only
+ *   when the result is shown.
+ */
+static test_backtrace_t s_test_backtrace;
+
+/**
+ * @brief Stack of the runner right before it calls into test code. The frames
+ *   a failure shares with it are cutest internals.
+ */
+static test_backtrace_t s_test_backtrace_base;
+
+/**
+ * @brief Remember where test code is entered, so _cutest_backtrace_capture()
+ *   can drop the runner frames below it.
+ */
+static void _cutest_backtrace_mark(void)
+{
+    if (g_test_ctx.mask.backtrace)
+    {
+        s_test_backtrace_base.size = cutest_backtrace_capture(s_test_backtrace_base.frames, BACKTRACE_MAX_FRAMES);
+    }
+}
+
+/**
+ * @brief Capture backtrace of current failure.
+ * @param[in] caller - Return address of the assertion function. Frames inside
+ *   cutest are dropped so the first frame is where assertion failed, and the
+ *   last one is the test body, fixture setup or teardown.
+ */
+static void _cutest_backtrace_capture(const void* caller)
+{
+    test_backtrace_t* backtrace = &s_test_backtrace;
+    backtrace->size = cutest_backtrace_capture(backtrace->frames, BACKTRACE_MAX_FRAMES);
+
+    unsigned i;
+    for (i = 0; caller != NULL && i < backtrace->size; i++)
+    {
+        if (backtrace->frames[i] == caller)
+        {
+            backtrace->size -= i;
+            cutest_porting_memmove(backtrace->frames, backtrace->frames + i,
+                sizeof(backtrace->frames[0]) * backtrace->size);
+            break;
+        }
+    }
+
+    /* Drop the common runner frames, and the one that called into the test. */
+    const test_backtrace_t* base = &s_test_backtrace_base;
+    unsigned common = 0;
+    while (common < backtrace->size && common < base->size
+        && backtrace->frames[backtrace->size - 1 - common] == base->frames[base->size - 1 - common])
+    {
+        common++;
+    }
+    if (common > 0 && common + 1 < backtrace->size)
+    {
+        backtrace->size -= common + 1;
+    }
+}
+
+/**
+ * @brief Context of current thread.
+ *
+ * Assertions in fixture stage running on helper thread jump back by it, and
+ * #cutest_get_current_test() reports the case of the stage.
+ */
+typedef struct test_thread_ctx
+{
+    cutest_case_t*              cur_node;   /**< Case of the stage. */
+    cutest_porting_jmpbuf_t*    addr;       /**< Jump address. */
+    cutest_porting_longjmp_fn   func;       /**< Long jump function. */
+    FILE*                       out;        /**< Output of the stage, NULL to write #g_test_ctx. */
+
+    /**
+     * Guard malloc failure of this thread. Filled by the fault handler and
+     * printed once the test has jumped back, as stdio is not async-signal-safe.
+     */
+    struct
+    {
+        const char*             what;       /**< NULL if nothing to report. */
+        const char*             addr;       /**< Faulting address. */
+        const char*             ptr;        /**< Nearest guarded region. */
+        unsigned long           size;       /**< Size of that region. */
+    } guard_fault;
+} test_thread_ctx_t;
+
+static CUTEST_THREAD_LOCAL test_thread_ctx_t s_test_thread_ctx;
+
+static cutest_case_t* _cutest_current_case(void)
+{
+    return s_test_thread_ctx.cur_node != NULL ? s_test_thread_ctx.cur_node : g_test_ctx.runtime.cur_node;
+}
+
+/**
+ * @brief Output of current thread. Fixture stages on helper threads write
+ *   their own, so their messages are printed next to their case.
+ */
+static FILE* _cutest_out(void)
+{
+    return s_test_thread_ctx.out != NULL ? s_test_thread_ctx.out : g_test_ctx.out;
+}
+
+/**
+ * @brief Print a `[ WARNING  ]` line. Used for anything that degrades a run
+ *   without failing it.
+ */
+static void _cutest_warning(const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW, "[ WARNING  ]");
+    cutest_porting_fprintf(g_test_ctx.out, " ");
+    cutest_porting_vfprintf(g_test_ctx.out, fmt, ap);
+    va_end(ap);
+}
+
+/**
+ * @brief Print the guard malloc failure recorded for current thread, if any.
+ */
+static void _cutest_guard_report(void)
+{
+    const char* what = s_test_thread_ctx.guard_fault.what;
+    if (what == NULL)
+    {
+        return;
+    }
+    s_test_thread_ctx.guard_fault.what = NULL;
+
+    FILE* out = _cutest_out();
+    const char* name = cutest_get_current_test();
+    const char* p = s_test_thread_ctx.guard_fault.addr;
+    const char* ptr = s_test_thread_ctx.guard_fault.ptr;
+    unsigned long size = s_test_thread_ctx.guard_fault.size;
+
+    cutest_porting_fprintf(out, "%s.%s:guard malloc failure:\n",
+        name != NULL ? cutest_get_current_fixture() : "", name != NULL ? name : "");
+    if (p >= ptr && p < ptr + size)
+    {
+        cutest_porting_fprintf(out,
+            "            %s: address %p is %lu bytes inside of %lu-byte region %p\n",
+            what, (void*)p, (unsigned long)(p - ptr), size, (void*)ptr);
+    }
+    else if (p >= ptr + size)
+    {
+        cutest_porting_fprintf(out,
+            "            %s: address %p is %lu bytes after %lu-byte region %p\n",
+            what, (void*)p, (unsigned long)(p - ptr - size), size, (void*)ptr);
+    }
+    else
+    {
+        cutest_porting_fprintf(out,
+            "            %s: address %p is %lu bytes before %lu-byte region %p\n",
+            what, (void*)p, (unsigned long)(ptr - p), size, (void*)ptr);
+    }
+}
+
+static void _cutest_run_case_set_jmp(cutest_porting_jmpbuf_t* buf,
+                                     cutest_porting_longjmp_fn fn_longjmp)
+{
+    _cutest_guard_report();
+    g_test_ctx.jmp.addr = buf;
+    g_test_ctx.jmp.func = fn_longjmp;
+}
+
+static void _cutest_fixture_run_setup_jmp(cutest_porting_jmpbuf_t* buf,
+    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
+{
+    fixture_run_helper_t* helper = data;
+    test_case_info_t* info = helper->info;
+
+    _cutest_run_case_set_jmp(buf, fn_longjmp);
+
+    if (val != 0)
+    {
+        SET_MASK(info->test_case->data.mask, val);
+        goto after_setup;
+    }
+
+    _cutest_hook_before_fixture_setup(info->test_case);
+    _cutest_flight_record(CUTEST_FLIGHT_SETUP, 0, NULL);
+    _cutest_backtrace_mark();
+    info->test_case->stage.setup();
+
+after_setup:
+    _cutest_hook_after_fixture_setup(info->test_case, val);
+    helper->ret = val;
+}
+
+/**
+ * @brief Run setup stage.
+ * @param[in] test_case The test case to run.
+ * @return              0 if success, otherwise failure.
+ */
+static int _cutest_fixture_run_setup(test_case_info_t* info)
+{
+    if (info->test_case->stage.setup == NULL)
+    {
+        return 0;
+    }
+
+    fixture_run_helper_t helper = { info, 0 };
+    cutest_porting_setjmp(_cutest_fixture_run_setup_jmp, &helper);
+    return helper.ret;
+}
+
+static void _cutest_hook_before_test(test_case_info_t* info)
+{
+    cutest_case_t* test_case = info->test_case;
+    if (g_test_ctx.hook == NULL || g_test_ctx.hook->before_test == NULL)
+    {
+        return;
+    }
+
+    unsigned long fixture_sz = cutest_porting_strlen(test_case->info.fixture_name);
+    g_test_ctx.hook->before_test(test_case->info.fixture_name, info->fmt_name + fixture_sz);
+}
+
+static void _cutest_hook_after_test(test_case_info_t* info, int ret)
+{
+    cutest_case_t* test_case = info->test_case;
+    if (g_test_ctx.hook == NULL || g_test_ctx.hook->after_test == NULL)
+    {
+        return;
+    }
+
+    unsigned long fixture_sz = cutest_porting_strlen(test_case->info.fixture_name);
+    g_test_ctx.hook->after_test(test_case->info.fixture_name, info->fmt_name + fixture_sz, ret);
+}
+
+static void _cutest_hook_before_teardown(cutest_case_t* test_case)
+{
+    if (g_test_ctx.hook == NULL || g_test_ctx.hook->before_teardown == NULL)
+    {
+        return;
+    }
+
+    g_test_ctx.hook->before_teardown(test_case->info.fixture_name);
+}
+
+static void _cutest_hook_after_teardown(cutest_case_t* test_case, int ret)
+{
+    if (g_test_ctx.hook == NULL || g_test_ctx.hook->after_teardown == NULL)
+    {
+        return;
+    }
+    g_test_ctx.hook->after_teardown(test_case->info.fixture_name, ret);
+}
+
+static void _cutest_hook_before_all_test(int argc, char* argv[])
+{
+    if (g_test_ctx.hook == NULL || g_test_ctx.hook->before_all_test == NULL)
+    {
+        return;
+    }
+    g_test_ctx.hook->before_all_test(argc, argv);
+}
+
+static void _cutest_hook_after_all_test(void)
+{
+    if (g_test_ctx.hook == NULL || g_test_ctx.hook->after_all_test == NULL)
+    {
+        return;
+    }
+    g_test_ctx.hook->after_all_test();
+}
+
+static void _cutest_fixture_run_teardown_jmp(cutest_porting_jmpbuf_t* buf,
+    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
+{
+    test_case_info_t* info = data;
+
+    _cutest_run_case_set_jmp(buf, fn_longjmp);
+
+    if (val != 0)
+    {
+        SET_MASK(info->test_case->data.mask, val);
+        goto after_teardown;
+    }
+
+    _cutest_hook_before_teardown(info->test_case);
+    _cutest_flight_record(CUTEST_FLIGHT_TEARDOWN, 0, NULL);
+    _cutest_backtrace_mark();
+    info->test_case->stage.teardown();
+
+after_teardown:
+    _cutest_hook_after_teardown(info->test_case, val);
+}
+
+static void _cutest_fixture_run_teardown(test_case_info_t* info)
+{
+    if (info->test_case->stage.teardown == NULL)
+    {
+        return;
+    }
+
+    cutest_porting_setjmp(_cutest_fixture_run_teardown_jmp, info);
+}
+
+typedef struct test_hist_shard
+{
+    volatile long                   counts[HIST_BUCKET_COUNT];      /**< Count of each bucket. */
+    volatile long                   total;                          /**< Count of all records. */
+    volatile long                   max;                            /**< Maximum value, as unsigned long. */
+} test_hist_shard_t;
+
+typedef struct test_hist
+{
+    test_hist_shard_t               shards[HIST_SHARD_COUNT];
+    volatile long                   dirty;                          /**< Whether anything is recorded. */
+} test_hist_t;
+
+/**
+ * @brief Histogram of current test.
+ */
+static test_hist_t s_test_hist;
+
+static unsigned _cutest_hist_msb(unsigned long val)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)(sizeof(val) * 8 - 1 - __builtin_clzl(val));
+#else
+    unsigned msb = 0;
+    while (val >>= 1)
+    {
+        msb++;
+    }
+    return msb;
+#endif
+}
+
+static unsigned long _cutest_hist_index(unsigned long val)
+{
+    if (val < HIST_SUB_BUCKET_COUNT)
+    {
+        return val;
+    }
+
+    /* Keep the highest `HIST_SUB_BUCKET_BITS + 1` bits. */
+    unsigned shift = _cutest_hist_msb(val) - HIST_SUB_BUCKET_BITS;
+    return HIST_SUB_BUCKET_COUNT + shift * HIST_SUB_BUCKET_COUNT
+        + ((val >> shift) - HIST_SUB_BUCKET_COUNT);
+}
+
+/**
+ * @brief Get the highest value that can be recorded into bucket \p idx.
+ */
+static unsigned long _cutest_hist_bucket_upper(unsigned long idx)
+{
+    if (idx < HIST_SUB_BUCKET_COUNT)
+    {
+        return idx;
+    }
+
+    unsigned long shift = (idx - HIST_SUB_BUCKET_COUNT) / HIST_SUB_BUCKET_COUNT;
+    unsigned long sub = (idx - HIST_SUB_BUCKET_COUNT) % HIST_SUB_BUCKET_COUNT;
+    unsigned long lower = (HIST_SUB_BUCKET_COUNT + sub) << shift;
+    return lower + ((1UL << shift) - 1);
+}
+
+static void _cutest_hist_reset(void)
+{
+    if (s_test_hist.dirty)
+    {
+        cutest_porting_memset(&s_test_hist, 0, sizeof(s_test_hist));
+    }
+}
+
+/**
+ * @brief Merge all shards and save percentiles into \p test_case.
+ */
+static void _cutest_hist_summary(cutest_case_t* test_case)
+{
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    unsigned long* results[] = {
+        &test_case->histogram.p50, &test_case->histogram.p90,
+        &test_case->histogram.p99, &test_case->histogram.p999,
+    };
+    unsigned long ranks[TEST_ARRAY_SIZE(quantiles)];
+    unsigned long total = 0, max = 0;
+    unsigned long i, j, k;
+
+    if (!s_test_hist.dirty)
+    {
+        return;
+    }
+
+    for (i = 0; i < HIST_SHARD_COUNT; i++)
+    {
+        total += (unsigned long)s_test_hist.shards[i].total;
+        if ((unsigned long)s_test_hist.shards[i].max > max)
+        {
+            max = (unsigned long)s_test_hist.shards[i].max;
+        }
+    }
+    if (total == 0)
+    {
+        return;
+    }
+
+    for (k = 0; k < TEST_ARRAY_SIZE(quantiles); k++)
+    {
+        double rank = quantiles[k] * total;
+        ranks[k] = (unsigned long)rank;
+        if (ranks[k] < rank || ranks[k] == 0)
+        {
+            ranks[k]++;
+        }
+    }
+
+    unsigned long cumulative = 0;
+    for (i = 0, k = 0; i < HIST_BUCKET_COUNT && k < TEST_ARRAY_SIZE(quantiles); i++)
+    {
+        for (j = 0; j < HIST_SHARD_COUNT; j++)
+        {
+            cumulative += (unsigned long)s_test_hist.shards[j].counts[i];
+        }
+
+        unsigned long upper = _cutest_hist_bucket_upper(i);
+        for (; k < TEST_ARRAY_SIZE(quantiles) && cumulative >= ranks[k]; k++)
+        {
+            *results[k] = upper < max ? upper : max;
+        }
+    }
+
+    test_case->histogram.count = total;
+    test_case->histogram.max = max;
+}
+
+static void _cutest_hist_show_result(test_case_info_t* info)
+{
+    cutest_case_t* test_case = info->test_case;
+    if (test_case->histogram.count == 0)
+    {
+        return;
+    }
+
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ HIST     ]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT,
+        " %s p50=%lu p90=%lu p99=%lu p99.9=%lu max=%lu (%lu sample%s)\n",
+        info->fmt_name, test_case->histogram.p50, test_case->histogram.p90,
+        test_case->histogram.p99, test_case->histogram.p999, test_case->histogram.max,
+        test_case->histogram.count, test_case->histogram.count > 1 ? "s" : "");
+}
+
+typedef struct test_counter
+{
+    char                            name[COUNTER_NAME_SIZE];        /**< Counter name. */
+    double                          value;                          /**< Value set by user. */
+    double                          result;                         /**< Value after apply flags. */
+    int                             flags;                          /**< #cutest_counter_flag_t */
+} test_counter_t;
+
+typedef struct test_counter_table
+{
+    test_counter_t                  items[COUNTER_MAX];
+    unsigned                        size;
+} test_counter_table_t;
+
+/**
+ * @brief Counters of current test.
+ */
+static test_counter_table_t s_test_counters;
+
+/**
+ * @brief Apply counter flags.
+ */
+static void _cutest_counter_resolve(test_case_info_t* info)
+{
+    double seconds = g_test_ctx.benchmark.total_ns / 1000000000.0;
+    double iterations = g_test_ctx.benchmark.total_iterations;
+    double threads = g_test_ctx.benchmark.threads != 0 ? g_test_ctx.benchmark.threads : 1;
+
+    /* Not a benchmark, use the time of whole test. */
+    if (seconds <= 0)
+    {
+        cutest_porting_timespec_t tv_now;
+        cutest_porting_clock_gettime(&tv_now);
+        seconds = cutest_timestamp_dif_ns(&info->tv_case_beg, &tv_now) / 1000000000.0;
+    }
+
+    unsigned i;
+    for (i = 0; i < s_test_counters.size; i++)
+    {
+        test_counter_t* counter = &s_test_counters.items[i];
+        counter->result = counter->value;
+
+        if ((counter->flags & CUTEST_COUNTER_AVG_ITERATIONS) && iterations > 0)
+        {
+            counter->result /= iterations;
+        }
+        if (counter->flags & CUTEST_COUNTER_PER_THREAD)
+        {
+            counter->result /= threads;
+        }
+        if ((counter->flags & CUTEST_COUNTER_RATE) && seconds > 0)
+        {
+            counter->result /= seconds;
+        }
+    }
+}
+
+static void _cutest_counter_show_result(test_case_info_t* info)
+{
+    static const char* units[] = { "", "k", "M", "G", "T", "P" };
+
+    if (s_test_counters.size == 0)
+    {
+        return;
+    }
+
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ COUNTER  ]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s", info->fmt_name);
+
+    unsigned i;
+    for (i = 0; i < s_test_counters.size; i++)
+    {
+        test_counter_t* counter = &s_test_counters.items[i];
+
+        /* Use SI prefix for large values. */
+        double value = counter->result;
+        unsigned unit = 0;
+        while ((value >= 1000 || value <= -1000) && unit < TEST_ARRAY_SIZE(units) - 1)
+        {
+            value /= 1000;
+            unit++;
+        }
+
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s=%.4g%s%s",
+            counter->name, value, units[unit], (counter->flags & CUTEST_COUNTER_RATE) ? "/s" : "");
+    }
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
+}
+
+static void _cutest_backtrace_show_result(void)
+{
+    const void* biases[BACKTRACE_MAX_FRAMES];
+    const char* modules[BACKTRACE_MAX_FRAMES];
+    unsigned module_sz = 0;
+
+    unsigned i, j;
+    for (i = 0; i < s_test_backtrace.size; i++)
+    {
+        const void* frame = s_test_backtrace.frames[i];
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_RED, "[ TRACE    ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " #%u %p", i, frame);
+
+        cutest_backtrace_symbol_t sym;
+        if (cutest_backtrace_symbolize(frame, &sym) != 0 || sym.module == NULL)
+        {
+            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
+            continue;
+        }
+
+        if (sym.name != NULL)
+        {
+            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " in %s+0x%lx",
+                sym.name, (unsigned long)((const char*)frame - (const char*)sym.addr));
+        }
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " (%s+0x%lx)\n",
+            sym.module, (unsigned long)((const char*)frame - (const char*)sym.bias));
+
+        for (j = 0; j < module_sz && biases[j] != sym.bias; j++)
+        {
+        }
+        if (j == module_sz)
+        {
+            biases[module_sz] = sym.bias;
+            modules[module_sz] = sym.module;
+            module_sz++;
+        }
+    }
+
+    /* Enough to symbolize offline, even if binaries are rebuilt. */
+    for (j = 0; j < module_sz; j++)
+    {
+        char build_id[128];
+        if (cutest_backtrace_build_id(biases[j], build_id, sizeof(build_id)) == 0)
+        {
+            continue;
+        }
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_RED, "[ TRACE    ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s build-id %s\n",
+            modules[j], build_id);
+    }
+}
+
+/**
+ * @brief Seqlock write side. Readers retry if \p seq is odd or changed.
+ */
+static void _cutest_monitor_write_begin(volatile unsigned long* seq)
+{
+    *seq = *seq + 1;
+    cutest_shm_fence();
+}
+
+static void _cutest_monitor_write_end(volatile unsigned long* seq)
+{
+    cutest_shm_fence();
+    *seq = *seq + 1;
+}
+
+static void _cutest_monitor_copy_name(char* dst, const char* src)
+{
+    unsigned long len = cutest_porting_strlen(src);
+    if (len >= CUTEST_MONITOR_NAME_SIZE)
+    {
+        len = CUTEST_MONITOR_NAME_SIZE - 1;
+    }
+    cutest_porting_memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+/**
+ * @brief Mirror result counters to status board. Caller must hold the seqlock.
+ */
+static void _cutest_monitor_sync_counter(cutest_monitor_board_t* board)
+{
+    board->total = g_test_ctx.counter.result.total;
+    board->disabled = g_test_ctx.counter.result.disabled;
+    board->success = g_test_ctx.counter.result.success;
+    board->skipped = g_test_ctx.counter.result.skipped;
+    board->failed = g_test_ctx.counter.result.failed;
+    board->repeat = g_test_ctx.counter.repeat.repeat;
+    board->repeated = g_test_ctx.counter.repeat.repeated;
+}
+
+static void _cutest_monitor_update_counter(void)
+{
+    cutest_monitor_board_t* board = g_test_ctx.monitor.board;
+    if (board == NULL)
+    {
+        return;
+    }
+
+    _cutest_monitor_write_begin(&board->seq);
+    _cutest_monitor_sync_counter(board);
+    _cutest_monitor_write_end(&board->seq);
+}
+
+static void _cutest_monitor_case_begin(test_case_info_t* info)
+{
+    cutest_monitor_board_t* board = g_test_ctx.monitor.board;
+    if (board == NULL)
+    {
+        return;
+    }
+
+    cutest_monitor_worker_t* worker = &board->workers[g_test_ctx.monitor.worker];
+    _cutest_monitor_write_begin(&worker->seq);
+    worker->tv_sec = (unsigned long)info->tv_case_beg.tv_sec;
+    worker->tv_nsec = (unsigned long)info->tv_case_beg.tv_nsec;
+    _cutest_monitor_copy_name(worker->name, info->fmt_name);
+    _cutest_monitor_write_end(&worker->seq);
+
+    _cutest_monitor_update_counter();
+}
+
+static void _cutest_monitor_case_end(test_case_info_t* info, unsigned long elapsed_ms)
+{
+    cutest_monitor_board_t* board = g_test_ctx.monitor.board;
+    if (board == NULL)
+    {
+        return;
+    }
+
+    cutest_monitor_worker_t* worker = &board->workers[g_test_ctx.monitor.worker];
+    _cutest_monitor_write_begin(&worker->seq);
+    worker->name[0] = '\0';
+    _cutest_monitor_write_end(&worker->seq);
+
+    _cutest_monitor_write_begin(&board->seq);
+    _cutest_monitor_sync_counter(board);
+
+    if (HAS_MASK(info->test_case->data.mask, MASK_FAILURE))
+    {
+        cutest_monitor_record_t* record = &board->failures[board->failure_cnt % CUTEST_MONITOR_RECORDS];
+        _cutest_monitor_copy_name(record->name, info->fmt_name);
+        record->elapsed_ms = elapsed_ms;
+        board->failure_cnt++;
+    }
+
+    /* Insertion sort, slowest first. */
+    unsigned i = CUTEST_MONITOR_RECORDS;
+    while (i > 0 && (board->slowest[i - 1].name[0] == '\0' || board->slowest[i - 1].elapsed_ms < elapsed_ms))
+    {
+        if (i < CUTEST_MONITOR_RECORDS)
+        {
+            board->slowest[i] = board->slowest[i - 1];
+        }
+        i--;
+    }
+    if (i < CUTEST_MONITOR_RECORDS)
+    {
+        _cutest_monitor_copy_name(board->slowest[i].name, info->fmt_name);
+        board->slowest[i].elapsed_ms = elapsed_ms;
+    }
+
+    _cutest_monitor_write_end(&board->seq);
+}
+
+static void _cutest_monitor_setup(void)
+{
+    if (g_test_ctx.monitor.path == NULL)
+    {
+        return;
+    }
+
+    cutest_monitor_board_t* board = cutest_shm_create(g_test_ctx.monitor.path, sizeof(*board));
+    if (board == NULL)
+    {
+        _cutest_warning("Can not create status board `%s', monitor is disabled.\n",
+            g_test_ctx.monitor.path);
+        return;
+    }
+
+    board->magic = CUTEST_MONITOR_MAGIC;
+    board->version = CUTEST_MONITOR_VERSION;
+    board->pid = cutest_process_id();
+    board->workers[g_test_ctx.monitor.worker].pid = board->pid;
+    g_test_ctx.monitor.board = board;
+
+    _cutest_monitor_update_counter();
+}
+
+/**
+ * @brief Mark the run as finished. The file is kept so the final state can
+ *   still be read.
+ */
+static void _cutest_monitor_cleanup(void)
+{
+    cutest_monitor_board_t* board = g_test_ctx.monitor.board;
+    if (board == NULL)
+    {
+        return;
+    }
+
+    _cutest_monitor_write_begin(&board->seq);
+    _cutest_monitor_sync_counter(board);
+    board->finished = 1;
+    _cutest_monitor_write_end(&board->seq);
+
+    cutest_shm_destroy(board, sizeof(*board));
+    g_test_ctx.monitor.board = NULL;
+}
+
+volatile int cutest_internal_flight_enabled = 0;
+
+/**
+ * @brief Record location of assertion, readers see file and line together.
+ *
+ * Any thread may assert, so a writer owns the record by taking `seq` from even
+ * to odd with CAS, and other writers wait until it is even again.
+ */
+static void _cutest_flight_assert(const char* file, int line)
+{
+    cutest_flight_recorder_t* recorder = g_test_ctx.flight.recorder;
+    if (recorder == NULL)
+    {
+        return;
+    }
+
+    cutest_flight_assert_t* last = &recorder->last_assert;
+    long seq;
+    while (((seq = last->seq) & 1) != 0 || !cutest_atomic_cas(&last->seq, seq, seq + 1))
+    {
+        cutest_thread_yield();
+    }
+    cutest_shm_fence();
+
+    /* Assertions in a row are usually in the same file. */
+    if (file != g_test_ctx.flight.assert_file)
+    {
+        g_test_ctx.flight.assert_file = file;
+        _cutest_flight_copy_name(last->file, file, 1);
+    }
+    last->line = (unsigned long)line;
+
+    cutest_shm_fence();
+    last->seq = seq + 2;
+}
+
+/**
+ * @brief Copy location of the last assertion, with file and line written by
+ *   the same assertion.
+ * @return 0 if success, -1 if it stays busy, e.g. the writer died in between.
+ */
+static int _cutest_flight_read_assert(const cutest_flight_recorder_t* recorder, cutest_flight_assert_t* copy)
+{
+    int retry;
+    for (retry = 0; retry < 100; retry++)
+    {
+        long seq = recorder->last_assert.seq;
+        cutest_shm_fence();
+        cutest_porting_memcpy(copy, (const void*)&recorder->last_assert, sizeof(*copy));
+        cutest_shm_fence();
+        if ((seq & 1) == 0 && seq == recorder->last_assert.seq)
+        {
+            return 0;
+        }
+        cutest_thread_yield();
+    }
+    return -1;
+}
+
+static void _cutest_flight_setup(void)
+{
+    if (g_test_ctx.flight.path == NULL)
+    {
+        return;
+    }
+
+    cutest_flight_recorder_t* recorder = cutest_shm_create(g_test_ctx.flight.path, sizeof(*recorder));
+    if (recorder == NULL)
+    {
+        _cutest_warning("Can not create flight recorder `%s', it is disabled.\n",
+            g_test_ctx.flight.path);
+        return;
+    }
+
+    recorder->magic = CUTEST_FLIGHT_MAGIC;
+    recorder->version = CUTEST_FLIGHT_VERSION;
+    recorder->pid = cutest_process_id();
+    g_test_ctx.flight.recorder = recorder;
+    g_test_ctx.flight.assert_file = NULL;
+    cutest_internal_flight_enabled = 1;
+
+    _cutest_flight_record(CUTEST_FLIGHT_RUN_BEGIN, recorder->pid, NULL);
+}
+
+/**
+ * @brief Record the end of run. The file is kept for post-mortem.
+ */
+static void _cutest_flight_cleanup(void)
+{
+    cutest_flight_recorder_t* recorder = g_test_ctx.flight.recorder;
+    if (recorder == NULL)
+    {
+        return;
+    }
+
+    _cutest_flight_record(CUTEST_FLIGHT_RUN_END, g_test_ctx.counter.result.failed, NULL);
+    cutest_internal_flight_enabled = 0;
+    g_test_ctx.flight.recorder = NULL;
+    cutest_shm_destroy(recorder, sizeof(*recorder));
+}
+
+/**
+ * @brief Print events of the last case, for a child process that died.
+ */
+static void _cutest_flight_show_last_case(void)
+{
+    static const char* s_type_names[] = {
+        "", "run begin", "run end", "case begin", "case end",
+        "setup", "body", "teardown", "failure",
+    };
+    cutest_flight_recorder_t* recorder = g_test_ctx.flight.recorder;
+    if (recorder == NULL)
+    {
+        return;
+    }
+
+    cutest_shm_fence();
+    unsigned long head = (unsigned long)recorder->head;
+    unsigned long beg = head;
+    while (beg > 0 && head - beg < CUTEST_FLIGHT_EVENTS)
+    {
+        const cutest_flight_event_t* event = &recorder->events[(beg - 1) % CUTEST_FLIGHT_EVENTS];
+        if (event->seq != beg)
+        {
+            break;
+        }
+        beg--;
+        if (event->type == CUTEST_FLIGHT_CASE_BEGIN)
+        {
+            break;
+        }
+    }
+
+    for (; beg < head; beg++)
+    {
+        const cutest_flight_event_t* event = &recorder->events[beg % CUTEST_FLIGHT_EVENTS];
+        if (event->seq != beg + 1 || event->type >= sizeof(s_type_names) / sizeof(s_type_names[0]))
+        {
+            continue;
+        }
+        cutest_porting_fprintf(g_test_ctx.out, "[ FLIGHT   ] %s", s_type_names[event->type]);
+        if (event->name[0] != '\0')
+        {
+            cutest_porting_fprintf(g_test_ctx.out, " %s", event->name);
+        }
+        if (event->type == CUTEST_FLIGHT_FAILURE)
+        {
+            cutest_porting_fprintf(g_test_ctx.out, ":%lu", event->data);
+        }
+        cutest_porting_fprintf(g_test_ctx.out, "\n");
+    }
+    /* Not if it died in the middle of writing it. */
+    cutest_flight_assert_t last;
+    if (_cutest_flight_read_assert(recorder, &last) == 0 && last.file[0] != '\0')
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ FLIGHT   ] last assertion %s:%lu\n",
+            last.file, last.line);
+    }
+}
+
+/**
+ * @brief Parse a non-negative decimal number like `1.25`.
+ */
+static double _cutest_benchmark_parse_decimal(const char* str)
+{
+    double val = 0, scale = 1;
+    for (; *str >= '0' && *str <= '9'; str++)
+    {
+        val = val * 10 + (*str - '0');
+    }
+    if (*str == '.')
+    {
+        for (str++; *str >= '0' && *str <= '9'; str++)
+        {
+            scale /= 10;
+            val += (*str - '0') * scale;
+        }
+    }
+    return val;
+}
+
+/**
+ * @brief Warn about system settings that make benchmark results unstable.
+ */
+static void _cutest_benchmark_check_environment(void)
+{
+    char buf[128];
+
+    if (cutest_read_first_line("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor", buf, sizeof(buf)) == 0
+        && cutest_porting_strcmp(buf, "performance") != 0)
+    {
+        _cutest_warning("CPU frequency scaling governor is `%s', consider `performance'.\n", buf);
+    }
+
+    if ((cutest_read_first_line("/sys/devices/system/cpu/intel_pstate/no_turbo", buf, sizeof(buf)) == 0
+            && cutest_porting_strcmp(buf, "0") == 0)
+        || (cutest_read_first_line("/sys/devices/system/cpu/cpufreq/boost", buf, sizeof(buf)) == 0
+            && cutest_porting_strcmp(buf, "1") == 0))
+    {
+        _cutest_warning("CPU turbo boost is enabled, results may be unstable.\n");
+    }
+
+    if (cutest_read_first_line("/proc/loadavg", buf, sizeof(buf)) == 0)
+    {
+        unsigned ncpu = cutest_thread_cpu_count();
+        double loadavg = _cutest_benchmark_parse_decimal(buf);
+        if (loadavg > ncpu / 2.0)
+        {
+            _cutest_warning("Load average is %.2f on %u CPU%s, results may be unstable.\n",
+                loadavg, ncpu, ncpu > 1 ? "s" : "");
+        }
+    }
+}
+
+/**
+ * @brief Prepare current thread for measurement.
+ * @param[in] pin - Whether to pin current thread. Threads created later
+ *   inherit the affinity, so do not pin if the benchmark create threads.
+ */
+static void _cutest_benchmark_begin(int pin)
+{
+    if (!g_test_ctx.benchmark.env_checked)
+    {
+        g_test_ctx.benchmark.env_checked = 1;
+        _cutest_benchmark_check_environment();
+    }
+
+    if (pin && !g_test_ctx.benchmark.pinned && cutest_affinity_pin_current() == 0)
+    {
+        g_test_ctx.benchmark.pinned = 1;
+    }
+
+    if (g_test_ctx.mask.benchmark_priority && !g_test_ctx.benchmark.prioritized)
+    {
+        if (cutest_priority_raise() == 0)
+        {
+            g_test_ctx.benchmark.prioritized = 1;
+        }
+        else
+        {
+            _cutest_warning("Failed to raise priority.\n");
+        }
+    }
+}
+
+/**
+ * @brief Undo #_cutest_benchmark_begin(). It is safe to call multiple times.
+ */
+static void _cutest_benchmark_end(void)
+{
+    if (g_test_ctx.benchmark.prioritized)
+    {
+        g_test_ctx.benchmark.prioritized = 0;
+        cutest_priority_restore();
+    }
+    if (g_test_ctx.benchmark.pinned)
+    {
+        g_test_ctx.benchmark.pinned = 0;
+        cutest_affinity_restore();
+    }
+}
+
+static void _cutest_benchmark_add_sample(double ns_per_op)
+{
+    if (g_test_ctx.benchmark.samples == 0 || ns_per_op < g_test_ctx.benchmark.sample_min)
+    {
+        g_test_ctx.benchmark.sample_min = ns_per_op;
+    }
+    if (g_test_ctx.benchmark.samples == 0 || ns_per_op > g_test_ctx.benchmark.sample_max)
+    {
+        g_test_ctx.benchmark.sample_max = ns_per_op;
+    }
+    g_test_ctx.benchmark.samples++;
+}
+
+/**
+ * @brief Cache eviction buffer. Set by #cutest_benchmark_set_evict_buffer().
+ */
+static struct
+{
+    unsigned char*          buf;        /**< User buffer, NULL to use builtin. */
+    unsigned long           size;       /**< Size of user buffer. */
+    const unsigned char*    tlb_span;   /**< Zero page mapping for TLB eviction. */
+} s_test_evict;
+
+static unsigned char s_test_evict_builtin[BENCHMARK_EVICT_BUFFER_SIZE];
+
+/**
+ * @brief Get the size of last level cache from sysfs.
+ * @return Size in bytes, or 0 if unknown.
+ */
+static unsigned long _cutest_benchmark_llc_size(void)
+{
+    char path[] = "/sys/devices/system/cpu/cpu0/cache/index0/size";
+    char* idx = path + sizeof("/sys/devices/system/cpu/cpu0/cache/index") - 1;
+    char buf[32];
+    unsigned long size = 0;
+
+    int i;
+    for (i = 0; i < 8; i++)
+    {
+        *idx = (char)('0' + i);
+        if (cutest_read_first_line(path, buf, sizeof(buf)) != 0)
+        {
+            break;
+        }
+
+        double val = _cutest_benchmark_parse_decimal(buf);
+        char* unit = buf;
+        while ((*unit >= '0' && *unit <= '9') || *unit == '.')
+        {
+            unit++;
+        }
+        val *= *unit == 'K' ? 1024 : *unit == 'M' ? 1024 * 1024 : *unit == 'G' ? 1024 * 1024 * 1024 : 1;
+        if (val > size)
+        {
+            size = (unsigned long)val;
+        }
+    }
+
+    return size;
+}
+
+/**
+ * @brief Evict CPU caches, and TLB if `--test_benchmark_cold_tlb` is set.
+ */
+static void _cutest_benchmark_evict(void)
+{
+    volatile unsigned char* buf = s_test_evict.buf != NULL ? s_test_evict.buf : s_test_evict_builtin;
+    unsigned long size = s_test_evict.buf != NULL ? s_test_evict.size : sizeof(s_test_evict_builtin);
+    unsigned long i;
+
+    if (!g_test_ctx.benchmark.evict_warned)
+    {
+        g_test_ctx.benchmark.evict_warned = 1;
+        unsigned long llc = _cutest_benchmark_llc_size();
+        if (size < llc * 2)
+        {
+            _cutest_warning("Cache eviction buffer (%lu KiB) is less than twice the last level cache"
+                " (%lu KiB), see cutest_benchmark_set_evict_buffer().\n", size / 1024, llc / 1024);
+        }
+    }
+
+    if (g_test_ctx.mask.benchmark_cold_tlb)
+    {
+        if (s_test_evict.tlb_span == NULL)
+        {
+            s_test_evict.tlb_span = cutest_vm_map_zero(BENCHMARK_EVICT_TLB_SPAN);
+        }
+
+        /* Every page maps to the same physical page, so cache is barely touched. */
+        if (s_test_evict.tlb_span != NULL)
+        {
+            volatile const unsigned char* span = s_test_evict.tlb_span;
+            unsigned char sum = 0;
+            for (i = 0; i < BENCHMARK_EVICT_TLB_SPAN; i += BENCHMARK_EVICT_PAGE_STRIDE)
+            {
+                sum = (unsigned char)(sum + span[i]);
+            }
+            buf[0] = (unsigned char)(buf[0] + sum);
+        }
+        else
+        {
+            for (i = 0; i < size; i += BENCHMARK_EVICT_PAGE_STRIDE)
+            {
+                buf[i]++;
+            }
+        }
+    }
+
+    /* Write, so dirty lines of the test are written back now. */
+    for (i = 0; i < size; i += BENCHMARK_EVICT_CACHE_STRIDE)
+    {
+        buf[i]++;
+    }
+}
+
+/**
+ * @brief Start cold measurement after the warm one is finished.
+ */
+static void _cutest_benchmark_cold_begin(void)
+{
+    g_test_ctx.benchmark.cold = 1;
+    g_test_ctx.benchmark.cold_done = 0;
+    g_test_ctx.benchmark.cold_sum_ns = 0;
+    cutest_porting_clock_gettime(&g_test_ctx.benchmark.tv_cold_beg);
+
+    _cutest_benchmark_evict();
+    cutest_porting_clock_gettime(&g_test_ctx.benchmark.tv_beg);
+}
+
+/**
+ * @brief Finish one cold iteration.
+ * @return Non-zero if need one more iteration.
+ */
+static int _cutest_benchmark_cold_step(cutest_case_t* test_case)
+{
+    cutest_porting_timespec_t tv_end;
+    cutest_porting_clock_gettime(&tv_end);
+
+    g_test_ctx.benchmark.cold_sum_ns += cutest_timestamp_dif_ns(&g_test_ctx.benchmark.tv_beg, &tv_end);
+    g_test_ctx.benchmark.cold_done++;
+
+    /* The time of eviction is counted here, so the test does not run too long. */
+    double elapsed = cutest_timestamp_dif_ns(&g_test_ctx.benchmark.tv_cold_beg, &tv_end);
+    double min_time = (double)g_test_ctx.benchmark.min_time_ms * 1000 * 1000;
+    if (g_test_ctx.benchmark.cold_done < BENCHMARK_COLD_MAX_ITERATIONS
+        && (g_test_ctx.benchmark.cold_done < BENCHMARK_COLD_MIN_ITERATIONS || elapsed < min_time))
+    {
+        _cutest_benchmark_evict();
+        cutest_porting_clock_gettime(&g_test_ctx.benchmark.tv_beg);
+        return 1;
+    }
+
+    test_case->benchmark.cold_iterations = g_test_ctx.benchmark.cold_done;
+    test_case->benchmark.cold_ns_per_op = g_test_ctx.benchmark.cold_sum_ns / g_test_ctx.benchmark.cold_done;
+    g_test_ctx.benchmark.cold = 0;
+    return 0;
+}
+
+static void _cutest_benchmark_show_result(test_case_info_t* info)
+{
+    cutest_case_t* test_case = info->test_case;
+    if (test_case->benchmark.iterations == 0)
+    {
+        return;
+    }
+
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ BENCH    ]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s %.2f ns/op (%lu iteration%s",
+        info->fmt_name, test_case->benchmark.ns_per_op, test_case->benchmark.iterations,
+        test_case->benchmark.iterations > 1 ? "s" : "");
+    if (test_case->benchmark.spread >= 0)
+    {
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, ", spread %.1f%%",
+            test_case->benchmark.spread);
+    }
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, ")");
+    if (test_case->benchmark.cold_iterations != 0)
+    {
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, ", cold %.2f ns/op (%lu iteration%s",
+            test_case->benchmark.cold_ns_per_op, test_case->benchmark.cold_iterations,
+            test_case->benchmark.cold_iterations > 1 ? "s" : "");
+        if (test_case->benchmark.ns_per_op > 0)
+        {
+            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, ", %.1fx",
+                test_case->benchmark.cold_ns_per_op / test_case->benchmark.ns_per_op);
+        }
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, ")");
+    }
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
+}
+
+/**
+ * @brief Print result of \p info, which finished at `tv_case_end`.
+ */
+static void _cutest_show_result(test_case_info_t* info)
+{
+    cutest_porting_timespec_t tv_diff;
+    cutest_timestamp_dif(&info->tv_case_beg, &info->tv_case_end, &tv_diff);
+
+    _cutest_benchmark_show_result(info);
+    _cutest_hist_show_result(info);
+    _cutest_counter_show_result(info);
+
+    if (HAS_MASK(info->test_case->data.mask, MASK_FAILURE))
+    {
+        _cutest_backtrace_show_result();
+        g_test_ctx.counter.result.failed++;
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_RED, "[  FAILED  ]");
+    }
+    else if (HAS_MASK(info->test_case->data.mask, MASK_SKIPPED))
+    {
+        g_test_ctx.counter.result.skipped++;
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW, "[   SKIP   ]");
+    }
+    else
+    {
+        g_test_ctx.counter.result.success++;
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[       OK ]");
+    }
+
+    unsigned long take_time = (unsigned long)(tv_diff.tv_sec * 1000 + tv_diff.tv_nsec / 1000000);
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s", info->fmt_name);
+    if (!g_test_ctx.mask.no_print_time)
+    {
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " (%lu ms)", take_time);
+    }
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
+
+    _cutest_monitor_case_end(info, take_time);
+    _cutest_flight_record(CUTEST_FLIGHT_CASE_END,
+        HAS_MASK(info->test_case->data.mask, MASK_FAILURE) ? 1 : (HAS_MASK(info->test_case->data.mask, MASK_SKIPPED) ? 2 : 0),
+        info->fmt_name);
+}
+
+static void _cutest_finishlize(test_case_info_t* info)
+{
+    cutest_porting_clock_gettime(&info->tv_case_end);
+    _cutest_show_result(info);
+}
+
+static void _cutest_run_case_normal_body_jmp(cutest_porting_jmpbuf_t* buf,
+    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
+{
+    test_case_helper_t* helper = data;
+    test_case_info_t* info = helper->info;
+
+    _cutest_run_case_set_jmp(buf, fn_longjmp);
+
+    if (val != 0)
+    {
+        SET_MASK(info->test_case->data.mask, val);
+        goto after_body;
+    }
+
+    _cutest_hook_before_test(info);
+    _cutest_flight_record(CUTEST_FLIGHT_BODY, 0, NULL);
+    _cutest_backtrace_mark();
+    info->test_case->stage.body(NULL, 0);
+
+after_body:
+    _cutest_hook_after_test(info, val);
+    helper->ret = val;
+}
+
+static int _cutest_run_case_normal_body(test_case_info_t* info)
+{
+    test_case_helper_t helper = { info, 0 };
+    cutest_porting_setjmp(_cutest_run_case_normal_body_jmp, &helper);
+    return helper.ret;
+}
+
+/**
+ * @return  1 if need to process, 0 to stop.
+ */
+static int _cutest_run_prepare(test_case_info_t* info)
+{
+    /* Check if need to run this test case */
+    if (!_cutest_check_pattern(info->fmt_name, info->fmt_name_sz) || info->test_case->data.sampled_out)
+    {
+        return 1;
+    }
+    g_test_ctx.counter.result.total++;
+
+    /* check if this test is disabled */
+    if (_cutest_check_disable(info->test_case->info.case_name))
+    {
+        g_test_ctx.counter.result.disabled++;
+        return 1;
+    }
+
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ RUN      ]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s\n", info->fmt_name);
+
+    /* record start time */
+    cutest_porting_clock_gettime(&info->tv_case_beg);
+    _cutest_monitor_case_begin(info);
+    _cutest_flight_record(CUTEST_FLIGHT_CASE_BEGIN, 0, info->fmt_name);
+    return 0;
+}
+
+typedef struct test_isolate_result
+{
+    cutest_case_t           test_case;  /**< Test case status in child process. */
+    test_counter_table_t    counters;   /**< Counters in child process. */
+    test_backtrace_t        backtrace;  /**< Backtrace in child process. */
+} test_isolate_result_t;
+
+typedef struct test_isolate_helper
+{
+    test_case_info_t*       info;
+    void                    (*stages)(void*);
+    test_isolate_result_t   result;
+} test_isolate_helper_t;
+
+/**
+ * @brief Collect results that only available in the process running the test.
+ */
+static void _cutest_run_stages_summary(test_case_info_t* info)
+{
+    _cutest_hist_summary(info->test_case);
+    _cutest_counter_resolve(info);
+}
+
+static void _cutest_run_stages_isolated(void* arg)
+{
+    test_isolate_helper_t* helper = arg;
+    helper->stages(helper->info);
+    _cutest_run_stages_summary(helper->info);
+    helper->result.test_case = *helper->info->test_case;
+    helper->result.counters = s_test_counters;
+    helper->result.backtrace = s_test_backtrace;
+}
+
+/**
+ * @brief Run setup, body and teardown of test case.
+ *
+ * If `--test_benchmark_isolate` is set, they are run in a child process, and
+ * the result is sent back to us.
+ */
+static void _cutest_run_stages(test_case_info_t* info, void (*stages)(void*))
+{
+    if (!g_test_ctx.mask.benchmark_isolate)
+    {
+        stages(info);
+        _cutest_run_stages_summary(info);
+        return;
+    }
+
+    cutest_case_t* test_case = info->test_case;
+    test_isolate_helper_t helper;
+    helper.info = info;
+    helper.stages = stages;
+
+    int ret = cutest_process_isolate(g_test_ctx.out, _cutest_run_stages_isolated, &helper,
+        &helper.result, sizeof(helper.result));
+    if (ret == 0)
+    {
+        test_case->data = helper.result.test_case.data;
+        test_case->benchmark = helper.result.test_case.benchmark;
+        test_case->histogram = helper.result.test_case.histogram;
+        s_test_counters = helper.result.counters;
+        s_test_backtrace = helper.result.backtrace;
+        return;
+    }
+
+    if (ret < 0)
+    {
+        if (!g_test_ctx.benchmark.isolate_warned)
+        {
+            g_test_ctx.benchmark.isolate_warned = 1;
+            _cutest_warning("Process isolation is not available, run in process.\n");
+        }
+        stages(info);
+        _cutest_run_stages_summary(info);
+        return;
+    }
+
+    cutest_porting_fprintf(g_test_ctx.out, "%s: child process terminated abnormally.\n", info->fmt_name);
+    _cutest_flight_show_last_case();
+    SET_MASK(test_case->data.mask, MASK_FAILURE);
+}
+
+/**
+ * @brief Append \p str at \p pos of \p buf, truncate if \p buf is too small.
+ * @return The position after \p str, as if not truncated.
+ */
+static unsigned long _cutest_fmt_append(char* buf, unsigned long len, unsigned long pos, const char* str)
+{
+    unsigned long str_len = cutest_porting_strlen(str);
+    if (pos < len)
+    {
+        unsigned long copy_size = len - 1 - pos < str_len ? len - 1 - pos : str_len;
+        cutest_porting_memcpy(buf + pos, str, copy_size);
+        buf[pos + copy_size] = '\0';
+    }
+    return pos + str_len;
+}
+
+static unsigned long _cutest_get_test_fmt_name_normal(char* buf, unsigned long len, cutest_case_t* test_case)
+{
+    unsigned long pos = 0;
+    buf[0] = '\0';
+
+    /* Cases of modules are named `module.fixture.case`. */
+    if (test_case->info.module_name != NULL)
+    {
+        pos = _cutest_fmt_append(buf, len, pos, test_case->info.module_name);
+        pos = _cutest_fmt_append(buf, len, pos, ".");
+    }
+    pos = _cutest_fmt_append(buf, len, pos, test_case->info.fixture_name);
+    pos = _cutest_fmt_append(buf, len, pos, ".");
+    return _cutest_fmt_append(buf, len, pos, test_case->info.case_name);
+}
+
+static unsigned long _cutest_get_test_fmt_name_parameter(char* buf, unsigned long len, cutest_case_t* test_case)
+{
+    char num_buf[32];
+
+    cutest_porting_ultoa(num_buf, test_case->parameterized.param_idx);
+    unsigned long num_len = cutest_porting_strlen(num_buf);
+
+    unsigned long ret = _cutest_get_test_fmt_name_normal(buf, len, test_case);
+    if (ret >= len - num_len - 1)
+    {
+        goto finish;
+    }
+
+    buf[ret] = '/';
+    cutest_porting_memcpy(buf + ret + 1, num_buf, num_len + 1);
+
+finish:
+    return ret + 1 + num_len;
+}
+
+/**
+ * @brief Mark a finished test case as failure, and fix the counter.
+ */
+static void _cutest_set_finished_case_failure(cutest_case_t* test_case)
+{
+    if (HAS_MASK(test_case->data.mask, MASK_FAILURE))
+    {
+        return;
+    }
+
+    if (HAS_MASK(test_case->data.mask, MASK_SKIPPED))
+    {
+        g_test_ctx.counter.result.skipped--;
+    }
+    else
+    {
+        g_test_ctx.counter.result.success--;
+    }
+    g_test_ctx.counter.result.failed++;
+    SET_MASK(test_case->data.mask, MASK_FAILURE);
+    _cutest_monitor_update_counter();
+}
+
+typedef struct test_pipeline_stage
+{
+    cutest_thread_t             thread;
+    cutest_case_t*              test_case;  /**< NULL if idle. */
+    void                        (*fn)(void);/**< Setup or teardown. */
+    int                         ret;        /**< Stage result, 0 if success. */
+    FILE*                       out;        /**< Output of the stage, printed when it is collected. */
+} test_pipeline_stage_t;
+
+static struct
+{
+    const char*                 fixtures[PIPELINE_MAX_FIXTURES];    /**< Thread safe fixtures. */
+    unsigned                    fixture_sz;
+    int                         active;     /**< Whether pipelining is allowed. */
+    cutest_case_t*              next;       /**< The case that run after current one. */
+    test_pipeline_stage_t       setup;      /**< Setup of next case. */
+    test_pipeline_stage_t       teardown;   /**< Teardown of previous case. */
+    test_case_info_t            pending;    /**< Case whose result waits for its teardown. */
+    test_backtrace_t            backtrace;  /**< Backtrace of the pending case. */
+    FILE*                       out;        /**< The real output while a result is pending, otherwise NULL. */
+} s_test_pipeline;
+
+static void _cutest_copy_file(FILE* dst, FILE* src)
+{
+    char buf[4096];
+    size_t n;
+
+    rewind(src);
+    while ((n = fread(buf, 1, sizeof(buf), src)) > 0)
+    {
+        fwrite(buf, 1, n, dst);
+    }
+}
+
+/**
+ * @brief Remove directory of #cutest_tmpdir() after teardown of \p test_case.
+ */
+static void _cutest_tmpdir_cleanup(cutest_case_t* test_case)
+{
+    if (test_case->data.tmpdir == NULL)
+    {
+        return;
+    }
+
+    cutest_tmpdir_remove(test_case->data.tmpdir);
+    free(test_case->data.tmpdir);
+    test_case->data.tmpdir = NULL;
+}
+
+static int _cutest_pipeline_is_thread_safe(const cutest_case_t* test_case)
+{
+    if (!s_test_pipeline.active || g_test_ctx.mask.benchmark_isolate)
+    {
+        return 0;
+    }
+
+    unsigned i;
+    for (i = 0; i < s_test_pipeline.fixture_sz; i++)
+    {
+        if (cutest_porting_strcmp(s_test_pipeline.fixtures[i], test_case->info.fixture_name) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Check if \p test_case will run, as #_cutest_run_prepare() does.
+ */
+static int _cutest_pipeline_will_run(cutest_case_t* test_case)
+{
+    char fmt_name[256];
+    unsigned long fmt_name_sz = test_case->parameterized.type_name == NULL ?
+        _cutest_get_test_fmt_name_normal(fmt_name, sizeof(fmt_name), test_case) :
+        _cutest_get_test_fmt_name_parameter(fmt_name, sizeof(fmt_name), test_case);
+
+    return fmt_name_sz < sizeof(fmt_name)
+        && _cutest_check_pattern(fmt_name, fmt_name_sz)
+        && !test_case->data.sampled_out
+        && !_cutest_check_disable(test_case->info.case_name);
+}
+
+static void _cutest_pipeline_stage_jmp(cutest_porting_jmpbuf_t* buf,
+    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
+{
+    test_pipeline_stage_t* stage = data;
+
+    s_test_thread_ctx.addr = buf;
+    s_test_thread_ctx.func = fn_longjmp;
+
+    if (val != 0)
+    {
+        _cutest_guard_report();
+        stage->ret = val;
+        return;
+    }
+
+    s_test_thread_ctx.cur_node = stage->test_case;
+    s_test_thread_ctx.out = stage->out;
+    _cutest_flight_record(stage->fn == stage->test_case->stage.setup ?
+        CUTEST_FLIGHT_SETUP : CUTEST_FLIGHT_TEARDOWN, 0, NULL);
+    stage->fn();
+}
+
+static void _cutest_pipeline_stage_thread(void* arg)
+{
+    test_pipeline_stage_t* stage = arg;
+    stage->ret = 0;
+    cutest_porting_setjmp(_cutest_pipeline_stage_jmp, stage);
+
+    s_test_thread_ctx.cur_node = NULL;
+    s_test_thread_ctx.addr = NULL;
+    s_test_thread_ctx.func = NULL;
+    s_test_thread_ctx.out = NULL;
+}
+
+static void _cutest_pipeline_stage_start(test_pipeline_stage_t* stage, cutest_case_t* test_case, void (*fn)(void))
+{
+    stage->test_case = test_case;
+    stage->fn = fn;
+    stage->ret = 0;
+    stage->out = cutest_memfile_open("cutest.stage");
+
+    stage->thread.fn = _cutest_pipeline_stage_thread;
+    stage->thread.arg = stage;
+    cutest_thread_create(&stage->thread);
+}
+
+/**
+ * @brief Wait for \p stage, and print what it wrote to \p out, or drop it if
+ *   \p out is NULL.
+ * @return The case of the stage.
+ */
+static cutest_case_t* _cutest_pipeline_stage_join(test_pipeline_stage_t* stage, FILE* out)
+{
+    cutest_thread_join(&stage->thread);
+
+    if (stage->out != NULL)
+    {
+        if (out != NULL)
+        {
+            _cutest_copy_file(out, stage->out);
+        }
+        fclose(stage->out);
+        stage->out = NULL;
+    }
+
+    cutest_case_t* test_case = stage->test_case;
+    stage->test_case = NULL;
+    return test_case;
+}
+
+/**
+ * @brief Start setup of next case on helper thread if its fixture is thread safe.
+ */
+static void _cutest_pipeline_prepare_next(void)
+{
+    if (s_test_pipeline.setup.test_case != NULL)
+    {
+        return;
+    }
+
+    cutest_map_node_t* it = s_test_pipeline.next != NULL ? &s_test_pipeline.next->node : NULL;
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (!_cutest_pipeline_will_run(test_case))
+        {
+            continue;
+        }
+
+        if (test_case->stage.setup != NULL && _cutest_pipeline_is_thread_safe(test_case))
+        {
+            test_case->data.fixture_data = NULL;
+            _cutest_pipeline_stage_start(&s_test_pipeline.setup, test_case, test_case->stage.setup);
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Wait for teardown of previous case, and print its result that was
+ *   held by #_cutest_pipeline_finishlize(), followed by the held output of
+ *   cases after it.
+ */
+static void _cutest_pipeline_collect_teardown(void)
+{
+    test_pipeline_stage_t* stage = &s_test_pipeline.teardown;
+    if (stage->test_case == NULL)
+    {
+        return;
+    }
+
+    FILE* held = g_test_ctx.out;
+    if (s_test_pipeline.out != NULL)
+    {
+        g_test_ctx.out = s_test_pipeline.out;
+        s_test_pipeline.out = NULL;
+    }
+
+    cutest_case_t* test_case = _cutest_pipeline_stage_join(stage, g_test_ctx.out);
+    _cutest_tmpdir_cleanup(test_case);
+    _cutest_hook_after_teardown(test_case, stage->ret);
+    if (stage->ret != 0)
+    {
+        SET_MASK(test_case->data.mask, stage->ret);
+    }
+
+    if (held == g_test_ctx.out)
+    {
+        return;
+    }
+
+    test_backtrace_t backtrace = s_test_backtrace;
+    s_test_backtrace = s_test_pipeline.backtrace;
+    _cutest_show_result(&s_test_pipeline.pending);
+    s_test_backtrace = backtrace;
+
+    _cutest_copy_file(g_test_ctx.out, held);
+    fclose(held);
+}
+
+/**
+ * @brief Print result of \p info. If its teardown is still running on helper
+ *   thread, hold the result, and the output of cases after it, until the
+ *   teardown is collected, so every case gets one result in the usual order.
+ */
+static void _cutest_pipeline_finishlize(test_case_info_t* info)
+{
+    FILE* held;
+    if (s_test_pipeline.teardown.test_case != info->test_case
+        || (held = cutest_memfile_open("cutest.pipeline")) == NULL)
+    {
+        _cutest_pipeline_collect_teardown();
+        _cutest_finishlize(info);
+        return;
+    }
+
+    cutest_porting_clock_gettime(&info->tv_case_end);
+    s_test_pipeline.pending = *info;
+    s_test_pipeline.backtrace = s_test_backtrace;
+    s_test_pipeline.out = g_test_ctx.out;
+    g_test_ctx.out = held;
+}
+
+/**
+ * @brief Wait for all helper threads. A prepared setup whose case does not
+ *   run is teardown immediately.
+ */
+static void _cutest_pipeline_flush(void)
+{
+    _cutest_pipeline_collect_teardown();
+
+    test_pipeline_stage_t* stage = &s_test_pipeline.setup;
+    if (stage->test_case == NULL)
+    {
+        return;
+    }
+
+    /* The case does not run, nor is reported. */
+    cutest_case_t* test_case = _cutest_pipeline_stage_join(stage, NULL);
+    if (stage->ret == 0 && test_case->stage.teardown != NULL)
+    {
+        _cutest_pipeline_stage_start(stage, test_case, test_case->stage.teardown);
+        _cutest_pipeline_stage_join(stage, NULL);
+    }
+    _cutest_tmpdir_cleanup(test_case);
+}
+
+/**
+ * @brief Run setup stage, or take the result of the one prepared on helper
+ *   thread. Hooks are always called here so they keep the usual order, which
+ *   means after a prepared setup has finished.
+ */
+static int _cutest_pipeline_setup(test_case_info_t* info)
+{
+    test_pipeline_stage_t* stage = &s_test_pipeline.setup;
+    if (stage->test_case != info->test_case)
+    {
+        info->test_case->data.fixture_data = NULL;
+        return _cutest_fixture_run_setup(info);
+    }
+
+    _cutest_pipeline_stage_join(stage, g_test_ctx.out);
+
+    _cutest_hook_before_fixture_setup(info->test_case);
+    _cutest_hook_after_fixture_setup(info->test_case, stage->ret);
+    if (stage->ret != 0)
+    {
+        SET_MASK(info->test_case->data.mask, stage->ret);
+    }
+    return stage->ret;
+}
+
+/**
+ * @brief Run teardown stage, or hand it over to helper thread.
+ */
+static void _cutest_pipeline_teardown(test_case_info_t* info)
+{
+    _cutest_pipeline_collect_teardown();
+
+    cutest_case_t* test_case = info->test_case;
+    if (test_case->stage.teardown == NULL || !_cutest_pipeline_is_thread_safe(test_case))
+    {
+        _cutest_fixture_run_teardown(info);
+        _cutest_tmpdir_cleanup(test_case);
+        return;
+    }
+
+    _cutest_hook_before_teardown(test_case);
+    _cutest_pipeline_stage_start(&s_test_pipeline.teardown, test_case, test_case->stage.teardown);
+}
+
+static void _cutest_run_case_normal_stages(void* arg)
+{
+    test_case_info_t* info = arg;
+
+    /* setup */
+    if (_cutest_pipeline_setup(info) != 0)
+    {
+        _cutest_tmpdir_cleanup(info->test_case);
+        return;
+    }
+
+    _cutest_pipeline_prepare_next();
+    _cutest_run_case_normal_body(info);
+    _cutest_pipeline_teardown(info);
+}
+
+static void _cutest_run_case_normal(cutest_case_t* test_case)
+{
+    test_case_info_t info;
+    unsigned long ret = _cutest_get_test_fmt_name_normal(info.fmt_name, sizeof(info.fmt_name), test_case);
+    if (ret >= sizeof(info.fmt_name))
+    {
+        cutest_abort("");
+        return;
+    }
+    info.fmt_name_sz = ret;
+    info.test_case = test_case;
+
+    if (_cutest_run_prepare(&info) != 0)
+    {
+        return;
+    }
+
+    _cutest_run_stages(&info, _cutest_run_case_normal_stages);
+    _cutest_pipeline_finishlize(&info);
+}
+
+static void _cutest_run_case_parameterized_body_jmp(cutest_porting_jmpbuf_t* buf,
+    cutest_porting_longjmp_fn fn_longjmp, int val, void* data)
+{
+    test_run_parameterized_helper_t* helper = data;
+    test_case_info_t* info = helper->info;
+    cutest_case_t* test_case = info->test_case;
+
+    _cutest_run_case_set_jmp(buf, fn_longjmp);
+
+    if (val != 0)
+    {
+        SET_MASK(info->test_case->data.mask, val);
+        goto after_body;
+    }
+
+    _cutest_flight_record(CUTEST_FLIGHT_BODY, 0, NULL);
+    _cutest_backtrace_mark();
+    info->test_case->stage.body(test_case->parameterized.param_data, test_case->parameterized.param_idx);
+
+after_body:
+    _cutest_hook_after_test(info, val);
+}
+
+static void _cutest_run_case_parameterized_body(test_case_info_t* info)
+{
+    _cutest_hook_before_test(info);
+
+    test_run_parameterized_helper_t helper = { info };
+    cutest_porting_setjmp(_cutest_run_case_parameterized_body_jmp, &helper);
+}
+
+static void _cutest_run_case_parameterized_stages(void* arg)
+{
+    test_case_info_t* info = arg;
+
+    /* setup */
+    if (_cutest_pipeline_setup(info) != 0)
+    {
+        _cutest_tmpdir_cleanup(info->test_case);
+        return;
+    }
+
+    _cutest_pipeline_prepare_next();
+    _cutest_run_case_parameterized_body(info);
+    _cutest_pipeline_teardown(info);
+}
+
+static void _cutest_run_case_parameterized_idx(test_case_info_t* info)
+{
+    if (_cutest_run_prepare(info) != 0)
+    {
+        return;
+    }
+
+    _cutest_run_stages(info, _cutest_run_case_parameterized_stages);
+    _cutest_pipeline_finishlize(info);
+}
+
+static void _cutest_run_case_parameterized(cutest_case_t* test_case)
+{
+    test_case_info_t info;
+    info.test_case = test_case;
+
+    unsigned long ret = _cutest_get_test_fmt_name_parameter(info.fmt_name, sizeof(info.fmt_name), test_case);
+    if (ret >= sizeof(info.fmt_name))
+    {
+        cutest_abort("name too long.\n");
+        return;
+    }
+    info.fmt_name_sz = ret;
+
+    _cutest_run_case_parameterized_idx(&info);
+}
+
+/**
+ * run test case.
+ * the target case was set to `g_test_ctx.runtime.cur_case`
+ */
+static void _cutest_run_case(cutest_case_t* test_case)
+{
+    test_case->data.mask = 0;
+    test_case->benchmark.iterations = 0;
+    test_case->benchmark.ns_per_op = 0;
+    test_case->benchmark.spread = -1;
+    test_case->benchmark.cold_iterations = 0;
+    test_case->benchmark.cold_ns_per_op = 0;
+    test_case->benchmark.complexity_n = 0;
+    test_case->benchmark.complexity = CUTEST_COMPLEXITY_AUTO;
+    cutest_porting_memset(&test_case->histogram, 0, sizeof(test_case->histogram));
+    g_test_ctx.benchmark.running = 0;
+    g_test_ctx.benchmark.cold = 0;
+    g_test_ctx.benchmark.total_ns = 0;
+    g_test_ctx.benchmark.total_iterations = 0;
+    g_test_ctx.benchmark.threads = 0;
+    g_test_ctx.perf.running = 0;
+    _cutest_hist_reset();
+    s_test_counters.size = 0;
+    s_test_backtrace.size = 0;
+
+    if (test_case->parameterized.type_name != NULL)
+    {
+        _cutest_run_case_parameterized(test_case);
+    }
+    else
+    {
+        _cutest_run_case_normal(test_case);
+    }
+
+    /* The benchmark might be interrupted by failure. */
+    _cutest_benchmark_end();
+}
+
+static void _cutest_reset_all_test_mask(void)
+{
+    cutest_porting_memset(&g_test_ctx.counter.result, 0, sizeof(g_test_ctx.counter.result));
+
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        test_case->data.mask = 0;
+    }
+}
+
+static const char* _cutest_complexity_name(int complexity)
+{
+    switch (complexity)
+    {
+    case CUTEST_COMPLEXITY_1:       return "1";
+    case CUTEST_COMPLEXITY_LOGN:    return "logN";
+    case CUTEST_COMPLEXITY_N:       return "N";
+    case CUTEST_COMPLEXITY_NLOGN:   return "NlogN";
+    case CUTEST_COMPLEXITY_N2:      return "N^2";
+    case CUTEST_COMPLEXITY_N3:      return "N^3";
+    default:                        break;
+    }
+    return "?";
+}
+
+static double _cutest_complexity_fn(int complexity, double n)
+{
+    switch (complexity)
+    {
+    case CUTEST_COMPLEXITY_LOGN:    return cutest_porting_log2(n);
+    case CUTEST_COMPLEXITY_N:       return n;
+    case CUTEST_COMPLEXITY_NLOGN:   return n * cutest_porting_log2(n);
+    case CUTEST_COMPLEXITY_N2:      return n * n;
+    case CUTEST_COMPLEXITY_N3:      return n * n * n;
+    default:                        break;
+    }
+    return 1;
+}
+
+/**
+ * @brief Check if \p t1 and \p t2 are instances of the same parameterized
+ *   test. Cases of different modules never are, even if named the same.
+ */
+static int _cutest_same_family(const cutest_case_t* t1, const cutest_case_t* t2)
+{
+    return t1->info.module_name == t2->info.module_name
+        && cutest_porting_strcmp(t1->info.fixture_name, t2->info.fixture_name) == 0
+        && cutest_porting_strcmp(t1->info.case_name, t2->info.case_name) == 0;
+}
+
+typedef struct test_param_history
+{
+    cutest_map_node_t               node;
+    unsigned long                   run;            /**< The last run it failed. */
+    char*                           name;           /**< Name of instance. */
+} test_param_history_t;
+
+static int _cutest_on_cmp_param_history(const cutest_map_node_t* key1, const cutest_map_node_t* key2, void* arg)
+{
+    (void)arg;
+    test_param_history_t* h1 = CONTAINER_OF(key1, test_param_history_t, node);
+    test_param_history_t* h2 = CONTAINER_OF(key2, test_param_history_t, node);
+    return cutest_porting_strcmp(h1->name, h2->name);
+}
+
+static struct
+{
+    unsigned long                   count;          /**< `--test_param_sample=K`, 0 if by percent. */
+    unsigned long                   percent;        /**< `--test_param_sample=P%`. */
+    unsigned long                   shard_index;    /**< `--test_param_sample_shard=INDEX/TOTAL` */
+    unsigned long                   shard_total;    /**< 0 if not sharded. */
+    const char*                     history_path;   /**< `--test_param_history` */
+    unsigned long                   run;            /**< Number of this run, counted by history. */
+    unsigned long                   seed;           /**< Seed of sampling, kept by history. */
+    cutest_map_t                    history;        /**< Recently failed instances. #test_param_history_t */
+} s_test_param_sample;
+
+static int _cutest_param_sample_enabled(void)
+{
+    return s_test_param_sample.count != 0 || s_test_param_sample.percent != 0;
+}
+
+static unsigned long _cutest_param_sample_hash(const char* str)
+{
+    /* FNV-1a, stable across platforms and runs. */
+    unsigned long hash = 2166136261UL;
+    for (; *str != '\0'; str++)
+    {
+        hash = ((hash ^ (unsigned char)*str) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
+static unsigned long _cutest_param_sample_mix(unsigned long hash, unsigned long value)
+{
+    int i;
+    for (i = 0; i < 4; i++, value >>= 8)
+    {
+        hash = ((hash ^ (value & 0xFFUL)) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+    return hash;
+}
+
+static unsigned long _cutest_param_sample_gcd(unsigned long a, unsigned long b)
+{
+    while (b != 0)
+    {
+        unsigned long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static test_param_history_t* _cutest_param_sample_find(const char* name)
+{
+    test_param_history_t key;
+    key.name = (char*)name;
+
+    cutest_map_node_t* it = cutest_map_find(&s_test_param_sample.history, &key.node);
+    return it != NULL ? CONTAINER_OF(it, test_param_history_t, node) : NULL;
+}
+
+static void _cutest_param_sample_add_failure(const char* name, unsigned long run)
+{
+    test_param_history_t* item = _cutest_param_sample_find(name);
+    if (item != NULL)
+    {
+        item->run = run > item->run ? run : item->run;
+        return;
+    }
+
+    unsigned long len = cutest_porting_strlen(name);
+    if ((item = malloc(sizeof(*item) + len + 1)) == NULL)
+    {
+        return;
+    }
+    item->run = run;
+    item->name = (char*)(item + 1);
+    cutest_porting_memcpy(item->name, name, len + 1);
+    cutest_map_insert(&s_test_param_sample.history, &item->node);
+}
+
+/**
+ * @brief Load history. The first lines are `run<TAB>RUN` and `seed<TAB>SEED`,
+ *   followed by `failed<TAB>RUN<TAB>NAME` for each recently failed instance.
+ */
+static void _cutest_param_sample_load_history(void)
+{
+    cutest_map_t history = CUTEST_MAP_INIT(_cutest_on_cmp_param_history, NULL);
+    s_test_param_sample.history = history;
+    s_test_param_sample.run = 0;
+    s_test_param_sample.seed = g_test_ctx.runtime.seed & 0xFFFFFFFFUL;
+
+    FILE* file;
+    if (s_test_param_sample.history_path == NULL
+        || (file = fopen(s_test_param_sample.history_path, "r")) == NULL)
+    {
+        return;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        unsigned long len = cutest_porting_strlen(line);
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        {
+            line[--len] = '\0';
+        }
+
+        unsigned long run;
+        if (cutest_porting_strncmp(line, "run\t", 4) == 0)
+        {
+            if (cutest_porting_atoul(line + 4, &run) == 0)
+            {
+                s_test_param_sample.run = run;
+            }
+            continue;
+        }
+        if (cutest_porting_strncmp(line, "seed\t", 5) == 0)
+        {
+            if (cutest_porting_atoul(line + 5, &run) == 0)
+            {
+                s_test_param_sample.seed = run;
+            }
+            continue;
+        }
+
+        char* name;
+        if (cutest_porting_strncmp(line, "failed\t", 7) != 0
+            || (name = cutest_porting_strchr(line + 7, '\t')) == NULL)
+        {
+            continue;
+        }
+        *name++ = '\0';
+        if (cutest_porting_atoul(line + 7, &run) == 0)
+        {
+            _cutest_param_sample_add_failure(name, run);
+        }
+    }
+    fclose(file);
+}
+
+/**
+ * @brief Pick a stride coprime to \p size that is not 1 or size - 1, or
+ *   the sample would be a contiguous window of instances.
+ * @return The stride, or 1 if \p size has none.
+ */
+static unsigned long _cutest_param_sample_stride(unsigned long size, unsigned long key)
+{
+    if (size < 5)
+    {
+        return 1;
+    }
+
+    unsigned long i, stride = 2 + key % (size - 3);
+    for (i = 0; i < size - 3; i++)
+    {
+        if (_cutest_param_sample_gcd(stride, size) == 1)
+        {
+            return stride;
+        }
+        stride = stride < size - 2 ? stride + 1 : 2;
+    }
+    return 1;
+}
+
+/**
+ * @brief Decide which instances of the family starting at \p first run.
+ *
+ * Instances are visited in an order derived from the name of family and
+ * the seed, and each run takes the next window of them, so they are all
+ * covered after enough runs. Shards of the same run take different windows.
+ *
+ * @return The last instance of the family.
+ */
+static cutest_case_t* _cutest_param_sample_family(cutest_case_t* first)
+{
+    char name[256];
+    unsigned long size = 0, matched = 0, sampled = 0, recent = 0;
+    cutest_case_t* last = first;
+
+    cutest_map_node_t* it = &first->node;
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (test_case->parameterized.type_name == NULL || !_cutest_same_family(test_case, first))
+        {
+            break;
+        }
+        last = test_case;
+        size++;
+    }
+
+    unsigned long count = s_test_param_sample.count != 0 ?
+        s_test_param_sample.count : (size * s_test_param_sample.percent + 99) / 100;
+    count = count == 0 ? 1 : (count > size ? size : count);
+
+    _cutest_get_test_fmt_name_normal(name, sizeof(name), first);
+    unsigned long hash = _cutest_param_sample_mix(_cutest_param_sample_hash(name), s_test_param_sample.seed);
+    unsigned long stride = _cutest_param_sample_stride(size, hash);
+
+    unsigned long shards = s_test_param_sample.shard_total != 0 ? s_test_param_sample.shard_total : 1;
+    unsigned long round = s_test_param_sample.run * shards + s_test_param_sample.shard_index;
+    unsigned long begin = round % ((size + count - 1) / count) * count;
+    unsigned long pos = _cutest_param_sample_mix(hash, s_test_param_sample.seed) % size;
+
+    for (it = &first->node; ; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        unsigned long name_sz = _cutest_get_test_fmt_name_parameter(name, sizeof(name), test_case);
+
+        int selected = (pos + size - begin) % size < count;
+        if (!selected && _cutest_param_sample_find(name) != NULL)
+        {
+            selected = 1;
+            recent++;
+        }
+        test_case->data.sampled_out = !selected;
+
+        if (name_sz < sizeof(name) && _cutest_check_pattern(name, name_sz))
+        {
+            matched++;
+            sampled += selected;
+        }
+
+        pos = (pos + stride) % size;
+        if (test_case == last)
+        {
+            break;
+        }
+    }
+
+    if (matched != 0)
+    {
+        _cutest_get_test_fmt_name_normal(name, sizeof(name), first);
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "[ SAMPLE   ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT,
+            " %s: %lu/%lu instance%s, %lu failed recently.\n",
+            name, sampled, matched, matched > 1 ? "s" : "", recent);
+    }
+    return last;
+}
+
+/**
+ * @brief Apply `--test_param_sample` before tests run.
+ */
+static void _cutest_param_sample_setup(void)
+{
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        CONTAINER_OF(it, cutest_case_t, node)->data.sampled_out = 0;
+    }
+
+    if (!_cutest_param_sample_enabled())
+    {
+        return;
+    }
+
+    _cutest_param_sample_load_history();
+    for (it = cutest_map_begin(&g_test_ctx.case_table); it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (test_case->parameterized.type_name != NULL)
+        {
+            it = &_cutest_param_sample_family(test_case)->node;
+        }
+    }
+}
+
+/**
+ * @brief Remember instances failed in this run.
+ */
+static void _cutest_param_sample_collect(void)
+{
+    if (!_cutest_param_sample_enabled() || s_test_param_sample.history_path == NULL)
+    {
+        return;
+    }
+
+    char name[256];
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (test_case->parameterized.type_name != NULL && HAS_MASK(test_case->data.mask, MASK_FAILURE)
+            && _cutest_get_test_fmt_name_parameter(name, sizeof(name), test_case) < sizeof(name))
+        {
+            _cutest_param_sample_add_failure(name, s_test_param_sample.run);
+        }
+    }
+}
+
+/**
+ * @brief Save history for next run and release it.
+ * @param[in] save - Whether to write the history file.
+ */
+static void _cutest_param_sample_cleanup(int save)
+{
+    if (!_cutest_param_sample_enabled())
+    {
+        return;
+    }
+
+    FILE* file = NULL;
+    if (save && s_test_param_sample.history_path != NULL
+        && (file = fopen(s_test_param_sample.history_path, "w")) == NULL)
+    {
+        _cutest_warning("Can not write parameter history `%s'.\n", s_test_param_sample.history_path);
+    }
+    if (file != NULL)
+    {
+        cutest_porting_fprintf(file, "run\t%lu\n", s_test_param_sample.run + 1);
+        cutest_porting_fprintf(file, "seed\t%lu\n", s_test_param_sample.seed);
+    }
+
+    cutest_map_node_t* it;
+    while ((it = cutest_map_begin(&s_test_param_sample.history)) != NULL)
+    {
+        test_param_history_t* item = CONTAINER_OF(it, test_param_history_t, node);
+        if (file != NULL && s_test_param_sample.run - item->run < PARAM_SAMPLE_HISTORY_RUNS)
+        {
+            cutest_porting_fprintf(file, "failed\t%lu\t%s\n", item->run, item->name);
+        }
+        cutest_map_erase(&s_test_param_sample.history, it);
+        free(item);
+    }
+
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+}
+
+static int _cutest_complexity_has_data(const cutest_case_t* test_case)
+{
+    return test_case->benchmark.iterations != 0 && test_case->benchmark.complexity_n != 0;
+}
+
+/**
+ * @brief Fit all instances of the parameterized benchmark that \p first
+ *   belongs to by least squares, and report the best fitting complexity.
+ *
+ * Residuals are relative to the measured time, so noise of the largest
+ * instance does not outweigh all the others. Among classes that fit about
+ * equally well, the slowest growing one is taken.
+ */
+static void _cutest_complexity_fit_family(cutest_case_t* first)
+{
+    char name[256];
+    double sum_g[CUTEST_COMPLEXITY_N3 + 1], sum_gg[CUTEST_COMPLEXITY_N3 + 1];
+    double rms[CUTEST_COMPLEXITY_N3 + 1], coef[CUTEST_COMPLEXITY_N3 + 1];
+    unsigned long cnt = 0;
+    int expect = CUTEST_COMPLEXITY_AUTO;
+    cutest_case_t* last = first;
+    int i;
+
+    for (i = 0; i <= CUTEST_COMPLEXITY_N3; i++)
+    {
+        sum_g[i] = 0;
+        sum_gg[i] = 0;
+    }
+
+    /* Instances of a family are adjacent in case table. */
+    cutest_map_node_t* it = &first->node;
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (!_cutest_same_family(first, test_case))
+        {
+            break;
+        }
+        if (!_cutest_complexity_has_data(test_case))
+        {
+            continue;
+        }
+        SET_MASK(test_case->data.mask, MASK_BIGO_VISITED);
+
+        double t = test_case->benchmark.ns_per_op;
+        double n = (double)test_case->benchmark.complexity_n;
+        if (t <= 0)
+        {
+            continue;
+        }
+        for (i = CUTEST_COMPLEXITY_1; i <= CUTEST_COMPLEXITY_N3; i++)
+        {
+            double g = _cutest_complexity_fn(i, n) / t;
+            sum_g[i] += g;
+            sum_gg[i] += g * g;
+        }
+        cnt++;
+
+        if (test_case->benchmark.complexity > expect)
+        {
+            expect = test_case->benchmark.complexity;
+        }
+        if (test_case->parameterized.param_idx >= last->parameterized.param_idx)
+        {
+            last = test_case;
+        }
+    }
+
+    /* Need at least two points to fit a curve. */
+    if (cnt < 2)
+    {
+        return;
+    }
+
+    /*
+     * With g = f/t, sum(((t - c*f)/t)^2) = cnt - 2c*sum(g) + c^2*sum(g^2),
+     * which is minimal at c = sum(g)/sum(g^2).
+     */
+    double min_rms = -1;
+    for (i = CUTEST_COMPLEXITY_1; i <= CUTEST_COMPLEXITY_N3; i++)
+    {
+        rms[i] = -1;
+        if (sum_gg[i] == 0)
+        {
+            continue;
+        }
+        coef[i] = sum_g[i] / sum_gg[i];
+        double sse = cnt - sum_g[i] * coef[i];
+        rms[i] = cutest_porting_sqrt((sse > 0 ? sse : 0) / cnt);
+        if (min_rms < 0 || rms[i] < min_rms)
+        {
+            min_rms = rms[i];
+        }
+    }
+
+    int best = CUTEST_COMPLEXITY_1;
+    for (i = CUTEST_COMPLEXITY_1; i <= CUTEST_COMPLEXITY_N3; i++)
+    {
+        if (rms[i] >= 0 && rms[i] <= min_rms * BENCHMARK_BIGO_MARGIN)
+        {
+            best = i;
+            break;
+        }
+    }
+
+    _cutest_get_test_fmt_name_normal(name, sizeof(name), first);
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ BIG-O    ]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s O(%s), %.4f ns * %s, RMS %.0f%%\n",
+        name, _cutest_complexity_name(best), coef[best], _cutest_complexity_name(best), rms[best] * 100);
+
+    if (expect == CUTEST_COMPLEXITY_AUTO || best <= expect)
+    {
+        return;
+    }
+
+    cutest_porting_fprintf(g_test_ctx.out,
+        "%s:complexity failure:\n"
+        "            expected: O(%s)\n"
+        "              actual: O(%s)\n",
+        name, _cutest_complexity_name(expect), _cutest_complexity_name(best));
+    _cutest_set_finished_case_failure(last);
+}
+
+static void _cutest_complexity_fit_all(void)
+{
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (!_cutest_complexity_has_data(test_case) || HAS_MASK(test_case->data.mask, MASK_BIGO_VISITED))
+        {
+            continue;
+        }
+        _cutest_complexity_fit_family(test_case);
+    }
+}
+
+typedef struct test_resource
+{
+    cutest_resource_t           resource;
+    char*                       path;                               /**< Path, followed by name. */
+    unsigned long               users;                              /**< The number of cases used it. */
+} test_resource_t;
+
+/**
+ * @brief A case that mapped a resource, so each case is counted once no matter
+ *   how often or in which order cases map it.
+ */
+typedef struct test_resource_user
+{
+    cutest_map_node_t           node;
+    unsigned                    idx;                                /**< Index of resource. */
+    const cutest_case_t*        test_case;
+} test_resource_user_t;
+
+static int _cutest_on_cmp_resource_user(const cutest_map_node_t* key1, const cutest_map_node_t* key2, void* arg)
+{
+    (void)arg;
+    test_resource_user_t* u1 = CONTAINER_OF(key1, test_resource_user_t, node);
+    test_resource_user_t* u2 = CONTAINER_OF(key2, test_resource_user_t, node);
+    if (u1->idx != u2->idx)
+    {
+        return u1->idx < u2->idx ? -1 : 1;
+    }
+    if (u1->test_case != u2->test_case)
+    {
+        return (uintptr_t)u1->test_case < (uintptr_t)u2->test_case ? -1 : 1;
+    }
+    return 0;
+}
+
+static struct
+{
+    cutest_map_t                users;                              /**< #test_resource_user_t */
+    test_resource_t             resources[RESOURCE_MAX_COUNT];
+    unsigned                    size;
+    volatile long               lock;
+    const char*                 dir;                                /**< `--test_resource_dir`. */
+    int                         prefetch;                           /**< `--test_resource_prefetch`. */
+    const char*                 preload[RESOURCE_MAX_COUNT];        /**< `--test_resource_preload`. */
+    unsigned                    preload_sz;
+} s_test_resource;
+
+/**
+ * @brief Find resource \p name, map it if not yet.
+ * @return NULL if failed.
+ */
+static test_resource_t* _cutest_resource_get(const char* name)
+{
+    unsigned i;
+    for (i = 0; i < s_test_resource.size; i++)
+    {
+        if (cutest_porting_strcmp(s_test_resource.resources[i].resource.name, name) == 0)
+        {
+            return &s_test_resource.resources[i];
+        }
+    }
+    if (s_test_resource.size == RESOURCE_MAX_COUNT)
+    {
+        return NULL;
+    }
+
+    const char* dir = s_test_resource.dir;
+    if (name[0] == '/' || name[0] == '\\' || (name[0] != '\0' && name[1] == ':'))
+    {
+        dir = NULL;
+    }
+    unsigned long dir_sz = dir != NULL ? cutest_porting_strlen(dir) : 0;
+    unsigned long name_sz = cutest_porting_strlen(name);
+    char* path = malloc(dir_sz + 1 + name_sz + 1 + name_sz + 1);
+    if (path == NULL)
+    {
+        return NULL;
+    }
+
+    unsigned long pos = 0;
+    if (dir != NULL)
+    {
+        cutest_porting_memcpy(path, dir, dir_sz);
+        pos = dir_sz;
+        path[pos++] = '/';
+    }
+    cutest_porting_memcpy(path + pos, name, name_sz + 1);
+    char* copy = path + pos + name_sz + 1;
+    cutest_porting_memcpy(copy, name, name_sz + 1);
+
+    size_t size = 0;
+    void* data = cutest_file_map(path, s_test_resource.prefetch, &size);
+    if (data == NULL)
+    {
+        free(path);
+        return NULL;
+    }
+
+    test_resource_t* item = &s_test_resource.resources[s_test_resource.size++];
+    item->resource.name = copy;
+    item->resource.data = data;
+    item->resource.size = size;
+    item->path = path;
+    item->users = 0;
+    return item;
+}
+
+/**
+ * @brief Prepare for #cutest_resource_map(). Resources given by
+ *   `--test_resource_preload` are mapped now, so child processes forked later
+ *   share the mapping.
+ */
+static void _cutest_resource_preload(void)
+{
+    cutest_map_t users = CUTEST_MAP_INIT(_cutest_on_cmp_resource_user, NULL);
+    s_test_resource.users = users;
+
+    unsigned i;
+    for (i = 0; i < s_test_resource.preload_sz; i++)
+    {
+        if (_cutest_resource_get(s_test_resource.preload[i]) == NULL)
+        {
+            _cutest_warning("Can not map resource `%s'.\n", s_test_resource.preload[i]);
+        }
+    }
+}
+
+static void _cutest_resource_unmap_all(void)
+{
+    unsigned i;
+    for (i = 0; i < s_test_resource.size; i++)
+    {
+        test_resource_t* item = &s_test_resource.resources[i];
+        cutest_file_unmap((void*)item->resource.data, item->resource.size);
+        free(item->path);
+    }
+
+    cutest_map_node_t* it;
+    while ((it = cutest_map_begin(&s_test_resource.users)) != NULL)
+    {
+        cutest_map_erase(&s_test_resource.users, it);
+        free(CONTAINER_OF(it, test_resource_user_t, node));
+    }
+
+    cutest_porting_memset(&s_test_resource, 0, sizeof(s_test_resource));
+}
+
+/**
+ * @brief Count \p test_case as a user of \p item, once.
+ */
+static void _cutest_resource_add_user(test_resource_t* item, const cutest_case_t* test_case)
+{
+    test_resource_user_t key;
+    key.idx = (unsigned)(item - s_test_resource.resources);
+    key.test_case = test_case;
+    if (cutest_map_find(&s_test_resource.users, &key.node) != NULL)
+    {
+        return;
+    }
+
+    test_resource_user_t* user = malloc(sizeof(*user));
+    if (user == NULL)
+    {
+        return;
+    }
+    *user = key;
+    cutest_map_insert(&s_test_resource.users, &user->node);
+    item->users++;
+}
+
+/**
+ * @brief Compressed files decompressed by cutest_embed_data().
+ */
+static struct
+{
+    cutest_embed_t*             head;
+    volatile long               lock;
+} s_test_embed;
+
+static void _cutest_embed_lock(void)
+{
+    while (!cutest_atomic_cas(&s_test_embed.lock, 0, 1))
+    {
+        cutest_thread_yield();
+    }
+}
+
+static void _cutest_embed_unlock(void)
+{
+    cutest_atomic_cas(&s_test_embed.lock, 1, 0);
+}
+
+/**
+ * @brief Free decompressed files. They are decompressed again on next access.
+ * @note Must be called before any module is unloaded, as the list may point
+ *   into it.
+ */
+static void _cutest_embed_free_all(void)
+{
+    _cutest_embed_lock();
+    cutest_embed_t* embed = s_test_embed.head;
+    s_test_embed.head = NULL;
+    _cutest_embed_unlock();
+
+    while (embed != NULL)
+    {
+        cutest_embed_t* next = embed->next;
+        free(embed->cache);
+        embed->cache = NULL;
+        embed->next = NULL;
+        embed->state = 0;
+        embed = next;
+    }
+}
+
+static void _cutest_resource_show_report(void)
+{
+    unsigned i;
+    for (i = 0; i < s_test_resource.size; i++)
+    {
+        test_resource_t* item = &s_test_resource.resources[i];
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "[ RESOURCE ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s: %.1f MB, used by %lu test%s.\n",
+            item->resource.name, (double)item->resource.size / (1024 * 1024),
+            item->users, item->users > 1 ? "s" : "");
+    }
+}
+
+static void _cutest_show_report_failed(void)
+{
+    char buffer[512];
+
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (!HAS_MASK(test_case->data.mask, MASK_FAILURE))
+        {
+            continue;
+        }
+
+        if (test_case->parameterized.type_name == NULL)
+        {
+            _cutest_get_test_fmt_name_normal(buffer, sizeof(buffer), test_case);
+        }
+        else
+        {
+            _cutest_get_test_fmt_name_parameter(buffer, sizeof(buffer), test_case);
+        }
+
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_RED, "[  FAILED  ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s\n", buffer);
+    }
+}
+
+static void _cutest_show_report(const cutest_porting_timespec_t* tv_total_start,
+    const cutest_porting_timespec_t* tv_total_end)
+{
+    cutest_porting_timespec_t tv_diff;
+    cutest_timestamp_dif(tv_total_start, tv_total_end, &tv_diff);
+
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "[==========]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %u/%u test case%s ran.",
+        g_test_ctx.counter.result.total,
+        (unsigned)g_test_ctx.case_table.size,
+        g_test_ctx.counter.result.total > 1 ? "s" : "");
+    if (!g_test_ctx.mask.no_print_time)
+    {
+        unsigned long take_time = (unsigned long)(tv_diff.tv_sec * 1000 + tv_diff.tv_nsec / 1000000);
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " (%lu ms total)", take_time);
+    }
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
+
+    if (g_test_ctx.counter.result.disabled != 0)
+    {
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ DISABLED ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %u test%s.\n",
+            g_test_ctx.counter.result.disabled,
+            g_test_ctx.counter.result.disabled > 1 ? "s" : "");
+    }
+    if (g_test_ctx.counter.result.skipped != 0)
+    {
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW,"[ BYPASSED ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %u test%s.\n",
+            g_test_ctx.counter.result.skipped,
+            g_test_ctx.counter.result.skipped > 1 ? "s" : "");
+    }
+    if (g_test_ctx.counter.result.success != 0)
+    {
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[  PASSED  ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %u test%s.\n",
+            g_test_ctx.counter.result.success,
+            g_test_ctx.counter.result.success > 1 ? "s" : "");
+    }
+    _cutest_resource_show_report();
+
+    /* don't show failed tests if every test was success */
+    if (g_test_ctx.counter.result.failed == 0)
+    {
+        return;
+    }
+
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_RED, "[  FAILED  ]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT,
+        " %u test%s, listed below:\n", g_test_ctx.counter.result.failed, g_test_ctx.counter.result.failed > 1 ? "s" : "");
+    _cutest_show_report_failed();
+}
+
+static int _cutest_setup_arg_pattern(char* user_pattern)
+{
+    g_test_ctx.filter.pattern = _cutest_str(user_pattern);
+    return 0;
+}
+
+/**
+ * @return The length of whole string, including double quotation marks.
+ */
+static unsigned long _cutest_parameterized_parser_peek_string(const char* str)
+{
+    CUTEST_PORTING_ASSERT(str[0] == '"');
+
+    unsigned long pos = 1;
+    int flag_escape = 0;
+
+    /* Find valid double quotation marks. */
+    for (; str[pos] != 0; pos++)
+    {
+        char c = str[pos];
+        if (flag_escape)
+        {
+            flag_escape = 0;
+            continue;
+        }
+
+        switch (c)
+        {
+        case '\\':
+            flag_escape = 1;
+            break;
+
+        case '"':
+            return pos + 1;
+        }
+    }
+
+    CUTEST_PORTING_ASSERT(!"string not end with quote");
+    return 0;
+}
+
+static unsigned long _cutest_parameterized_parser_peek_struct(const char* str)
+{
+    CUTEST_PORTING_ASSERT(str[0] == '{');
+
+    unsigned long pos = 1;
+    unsigned long left_bracket = 1;
+
+    for (; str[pos] != '\0'; pos++)
+    {
+        char c = str[pos];
+        switch (c)
+        {
+        case '"':
+            pos += _cutest_parameterized_parser_peek_string(str + pos) - 1;
+            break;
+
+        case '{':
+            left_bracket++;
+            break;
+
+        case '}':
+            left_bracket--;
+            if (left_bracket == 0)
+            {
+                return pos + 1;
+            }
+
+        default:
+            break;
+        }
+    }
+
+    CUTEST_PORTING_ASSERT_P(str[pos] != '\0', "unbalanced struct: %s", str);
+    return 0;
+}
+
+/**
+ * @brief Parser static initialize code into sequence of tokens.
+ * @param[in] code  Initialize code.
+ * @param[in] idx   Index of element we want.
+ * @param[out] len  The length of element code in bytes.
+ * @return          The position of element code.
+ */
+static const char* _cutest_parameterized_parser(const char* code, unsigned long idx, int* len)
+{
+    const char* str = code;
+    unsigned long pos = 0;
+
+    for (; code[pos] != '\0'; pos++)
+    {
+        char c = code[pos];
+        switch (c)
+        {
+        case '"':
+            pos += _cutest_parameterized_parser_peek_string(code + pos) - 1;
+            break;
+
+        case ' ':
+            break;
+
+        case '{':
+            pos += _cutest_parameterized_parser_peek_struct(code + pos) - 1;
+            break;
+
+        case ',':
+            if (idx == 0)
+            {
+                goto finish;
+            }
+            else
+            {
+                idx--;
+                str = code + pos + 1;
+                while (*str == ' ')
+                {
+                    str++;
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+finish:
+    *len = (int)(code + pos - str);
+    return str;
+}
+
+static void _cutest_list_tests_print_name(const cutest_case_t* test_case)
+{
+    const char* case_name = test_case->info.case_name;
+
+    if (test_case->parameterized.type_name == NULL)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "  %s\n", case_name);
+        return;
+    }
+
+    const char* type_name = test_case->parameterized.type_name;
+    unsigned long parameterized_idx = test_case->parameterized.param_idx;
+
+    int len = 0;;
+    const char* str = _cutest_parameterized_parser(test_case->parameterized.test_data_cstr, parameterized_idx, &len);
+
+    cutest_porting_fprintf(g_test_ctx.out, "  %s/%u  # <%s> %.*s\n",
+        case_name, (unsigned)parameterized_idx, type_name, len, str);
+}
+
+static void _cutest_list_tests(void)
+{
+    const char* last_class_name = "";
+    const char* last_module_name = NULL;
+
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+
+        /* some compiler will make same string with different address */
+        if (last_module_name != test_case->info.module_name
+            || (last_class_name != test_case->info.fixture_name
+                && cutest_porting_strcmp(last_class_name, test_case->info.fixture_name) != 0))
+        {
+            last_class_name = test_case->info.fixture_name;
+            last_module_name = test_case->info.module_name;
+            if (last_module_name != NULL)
+            {
+                cutest_porting_fprintf(g_test_ctx.out, "%s.", last_module_name);
+            }
+            cutest_porting_fprintf(g_test_ctx.out, "%s.\n", last_class_name);
+        }
+        _cutest_list_tests_print_name(test_case);
+    }
+}
+
+static void _cutest_list_types(void)
+{
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.type_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_type_info_t* type_info = CONTAINER_OF(it, cutest_type_info_t, node);
+        cutest_porting_fprintf(g_test_ctx.out, "%s\n", type_info->type_name);
+    }
+}
+
+static int _cutest_setup_arg_repeat(const char* str)
+{
+    unsigned long repeat;
+    if (cutest_porting_atoul(str, &repeat) != 0)
+    {
+        return 1 << 8 | 1;
+    }
+
+    g_test_ctx.counter.repeat.repeat = repeat;
+    return 0;
+}
+
+static int _cutest_setup_arg_repeat_until_fail(const char* str)
+{
+    unsigned long val;
+    if (cutest_porting_atoul(str, &val) != 0 || val == 0)
+    {
+        return 1 << 8 | 1;
+    }
+
+    g_test_ctx.counter.repeat.until_fail = val;
+    return 0;
+}
+
+static int _cutest_setup_arg_repeat_jobs(const char* str)
+{
+    unsigned long val;
+    if (cutest_porting_atoul(str, &val) != 0 || val == 0 || val > REPEAT_MAX_JOBS)
+    {
+        return 1 << 8 | 1;
+    }
+
+    g_test_ctx.counter.repeat.jobs = (unsigned)val;
+    return 0;
+}
+
+static int _cutest_setup_arg_benchmark_min_time(const char* str)
+{
+    unsigned long val;
+    if (cutest_porting_atoul(str, &val) != 0 || val == 0)
+    {
+        return 1 << 8 | 1;
+    }
+
+    g_test_ctx.benchmark.min_time_ms = val;
+    return 0;
+}
+
+static int _cutest_setup_arg_benchmark_repetitions(const char* str)
+{
+    unsigned long val;
+    if (cutest_porting_atoul(str, &val) != 0 || val == 0)
+    {
+        return 1 << 8 | 1;
+    }
+
+    g_test_ctx.benchmark.repetitions = val;
+    return 0;
+}
+
+static int _cutest_setup_arg_print_time(const char* str)
+{
+    unsigned long val = 1;
+    if (cutest_porting_atoul(str, &val) != 0)
+    {
+        return 1 << 8 | 1;
+    }
+
+    g_test_ctx.mask.no_print_time = !val;
+    return 0;
+}
+
+static void _cutest_srand(unsigned long s)
+{
+    s = s % (MAX_RAND + 1);
+    cutest_porting_srand(s);
+    g_test_ctx.runtime.seed = s;
+}
+
+static int _cutest_setup_arg_random_seed(const char* str)
+{
+    unsigned long val = 0;
+    if (cutest_porting_atoul(str, &val) != 0)
+    {
+        return 1 << 8 | 1;
+    }
+
+    if (val > MAX_RAND)
+    {
+        return 1 << 8 | 1;
+    }
+
+    _cutest_srand(val);
+    return 0;
+}
+
+static void _cutest_shuffle_cases(void)
+{
+    cutest_map_node_t* it;
+    while ((it = cutest_map_begin(&g_test_ctx.case_table)) != NULL)
+    {
+        cutest_case_t* tc = CONTAINER_OF(it, cutest_case_t, node);
+        if (tc->data.randkey != 0)
+        {
+            break;
+        }
+
+        cutest_map_erase(&g_test_ctx.case_table, it);
+        tc->data.randkey = cutest_porting_rand(MAX_RAND + 1);
+        cutest_map_insert(&g_test_ctx.case_table, it);
+    }
+}
+
+static void _cutest_undo_shuffle_cases(void)
+{
+    cutest_map_node_t* it;
+
+    while ((it = cutest_map_end(&g_test_ctx.case_table)) != NULL)
+    {
+        cutest_case_t* tc = CONTAINER_OF(it, cutest_case_t, node);
+        if (tc->data.randkey == 0)
+        {
+            break;
+        }
+
+        cutest_map_erase(&g_test_ctx.case_table, it);
+        tc->data.randkey = 0;
+        cutest_map_insert(&g_test_ctx.case_table, it);
+    }
+}
+
+static int _cutest_smart_print_int(FILE* stream, const void* addr,
+    unsigned width, int is_signed)
+{
+    if (is_signed)
+    {
+        if (width == sizeof(char))
+        {
+            int val = *(char*)addr;
+            return cutest_porting_fprintf(stream, "%d", val);
+        }
+
+        if (width == sizeof(short))
+        {
+            int val = *(short*)addr;
+            return cutest_porting_fprintf(stream, "%d", val);
+        }
+
+        if (width == sizeof(int))
+        {
+            return cutest_porting_fprintf(stream, "%d", *(int*)addr);
+        }
+
+        if (width == sizeof(long))
+        {
+            return cutest_porting_fprintf(stream, "%ld", *(long*)addr);
+        }
+
+#if !defined(CUTEST_NO_C99_SUPPORT)
+        if (width == sizeof(long long))
+        {
+            return cutest_porting_fprintf(stream, "%lld", *(long long*)addr);
+        }
+#endif
+    }
+    else
+    {
+        if (width == sizeof(unsigned char))
+        {
+            unsigned val = *(unsigned char*)addr;
+            return cutest_porting_fprintf(stream, "%u", val);
+        }
+
+        if (width == sizeof(unsigned short))
+        {
+            unsigned val = *(unsigned short*)addr;
+            return cutest_porting_fprintf(stream, "%u", val);
+        }
+
+        if (width == sizeof(unsigned int))
+        {
+            return cutest_porting_fprintf(stream, "%u", *(unsigned*)addr);
+        }
+
+        if (width == sizeof(unsigned long))
+        {
+            return cutest_porting_fprintf(stream, "%lu", *(unsigned long*)addr);
+        }
+
+#if !defined(CUTEST_NO_C99_SUPPORT)
+        if (width == sizeof(unsigned long long))
+        {
+            return cutest_porting_fprintf(stream, "%llu", *(unsigned long long*)addr);
+        }
+#endif
+    }
+
+    CUTEST_PORTING_ASSERT_P(!"error", "width of %u does not match any native size", width);
+    return 0;
+}
+
+static int _cutest_print_char(FILE* stream, const void* addr,
+    unsigned width, int is_signed)
+{
+    (void)width; (void)is_signed;
+    return cutest_porting_fprintf(stream, "%c", *(char*)addr);
+}
+
+TEST_GENERATE_TEMPLATE_COMPARE(s_type_info_char, char, _cutest_print_char);
+TEST_GENERATE_TEMPLATE_COMPARE(s_type_info_signed_char, signed char, _cutest_print_char);
+TEST_GENERATE_TEMPLATE_COMPARE(s_type_info_unsigned_char, unsigned char, _cutest_print_char);
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_short, short);
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_unsigned_short, unsigned short);
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_int, int);
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_unsigned_int, unsigned int);
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_long, long);
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_unsigned_long, unsigned long);
+
+#if !defined(CUTEST_NO_C99_SUPPORT)
+#include <stdint.h>
+#include <stddef.h>
+#if !defined(CUTEST_NO_LONGLONG_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_long_long, long long);
+#endif
+#if !defined(CUTEST_NO_ULONGLONG_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_unsigned_long_long, unsigned long long);
+#endif
+#if !defined(CUTEST_NO_INT8_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_int8_t, int8_t);
+#endif
+#if !defined(CUTEST_NO_UINT8_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_uint8_t, uint8_t);
+#endif
+#if !defined(CUTEST_NO_INT16_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_int16_t, int16_t);
+#endif
+#if !defined(CUTEST_NO_UINT16_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_uint16_t, uint16_t);
+#endif
+#if !defined(CUTEST_NO_INT32_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_int32_t, int32_t);
+#endif
+#if !defined(CUTEST_NO_UINT32_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_uint32_t, uint32_t);
+#endif
+#if !defined(CUTEST_NO_INT64_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_int64_t, int64_t);
+#endif
+#if !defined(CUTEST_NO_UINT64_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_uint64_t, uint64_t);
+#endif
+#if !defined(CUTEST_NO_SIZE_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_size_t, size_t);
+#endif
+#if !defined(CUTEST_NO_PTRDIFF_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_ptrdiff_t, ptrdiff_t);
+#endif
+#if !defined(CUTEST_NO_INTPTR_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_intptr_t, intptr_t);
+#endif
+#if !defined(CUTEST_NO_UINTPTR_SUPPORT)
+TEST_GENERATE_NATIVE_COMPARE(s_type_info_uintptr_t, uintptr_t);
+#endif
+#endif
+
+static int _cutest_cmp_ptr(const void** addr1, const void** addr2)
+{
+    const void* t_addr1 = *addr1;
+    const void* t_addr2 = *addr2;
+
+    const char* v1 = (const char*)t_addr1;
+    const char* v2 = (const char*)t_addr2;
+
+    if (v1 == v2)
+    {
+        return 0;
+    }
+    return v1 < v2 ? -1 : 1;
+}
+
+static int _cutest_print_ptr(FILE* file, const void** addr)
+{
+    return cutest_porting_fprintf(file, "%p", *addr);
+}
+
+static cutest_type_info_t s_type_info_ptr = {
+    { NULL, NULL, NULL }, "const void*",
+    (cutest_custom_type_cmp_fn)_cutest_cmp_ptr,
+    (cutest_custom_type_dump_fn)_cutest_print_ptr,
+};
+
+static int _cutest_cmp_str(const char** addr1, const char** addr2)
+{
+    const char* v1 = *addr1;
+    const char* v2 = *addr2;
+    return cutest_porting_strcmp(v1, v2);
+}
+
+static int _cutest_print_str(FILE* file, const char** addr)
+{
+    const char* v = *addr;
+    return cutest_porting_fprintf(file, "%s", v);
+}
+
+static cutest_type_info_t s_type_info_str = {
+    { NULL, NULL, NULL }, "const char*",
+    (cutest_custom_type_cmp_fn)_cutest_cmp_str,
+    (cutest_custom_type_dump_fn)_cutest_print_str,
+};
+
+static int _cutest_cmp_float(const float* addr1, const float* addr2)
+{
+    return cutest_porting_compare_floating_number(0, addr1, addr2);
+}
+
+static int _cutest_dump_float(FILE* file, const float* addr)
+{
+    return cutest_porting_fprintf(file, "%f", *addr);
+}
+
+static cutest_type_info_t s_type_info_float = {
+    { NULL, NULL, NULL }, "float",
+    (cutest_custom_type_cmp_fn)_cutest_cmp_float,
+    (cutest_custom_type_dump_fn)_cutest_dump_float,
+};
+
+static int _cutest_cmp_double(const double* addr1, const double* addr2)
+{
+    return cutest_porting_compare_floating_number(1, addr1, addr2);
+}
+
+static int _cutest_dump_double(FILE* file, const double* addr)
+{
+    return cutest_porting_fprintf(file, "%f", *addr);
+}
+
+static cutest_type_info_t s_type_info_double = {
+    { NULL, NULL, NULL }, "double",
+    (cutest_custom_type_cmp_fn)_cutest_cmp_double,
+    (cutest_custom_type_dump_fn)_cutest_dump_double,
+};
+
+static void _cutest_setup_type(void)
+{
+    /* C89 */
+    cutest_internal_register_type(&s_type_info_char);
+    cutest_internal_register_type(&s_type_info_signed_char);
+    cutest_internal_register_type(&s_type_info_unsigned_char);
+    cutest_internal_register_type(&s_type_info_short);
+    cutest_internal_register_type(&s_type_info_unsigned_short);
+    cutest_internal_register_type(&s_type_info_int);
+    cutest_internal_register_type(&s_type_info_unsigned_int);
+    cutest_internal_register_type(&s_type_info_long);
+    cutest_internal_register_type(&s_type_info_unsigned_long);
+    cutest_internal_register_type(&s_type_info_ptr);
+    cutest_internal_register_type(&s_type_info_str);
+    cutest_internal_register_type(&s_type_info_float);
+    cutest_internal_register_type(&s_type_info_double);
+
+    /* C99 */
+#if !defined(CUTEST_NO_C99_SUPPORT)
+#if !defined(CUTEST_NO_LONGLONG_SUPPORT)
+    cutest_internal_register_type(&s_type_info_long_long);
+#endif
+#if !defined(CUTEST_NO_ULONGLONG_SUPPORT)
+    cutest_internal_register_type(&s_type_info_unsigned_long_long);
+#endif
+#if !defined(CUTEST_NO_INT8_SUPPORT)
+    cutest_internal_register_type(&s_type_info_int8_t);
+#endif
+#if !defined(CUTEST_NO_UINT8_SUPPORT)
+    cutest_internal_register_type(&s_type_info_uint8_t);
+#endif
+#if !defined(CUTEST_NO_INT16_SUPPORT)
+    cutest_internal_register_type(&s_type_info_int16_t);
+#endif
+#if !defined(CUTEST_NO_UINT16_SUPPORT)
+    cutest_internal_register_type(&s_type_info_uint16_t);
+#endif
+#if !defined(CUTEST_NO_INT32_SUPPORT)
+    cutest_internal_register_type(&s_type_info_int32_t);
+#endif
+#if !defined(CUTEST_NO_UINT32_SUPPORT)
+    cutest_internal_register_type(&s_type_info_uint32_t);
+#endif
+#if !defined(CUTEST_NO_INT64_SUPPORT)
+    cutest_internal_register_type(&s_type_info_int64_t);
+#endif
+#if !defined(CUTEST_NO_UINT64_SUPPORT)
+    cutest_internal_register_type(&s_type_info_uint64_t);
+#endif
+#if !defined(CUTEST_NO_SIZE_SUPPORT)
+    cutest_internal_register_type(&s_type_info_size_t);
+#endif
+#if !defined(CUTEST_NO_PTRDIFF_SUPPORT)
+    cutest_internal_register_type(&s_type_info_ptrdiff_t);
+#endif
+#if !defined(CUTEST_NO_INTPTR_SUPPORT)
+    cutest_internal_register_type(&s_type_info_intptr_t);
+#endif
+#if !defined(CUTEST_NO_UINTPTR_SUPPORT)
+    cutest_internal_register_type(&s_type_info_uintptr_t);
+#endif
+#endif
+}
+
+/**
+ * @brief Setup resources that will not change.
+ */
+static void _cutest_setup_once(void)
+{
+    static int token = 0;
+    if (token == 0)
+    {
+        token = 1;
+        _cutest_setup_type();
+    }
+}
+
+static void _cutest_prepare(void)
+{
+    cutest_porting_timespec_t seed;
+    cutest_porting_clock_gettime(&seed);
+    _cutest_srand((unsigned long)seed.tv_sec);
+
+    g_test_ctx.runtime.tid = cutest_porting_gettid();
+    g_test_ctx.counter.repeat.repeat = 1;
+    g_test_ctx.benchmark.min_time_ms = BENCHMARK_DEFAULT_MIN_TIME_MS;
+    g_test_ctx.benchmark.repetitions = 1;
+}
+
+static int _cutest_setup_arg_help(void)
+{
+    _cutest_print_encoded(s_test_help_encoded);
+    return 1 << 8 | 0;
+}
+
+static int _cutest_setup_arg_list_tests(void)
+{
+    /* Cases of modules are not registered yet. */
+    g_test_ctx.mask.list_tests = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_list_types(void)
+{
+    _cutest_list_types();
+    return 1 << 8 | 0;
+}
+
+static int _cutest_setup_arg_also_run_disabled_tests(void)
+{
+    g_test_ctx.mask.also_run_disabled_tests = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_shuffle(void)
+{
+    g_test_ctx.mask.shuffle = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_break_on_failure(void)
+{
+    g_test_ctx.mask.break_on_failure = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_backtrace(void)
+{
+    g_test_ctx.mask.backtrace = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_benchmark_priority(void)
+{
+    g_test_ctx.mask.benchmark_priority = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_benchmark_isolate(void)
+{
+    g_test_ctx.mask.benchmark_isolate = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_benchmark_cold_cache(void)
+{
+    g_test_ctx.mask.benchmark_cold_cache = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_benchmark_cold_tlb(void)
+{
+    g_test_ctx.mask.benchmark_cold_cache = 1;
+    g_test_ctx.mask.benchmark_cold_tlb = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_monitor(const char* str)
+{
+    g_test_ctx.monitor.path = str;
+    return 0;
+}
+
+static int _cutest_setup_arg_flight_recorder(const char* str)
+{
+    g_test_ctx.flight.path = str;
+    return 0;
+}
+
+typedef struct test_module
+{
+    const char*                 path;                               /**< As given in command line. */
+    char                        name[MODULE_NAME_SIZE];             /**< Namespace of its cases. */
+    void*                       handle;                             /**< NULL if not loaded. */
+    int                         watch;                              /**< Given by `--test_watch`. */
+    int                         wd;                                 /**< Watch descriptor of directory, -1 if not watched. */
+    int                         dirty;                              /**< Changed since last load. */
+    char                        failed[MODULE_FAILED_SIZE];         /**< Names of failed cases, each ends with NUL. */
+} test_module_t;
+
+static struct
+{
+    test_module_t               modules[MODULE_MAX_COUNT];
+    unsigned                    size;
+    test_module_t*              loading;                            /**< Cases registered now belong to it. */
+    int                         fd;                                 /**< Watcher. */
+} s_test_module;
+
+/**
+ * @brief Add module \p path, named after its file: `libfoo_tests.so` is `foo_tests`.
+ */
+static int _cutest_module_add(const char* path, int watch)
+{
+    if (s_test_module.size >= MODULE_MAX_COUNT)
+    {
+        return 1 << 8 | 1;
+    }
+
+    test_module_t* module = &s_test_module.modules[s_test_module.size++];
+    cutest_porting_memset(module, 0, sizeof(*module));
+    module->path = path;
+    module->watch = watch;
+    module->wd = -1;
+
+    const char* name = path;
+    const char* pos;
+    for (pos = path; *pos != '\0'; pos++)
+    {
+        if (*pos == '/' || *pos == '\\')
+        {
+            name = pos + 1;
+        }
+    }
+    if (cutest_porting_strncmp(name, "lib", 3) == 0 && name[3] != '.' && name[3] != '\0')
+    {
+        name += 3;
+    }
+
+    unsigned long len = 0;
+    while (name[len] != '\0' && name[len] != '.' && len < sizeof(module->name) - 1)
+    {
+        module->name[len] = name[len];
+        len++;
+    }
+    return len != 0 ? 0 : (1 << 8 | 1);
+}
+
+static int _cutest_setup_arg_load(const char* str)
+{
+    return _cutest_module_add(str, 0);
+}
+
+static int _cutest_setup_arg_watch(const char* str)
+{
+    return _cutest_module_add(str, 1);
+}
+
+static int _cutest_setup_arg_resource_dir(const char* str)
+{
+    s_test_resource.dir = str;
+    return 0;
+}
+
+static int _cutest_setup_arg_resource_preload(const char* str)
+{
+    if (s_test_resource.preload_sz >= RESOURCE_MAX_COUNT)
+    {
+        return 1 << 8 | 1;
+    }
+    s_test_resource.preload[s_test_resource.preload_sz++] = str;
+    return 0;
+}
+
+static int _cutest_setup_arg_resource_prefetch(void)
+{
+    s_test_resource.prefetch = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_param_sample(const char* str)
+{
+    char buf[32];
+    unsigned long len = cutest_porting_strlen(str), val;
+    if (len == 0 || len >= sizeof(buf))
+    {
+        return 1 << 8 | 1;
+    }
+    cutest_porting_memcpy(buf, str, len + 1);
+
+    int percent = buf[len - 1] == '%';
+    if (percent)
+    {
+        buf[len - 1] = '\0';
+    }
+    if (cutest_porting_atoul(buf, &val) != 0 || val == 0 || (percent && val > 100))
+    {
+        return 1 << 8 | 1;
+    }
+
+    s_test_param_sample.count = percent ? 0 : val;
+    s_test_param_sample.percent = percent ? val : 0;
+    return 0;
+}
+
+static int _cutest_setup_arg_param_sample_shard(const char* str)
+{
+    char buf[64];
+    unsigned long len = cutest_porting_strlen(str), index, total;
+    if (len >= sizeof(buf))
+    {
+        return 1 << 8 | 1;
+    }
+    cutest_porting_memcpy(buf, str, len + 1);
+
+    char* sep = cutest_porting_strchr(buf, '/');
+    if (sep == NULL)
+    {
+        return 1 << 8 | 1;
+    }
+    *sep = '\0';
+    if (cutest_porting_atoul(buf, &index) != 0 || cutest_porting_atoul(sep + 1, &total) != 0
+        || total == 0 || index >= total)
+    {
+        return 1 << 8 | 1;
+    }
+
+    s_test_param_sample.shard_index = index;
+    s_test_param_sample.shard_total = total;
+    return 0;
+}
+
+static int _cutest_setup_arg_param_history(const char* str)
+{
+    s_test_param_sample.history_path = str;
+    return 0;
+}
+
+static int _cutest_setup_arg_daemon(const char* str)
+{
+    g_test_ctx.daemon.path = str;
+    return 0;
+}
+
+/**
+ * @param[in] str   Value of `--test_guard_malloc`, or NULL if not given.
+ */
+static int _cutest_setup_arg_guard_malloc(const char* str)
+{
+    unsigned long val = GUARD_DEFAULT_SAMPLE_RATE;
+    if (str != NULL && (cutest_porting_atoul(str, &val) != 0 || val == 0))
+    {
+        return 1 << 8 | 1;
+    }
+
+    g_test_ctx.guard.sample_rate = val;
+    return 0;
+}
+
+static int _cutest_setup_arg_autotune(void)
+{
+    g_test_ctx.mask.autotune = 1;
+    return 0;
+}
+
+static int _cutest_setup_arg_autotune_output(const char* str)
+{
+    if (*str == '\0')
+    {
+        return 1 << 8 | 1;
+    }
+
+    g_test_ctx.mask.autotune = 1;
+    g_test_ctx.benchmark.autotune_output = str;
+    return 0;
+}
+
+static void _cutest_cleanup(void)
+{
+    /* Reset all data. */
+    {
+        cutest_map_t case_table = g_test_ctx.case_table;
+        cutest_map_t type_table = g_test_ctx.type_table;
+        cutest_porting_memset(&g_test_ctx, 0, sizeof(g_test_ctx));
+        g_test_ctx.case_table = case_table;
+        g_test_ctx.type_table = type_table;
+    }
+}
+
+/**
+ * @brief Setup test context
+ * @param[in] argc      The number of command line argument.
+ * @param[in] argv      Command line argument list.
+ * @param[in] hook      Global test hook.
+ * @param[out] b_exit   Whether need to exit.
+ * @return              0 if success, otherwise failure. The lower 8 bit is the actual exit code.
+ */
+static int _cutest_setup(int argc, char* argv[], FILE* out, const cutest_hook_t* hook)
+{
+#define PARSER_LONGOPT_WITH_VALUE(OPT, FUNC)   \
+    do {\
+        int ret = -1; const char* opt = OPT;\
+        unsigned optlen = cutest_porting_strlen(opt);\
+        if (cutest_porting_strncmp(argv[i], opt, optlen) == 0\
+            && (argv[i][optlen] == '=' || argv[i][optlen] == '\0')) {\
+            if (argv[i][optlen] == '=') {\
+                ret = FUNC(argv[i] + optlen + 1);\
+            } else if (i < argc - 1) {\
+                ret = FUNC(argv[i + 1]); i++;\
+            }\
+            if (ret != 0) {\
+                cutest_porting_fprintf(g_test_ctx.out, "Invalid argument to `%s'\n", opt);\
+                return ret;\
+            }\
+            continue;\
+        }\
+    } while (0)
+
+#define PARSER_LONGOPT_OPTIONAL_VALUE(OPT, FUNC)   \
+    do {\
+        int ret = 0; const char* opt = OPT;\
+        unsigned optlen = cutest_porting_strlen(opt);\
+        if (cutest_porting_strncmp(argv[i], opt, optlen) == 0\
+            && (argv[i][optlen] == '=' || argv[i][optlen] == '\0')) {\
+            if ((ret = FUNC(argv[i][optlen] == '=' ? argv[i] + optlen + 1 : NULL)) != 0) {\
+                cutest_porting_fprintf(g_test_ctx.out, "Invalid argument to `%s'\n", opt);\
+                return ret;\
+            }\
+            continue;\
+        }\
+    } while (0)
+
+#define PARSER_LONGOPT_NO_VALUE(OPT, FUNC)   \
+    do {\
+        int ret = 0; const char* opt = OPT;\
+        if (cutest_porting_strcmp(argv[i], opt) == 0) {\
+            if ((ret = FUNC()) != 0) {\
+                return ret;\
+            }\
+        }\
+        continue;\
+    } while (0)
+
+    _cutest_setup_once();
+
+    _cutest_cleanup();
+    _cutest_prepare();
+
+    g_test_ctx.out = out;
+    g_test_ctx.hook = hook;
+
+    int i;
+    for (i = 0; i < argc; i++)
+    {
+        PARSER_LONGOPT_NO_VALUE("-h",                               _cutest_setup_arg_help);
+        PARSER_LONGOPT_NO_VALUE("--help",                           _cutest_setup_arg_help);
+        PARSER_LONGOPT_NO_VALUE("--test_list_tests",                _cutest_setup_arg_list_tests);
+        PARSER_LONGOPT_NO_VALUE("--test_list_types",                _cutest_setup_arg_list_types);
+        PARSER_LONGOPT_NO_VALUE("--test_also_run_disabled_tests",   _cutest_setup_arg_also_run_disabled_tests);
+        PARSER_LONGOPT_NO_VALUE("--test_shuffle",                   _cutest_setup_arg_shuffle);
+        PARSER_LONGOPT_NO_VALUE("--test_break_on_failure",          _cutest_setup_arg_break_on_failure);
+        PARSER_LONGOPT_NO_VALUE("--test_backtrace",                 _cutest_setup_arg_backtrace);
+        PARSER_LONGOPT_NO_VALUE("--test_benchmark_priority",        _cutest_setup_arg_benchmark_priority);
+        PARSER_LONGOPT_NO_VALUE("--test_benchmark_isolate",         _cutest_setup_arg_benchmark_isolate);
+        PARSER_LONGOPT_NO_VALUE("--test_benchmark_cold_cache",      _cutest_setup_arg_benchmark_cold_cache);
+        PARSER_LONGOPT_NO_VALUE("--test_benchmark_cold_tlb",        _cutest_setup_arg_benchmark_cold_tlb);
+        PARSER_LONGOPT_NO_VALUE("--test_autotune",                  _cutest_setup_arg_autotune);
+
+        PARSER_LONGOPT_WITH_VALUE("--test_filter",                  _cutest_setup_arg_pattern);
+        PARSER_LONGOPT_WITH_VALUE("--test_repeat",                  _cutest_setup_arg_repeat);
+        PARSER_LONGOPT_WITH_VALUE("--test_repeat_until_fail",       _cutest_setup_arg_repeat_until_fail);
+        PARSER_LONGOPT_WITH_VALUE("--test_repeat_jobs",             _cutest_setup_arg_repeat_jobs);
+        PARSER_LONGOPT_WITH_VALUE("--test_random_seed",             _cutest_setup_arg_random_seed);
+        PARSER_LONGOPT_WITH_VALUE("--test_print_time",              _cutest_setup_arg_print_time);
+        PARSER_LONGOPT_WITH_VALUE("--test_benchmark_min_time",      _cutest_setup_arg_benchmark_min_time);
+        PARSER_LONGOPT_WITH_VALUE("--test_benchmark_repetitions",   _cutest_setup_arg_benchmark_repetitions);
+        PARSER_LONGOPT_WITH_VALUE("--test_autotune_output",         _cutest_setup_arg_autotune_output);
+        PARSER_LONGOPT_OPTIONAL_VALUE("--test_guard_malloc",        _cutest_setup_arg_guard_malloc);
+        PARSER_LONGOPT_WITH_VALUE("--test_monitor",                 _cutest_setup_arg_monitor);
+        PARSER_LONGOPT_WITH_VALUE("--test_flight_recorder",         _cutest_setup_arg_flight_recorder);
+        PARSER_LONGOPT_WITH_VALUE("--test_daemon",                  _cutest_setup_arg_daemon);
+        PARSER_LONGOPT_WITH_VALUE("--test_load",                    _cutest_setup_arg_load);
+        PARSER_LONGOPT_WITH_VALUE("--test_watch",                   _cutest_setup_arg_watch);
+        PARSER_LONGOPT_WITH_VALUE("--test_resource_dir",            _cutest_setup_arg_resource_dir);
+        PARSER_LONGOPT_WITH_VALUE("--test_resource_preload",        _cutest_setup_arg_resource_preload);
+        PARSER_LONGOPT_WITH_VALUE("--test_param_sample",            _cutest_setup_arg_param_sample);
+        PARSER_LONGOPT_WITH_VALUE("--test_param_sample_shard",      _cutest_setup_arg_param_sample_shard);
+        PARSER_LONGOPT_WITH_VALUE("--test_param_history",           _cutest_setup_arg_param_history);
+        PARSER_LONGOPT_NO_VALUE  ("--test_resource_prefetch",       _cutest_setup_arg_resource_prefetch);
+    }
+
+    return 0;
+
+#undef PARSER_LONGOPT_NO_VALUE
+#undef PARSER_LONGOPT_OPTIONAL_VALUE
+#undef PARSER_LONGOPT_WITH_VALUE
+}
+
+typedef enum test_guard_slot_state
+{
+    TEST_GUARD_SLOT_FREE,       /**< Never used. */
+    TEST_GUARD_SLOT_USED,       /**< Allocated. */
+    TEST_GUARD_SLOT_FREED,      /**< Freed and inaccessible, until it is reused. */
+} test_guard_slot_state_t;
+
+typedef struct test_guard_slot
+{
+    char*                       ptr;        /**< Address of user memory. */
+    unsigned long               size;       /**< Requested size. */
+    test_guard_slot_state_t     state;
+} test_guard_slot_t;
+
+static struct
+{
+    char*                       pool;       /**< Guard, slot, guard, slot, ..., guard. */
+    unsigned long               page_size;
+    test_guard_slot_t           slots[GUARD_SLOT_COUNT];
+    unsigned long               cursor;     /**< Next slot to try. */
+    volatile long               counter;    /**< Allocation counter for sampling. */
+    volatile long               lock;
+} s_test_guard;
+
+static void _cutest_guard_lock(void)
+{
+    while (!cutest_atomic_cas(&s_test_guard.lock, 0, 1))
+    {
+        cutest_thread_yield();
+    }
+}
+
+static void _cutest_guard_unlock(void)
+{
+    cutest_atomic_cas(&s_test_guard.lock, 1, 0);
+}
+
+static char* _cutest_guard_slot_page(unsigned long idx)
+{
+    return s_test_guard.pool + (2 * idx + 1) * s_test_guard.page_size;
+}
+
+/**
+ * @brief Find the slot that \p ptr points into, include its guard pages.
+ * @return Slot index, or -1 if not in the pool.
+ */
+static long _cutest_guard_find_slot(const void* ptr)
+{
+    const char* addr = ptr;
+    if (s_test_guard.pool == NULL || addr < s_test_guard.pool
+        || addr >= s_test_guard.pool + (2 * GUARD_SLOT_COUNT + 1) * s_test_guard.page_size)
+    {
+        return -1;
+    }
+
+    unsigned long page = (unsigned long)(addr - s_test_guard.pool) / s_test_guard.page_size;
+    if (page % 2 == 1)
+    {
+        return (long)(page / 2);
+    }
+
+    /* A guard page, blame the neighbor that is in use. */
+    long left = (long)page / 2 - 1, right = (long)page / 2;
+    if (left >= 0 && s_test_guard.slots[left].state != TEST_GUARD_SLOT_FREE)
+    {
+        return left;
+    }
+    if (right < GUARD_SLOT_COUNT && s_test_guard.slots[right].state != TEST_GUARD_SLOT_FREE)
+    {
+        return right;
+    }
+    return left >= 0 ? left : right;
+}
+
+/**
+ * @brief Record a guard malloc failure for _cutest_guard_report().
+ * @note Called from the fault handler, so only plain stores are allowed here.
+ */
+static void _cutest_guard_record(const void* addr, long idx, const char* what)
+{
+    s_test_thread_ctx.guard_fault.addr = addr;
+    s_test_thread_ctx.guard_fault.ptr = s_test_guard.slots[idx].ptr;
+    s_test_thread_ctx.guard_fault.size = s_test_guard.slots[idx].size;
+    s_test_thread_ctx.guard_fault.what = what;
+}
+
+static void _cutest_guard_on_fault(void* addr)
+{
+    long idx = _cutest_guard_find_slot(addr);
+    if (idx < 0 || s_test_guard.slots[idx].state == TEST_GUARD_SLOT_FREE)
+    {
+        return;
+    }
+
+    const char* p = addr;
+    test_guard_slot_t* slot = &s_test_guard.slots[idx];
+    if (slot->state == TEST_GUARD_SLOT_FREED)
+    {
+        _cutest_guard_record(addr, idx, "heap-use-after-free");
+    }
+    else
+    {
+        _cutest_guard_record(addr, idx, p < slot->ptr ? "heap-buffer-underflow" : "heap-buffer-overflow");
+    }
+    /* The report is printed where the test jumps back to. */
+    cutest_internal_assert_failure();
+}
+
+static void _cutest_guard_setup(void)
+{
+    if (g_test_ctx.guard.sample_rate == 0)
+    {
+        return;
+    }
+
+    if (s_test_guard.pool == NULL)
+    {
+        s_test_guard.page_size = cutest_vm_page_size();
+        s_test_guard.pool = cutest_vm_reserve((2 * GUARD_SLOT_COUNT + 1) * s_test_guard.page_size);
+    }
+
+    if (s_test_guard.pool == NULL || cutest_fault_handler_install(_cutest_guard_on_fault) != 0)
+    {
+        _cutest_warning("Guard malloc is not available on this platform.\n");
+        g_test_ctx.guard.sample_rate = 0;
+        return;
+    }
+    g_test_ctx.guard.installed = 1;
+}
+
+static void _cutest_guard_cleanup(void)
+{
+    if (g_test_ctx.guard.installed)
+    {
+        g_test_ctx.guard.installed = 0;
+        cutest_fault_handler_uninstall();
+    }
+}
+
+/**
+ * @brief Try to allocate from guarded pool.
+ * @return NULL if not sampled.
+ */
+static void* _cutest_guard_alloc(size_t size)
+{
+    if (g_test_ctx.guard.sample_rate == 0 || g_test_ctx.runtime.cur_node == NULL
+        || size == 0 || size > s_test_guard.page_size)
+    {
+        return NULL;
+    }
+    if ((unsigned long)cutest_atomic_add(&s_test_guard.counter, 1) % g_test_ctx.guard.sample_rate != 0)
+    {
+        return NULL;
+    }
+
+    _cutest_guard_lock();
+
+    /* Round robin, so freed slots stay in quarantine as long as possible. */
+    unsigned long i;
+    test_guard_slot_t* slot = NULL;
+    unsigned long idx = 0;
+    for (i = 0; i < GUARD_SLOT_COUNT; i++)
+    {
+        idx = (s_test_guard.cursor + i) % GUARD_SLOT_COUNT;
+        if (s_test_guard.slots[idx].state != TEST_GUARD_SLOT_USED)
+        {
+            slot = &s_test_guard.slots[idx];
+            break;
+        }
+    }
+
+    char* page = slot != NULL ? _cutest_guard_slot_page(idx) : NULL;
+    if (page == NULL || cutest_vm_protect(page, s_test_guard.page_size, 1) != 0)
+    {
+        _cutest_guard_unlock();
+        return NULL;
+    }
+
+    /* Put it against the right guard page. */
+    unsigned long aligned = (size + GUARD_ALIGNMENT - 1) / GUARD_ALIGNMENT * GUARD_ALIGNMENT;
+    slot->ptr = page + s_test_guard.page_size - aligned;
+    slot->size = size;
+    slot->state = TEST_GUARD_SLOT_USED;
+    s_test_guard.cursor = idx + 1;
+
+    _cutest_guard_unlock();
+    return slot->ptr;
+}
+
+/**
+ * @brief Free guarded memory.
+ * @return 0 if \p ptr is not guarded.
+ */
+static int _cutest_guard_release(void* ptr)
+{
+    long idx = _cutest_guard_find_slot(ptr);
+    if (idx < 0)
+    {
+        return 0;
+    }
+
+    test_guard_slot_t* slot = &s_test_guard.slots[idx];
+    if (slot->state != TEST_GUARD_SLOT_USED || (char*)ptr != slot->ptr)
+    {
+        _cutest_guard_record(ptr, idx, slot->state == TEST_GUARD_SLOT_FREED ?
+            "attempting double-free" : "attempting free on address which was not malloc()-ed");
+        _cutest_guard_report();
+        cutest_internal_assert_failure();
+        return 1;
+    }
+
+    _cutest_guard_lock();
+    slot->state = TEST_GUARD_SLOT_FREED;
+    cutest_vm_protect(_cutest_guard_slot_page((unsigned long)idx), s_test_guard.page_size, 0);
+    _cutest_guard_unlock();
+    return 1;
+}
+
+typedef struct test_autotune_candidate
+{
+    cutest_case_t*  test_case;
+    unsigned long   samples;    /**< The number of ns/op samples. */
+    double          mean;       /**< Mean of samples. */
+    double          m2;         /**< Sum of squared differences from the mean. */
+} test_autotune_candidate_t;
+
+static struct
+{
+    test_autotune_candidate_t   candidates[AUTOTUNE_MAX_CANDIDATES];
+    FILE*                       output;
+} s_test_autotune;
+
+static void _cutest_autotune_add_sample(test_autotune_candidate_t* candidate, double ns_per_op)
+{
+    /* Welford's online algorithm. */
+    candidate->samples++;
+    double delta = ns_per_op - candidate->mean;
+    candidate->mean += delta / candidate->samples;
+    candidate->m2 += delta * (ns_per_op - candidate->mean);
+}
+
+/**
+ * @brief Half width of 95% confidence interval of the mean.
+ * @return Negative if unknown.
+ */
+static double _cutest_autotune_ci95(const test_autotune_candidate_t* candidate)
+{
+    /* Two-sided 97.5% quantile of Student's t distribution, by degrees of freedom. */
+    static const double s_t_table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    };
+
+    if (candidate->samples < 2)
+    {
+        return -1;
+    }
+
+    unsigned long df = candidate->samples - 1;
+    double t = df <= sizeof(s_t_table) / sizeof(s_t_table[0]) ? s_t_table[df - 1] : df <= 30 ? 2.042 : 1.960;
+    double variance = candidate->m2 / df;
+    return t * cutest_porting_sqrt(variance / candidate->samples);
+}
+
+/**
+ * @brief Run \p test_case again without touching the test result counters.
+ * @return 0 if a new sample is collected.
+ */
+static int _cutest_autotune_rerun(cutest_case_t* test_case, double* ns_per_op)
+{
+    unsigned long mask = test_case->data.mask;
+    g_test_ctx.runtime.cur_node = test_case;
+
+    /* Only the first run is counted in the report. */
+    char result[sizeof(g_test_ctx.counter.result)];
+    cutest_porting_memcpy(result, &g_test_ctx.counter.result, sizeof(result));
+    _cutest_run_case(test_case);
+    cutest_porting_memcpy(&g_test_ctx.counter.result, result, sizeof(result));
+
+    int failed = HAS_MASK(test_case->data.mask, MASK_FAILURE);
+    int measured = test_case->benchmark.iterations != 0 && !HAS_MASK(test_case->data.mask, MASK_SKIPPED);
+    *ns_per_op = test_case->benchmark.ns_per_op;
+
+    test_case->data.mask = mask;
+    if (failed)
+    {
+        _cutest_set_finished_case_failure(test_case);
+    }
+    return (!failed && measured) ? 0 : -1;
+}
+
+static int _cutest_autotune_on_cmp(const test_autotune_candidate_t* a, const test_autotune_candidate_t* b)
+{
+    if (a->mean == b->mean)
+    {
+        return 0;
+    }
+    return a->mean < b->mean ? -1 : 1;
+}
+
+static void _cutest_autotune_sort(test_autotune_candidate_t* candidates, unsigned long size)
+{
+    unsigned long i, j;
+    for (i = 1; i < size; i++)
+    {
+        test_autotune_candidate_t tmp = candidates[i];
+        for (j = i; j > 0 && _cutest_autotune_on_cmp(&tmp, &candidates[j - 1]) < 0; j--)
+        {
+            candidates[j] = candidates[j - 1];
+        }
+        candidates[j] = tmp;
+    }
+}
+
+static void _cutest_autotune_report(const test_autotune_candidate_t* best)
+{
+    char name[256];
+    cutest_case_t* test_case = best->test_case;
+    _cutest_get_test_fmt_name_parameter(name, sizeof(name), test_case);
+
+    int len = 0;
+    const char* value = _cutest_parameterized_parser(test_case->parameterized.test_data_cstr,
+        test_case->parameterized.param_idx, &len);
+    double ci = _cutest_autotune_ci95(best);
+
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ AUTOTUNE ]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s best %.*s %.2f ns/op",
+        name, len, value, best->mean);
+    if (ci >= 0)
+    {
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " +/- %.2f (95%% CI, %lu samples)",
+            ci, best->samples);
+    }
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
+
+    if (s_test_autotune.output == NULL)
+    {
+        return;
+    }
+
+    const char* fixture_name = test_case->info.fixture_name;
+    const char* case_name = test_case->info.case_name;
+    cutest_porting_fprintf(s_test_autotune.output, "%s.%s.index=%lu\n",
+        fixture_name, case_name, test_case->parameterized.param_idx);
+    cutest_porting_fprintf(s_test_autotune.output, "%s.%s.value=%.*s\n",
+        fixture_name, case_name, len, value);
+    cutest_porting_fprintf(s_test_autotune.output, "%s.%s.ns_per_op=%.2f\n",
+        fixture_name, case_name, best->mean);
+    if (ci >= 0)
+    {
+        cutest_porting_fprintf(s_test_autotune.output, "%s.%s.ci95=%.2f\n",
+            fixture_name, case_name, ci);
+    }
+}
+
+/**
+ * @brief Successive halving over all instances of the parameterized benchmark
+ *   that \p first belongs to.
+ */
+static void _cutest_autotune_family(cutest_case_t* first)
+{
+    test_autotune_candidate_t* candidates = s_test_autotune.candidates;
+    unsigned long size = 0, i, j;
+
+    cutest_map_node_t* it = &first->node;
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (!_cutest_same_family(first, test_case))
+        {
+            continue;
+        }
+        SET_MASK(test_case->data.mask, MASK_AUTOTUNE_VISITED);
+
+        if (test_case->benchmark.iterations == 0 || HAS_MASK(test_case->data.mask, MASK_FAILURE))
+        {
+            continue;
+        }
+        if (size == AUTOTUNE_MAX_CANDIDATES)
+        {
+            _cutest_warning("%s.%s has too many configurations, only the first %d are tuned.\n",
+                first->info.fixture_name, first->info.case_name, AUTOTUNE_MAX_CANDIDATES);
+            break;
+        }
+
+        /* The first run is the first sample. */
+        candidates[size].test_case = test_case;
+        candidates[size].samples = 0;
+        candidates[size].mean = 0;
+        candidates[size].m2 = 0;
+        _cutest_autotune_add_sample(&candidates[size], test_case->benchmark.ns_per_op);
+        size++;
+    }
+
+    if (size < 2)
+    {
+        return;
+    }
+
+    unsigned long round_samples = AUTOTUNE_ROUND_SAMPLES;
+    unsigned round;
+    for (round = 1; size > 1; round++)
+    {
+        unsigned long alive = 0;
+        for (i = 0; i < size; i++)
+        {
+            for (j = 0; j < round_samples; j++)
+            {
+                double ns_per_op;
+                if (_cutest_autotune_rerun(candidates[i].test_case, &ns_per_op) != 0)
+                {
+                    break;
+                }
+                _cutest_autotune_add_sample(&candidates[i], ns_per_op);
+            }
+
+            /* A configuration that fails is out. */
+            if (j == round_samples)
+            {
+                candidates[alive++] = candidates[i];
+            }
+        }
+
+        _cutest_autotune_sort(candidates, alive);
+        unsigned long keep = (alive + 1) / 2;
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ AUTOTUNE ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %s.%s round %u keeps %lu of %lu\n",
+            first->info.fixture_name, first->info.case_name, round, keep, size);
+        size = keep;
+
+        if (round_samples * 2 <= AUTOTUNE_MAX_ROUND_SAMPLES)
+        {
+            round_samples *= 2;
+        }
+    }
+
+    if (size == 1)
+    {
+        _cutest_autotune_report(&candidates[0]);
+    }
+}
+
+static void _cutest_autotune_all(void)
+{
+    if (g_test_ctx.benchmark.autotune_output != NULL)
+    {
+        s_test_autotune.output = fopen(g_test_ctx.benchmark.autotune_output, "w");
+        if (s_test_autotune.output == NULL)
+        {
+            _cutest_warning("Failed to open `%s'.\n", g_test_ctx.benchmark.autotune_output);
+        }
+    }
+
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        if (test_case->parameterized.type_name == NULL
+            || test_case->benchmark.iterations == 0
+            || HAS_MASK(test_case->data.mask, MASK_AUTOTUNE_VISITED))
+        {
+            continue;
+        }
+        _cutest_autotune_family(test_case);
+    }
+    g_test_ctx.runtime.cur_node = NULL;
+
+    if (s_test_autotune.output != NULL)
+    {
+        fclose(s_test_autotune.output);
+        s_test_autotune.output = NULL;
+    }
+}
+
+static void _cutest_run_all_test_once(void)
+{
+    _cutest_reset_all_test_mask();
+
+    cutest_porting_timespec_t tv_total_start, tv_total_end;
+    cutest_porting_clock_gettime(&tv_total_start);
+
+    s_test_pipeline.active = 1;
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    for (; it != NULL; it = cutest_map_next(it))
+    {
+        g_test_ctx.runtime.cur_node = CONTAINER_OF(it, cutest_case_t, node);
+        cutest_map_node_t* next = cutest_map_next(it);
+        s_test_pipeline.next = next != NULL ? CONTAINER_OF(next, cutest_case_t, node) : NULL;
+        _cutest_run_case(g_test_ctx.runtime.cur_node);
+    }
+    _cutest_pipeline_flush();
+    s_test_pipeline.active = 0;
+    s_test_pipeline.next = NULL;
+
+    cutest_porting_clock_gettime(&tv_total_end);
+
+    _cutest_complexity_fit_all();
+    if (g_test_ctx.mask.autotune)
+    {
+        _cutest_autotune_all();
+    }
+    _cutest_show_report(&tv_total_start, &tv_total_end);
+}
+
+static void _cutest_show_information(void)
+{
+#if CUTEST_VERSION_PREREL
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $VERSION ] %d.%d.%d-dev%d\n", CUTEST_VERSION_MAJOR, CUTEST_VERSION_MINOR, CUTEST_VERSION_PATCH, CUTEST_VERSION_PREREL);
+#else
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $VERSION ] %d.%d.%d\n", CUTEST_VERSION_MAJOR, CUTEST_VERSION_MINOR, CUTEST_VERSION_PATCH);
+#endif
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $PARAME. ] --test_shuffle=%d\n", (int)g_test_ctx.mask.shuffle);
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $PARAME. ] --test_random_seed=%lu\n", cutest_porting_grand());
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $PARAME. ] --test_also_run_disabled_tests=%d\n", (int)g_test_ctx.mask.also_run_disabled_tests);
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $PARAME. ] --test_filter=%s\n", g_test_ctx.filter.pattern.ptr != NULL ? g_test_ctx.filter.pattern.ptr : "");
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $PARAME. ] --test_repeat=%lu\n", g_test_ctx.counter.repeat.repeat);
+    if (g_test_ctx.counter.repeat.until_fail != 0)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_repeat_until_fail=%lu\n", g_test_ctx.counter.repeat.until_fail);
+    }
+    if (g_test_ctx.counter.repeat.jobs != 0)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_repeat_jobs=%u\n", g_test_ctx.counter.repeat.jobs);
+    }
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $PARAME. ] --test_break_on_failure=%d\n", (int)g_test_ctx.mask.break_on_failure);
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[ $PARAME. ] --test_print_time=%d\n", (int)!g_test_ctx.mask.no_print_time);
+    if (g_test_ctx.mask.backtrace)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_backtrace\n");
+    }
+    if (g_test_ctx.benchmark.min_time_ms != BENCHMARK_DEFAULT_MIN_TIME_MS)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_benchmark_min_time=%lu\n", g_test_ctx.benchmark.min_time_ms);
+    }
+    if (g_test_ctx.benchmark.repetitions != 1)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_benchmark_repetitions=%lu\n", g_test_ctx.benchmark.repetitions);
+    }
+    if (g_test_ctx.mask.benchmark_priority)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_benchmark_priority\n");
+    }
+    if (g_test_ctx.mask.benchmark_isolate)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_benchmark_isolate\n");
+    }
+    if (g_test_ctx.mask.benchmark_cold_tlb)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_benchmark_cold_tlb\n");
+    }
+    else if (g_test_ctx.mask.benchmark_cold_cache)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_benchmark_cold_cache\n");
+    }
+    if (g_test_ctx.benchmark.autotune_output != NULL)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_autotune_output=%s\n", g_test_ctx.benchmark.autotune_output);
+    }
+    else if (g_test_ctx.mask.autotune)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_autotune\n");
+    }
+    if (g_test_ctx.guard.sample_rate != 0)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_guard_malloc=%lu\n", g_test_ctx.guard.sample_rate);
+    }
+    if (g_test_ctx.monitor.path != NULL)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_monitor=%s\n", g_test_ctx.monitor.path);
+    }
+    if (g_test_ctx.flight.path != NULL)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_flight_recorder=%s\n", g_test_ctx.flight.path);
+    }
+    if (s_test_resource.dir != NULL)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_resource_dir=%s\n", s_test_resource.dir);
+    }
+    if (s_test_resource.prefetch)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_resource_prefetch\n");
+    }
+    unsigned i;
+    for (i = 0; i < s_test_resource.preload_sz; i++)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_resource_preload=%s\n", s_test_resource.preload[i]);
+    }
+    if (s_test_param_sample.count != 0)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_param_sample=%lu\n", s_test_param_sample.count);
+    }
+    if (s_test_param_sample.percent != 0)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_param_sample=%lu%%\n", s_test_param_sample.percent);
+    }
+    if (s_test_param_sample.shard_total != 0)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_param_sample_shard=%lu/%lu\n",
+            s_test_param_sample.shard_index, s_test_param_sample.shard_total);
+    }
+    if (s_test_param_sample.history_path != NULL)
+    {
+        cutest_porting_fprintf(g_test_ctx.out,
+            "[ $PARAME. ] --test_param_history=%s\n", s_test_param_sample.history_path);
+    }
+    for (i = 0; i < s_test_module.size; i++)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ $PARAME. ] --test_%s=%s\n",
+            s_test_module.modules[i].watch ? "watch" : "load", s_test_module.modules[i].path);
+    }
+    cutest_porting_fprintf(g_test_ctx.out,
+        "[==========] total %u test%s registered.\n",
+        (unsigned)g_test_ctx.case_table.size,
+        g_test_ctx.case_table.size > 1 ? "s" : "");
+}
+
+static void _cutest_run_all_tests(void)
+{
+    _cutest_show_information();
+    _cutest_guard_setup();
+    _cutest_monitor_setup();
+    _cutest_flight_setup();
+    _cutest_param_sample_setup();
+
+    for (g_test_ctx.counter.repeat.repeated = 0;
+        g_test_ctx.counter.repeat.repeated < g_test_ctx.counter.repeat.repeat;
+        g_test_ctx.counter.repeat.repeated++)
+    {
+        if (g_test_ctx.counter.repeat.repeat > 1)
+        {
+            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW, "[==========]");
+            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT,
+                " start loop: %u/%u\n",
+                (unsigned)(g_test_ctx.counter.repeat.repeated + 1),
+                (unsigned)g_test_ctx.counter.repeat.repeat);
+        }
+
+        _cutest_monitor_update_counter();
+
+        /* shuffle if necessary */
+        if (g_test_ctx.mask.shuffle)
+        {
+            _cutest_shuffle_cases();
+        }
+
+        _cutest_run_all_test_once();
+        _cutest_param_sample_collect();
+
+        /* Undo shuffle. */
+        _cutest_undo_shuffle_cases();
+
+        if (g_test_ctx.counter.repeat.repeat > 1)
+        {
+            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW, "[==========]");
+            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT,
+                " end loop (%u/%u)\n",
+                (unsigned)(g_test_ctx.counter.repeat.repeated + 1),
+                (unsigned)g_test_ctx.counter.repeat.repeat);
+            if (g_test_ctx.counter.repeat.repeated < g_test_ctx.counter.repeat.repeat - 1)
+            {
+                cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
+            }
+        }
+    }
+
+    /* Iterations of `--test_repeat_until_fail` run concurrently. */
+    _cutest_param_sample_cleanup(g_test_ctx.counter.repeat.until_fail == 0);
+    _cutest_flight_cleanup();
+    _cutest_monitor_cleanup();
+    _cutest_guard_cleanup();
+}
+
+typedef struct test_repeat_job
+{
+    unsigned long               pid;                            /**< Child process, 0 if idle. */
+    unsigned long               iteration;                      /**< Zero based iteration. */
+    unsigned long               seed;                           /**< Random seed of iteration. */
+    FILE*                       log;                            /**< Output of iteration. */
+} test_repeat_job_t;
+
+/**
+ * @brief Run one iteration of `--test_repeat_until_fail`, usually in a child
+ *   process.
+ * @return 0 if success, 1 if failed.
+ */
+static int _cutest_repeat_iteration(void* arg)
+{
+    test_repeat_job_t* job = arg;
+
+    /* Iterations run concurrently, they can not share these files. */
+    g_test_ctx.monitor.path = NULL;
+    g_test_ctx.flight.path = NULL;
+
+    g_test_ctx.out = job->log;
+    g_test_ctx.counter.repeat.repeat = 1;
+    _cutest_srand(job->seed);
+
+    _cutest_run_all_tests();
+    fflush(job->log);
+    return g_test_ctx.counter.result.failed != 0;
+}
+
+/**
+ * @brief Run the tests on all CPUs until one iteration fails.
+ * @return 0 if all iterations passed, 1 if any failed.
+ */
+static int _cutest_repeat_until_fail(void)
+{
+    static test_repeat_job_t s_jobs[REPEAT_MAX_JOBS];
+    FILE* out = g_test_ctx.out;
+    unsigned long total = g_test_ctx.counter.repeat.until_fail;
+    unsigned long base_seed = g_test_ctx.runtime.seed;
+
+    unsigned long jobs = g_test_ctx.counter.repeat.jobs != 0 ?
+        g_test_ctx.counter.repeat.jobs : cutest_thread_cpu_count();
+    if (jobs > REPEAT_MAX_JOBS)
+    {
+        jobs = REPEAT_MAX_JOBS;
+    }
+    if (jobs > total)
+    {
+        jobs = total;
+    }
+
+    cutest_porting_cfprintf(out, CUTEST_COLOR_YELLOW, "[==========]");
+    cutest_porting_cfprintf(out, CUTEST_COLOR_DEFAULT,
+        " repeat until fail: %lu iteration%s, %lu at a time.\n",
+        total, total > 1 ? "s" : "", jobs);
+
+    cutest_porting_memset(s_jobs, 0, sizeof(s_jobs));
+    test_repeat_job_t* failed = NULL;
+    int failed_code = 0;
+    unsigned long next = 0, done = 0, running = 0, i;
+
+    for (;;)
+    {
+        while (failed == NULL && next < total && running < jobs)
+        {
+            test_repeat_job_t* job = &s_jobs[0];
+            while (job->log != NULL)
+            {
+                job++;
+            }
+
+            if ((job->log = cutest_memfile_open("cutest.repeat")) == NULL)
+            {
+                cutest_abort("Can not create output file of iteration.\n");
+            }
+            job->iteration = next++;
+            job->seed = (base_seed + job->iteration * REPEAT_SEED_STRIDE) % (MAX_RAND + 1);
+
+            if ((job->pid = cutest_process_spawn(out, job->log, _cutest_repeat_iteration, job)) != 0)
+            {
+                running++;
+                continue;
+            }
+
+            /* No child process, run it here. */
+            int code = _cutest_repeat_iteration(job);
+            g_test_ctx.out = out;
+            done++;
+            if (code != 0)
+            {
+                failed = job;
+                failed_code = code;
+                break;
+            }
+            fclose(job->log);
+            job->log = NULL;
+        }
+
+        int code = 0;
+        unsigned long pid;
+        if (running == 0 || (pid = cutest_process_wait_any(&code)) == 0)
+        {
+            break;
+        }
+
+        for (i = 0; i < REPEAT_MAX_JOBS && s_jobs[i].pid != pid; i++)
+        {
+        }
+        if (i == REPEAT_MAX_JOBS)
+        {
+            /* Not ours. */
+            continue;
+        }
+        test_repeat_job_t* job = &s_jobs[i];
+        job->pid = 0;
+        running--;
+        done++;
+
+        if (code == 0 || failed != NULL)
+        {
+            fclose(job->log);
+            job->log = NULL;
+            continue;
+        }
+
+        /* Stop everything else. */
+        failed = job;
+        failed_code = code;
+        for (i = 0; i < REPEAT_MAX_JOBS; i++)
+        {
+            if (s_jobs[i].pid != 0)
+            {
+                cutest_process_kill(s_jobs[i].pid);
+                fclose(s_jobs[i].log);
+                cutest_porting_memset(&s_jobs[i], 0, sizeof(s_jobs[i]));
+                running--;
+            }
+        }
+    }
+
+    if (failed == NULL)
+    {
+        cutest_porting_cfprintf(out, CUTEST_COLOR_GREEN, "[  PASSED  ]");
+        cutest_porting_cfprintf(out, CUTEST_COLOR_DEFAULT,
+            " %lu iteration%s.\n", done, done > 1 ? "s" : "");
+        return 0;
+    }
+
+    _cutest_copy_file(g_test_ctx.out, failed->log);
+    fclose(failed->log);
+
+    cutest_porting_cfprintf(out, CUTEST_COLOR_RED, "[  FAILED  ]");
+    if (failed_code > 128)
+    {
+        cutest_porting_cfprintf(out, CUTEST_COLOR_DEFAULT,
+            " iteration %lu killed by signal %d after %lu iteration%s,",
+            failed->iteration + 1, failed_code - 128, done, done > 1 ? "s" : "");
+    }
+    else
+    {
+        cutest_porting_cfprintf(out, CUTEST_COLOR_DEFAULT,
+            " iteration %lu failed after %lu iteration%s,",
+            failed->iteration + 1, done, done > 1 ? "s" : "");
+    }
+    cutest_porting_cfprintf(out, CUTEST_COLOR_DEFAULT,
+        " reproduce with --test_random_seed=%lu\n", failed->seed);
+    return 1;
+}
+
+typedef struct test_daemon_request
+{
+    int                         argc;
+    char*                       argv[DAEMON_MAX_ARGS + 1];
+} test_daemon_request_t;
+
+static char s_test_daemon_buf[DAEMON_REQUEST_SIZE];
+
+/**
+ * @brief Run tests of one request, in child process of daemon.
+ */
+static int _cutest_daemon_child(void* arg)
+{
+    test_daemon_request_t* req = arg;
+    FILE* out = g_test_ctx.out;
+    const cutest_hook_t* hook = g_test_ctx.hook;
+
+    int ret = _cutest_setup(req->argc, req->argv, out, hook);
+    if (ret != 0)
+    {
+        return ret & 0xFF;
+    }
+    g_test_ctx.daemon.path = NULL;
+
+    _cutest_run_all_tests();
+    return (int)g_test_ctx.counter.result.failed & 0xFF;
+}
+
+/**
+ * @brief Serve requests until a `STOP` request.
+ * @return 0 if success.
+ */
+static int _cutest_daemon_run(char* prog)
+{
+    const char* path = g_test_ctx.daemon.path;
+    int listener = cutest_daemon_listen(path);
+    if (listener < 0)
+    {
+        _cutest_warning("Can not listen on `%s', daemon is not started.\n", path);
+        return 1;
+    }
+    cutest_porting_fprintf(g_test_ctx.out, "[ DAEMON   ] %u test%s ready on %s.\n",
+        (unsigned)g_test_ctx.case_table.size, g_test_ctx.case_table.size > 1 ? "s" : "", path);
+
+    for (;;)
+    {
+        int out_fd = -1;
+        int conn = cutest_daemon_accept(listener, s_test_daemon_buf, sizeof(s_test_daemon_buf), &out_fd);
+        if (conn < 0)
+        {
+            continue;
+        }
+
+        /* Command, then arguments, then an empty string. */
+        char* pos = s_test_daemon_buf;
+        const char* command = pos;
+        pos += cutest_porting_strlen(pos) + 1;
+        if (cutest_porting_strcmp(command, "STOP") == 0)
+        {
+            cutest_daemon_serve(listener, conn, out_fd, g_test_ctx.out, NULL, NULL);
+            break;
+        }
+
+        test_daemon_request_t req;
+        req.argc = 0;
+        if (prog != NULL)
+        {
+            req.argv[req.argc++] = prog;
+        }
+        for (; *pos != '\0' && req.argc < DAEMON_MAX_ARGS; pos += cutest_porting_strlen(pos) + 1)
+        {
+            req.argv[req.argc++] = pos;
+        }
+        req.argv[req.argc] = NULL;
+
+        int code = cutest_daemon_serve(listener, conn, out_fd, g_test_ctx.out, _cutest_daemon_child, &req);
+        cutest_porting_fprintf(g_test_ctx.out, "[ DAEMON   ] request finished with exit code %d.\n", code);
+    }
+
+    cutest_daemon_close(listener, path);
+    return 0;
+}
+
+static unsigned long _cutest_get_test_fmt_name(char* buf, unsigned long len, cutest_case_t* test_case)
+{
+    return test_case->parameterized.type_name == NULL ?
+        _cutest_get_test_fmt_name_normal(buf, len, test_case) :
+        _cutest_get_test_fmt_name_parameter(buf, len, test_case);
+}
+
+static int _cutest_module_has_failed(const test_module_t* module, const char* name)
+{
+    const char* pos = module->failed;
+    for (; *pos != '\0'; pos += cutest_porting_strlen(pos) + 1)
+    {
+        if (cutest_porting_strcmp(pos, name) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int _cutest_module_load(test_module_t* module)
+{
+    s_test_module.loading = module;
+    module->handle = cutest_module_open(module->path);
+    s_test_module.loading = NULL;
+
+    if (module->handle == NULL)
+    {
+        _cutest_warning("Can not load `%s': %s.\n", module->path, cutest_module_error());
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Unregister cases of \p module, and remember which of them failed.
+ */
+static void _cutest_module_unload(test_module_t* module)
+{
+    unsigned long failed_sz = 0;
+    cutest_porting_memset(module->failed, 0, sizeof(module->failed));
+
+    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+    while (it != NULL)
+    {
+        cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+        it = cutest_map_next(it);
+        if (test_case->info.module_name != module->name)
+        {
+            continue;
+        }
+
+        char name[256];
+        unsigned long name_sz = _cutest_get_test_fmt_name(name, sizeof(name), test_case);
+        if (HAS_MASK(test_case->data.mask, MASK_FAILURE) && failed_sz + name_sz + 2 <= sizeof(module->failed))
+        {
+            cutest_porting_memcpy(module->failed + failed_sz, name, name_sz + 1);
+            failed_sz += name_sz + 1;
+        }
+        cutest_unregister_case(test_case);
+    }
+
+    if (module->handle != NULL)
+    {
+        _cutest_embed_free_all();
+        cutest_module_close(module->handle);
+        module->handle = NULL;
+    }
+}
+
+static void _cutest_module_load_all(void)
+{
+    unsigned i;
+    for (i = 0; i < s_test_module.size; i++)
+    {
+        _cutest_module_load(&s_test_module.modules[i]);
+    }
+}
+
+static void _cutest_module_unload_all(void)
+{
+    unsigned i;
+    for (i = 0; i < s_test_module.size; i++)
+    {
+        _cutest_module_unload(&s_test_module.modules[i]);
+    }
+    s_test_module.size = 0;
+}
+
+/**
+ * @brief Run cases of \p module, the ones failed last time first.
+ */
+static void _cutest_watch_rerun(test_module_t* module)
+{
+    _cutest_reset_all_test_mask();
+    _cutest_guard_setup();
+    _cutest_monitor_setup();
+    _cutest_flight_setup();
+
+    cutest_porting_timespec_t tv_total_start, tv_total_end;
+    cutest_porting_clock_gettime(&tv_total_start);
+
+    int failed_first;
+    for (failed_first = 1; failed_first >= 0; failed_first--)
+    {
+        cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
+        for (; it != NULL; it = cutest_map_next(it))
+        {
+            cutest_case_t* test_case = CONTAINER_OF(it, cutest_case_t, node);
+            if (test_case->info.module_name != module->name)
+            {
+                continue;
+            }
+
+            char name[256];
+            _cutest_get_test_fmt_name(name, sizeof(name), test_case);
+            if (_cutest_module_has_failed(module, name) != failed_first)
+            {
+                continue;
+            }
+
+            g_test_ctx.runtime.cur_node = test_case;
+            _cutest_run_case(test_case);
+        }
+    }
+
+    cutest_porting_clock_gettime(&tv_total_end);
+    _cutest_show_report(&tv_total_start, &tv_total_end);
+
+    _cutest_flight_cleanup();
+    _cutest_monitor_cleanup();
+    _cutest_guard_cleanup();
+}
+
+/**
+ * @brief Reload modules when they are rebuilt, and run their cases again.
+ */
+static void _cutest_watch_run(void)
+{
+    unsigned i;
+    int watched = 0;
+    s_test_module.fd = -1;
+    for (i = 0; i < s_test_module.size; i++)
+    {
+        test_module_t* module = &s_test_module.modules[i];
+        if (!module->watch)
+        {
+            continue;
+        }
+        if ((module->wd = cutest_watch_add(&s_test_module.fd, module->path)) < 0)
+        {
+            _cutest_warning("Can not watch `%s'.\n", module->path);
+            continue;
+        }
+        watched++;
+    }
+    if (watched == 0)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        cutest_porting_fprintf(g_test_ctx.out, "[ WATCH    ] waiting for changes of %d module%s.\n",
+            watched, watched > 1 ? "s" : "");
+        fflush(g_test_ctx.out);
+
+        int changed = 0;
+        long timeout_ms = -1;
+        int wd;
+        char name[256];
+        while (cutest_watch_wait(s_test_module.fd, timeout_ms, &wd, name, sizeof(name)) == 0)
+        {
+            for (i = 0; i < s_test_module.size; i++)
+            {
+                test_module_t* module = &s_test_module.modules[i];
+                unsigned long path_sz = cutest_porting_strlen(module->path);
+                unsigned long name_sz = cutest_porting_strlen(name);
+                if (module->wd == wd && path_sz >= name_sz
+                    && cutest_porting_strcmp(module->path + path_sz - name_sz, name) == 0
+                    && (path_sz == name_sz || module->path[path_sz - name_sz - 1] == '/'))
+                {
+                    module->dirty = 1;
+                    changed = 1;
+                }
+            }
+            timeout_ms = changed ? WATCH_SETTLE_MS : -1;
+        }
+        if (!changed)
+        {
+            break;
+        }
+
+        for (i = 0; i < s_test_module.size; i++)
+        {
+            test_module_t* module = &s_test_module.modules[i];
+            if (!module->dirty)
+            {
+                continue;
+            }
+            module->dirty = 0;
+
+            cutest_porting_fprintf(g_test_ctx.out, "[ WATCH    ] %s changed, reloading.\n", module->path);
+            _cutest_module_unload(module);
+            if (_cutest_module_load(module) == 0)
+            {
+                _cutest_watch_rerun(module);
+            }
+        }
+    }
+}
+
+void cutest_register_case(cutest_case_t* tc)
+{
+    if (s_test_module.loading != NULL)
+    {
+        tc->info.module_name = s_test_module.loading->name;
+    }
+    CUTEST_PORTING_ASSERT(cutest_map_insert(&g_test_ctx.case_table, &tc->node) == 0);
+}
+
+void cutest_unregister_case(cutest_case_t* tc)
+{
+    cutest_map_erase(&g_test_ctx.case_table, &tc->node);
+}
+
+void cutest_case_init(cutest_case_t* tc, const char* fixture_name, const char* case_name,
+    cutest_test_case_setup_fn setup, cutest_test_case_teardown_fn teardown, cutest_test_case_body_fn body)
+{
+    const cutest_case_t s_empty_tc = {
+        { NULL, NULL, NULL },       /* .node */
+        { NULL, NULL, NULL },       /* .info */
+        { NULL, NULL, NULL },       /* .stage */
+        { 0, 0, NULL, NULL, 0 },    /* .data */
+        { NULL, NULL, NULL, 0 },    /* .parameterized */
+        { 0, 0, 0, 0, 0, 0, 0 },    /* .benchmark */
+        { 0, 0, 0, 0, 0, 0 },       /* .histogram */
+    };
+    *tc = s_empty_tc;
+
+    tc->info.fixture_name = fixture_name;
+    tc->info.case_name = case_name;
+    tc->stage.setup = setup;
+    tc->stage.teardown = teardown;
+    tc->stage.body = body;
+}
+
+void cutest_case_convert_parameterized(cutest_case_t* tc, const char* type,
+    const char* commit, void* data, unsigned long size)
+{
+    tc->parameterized.type_name = type;
+    tc->parameterized.test_data_cstr = commit;
+    tc->parameterized.param_data = data;
+    tc->parameterized.param_idx = size;
+}
+
+int cutest_run_tests(int argc, char* argv[], FILE* out, const cutest_hook_t* hook)
+{
+    int ret = 0;
+    CUTEST_PORTING_ASSERT(out != NULL);
+
+    /* Parser parameter */
+    if ((ret = _cutest_setup(argc, argv, out, hook)) != 0)
+    {
+        goto fin;
+    }
+
+    _cutest_module_load_all();
+    if (g_test_ctx.mask.list_tests)
+    {
+        _cutest_list_tests();
+        goto fin;
+    }
+
+    _cutest_resource_preload();
+    _cutest_hook_before_all_test(argc, argv);
+    if (g_test_ctx.daemon.path != NULL)
+    {
+        ret = _cutest_daemon_run(argc > 0 ? argv[0] : NULL);
+    }
+    else if (g_test_ctx.counter.repeat.until_fail != 0)
+    {
+        ret = _cutest_repeat_until_fail();
+    }
+    else
+    {
+        _cutest_run_all_tests();
+        ret = (int)g_test_ctx.counter.result.failed;
+    }
+    _cutest_watch_run();
+    _cutest_hook_after_all_test();
+
+fin:
+    cutest_porting_memset(&s_test_param_sample, 0, sizeof(s_test_param_sample));
+    _cutest_resource_unmap_all();
+    _cutest_embed_free_all();
+    _cutest_module_unload_all();
+    _cutest_cleanup();
+    return ret & 0xFF;
+}
+
+const char* cutest_get_current_fixture(void)
+{
+    cutest_case_t* test_case = _cutest_current_case();
+    if (test_case == NULL)
+    {
+        return NULL;
+    }
+    return test_case->info.fixture_name;
+}
+
+const char* cutest_get_current_test(void)
+{
+    cutest_case_t* test_case = _cutest_current_case();
+    if (test_case == NULL)
+    {
+        return NULL;
+    }
+    return test_case->info.case_name;
+}
+
+unsigned long cutest_random_seed(void)
+{
+    return g_test_ctx.runtime.seed;
+}
+
+void cutest_fixture_set_thread_safe(const char* fixture_name)
+{
+    if (s_test_pipeline.fixture_sz == PIPELINE_MAX_FIXTURES)
+    {
+        cutest_abort("Too many thread safe fixtures, the limit is %d.\n", PIPELINE_MAX_FIXTURES);
+        return;
+    }
+    s_test_pipeline.fixtures[s_test_pipeline.fixture_sz++] = fixture_name;
 }
 
-static int _cutest_dump_float(FILE* file, const float* addr)
+void cutest_fixture_set_data(void* data)
 {
-    return cutest_porting_fprintf(file, "%f", *addr);
+    cutest_case_t* test_case = _cutest_current_case();
+    CUTEST_PORTING_ASSERT(test_case != NULL);
+    test_case->data.fixture_data = data;
 }
 
-static cutest_type_info_t s_type_info_float = {
-    { NULL, NULL, NULL }, "float",
-    (cutest_custom_type_cmp_fn)_cutest_cmp_float,
-    (cutest_custom_type_dump_fn)_cutest_dump_float,
-};
-
-static int _cutest_cmp_double(const double* addr1, const double* addr2)
+void* cutest_fixture_get_data(void)
 {
-    return cutest_porting_compare_floating_number(1, addr1, addr2);
+    cutest_case_t* test_case = _cutest_current_case();
+    CUTEST_PORTING_ASSERT(test_case != NULL);
+    return test_case->data.fixture_data;
 }
 
-static int _cutest_dump_double(FILE* file, const double* addr)
+const char* cutest_tmpdir(void)
 {
-    return cutest_porting_fprintf(file, "%f", *addr);
-}
+    cutest_case_t* test_case = _cutest_current_case();
+    CUTEST_PORTING_ASSERT(test_case != NULL);
+    if (test_case->data.tmpdir != NULL)
+    {
+        return test_case->data.tmpdir;
+    }
 
-static cutest_type_info_t s_type_info_double = {
-    { NULL, NULL, NULL }, "double",
-    (cutest_custom_type_cmp_fn)_cutest_cmp_double,
-    (cutest_custom_type_dump_fn)_cutest_dump_double,
-};
+    char prefix[128];
+    unsigned long pos = _cutest_fmt_append(prefix, sizeof(prefix), 0, "cutest.");
+    pos = _cutest_fmt_append(prefix, sizeof(prefix), pos, test_case->info.fixture_name);
+    pos = _cutest_fmt_append(prefix, sizeof(prefix), pos, ".");
+    _cutest_fmt_append(prefix, sizeof(prefix), pos, test_case->info.case_name);
+    if ((test_case->data.tmpdir = cutest_tmpdir_create(prefix)) == NULL)
+    {
+        cutest_abort("Can not create temporary directory for %s.%s.\n",
+            test_case->info.fixture_name, test_case->info.case_name);
+    }
+    return test_case->data.tmpdir;
+}
 
-static void _cutest_setup_type(void)
+const cutest_resource_t* cutest_resource_map(const char* name)
 {
-    /* C89 */
-    cutest_internal_register_type(&s_type_info_char);
-    cutest_internal_register_type(&s_type_info_signed_char);
-    cutest_internal_register_type(&s_type_info_unsigned_char);
-    cutest_internal_register_type(&s_type_info_short);
-    cutest_internal_register_type(&s_type_info_unsigned_short);
-    cutest_internal_register_type(&s_type_info_int);
-    cutest_internal_register_type(&s_type_info_unsigned_int);
-    cutest_internal_register_type(&s_type_info_long);
-    cutest_internal_register_type(&s_type_info_unsigned_long);
-    cutest_internal_register_type(&s_type_info_ptr);
-    cutest_internal_register_type(&s_type_info_str);
-    cutest_internal_register_type(&s_type_info_float);
-    cutest_internal_register_type(&s_type_info_double);
+    while (!cutest_atomic_cas(&s_test_resource.lock, 0, 1))
+    {
+        cutest_thread_yield();
+    }
 
-    /* C99 */
-#if !defined(CUTEST_NO_C99_SUPPORT)
-#if !defined(CUTEST_NO_LONGLONG_SUPPORT)
-    cutest_internal_register_type(&s_type_info_long_long);
-#endif
-#if !defined(CUTEST_NO_ULONGLONG_SUPPORT)
-    cutest_internal_register_type(&s_type_info_unsigned_long_long);
-#endif
-#if !defined(CUTEST_NO_INT8_SUPPORT)
-    cutest_internal_register_type(&s_type_info_int8_t);
-#endif
-#if !defined(CUTEST_NO_UINT8_SUPPORT)
-    cutest_internal_register_type(&s_type_info_uint8_t);
-#endif
-#if !defined(CUTEST_NO_INT16_SUPPORT)
-    cutest_internal_register_type(&s_type_info_int16_t);
-#endif
-#if !defined(CUTEST_NO_UINT16_SUPPORT)
-    cutest_internal_register_type(&s_type_info_uint16_t);
-#endif
-#if !defined(CUTEST_NO_INT32_SUPPORT)
-    cutest_internal_register_type(&s_type_info_int32_t);
-#endif
-#if !defined(CUTEST_NO_UINT32_SUPPORT)
-    cutest_internal_register_type(&s_type_info_uint32_t);
-#endif
-#if !defined(CUTEST_NO_INT64_SUPPORT)
-    cutest_internal_register_type(&s_type_info_int64_t);
-#endif
-#if !defined(CUTEST_NO_UINT64_SUPPORT)
-    cutest_internal_register_type(&s_type_info_uint64_t);
-#endif
-#if !defined(CUTEST_NO_SIZE_SUPPORT)
-    cutest_internal_register_type(&s_type_info_size_t);
-#endif
-#if !defined(CUTEST_NO_PTRDIFF_SUPPORT)
-    cutest_internal_register_type(&s_type_info_ptrdiff_t);
-#endif
-#if !defined(CUTEST_NO_INTPTR_SUPPORT)
-    cutest_internal_register_type(&s_type_info_intptr_t);
-#endif
-#if !defined(CUTEST_NO_UINTPTR_SUPPORT)
-    cutest_internal_register_type(&s_type_info_uintptr_t);
-#endif
-#endif
+    test_resource_t* item = _cutest_resource_get(name);
+    cutest_case_t* test_case = _cutest_current_case();
+    if (item != NULL && test_case != NULL)
+    {
+        _cutest_resource_add_user(item, test_case);
+    }
+
+    cutest_atomic_cas(&s_test_resource.lock, 1, 0);
+    return item != NULL ? &item->resource : NULL;
 }
 
 /**
- * @brief Setup resources that will not change.
+ * @brief Decompress LZ4 block \p src into \p dst.
+ * @return 0 if exactly \p dst_size bytes are produced, -1 if \p src is corrupted.
  */
-static void _cutest_setup_once(void)
+static int _cutest_embed_lz4_decode(const unsigned char* src, size_t src_size,
+    unsigned char* dst, size_t dst_size)
 {
-    static int token = 0;
-    if (token == 0)
+    const unsigned char* src_end = src + src_size;
+    size_t pos = 0;
+
+    while (src < src_end)
     {
-        token = 1;
-        _cutest_setup_type();
+        unsigned token = *src++;
+
+        size_t len = token >> 4;
+        if (len == 15)
+        {
+            unsigned char c;
+            do
+            {
+                if (src >= src_end)
+                {
+                    return -1;
+                }
+                c = *src++;
+                len += c;
+            } while (c == 255);
+        }
+        if (len > (size_t)(src_end - src) || len > dst_size - pos)
+        {
+            return -1;
+        }
+        cutest_porting_memcpy(dst + pos, src, (unsigned long)len);
+        src += len;
+        pos += len;
+
+        /* The last sequence has literals only. */
+        if (src >= src_end)
+        {
+            break;
+        }
+
+        if (src_end - src < 2)
+        {
+            return -1;
+        }
+        size_t offset = (size_t)src[0] | ((size_t)src[1] << 8);
+        src += 2;
+        if (offset == 0 || offset > pos)
+        {
+            return -1;
+        }
+
+        len = (token & 0x0F) + 4;
+        if ((token & 0x0F) == 15)
+        {
+            unsigned char c;
+            do
+            {
+                if (src >= src_end)
+                {
+                    return -1;
+                }
+                c = *src++;
+                len += c;
+            } while (c == 255);
+        }
+        if (len > dst_size - pos)
+        {
+            return -1;
+        }
+
+        /* Byte by byte, the match may overlap itself. */
+        size_t i;
+        for (i = 0; i < len; i++, pos++)
+        {
+            dst[pos] = dst[pos - offset];
+        }
     }
+
+    return pos == dst_size ? 0 : -1;
 }
 
-static void _cutest_prepare(void)
+const void* cutest_embed_data(cutest_embed_t* embed, size_t* size)
 {
-    cutest_porting_timespec_t seed;
-    cutest_porting_clock_gettime(&seed);
-    _cutest_srand((unsigned long)seed.tv_sec);
+    if (size != NULL)
+    {
+        *size = embed->raw_size;
+    }
+    if (!embed->compressed)
+    {
+        return embed->data;
+    }
 
-    g_test_ctx.runtime.tid = cutest_porting_gettid();
-    g_test_ctx.counter.repeat.repeat = 1;
-}
+    /* 0: not decompressed, 1: decompressing, 2: done. */
+    if (cutest_atomic_cas(&embed->state, 0, 1))
+    {
+        unsigned char* buf = malloc(embed->raw_size + 1);
+        if (buf == NULL
+            || _cutest_embed_lz4_decode(embed->data, embed->size, buf, embed->raw_size) != 0)
+        {
+            cutest_abort("Can not decompress embedded file.\n");
+            return NULL;
+        }
+        buf[embed->raw_size] = '\0';
+        embed->cache = buf;
 
-static int _cutest_setup_arg_help(void)
-{
-    _cutest_print_encoded(s_test_help_encoded);
-    return 1 << 8 | 0;
+        _cutest_embed_lock();
+        embed->next = s_test_embed.head;
+        s_test_embed.head = embed;
+        _cutest_embed_unlock();
+        cutest_atomic_add(&embed->state, 1);
+    }
+    while (cutest_atomic_add(&embed->state, 0) != 2)
+    {
+        cutest_thread_yield();
+    }
+    return embed->cache;
 }
 
-static int _cutest_setup_arg_list_tests(void)
+FILE* cutest_memfile(const char* name)
 {
-    _cutest_list_tests();
-    return 1 << 8 | 0;
+    FILE* file = cutest_memfile_open(name != NULL ? name : "cutest");
+    if (file == NULL)
+    {
+        cutest_abort("Can not create memory file.\n");
+    }
+    return file;
 }
 
-static int _cutest_setup_arg_list_types(void)
+void cutest_internal_flight_assert(const cutest_internal_location_t* loc)
 {
-    _cutest_list_types();
-    return 1 << 8 | 0;
+    _cutest_flight_assert(loc->file, loc->line);
 }
 
-static int _cutest_setup_arg_also_run_disabled_tests(void)
+void cutest_internal_assert_failure(void)
 {
-    g_test_ctx.mask.also_run_disabled_tests = 1;
-    return 0;
-}
+    cutest_flight_assert_t last;
+    if (g_test_ctx.flight.recorder != NULL && _cutest_flight_read_assert(g_test_ctx.flight.recorder, &last) == 0)
+    {
+        _cutest_flight_record(CUTEST_FLIGHT_FAILURE, last.line, last.file);
+    }
 
-static int _cutest_setup_arg_shuffle(void)
-{
-    g_test_ctx.mask.shuffle = 1;
-    return 0;
+    /* Fixture stage running on helper thread. */
+    if (s_test_thread_ctx.func != NULL)
+    {
+        s_test_thread_ctx.func(s_test_thread_ctx.addr, MASK_FAILURE);
+        return;
+    }
+
+    if (g_test_ctx.runtime.tid != cutest_porting_gettid())
+    {
+        /**
+         * If current thread is NOT the main thread, it is dangerous to jump back
+         * to caller stack, so we just abort the program.
+         */
+        cutest_abort("");
+    }
+    else
+    {
+        if (g_test_ctx.mask.backtrace)
+        {
+            _cutest_backtrace_capture(CUTEST_RETURN_ADDRESS());
+        }
+        g_test_ctx.jmp.func(g_test_ctx.jmp.addr, MASK_FAILURE);
+    }
 }
 
-static int _cutest_setup_arg_break_on_failure(void)
+void cutest_skip_test(void)
 {
-    g_test_ctx.mask.break_on_failure = 1;
-    return 0;
+    SET_MASK(g_test_ctx.runtime.cur_node->data.mask, MASK_SKIPPED);
 }
 
-static void _cutest_cleanup(void)
+/**
+ * @brief Predict how many iterations we need to last \p min_time nanoseconds,
+ *   and overshoot a little.
+ */
+static unsigned long _cutest_benchmark_next_batch(unsigned long batch, double elapsed, double min_time)
 {
-    /* Reset all data. */
+    double multiplier = elapsed > 0 ? min_time * 1.4 / elapsed : 10;
+    if (multiplier > 10)
     {
-        cutest_map_t case_table = g_test_ctx.case_table;
-        cutest_map_t type_table = g_test_ctx.type_table;
-        cutest_porting_memset(&g_test_ctx, 0, sizeof(g_test_ctx));
-        g_test_ctx.case_table = case_table;
-        g_test_ctx.type_table = type_table;
+        multiplier = 10;
     }
+
+    double next = batch * multiplier;
+    if (next >= (double)(~0UL >> 1))
+    {
+        next = (double)(~0UL >> 1);
+    }
+    return next > batch ? (unsigned long)next : batch + 1;
 }
 
-/**
- * @brief Setup test context
- * @param[in] argc      The number of command line argument.
- * @param[in] argv      Command line argument list.
- * @param[in] hook      Global test hook.
- * @param[out] b_exit   Whether need to exit.
- * @return              0 if success, otherwise failure. The lower 8 bit is the actual exit code.
- */
-static int _cutest_setup(int argc, char* argv[], FILE* out, const cutest_hook_t* hook)
+int cutest_benchmark_loop(void)
 {
-#define PARSER_LONGOPT_WITH_VALUE(OPT, FUNC)   \
-    do {\
-        int ret = -1; const char* opt = OPT;\
-        unsigned optlen = cutest_porting_strlen(opt);\
-        if (cutest_porting_strncmp(argv[i], opt, optlen) == 0) {\
-            if (argv[i][optlen] == '=') {\
-                ret = FUNC(argv[i] + optlen + 1);\
-            } else if (i < argc - 1) {\
-                ret = FUNC(argv[i + 1]); i++;\
-            }\
-            if (ret != 0) {\
-                cutest_porting_fprintf(g_test_ctx.out, "Invalid argument to `%s'\n", opt);\
-                return ret;\
-            }\
-            continue;\
-        }\
-    } while (0)
+    cutest_case_t* test_case = g_test_ctx.runtime.cur_node;
+    CUTEST_PORTING_ASSERT(test_case != NULL);
 
-#define PARSER_LONGOPT_NO_VALUE(OPT, FUNC)   \
-    do {\
-        int ret = 0; const char* opt = OPT;\
-        if (cutest_porting_strcmp(argv[i], opt) == 0) {\
-            if ((ret = FUNC()) != 0) {\
-                return ret;\
-            }\
-        }\
-        continue;\
-    } while (0)
+    if (!g_test_ctx.benchmark.running)
+    {
+        _cutest_benchmark_begin(1);
+        g_test_ctx.benchmark.running = 1;
+        g_test_ctx.benchmark.batch = 1;
+        g_test_ctx.benchmark.done = 0;
+        g_test_ctx.benchmark.repeated = 0;
+        g_test_ctx.benchmark.sum_ns_per_op = 0;
+        g_test_ctx.benchmark.calibration_ns_per_op = 0;
+        g_test_ctx.benchmark.samples = 0;
+        cutest_porting_clock_gettime(&g_test_ctx.benchmark.tv_beg);
+        return 1;
+    }
 
-    _cutest_setup_once();
+    if (g_test_ctx.benchmark.cold)
+    {
+        if (_cutest_benchmark_cold_step(test_case))
+        {
+            return 1;
+        }
+        g_test_ctx.benchmark.running = 0;
+        _cutest_benchmark_end();
+        return 0;
+    }
+
+    if (++g_test_ctx.benchmark.done < g_test_ctx.benchmark.batch)
+    {
+        return 1;
+    }
+
+    cutest_porting_timespec_t tv_end;
+    cutest_porting_clock_gettime(&tv_end);
+
+    double elapsed = cutest_timestamp_dif_ns(&g_test_ctx.benchmark.tv_beg, &tv_end);
+    double min_time = (double)g_test_ctx.benchmark.min_time_ms * 1000 * 1000;
+    unsigned long batch = g_test_ctx.benchmark.batch;
+
+    g_test_ctx.benchmark.total_ns += elapsed;
+    g_test_ctx.benchmark.total_iterations += batch;
+    g_test_ctx.benchmark.threads = 1;
+
+    /* Calibration: find a batch size that lasts long enough. */
+    if (g_test_ctx.benchmark.repeated == 0 && elapsed < min_time)
+    {
+        /* Too short batches are dominated by overhead, they are not samples. */
+        if (elapsed >= min_time / 10)
+        {
+            g_test_ctx.benchmark.calibration_ns_per_op = elapsed / batch;
+        }
 
-    _cutest_cleanup();
-    _cutest_prepare();
+        g_test_ctx.benchmark.batch = _cutest_benchmark_next_batch(batch, elapsed, min_time);
+        g_test_ctx.benchmark.done = 0;
+        cutest_porting_clock_gettime(&g_test_ctx.benchmark.tv_beg);
+        return 1;
+    }
 
-    g_test_ctx.out = out;
-    g_test_ctx.hook = hook;
+    if (g_test_ctx.benchmark.repeated == 0 && g_test_ctx.benchmark.calibration_ns_per_op > 0)
+    {
+        _cutest_benchmark_add_sample(g_test_ctx.benchmark.calibration_ns_per_op);
+    }
+    _cutest_benchmark_add_sample(elapsed / batch);
+    g_test_ctx.benchmark.sum_ns_per_op += elapsed / batch;
+    g_test_ctx.benchmark.repeated++;
 
-    int i;
-    for (i = 0; i < argc; i++)
+    if (g_test_ctx.benchmark.repeated < g_test_ctx.benchmark.repetitions)
     {
-        PARSER_LONGOPT_NO_VALUE("-h",                               _cutest_setup_arg_help);
-        PARSER_LONGOPT_NO_VALUE("--help",                           _cutest_setup_arg_help);
-        PARSER_LONGOPT_NO_VALUE("--test_list_tests",                _cutest_setup_arg_list_tests);
-        PARSER_LONGOPT_NO_VALUE("--test_list_types",                _cutest_setup_arg_list_types);
-        PARSER_LONGOPT_NO_VALUE("--test_also_run_disabled_tests",   _cutest_setup_arg_also_run_disabled_tests);
-        PARSER_LONGOPT_NO_VALUE("--test_shuffle",                   _cutest_setup_arg_shuffle);
-        PARSER_LONGOPT_NO_VALUE("--test_break_on_failure",          _cutest_setup_arg_break_on_failure);
+        g_test_ctx.benchmark.done = 0;
+        cutest_porting_clock_gettime(&g_test_ctx.benchmark.tv_beg);
+        return 1;
+    }
 
-        PARSER_LONGOPT_WITH_VALUE("--test_filter",                  _cutest_setup_arg_pattern);
-        PARSER_LONGOPT_WITH_VALUE("--test_repeat",                  _cutest_setup_arg_repeat);
-        PARSER_LONGOPT_WITH_VALUE("--test_random_seed",             _cutest_setup_arg_random_seed);
-        PARSER_LONGOPT_WITH_VALUE("--test_print_time",              _cutest_setup_arg_print_time);
+    double ns_per_op = g_test_ctx.benchmark.sum_ns_per_op / g_test_ctx.benchmark.repeated;
+    test_case->benchmark.iterations = batch;
+    test_case->benchmark.ns_per_op = ns_per_op;
+    test_case->benchmark.spread = (g_test_ctx.benchmark.samples > 1 && ns_per_op > 0) ?
+        (g_test_ctx.benchmark.sample_max - g_test_ctx.benchmark.sample_min) / ns_per_op * 100 : -1;
+
+    if (g_test_ctx.mask.benchmark_cold_cache)
+    {
+        _cutest_benchmark_cold_begin();
+        return 1;
     }
 
+    g_test_ctx.benchmark.running = 0;
+    _cutest_benchmark_end();
     return 0;
-
-#undef PARSER_LONGOPT_NO_VALUE
-#undef PARSER_LONGOPT_WITH_VALUE
 }
 
-static void _cutest_run_all_test_once(void)
+typedef struct test_benchmark_worker
 {
-    _cutest_reset_all_test_mask();
+    cutest_thread_t                 thread;
+    struct test_benchmark_parallel* owner;
+    unsigned                        idx;        /**< Thread index. */
+    cutest_porting_timespec_t       tv_beg;     /**< Time after barrier. */
+    cutest_porting_timespec_t       tv_end;     /**< Time after benchmark body. */
+} test_benchmark_worker_t;
 
-    cutest_porting_timespec_t tv_total_start, tv_total_end;
-    cutest_porting_clock_gettime(&tv_total_start);
+typedef struct test_benchmark_parallel
+{
+    cutest_benchmark_parallel_fn    fn;
+    void*                           arg;
+    unsigned                        nthreads;   /**< Threads in this round. */
+    unsigned long                   iterations; /**< Iterations per thread. */
+    volatile long                   arrived;    /**< Start barrier. */
+    test_benchmark_worker_t         workers[BENCHMARK_MAX_THREADS];
+} test_benchmark_parallel_t;
 
-    cutest_map_node_t* it = cutest_map_begin(&g_test_ctx.case_table);
-    for (; it != NULL; it = cutest_map_next(it))
+static void _cutest_benchmark_parallel_worker(void* arg)
+{
+    test_benchmark_worker_t* worker = arg;
+    test_benchmark_parallel_t* ctx = worker->owner;
+
+    cutest_thread_pin(worker->idx);
+
+    /* Wait for all threads, so they start at the same time. */
+    cutest_atomic_add(&ctx->arrived, 1);
+    while (cutest_atomic_add(&ctx->arrived, 0) < (long)ctx->nthreads)
     {
-        g_test_ctx.runtime.cur_node = CONTAINER_OF(it, cutest_case_t, node);
-        _cutest_run_case(g_test_ctx.runtime.cur_node);
+        cutest_thread_yield();
     }
 
-    cutest_porting_clock_gettime(&tv_total_end);
-
-    _cutest_show_report(&tv_total_start, &tv_total_end);
+    cutest_porting_clock_gettime(&worker->tv_beg);
+    ctx->fn(ctx->arg, worker->idx, ctx->iterations);
+    cutest_porting_clock_gettime(&worker->tv_end);
 }
 
-static void _cutest_show_information(void)
+/**
+ * @brief Run one round.
+ * @param[out] wall - Time from the first thread start to the last thread finish.
+ * @param[out] latency - Average time of one operation on one thread.
+ */
+static void _cutest_benchmark_parallel_round(test_benchmark_parallel_t* ctx, double* wall, double* latency)
 {
-#if CUTEST_VERSION_PREREL
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $VERSION ] %d.%d.%d-dev%d\n", CUTEST_VERSION_MAJOR, CUTEST_VERSION_MINOR, CUTEST_VERSION_PATCH, CUTEST_VERSION_PREREL);
-#else
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $VERSION ] %d.%d.%d\n", CUTEST_VERSION_MAJOR, CUTEST_VERSION_MINOR, CUTEST_VERSION_PATCH);
-#endif
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $PARAME. ] --test_shuffle=%d\n", (int)g_test_ctx.mask.shuffle);
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $PARAME. ] --test_random_seed=%lu\n", cutest_porting_grand());
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $PARAME. ] --test_also_run_disabled_tests=%d\n", (int)g_test_ctx.mask.also_run_disabled_tests);
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $PARAME. ] --test_filter=%s\n", g_test_ctx.filter.pattern.ptr != NULL ? g_test_ctx.filter.pattern.ptr : "");
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $PARAME. ] --test_repeat=%lu\n", g_test_ctx.counter.repeat.repeat);
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $PARAME. ] --test_break_on_failure=%d\n", (int)g_test_ctx.mask.break_on_failure);
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[ $PARAME. ] --test_print_time=%d\n", (int)!g_test_ctx.mask.no_print_time);
-    cutest_porting_fprintf(g_test_ctx.out,
-        "[==========] total %u test%s registered.\n",
-        (unsigned)g_test_ctx.case_table.size,
-        g_test_ctx.case_table.size > 1 ? "s" : "");
+    unsigned i;
+    ctx->arrived = 0;
+
+    for (i = 0; i < ctx->nthreads; i++)
+    {
+        test_benchmark_worker_t* worker = &ctx->workers[i];
+        worker->owner = ctx;
+        worker->idx = i;
+        worker->thread.fn = _cutest_benchmark_parallel_worker;
+        worker->thread.arg = worker;
+        cutest_thread_create(&worker->thread);
+    }
+
+    cutest_porting_timespec_t tv_beg = { 0, 0 }, tv_end = { 0, 0 };
+    double sum = 0;
+    for (i = 0; i < ctx->nthreads; i++)
+    {
+        test_benchmark_worker_t* worker = &ctx->workers[i];
+        cutest_thread_join(&worker->thread);
+
+        if (i == 0 || cutest_timestamp_dif(&worker->tv_beg, &tv_beg, NULL) < 0)
+        {
+            tv_beg = worker->tv_beg;
+        }
+        if (i == 0 || cutest_timestamp_dif(&worker->tv_end, &tv_end, NULL) > 0)
+        {
+            tv_end = worker->tv_end;
+        }
+        sum += cutest_timestamp_dif_ns(&worker->tv_beg, &worker->tv_end);
+    }
+
+    *wall = cutest_timestamp_dif_ns(&tv_beg, &tv_end);
+    *latency = sum / ctx->nthreads / ctx->iterations;
 }
 
-static void _cutest_run_all_tests(void)
+void cutest_benchmark_parallel(cutest_benchmark_parallel_fn fn, void* arg,
+    unsigned max_threads)
 {
-    _cutest_show_information();
+    cutest_case_t* test_case = g_test_ctx.runtime.cur_node;
+    CUTEST_PORTING_ASSERT(test_case != NULL);
+    CUTEST_PORTING_ASSERT(fn != NULL);
 
-    for (g_test_ctx.counter.repeat.repeated = 0;
-        g_test_ctx.counter.repeat.repeated < g_test_ctx.counter.repeat.repeat;
-        g_test_ctx.counter.repeat.repeated++)
+#if defined(CUTEST_NO_THREADS)
+    max_threads = 1;
+#endif
+    if (max_threads == 0)
     {
-        if (g_test_ctx.counter.repeat.repeat > 1)
+        max_threads = cutest_thread_cpu_count();
+    }
+    if (max_threads > BENCHMARK_MAX_THREADS)
+    {
+        max_threads = BENCHMARK_MAX_THREADS;
+    }
+
+    _cutest_benchmark_begin(0);
+
+    test_benchmark_parallel_t ctx;
+    ctx.fn = fn;
+    ctx.arg = arg;
+
+    double min_time = (double)g_test_ctx.benchmark.min_time_ms * 1000 * 1000;
+    double base_throughput = 0;
+
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ SCALING  ]");
+    cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %7s %14s %14s %10s\n",
+        "threads", "ops/s", "ns/op/thread", "efficiency");
+
+    for (ctx.nthreads = 1;; ctx.nthreads = ctx.nthreads * 2 < max_threads ? ctx.nthreads * 2 : max_threads)
+    {
+        double wall, latency;
+        ctx.iterations = 1;
+        for (;;)
         {
-            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW, "[==========]");
-            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT,
-                " start loop: %u/%u\n",
-                (unsigned)(g_test_ctx.counter.repeat.repeated + 1),
-                (unsigned)g_test_ctx.counter.repeat.repeat);
+            _cutest_benchmark_parallel_round(&ctx, &wall, &latency);
+            g_test_ctx.benchmark.total_ns += wall;
+            g_test_ctx.benchmark.total_iterations += (double)ctx.nthreads * ctx.iterations;
+            g_test_ctx.benchmark.threads = ctx.nthreads;
+            if (wall >= min_time)
+            {
+                break;
+            }
+            ctx.iterations = _cutest_benchmark_next_batch(ctx.iterations, wall, min_time);
         }
 
-        /* shuffle if necessary */
-        if (g_test_ctx.mask.shuffle)
+
+        double throughput = (double)ctx.nthreads * ctx.iterations / wall * 1000 * 1000 * 1000;
+        if (ctx.nthreads == 1)
         {
-            _cutest_shuffle_cases();
+            base_throughput = throughput;
+            test_case->benchmark.iterations = ctx.iterations;
+            test_case->benchmark.ns_per_op = latency;
         }
 
-        _cutest_run_all_test_once();
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_GREEN, "[ SCALING  ]");
+        cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, " %7u %14.0f %14.2f %9.1f%%\n",
+            ctx.nthreads, throughput, latency, throughput / (base_throughput * ctx.nthreads) * 100);
 
-        /* Undo shuffle. */
-        _cutest_undo_shuffle_cases();
+        /* The maximum thread count is always measured. */
+        if (ctx.nthreads >= max_threads)
+        {
+            break;
+        }
+    }
 
-        if (g_test_ctx.counter.repeat.repeat > 1)
+    _cutest_benchmark_end();
+}
+
+void cutest_hist_record(unsigned long value)
+{
+    /* Spread threads into different shards. */
+    void* tid = cutest_porting_gettid();
+    unsigned long hash = 0;
+    cutest_porting_memcpy(&hash, &tid, sizeof(hash) < sizeof(tid) ? sizeof(hash) : sizeof(tid));
+    hash ^= (hash >> 7) ^ (hash >> 13);
+
+    test_hist_shard_t* shard = &s_test_hist.shards[hash % HIST_SHARD_COUNT];
+    cutest_atomic_add(&shard->counts[_cutest_hist_index(value)], 1);
+    cutest_atomic_add(&shard->total, 1);
+
+    for (;;)
+    {
+        long cur = shard->max;
+        if (value <= (unsigned long)cur || cutest_atomic_cas(&shard->max, cur, (long)value))
         {
-            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_YELLOW, "[==========]");
-            cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT,
-                " end loop (%u/%u)\n",
-                (unsigned)(g_test_ctx.counter.repeat.repeated + 1),
-                (unsigned)g_test_ctx.counter.repeat.repeat);
-            if (g_test_ctx.counter.repeat.repeated < g_test_ctx.counter.repeat.repeat - 1)
-            {
-                cutest_porting_cfprintf(g_test_ctx.out, CUTEST_COLOR_DEFAULT, "\n");
-            }
+            break;
         }
     }
+
+    s_test_hist.dirty = 1;
 }
 
-void cutest_register_case(cutest_case_t* tc)
+void* cutest_guard_malloc(size_t size)
 {
-    CUTEST_PORTING_ASSERT(cutest_map_insert(&g_test_ctx.case_table, &tc->node) == 0);
+    void* ptr = _cutest_guard_alloc(size);
+    return ptr != NULL ? ptr : malloc(size);
 }
 
-void cutest_unregister_case(cutest_case_t* tc)
+void* cutest_guard_calloc(size_t nmemb, size_t size)
 {
-    cutest_map_erase(&g_test_ctx.case_table, &tc->node);
+    if (size != 0 && nmemb > (size_t)-1 / size)
+    {
+        return NULL;
+    }
+
+    void* ptr = _cutest_guard_alloc(nmemb * size);
+    if (ptr == NULL)
+    {
+        return calloc(nmemb, size);
+    }
+
+    /* The slot might be used before. */
+    cutest_porting_memset(ptr, 0, nmemb * size);
+    return ptr;
 }
 
-void cutest_case_init(cutest_case_t* tc, const char* fixture_name, const char* case_name,
-    cutest_test_case_setup_fn setup, cutest_test_case_teardown_fn teardown, cutest_test_case_body_fn body)
+void* cutest_guard_realloc(void* ptr, size_t size)
 {
-    const cutest_case_t s_empty_tc = {
-        { NULL, NULL, NULL },       /* .node */
-        { NULL, NULL },             /* .info */
-        { NULL, NULL, NULL },       /* .stage */
-        { 0,0 },                    /* .data */
-        { NULL, NULL, NULL, 0 },    /* .parameterized */
-    };
-    *tc = s_empty_tc;
+    long idx = ptr != NULL ? _cutest_guard_find_slot(ptr) : -1;
+    if (idx < 0)
+    {
+        return realloc(ptr, size);
+    }
 
-    tc->info.fixture_name = fixture_name;
-    tc->info.case_name = case_name;
-    tc->stage.setup = setup;
-    tc->stage.teardown = teardown;
-    tc->stage.body = body;
+    void* new_ptr = cutest_guard_malloc(size);
+    if (new_ptr == NULL)
+    {
+        return NULL;
+    }
+
+    unsigned long old_size = s_test_guard.slots[idx].size;
+    cutest_porting_memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    _cutest_guard_release(ptr);
+    return new_ptr;
 }
 
-void cutest_case_convert_parameterized(cutest_case_t* tc, const char* type,
-    const char* commit, void* data, unsigned long size)
+void cutest_guard_free(void* ptr)
 {
-    tc->parameterized.type_name = type;
-    tc->parameterized.test_data_cstr = commit;
-    tc->parameterized.param_data = data;
-    tc->parameterized.param_idx = size;
+    if (ptr != NULL && !_cutest_guard_release(ptr))
+    {
+        free(ptr);
+    }
 }
 
-int cutest_run_tests(int argc, char* argv[], FILE* out, const cutest_hook_t* hook)
+void cutest_benchmark_set_evict_buffer(void* buf, unsigned long size)
 {
-    int ret = 0;
-    CUTEST_PORTING_ASSERT(out != NULL);
+    s_test_evict.buf = size != 0 ? buf : NULL;
+    s_test_evict.size = s_test_evict.buf != NULL ? size : 0;
+}
 
-    /* Parser parameter */
-    if ((ret = _cutest_setup(argc, argv, out, hook)) != 0)
+int cutest_internal_perf_loop(void)
+{
+    if (!g_test_ctx.perf.running)
     {
-        goto fin;
+        g_test_ctx.perf.running = 1;
+        g_test_ctx.perf.batch = 1;
+        g_test_ctx.perf.done = 0;
+        g_test_ctx.perf.rounds = 0;
+        g_test_ctx.perf.best = 0;
+        cutest_porting_clock_gettime(&g_test_ctx.perf.tv_beg);
+        return 1;
     }
 
-    _cutest_hook_before_all_test(argc, argv);
-    _cutest_run_all_tests();
-    ret = (int)g_test_ctx.counter.result.failed;
-    _cutest_hook_after_all_test();
+    if (++g_test_ctx.perf.done < g_test_ctx.perf.batch)
+    {
+        return 1;
+    }
 
-fin:
-    _cutest_cleanup();
-    return ret & 0xFF;
-}
+    cutest_porting_timespec_t tv_end;
+    cutest_porting_clock_gettime(&tv_end);
+    double elapsed = cutest_timestamp_dif_ns(&g_test_ctx.perf.tv_beg, &tv_end);
 
-const char* cutest_get_current_fixture(void)
-{
-    if (g_test_ctx.runtime.cur_node == NULL)
+    /* Too short round is dominated by timer, scale iterations. */
+    if (g_test_ctx.perf.rounds == 0 && elapsed < PERF_ROUND_MIN_NS)
     {
-        return NULL;
+        g_test_ctx.perf.batch = _cutest_benchmark_next_batch(g_test_ctx.perf.batch, elapsed, PERF_ROUND_MIN_NS);
+        g_test_ctx.perf.done = 0;
+        cutest_porting_clock_gettime(&g_test_ctx.perf.tv_beg);
+        return 1;
+    }
+
+    double ns_per_op = elapsed / g_test_ctx.perf.batch;
+    if (g_test_ctx.perf.rounds == 0 || ns_per_op < g_test_ctx.perf.best)
+    {
+        g_test_ctx.perf.best = ns_per_op;
+    }
+
+    if (++g_test_ctx.perf.rounds < PERF_ROUNDS)
+    {
+        g_test_ctx.perf.done = 0;
+        cutest_porting_clock_gettime(&g_test_ctx.perf.tv_beg);
+        return 1;
     }
-    return g_test_ctx.runtime.cur_node->info.fixture_name;
+
+    g_test_ctx.perf.running = 0;
+    return 0;
 }
 
-const char* cutest_get_current_test(void)
+double cutest_internal_perf_result(void)
+{
+    return g_test_ctx.perf.best;
+}
+
+/**
+ * @brief Check if we are running under Valgrind.
+ */
+static int _cutest_perf_under_valgrind(void)
 {
-    if (g_test_ctx.runtime.cur_node == NULL)
+    const char* preload = getenv("LD_PRELOAD");
+    return preload != NULL
+        && (cutest_porting_strstr(preload, "vgpreload") != NULL
+            || cutest_porting_strstr(preload, "valgrind") != NULL);
+}
+
+int cutest_internal_perf_check(const char* file, int line, const char* stmt,
+    double ns, double bound_ns, int sanitizer)
+{
+    _cutest_flight_assert(file, line);
+
+    double factor = 1;
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+    sanitizer = 1;
+#endif
+    if (sanitizer)
     {
-        return NULL;
+        factor = PERF_RELAX_SANITIZER;
+    }
+    if (_cutest_perf_under_valgrind())
+    {
+        factor = PERF_RELAX_VALGRIND;
+    }
+
+    if (ns <= bound_ns * factor)
+    {
+        return 1;
     }
-    return g_test_ctx.runtime.cur_node->info.case_name;
+
+    cutest_porting_fprintf(_cutest_out(),
+        "%s:%d:failure:\n"
+        "            expected: `%s' takes at most %.2f ns\n"
+        "              actual: %.2f ns\n",
+        file, line, stmt, bound_ns * factor, ns);
+    return 0;
 }
 
-void cutest_internal_assert_failure(void)
+void cutest_counter_set(const char* name, double value, int flags)
 {
-    if (g_test_ctx.runtime.tid != cutest_porting_gettid())
+    unsigned i;
+    for (i = 0; i < s_test_counters.size; i++)
     {
-        /**
-         * If current thread is NOT the main thread, it is dangerous to jump back
-         * to caller stack, so we just abort the program.
-         */
-        cutest_abort("");
+        if (cutest_porting_strncmp(s_test_counters.items[i].name, name, COUNTER_NAME_SIZE - 1) == 0)
+        {
+            break;
+        }
     }
-    else
+
+    if (i == s_test_counters.size)
     {
-        g_test_ctx.jmp.func(g_test_ctx.jmp.addr, MASK_FAILURE);
+        if (s_test_counters.size == COUNTER_MAX)
+        {
+            cutest_abort("Too many counters, at most %d counters can be set.\n", COUNTER_MAX);
+        }
+        s_test_counters.size++;
+
+        test_counter_t* counter = &s_test_counters.items[i];
+        unsigned long len = cutest_porting_strlen(name);
+        len = len < COUNTER_NAME_SIZE - 1 ? len : COUNTER_NAME_SIZE - 1;
+        cutest_porting_memcpy(counter->name, name, len);
+        counter->name[len] = '\0';
     }
+
+    s_test_counters.items[i].value = value;
+    s_test_counters.items[i].flags = flags;
 }
 
-void cutest_skip_test(void)
+void cutest_benchmark_set_complexity_n(unsigned long n)
 {
-    SET_MASK(g_test_ctx.runtime.cur_node->data.mask, MASK_SKIPPED);
+    CUTEST_PORTING_ASSERT(g_test_ctx.runtime.cur_node != NULL);
+    g_test_ctx.runtime.cur_node->benchmark.complexity_n = n;
+}
+
+void cutest_benchmark_expect_complexity(cutest_complexity_t complexity)
+{
+    CUTEST_PORTING_ASSERT(g_test_ctx.runtime.cur_node != NULL);
+    g_test_ctx.runtime.cur_node->benchmark.complexity = complexity;
 }
 
 int cutest_internal_break_on_failure(void)
@@ -3561,22 +10373,23 @@ void cutest_internal_dump(const char* file, int line, const char* type_name,
         return;
     }
 
-    cutest_porting_fprintf(g_test_ctx.out,
+    FILE* out = _cutest_out();
+    cutest_porting_fprintf(out,
         "%s:%d:failure:\n"
         "            expected: `%s' %s `%s'\n"
         "              actual: ",
         file, line, op_l, op, op_r);
-    type_info->dump(g_test_ctx.out, addr1);
-    cutest_porting_fprintf(g_test_ctx.out, " vs ");
-    type_info->dump(g_test_ctx.out, addr2);
-    cutest_porting_fprintf(g_test_ctx.out, "\n");
+    type_info->dump(out, addr1);
+    cutest_porting_fprintf(out, " vs ");
+    type_info->dump(out, addr2);
+    cutest_porting_fprintf(out, "\n");
 }
 
 void cutest_internal_printf(const char* fmt, ...)
 {
     va_list ap;
     va_start(ap, fmt);
-    cutest_porting_vfprintf(g_test_ctx.out, fmt, ap);
-    cutest_porting_fprintf(g_test_ctx.out, "\n");
+    cutest_porting_vfprintf(_cutest_out(), fmt, ap);
+    cutest_porting_fprintf(_cutest_out(), "\n");
     va_end(ap);
 }
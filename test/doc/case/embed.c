@@ -0,0 +1,28 @@
+#include <string.h>
+#include "test.h"
+
+/* Built only if the compiler has C23 `#embed`. */
+TEST_EMBED_DECLARE(cutest_h_embed_c23);
+TEST_EMBED_DECLARE(cutest_c_embed_c23);
+
+TEST(embed, cutest_h)
+{
+    size_t size, expect_size;
+    const char* data = cutest_embed_data(&cutest_h_embed_c23, &size);
+    const char* expect = cutest_embed_data(&cutest_h_embed, &expect_size);
+
+    ASSERT_EQ_SIZE(size, expect_size);
+    ASSERT_EQ_INT(memcmp(data, expect, size), 0);
+    ASSERT_EQ_CHAR(data[size], '\0');
+}
+
+TEST(embed, cutest_c_compressed)
+{
+    size_t size, expect_size;
+    const char* data = cutest_embed_data(&cutest_c_embed_c23, &size);
+    const char* expect = cutest_embed_data(&cutest_c_embed, &expect_size);
+
+    ASSERT_EQ_SIZE(size, expect_size);
+    ASSERT_EQ_INT(memcmp(data, expect, size), 0);
+    ASSERT_EQ_CHAR(data[size], '\0');
+}
@@ -7,27 +7,30 @@ static const char* s_warning =
 
 TEST(encoding, cutest_h)
 {
-    size_t i;
-    for (i = 0; i < cutest_h_hex_sz; i++)
+    size_t i, size;
+    const char* data = cutest_embed_data(&cutest_h_embed, &size);
+    for (i = 0; i < size; i++)
     {
-        ASSERT_NE_CHAR(cutest_h_hex[i], '\r', "%s", s_warning);
+        ASSERT_NE_CHAR(data[i], '\r', "%s", s_warning);
     }
 }
 
 TEST(encoding, cutest_c)
 {
-    size_t i;
-    for (i = 0; i < cutest_c_hex_sz; i++)
+    size_t i, size;
+    const char* data = cutest_embed_data(&cutest_c_embed, &size);
+    for (i = 0; i < size; i++)
     {
-        ASSERT_NE_CHAR(cutest_c_hex[i], '\r', "%s", s_warning);
+        ASSERT_NE_CHAR(data[i], '\r', "%s", s_warning);
     }
 }
 
 TEST(encoding, README_md)
 {
-    size_t i;
-    for (i = 0; i < readme_md_hex_sz; i++)
+    size_t i, size;
+    const char* data = cutest_embed_data(&readme_md_embed, &size);
+    for (i = 0; i < size; i++)
     {
-        ASSERT_NE_CHAR(readme_md_hex[i], '\r', "%s", s_warning);
+        ASSERT_NE_CHAR(data[i], '\r', "%s", s_warning);
     }
 }
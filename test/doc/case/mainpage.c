@@ -26,7 +26,7 @@ static const char* _find_mainpage(size_t* size)
     const char* pattern =
         "/**\n"
         " * @mainpage CUnitTest\n";
-    const char* start = strstr((const char*)cutest_h_hex, pattern);
+    const char* start = strstr(cutest_embed_data(&cutest_h_embed, NULL), pattern);
     ASSERT_NE_PTR(start, NULL, "start pattern not found");
 
     start += strlen(pattern);
@@ -51,7 +51,7 @@ static void _find_main_page_in_header(void)
 
 static void _generate_main_page_in_readmd(void)
 {
-    char* tmp = foreach_line_add((const char*)readme_md_hex, " * ", NULL);
+    char* tmp = foreach_line_add(cutest_embed_data(&readme_md_embed, NULL), " * ", NULL);
     g_doc_ctx.md_main_page = foreach_line_remove_trailing_space(tmp);
     free(tmp);
 }
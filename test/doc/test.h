@@ -9,14 +9,9 @@
 extern "C" {
 #endif
 
-extern const uint8_t cutest_h_hex[];
-extern const size_t cutest_h_hex_sz;
-
-extern const uint8_t cutest_c_hex[];
-extern const size_t cutest_c_hex_sz;
-
-extern const uint8_t readme_md_hex[];
-extern const size_t readme_md_hex_sz;
+TEST_EMBED_DECLARE(cutest_h_embed);
+TEST_EMBED_DECLARE(cutest_c_embed);
+TEST_EMBED_DECLARE(readme_md_embed);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,62 @@
+#include "test.h"
+
+static volatile unsigned long s_perf_sink;
+
+static void _perf_spin(unsigned long n)
+{
+    unsigned long i;
+    for (i = 0; i < n; i++)
+    {
+        s_perf_sink++;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(assertion_performance, faster_than)
+{
+    ASSERT_FASTER_THAN(_perf_spin(1), 1000 * 1000);
+}
+
+TEST(assertion_performance, faster_than_ref)
+{
+    ASSERT_FASTER_THAN_REF(_perf_spin(1), _perf_spin(10000), 1.0);
+}
+
+TEST(assertion_performance, throughput)
+{
+    ASSERT_THROUGHPUT_AT_LEAST(_perf_spin(1), 1000);
+}
+
+TEST(assertion_performance, failure)
+{
+    ASSERT_FASTER_THAN(_perf_spin(10000), 0.001, "%f ns", _L);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(assertion_performance, 0)
+{
+    /* Only `assertion_performance.failure` fails. */
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+
+    int found = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strcmp(line, "            expected: `_perf_spin(10000)' takes at most 0.00 ns") == 0)
+        {
+            found = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found);
+}
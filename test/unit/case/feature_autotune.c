@@ -0,0 +1,62 @@
+#include "test.h"
+
+static volatile unsigned long s_autotune_sink;
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_FIXTURE_SETUP(autotune)
+{
+}
+
+TEST_FIXTURE_TEARDOWN(autotune)
+{
+}
+
+TEST_PARAMETERIZED_DEFINE(autotune, spin, unsigned long, 4000, 1, 2000, 8000);
+
+TEST_P(autotune, spin)
+{
+    TEST_BENCHMARK_LOOP
+    {
+        unsigned long i;
+        for (i = 0; i < TEST_GET_PARAM(); i++)
+        {
+            s_autotune_sink++;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(autotune, spin, "--test_autotune_output=feature_autotune.txt", "--test_benchmark_min_time=1")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found_best = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strncmp(line, "[ AUTOTUNE ] autotune.spin/1 best 1 ", 36) == 0)
+        {
+            found_best = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+    TEST_PORTING_ASSERT(found_best);
+
+    FILE* file = fopen("feature_autotune.txt", "r");
+    TEST_PORTING_ASSERT(file != NULL);
+    matrix = string_matrix_create_from_file(file, "\n");
+    fclose(file);
+
+    ASSERT_STRING_EQ(string_matrix_access(matrix, 0, 0), "autotune.spin.index=1");
+    ASSERT_STRING_EQ(string_matrix_access(matrix, 1, 0), "autotune.spin.value=1");
+    string_matrix_destroy(matrix);
+}
@@ -0,0 +1,65 @@
+#include "test.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+static void _backtrace_check_positive(int v)
+{
+    ASSERT_GT_INT(v, 0);
+}
+
+TEST(backtrace, 0)
+{
+    _backtrace_check_positive(1);
+    _backtrace_check_positive(-1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+static void _backtrace_count_lines(int* frame, int* build_id)
+{
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strncmp(line, "[ TRACE    ] #", 14) == 0)
+        {
+            *frame += 1;
+        }
+        else if (strncmp(line, "[ TRACE    ] ", 13) == 0 && strstr(line, " build-id ") != NULL)
+        {
+            *build_id += 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+}
+
+DEFINE_TEST(backtrace, 0, "--test_backtrace")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+
+#if defined(__linux__) && defined(__GLIBC__)
+    int frame = 0, build_id = 0;
+    _backtrace_count_lines(&frame, &build_id);
+    TEST_PORTING_ASSERT(frame > 0);
+
+    /* The helper, the test body and its proxy. Runner frames are dropped. */
+    TEST_PORTING_ASSERT(frame <= 3);
+#endif
+}
+
+DEFINE_TEST(backtrace, 1)
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+
+    /* Not captured unless asked. */
+    int frame = 0, build_id = 0;
+    _backtrace_count_lines(&frame, &build_id);
+    TEST_PORTING_ASSERT(frame == 0);
+    TEST_PORTING_ASSERT(build_id == 0);
+}
@@ -0,0 +1,51 @@
+#include "test.h"
+
+static unsigned char s_cold_data[64 * 1024];
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(benchmark_cold, scan)
+{
+    volatile unsigned long sum = 0;
+    TEST_BENCHMARK_LOOP
+    {
+        size_t i;
+        for (i = 0; i < sizeof(s_cold_data); i += 64)
+        {
+            sum += s_cold_data[i];
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(benchmark_cold, scan, "--test_benchmark_cold_tlb", "--test_benchmark_min_time=1")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found_param = 0, found_bench = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strcmp(line, "[ $PARAME. ] --test_benchmark_cold_tlb") == 0)
+        {
+            found_param = 1;
+        }
+        if (strncmp(line, "[ BENCH    ] benchmark_cold.scan ", 33) == 0)
+        {
+            TEST_PORTING_ASSERT(strstr(line, "), cold ") != NULL);
+            found_bench = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_param);
+    TEST_PORTING_ASSERT(found_bench);
+}
@@ -0,0 +1,107 @@
+#include "test.h"
+
+/**
+ * Benchmarks below are timed by this clock, which only moves by the cost each
+ * iteration claims, so the fit is checked without noise of machine load.
+ */
+static cutest_porting_timespec_t s_now = { 0, 0 };
+
+///////////////////////////////////////////////////////////////////////////////
+// Porting
+///////////////////////////////////////////////////////////////////////////////
+
+void cutest_porting_clock_gettime(cutest_porting_timespec_t* tp)
+{
+    *tp = s_now;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+static void _benchmark_cost(unsigned long ns)
+{
+    s_now.tv_nsec += (long)ns;
+    while (s_now.tv_nsec >= 1000000000)
+    {
+        s_now.tv_nsec -= 1000000000;
+        s_now.tv_sec++;
+    }
+}
+
+/**
+ * @brief O(N^2), except that the largest instance is disturbed to be 50%
+ *   slower. An absolute least squares fit takes it for O(N^3).
+ */
+static void _benchmark_quadratic(unsigned long n)
+{
+    unsigned long cost = n * n / 16;
+    if (n == 256)
+    {
+        cost = cost * 3 / 2;
+    }
+
+    TEST_BENCHMARK_LOOP
+    {
+        _benchmark_cost(cost);
+    }
+}
+
+TEST_FIXTURE_SETUP(benchmark_complexity) {}
+TEST_FIXTURE_TEARDOWN(benchmark_complexity) {}
+
+TEST_PARAMETERIZED_DEFINE(benchmark_complexity, expect_n2, unsigned long, 32, 64, 128, 256);
+TEST_P(benchmark_complexity, expect_n2)
+{
+    cutest_benchmark_set_complexity_n(TEST_GET_PARAM());
+    cutest_benchmark_expect_complexity(CUTEST_COMPLEXITY_N2);
+    _benchmark_quadratic(TEST_GET_PARAM());
+}
+
+TEST_PARAMETERIZED_DEFINE(benchmark_complexity, expect_n, unsigned long, 32, 64, 128, 256);
+TEST_P(benchmark_complexity, expect_n)
+{
+    cutest_benchmark_set_complexity_n(TEST_GET_PARAM());
+    cutest_benchmark_expect_complexity(CUTEST_COMPLEXITY_N);
+    _benchmark_quadratic(TEST_GET_PARAM());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+static int _find_big_o(const char* expect)
+{
+    int found = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strncmp(line, expect, strlen(expect)) == 0)
+        {
+            found = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    return found;
+}
+
+DEFINE_TEST(benchmark_complexity, expect_n2, "--test_filter=benchmark_complexity.expect_n2/*")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+    TEST_PORTING_ASSERT(_find_big_o("[ BIG-O    ] benchmark_complexity.expect_n2 O(N^2), "));
+}
+
+DEFINE_TEST(benchmark_complexity, expect_n, "--test_filter=benchmark_complexity.expect_n/*")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+    TEST_PORTING_ASSERT(_find_big_o("[ BIG-O    ] benchmark_complexity.expect_n O(N^2), "));
+}
+
+DEFINE_TEST(benchmark_complexity, invalid_min_time, "--test_benchmark_min_time=0")
+{
+    TEST_PORTING_ASSERT(_TEST.rret != 0);
+}
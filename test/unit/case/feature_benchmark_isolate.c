@@ -0,0 +1,58 @@
+#include "test.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+static int s_isolate_counter = 0;
+
+TEST(benchmark_isolate, bench)
+{
+    volatile unsigned long sum = 0;
+    TEST_BENCHMARK_LOOP
+    {
+        sum++;
+    }
+    s_isolate_counter++;
+}
+
+TEST(benchmark_isolate, crash)
+{
+    abort();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(benchmark_isolate, bench, "--test_benchmark_isolate",
+    "--test_benchmark_min_time=1", "--test_benchmark_repetitions=3")
+{
+    /* One failure from crashed test. */
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+
+    /* Test body run in child process. */
+    TEST_PORTING_ASSERT(s_isolate_counter == 0);
+
+    int found_bench = 0, found_crash = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strncmp(line, "[ BENCH    ] benchmark_isolate.bench ", 37) == 0)
+        {
+            TEST_PORTING_ASSERT(strstr(line, "spread") != NULL);
+            found_bench = 1;
+        }
+        if (strcmp(line, "benchmark_isolate.crash: child process terminated abnormally.") == 0)
+        {
+            found_crash = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_bench);
+    TEST_PORTING_ASSERT(found_crash);
+}
@@ -0,0 +1,52 @@
+#include "test.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+static unsigned long s_parallel_counters[4 * 16];
+
+static void _benchmark_parallel(void* arg, unsigned idx, unsigned long iterations)
+{
+    volatile unsigned long* counters = arg;
+    TEST_PORTING_ASSERT(idx < 4);
+
+    unsigned long i;
+    for (i = 0; i < iterations; i++)
+    {
+        counters[idx * 16]++;
+    }
+}
+
+TEST(benchmark, parallel)
+{
+    cutest_benchmark_parallel(_benchmark_parallel, s_parallel_counters, 4);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(benchmark, parallel, "--test_benchmark_min_time=1")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    unsigned i;
+    for (i = 0; i < 4; i++)
+    {
+        TEST_PORTING_ASSERT(s_parallel_counters[i * 16] != 0);
+    }
+
+    /* Table header, and one line for each of 1, 2, 4 threads. */
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+    size_t pos = 0;
+    while (pos < matrix->line_sz && strstr(string_matrix_access(matrix, pos, 0), "[ SCALING  ] threads") == NULL)
+    {
+        pos++;
+    }
+    TEST_PORTING_ASSERT(pos + 3 < matrix->line_sz);
+    TEST_PORTING_ASSERT(strncmp(string_matrix_access(matrix, pos + 1, 0), "[ SCALING  ]       1 ", 21) == 0);
+    TEST_PORTING_ASSERT(strncmp(string_matrix_access(matrix, pos + 2, 0), "[ SCALING  ]       2 ", 21) == 0);
+    TEST_PORTING_ASSERT(strncmp(string_matrix_access(matrix, pos + 3, 0), "[ SCALING  ]       4 ", 21) == 0);
+    string_matrix_destroy(matrix);
+}
@@ -0,0 +1,54 @@
+#include "test.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(counter, set)
+{
+    cutest_counter_set("items", 1500, CUTEST_COUNTER_DEFAULT);
+    cutest_counter_set("bytes", 1, CUTEST_COUNTER_DEFAULT);
+
+    /* Overwrite. */
+    cutest_counter_set("bytes", 2000000, CUTEST_COUNTER_DEFAULT);
+}
+
+TEST(counter, avg_iterations)
+{
+    volatile unsigned long sum = 0;
+    unsigned long cnt = 0;
+    TEST_BENCHMARK_LOOP
+    {
+        sum++;
+        cnt += 3;
+    }
+    cutest_counter_set("avg", (double)cnt, CUTEST_COUNTER_AVG_ITERATIONS);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(counter, set, "--test_benchmark_min_time=1")
+{
+    int found_set = 0, found_avg = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strcmp(line, "[ COUNTER  ] counter.set items=1.5k bytes=2M") == 0)
+        {
+            found_set = 1;
+        }
+        if (strcmp(line, "[ COUNTER  ] counter.avg_iterations avg=3") == 0)
+        {
+            found_avg = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_set);
+    TEST_PORTING_ASSERT(found_avg);
+}
@@ -0,0 +1,57 @@
+#include "test.h"
+
+#define DAEMON_PATH         "feature_daemon.not_a_socket"
+#define DAEMON_CONTENT      "not a socket\n"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(daemon, 0)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST_SETUP(daemon)
+{
+    FILE* file = fopen(DAEMON_PATH, "wb");
+    TEST_PORTING_ASSERT(file != NULL);
+    fputs(DAEMON_CONTENT, file);
+    fclose(file);
+}
+
+DEFINE_TEST_TEARDOWN(daemon)
+{
+    remove(DAEMON_PATH);
+}
+
+/* A file that is not a socket must be kept, and the daemon not started. */
+DEFINE_TEST_F(daemon, not_a_socket, "--test_daemon=" DAEMON_PATH)
+{
+    TEST_PORTING_ASSERT(_TEST.rret != 0);
+
+    int found_warning = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strstr(line, "Can not listen on `" DAEMON_PATH "'") != NULL)
+        {
+            found_warning = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+    TEST_PORTING_ASSERT(found_warning);
+
+    char buf[64] = { 0 };
+    FILE* file = fopen(DAEMON_PATH, "rb");
+    TEST_PORTING_ASSERT(file != NULL);
+    TEST_PORTING_ASSERT(fread(buf, 1, sizeof(buf) - 1, file) > 0);
+    fclose(file);
+    TEST_PORTING_ASSERT(strcmp(buf, DAEMON_CONTENT) == 0);
+}
@@ -0,0 +1,197 @@
+#include "test.h"
+
+typedef struct test_pipeline_ctx
+{
+    volatile unsigned   setup_cnt;
+    unsigned            teardown_cnt;
+    int                 slots[3];
+    int                 teardown_data[3];
+    int                 body_ok[3];
+    char                hook_log[64];
+    size_t              hook_log_sz;
+    unsigned            fail_teardown_cnt;
+} test_pipeline_ctx_t;
+
+static test_pipeline_ctx_t s_pipeline;
+
+static void _pipeline_body(int idx)
+{
+    int* data = cutest_fixture_get_data();
+    s_pipeline.body_ok[idx] = data == &s_pipeline.slots[idx] && *data == idx + 1;
+
+    /* Setup of next test runs on helper thread while we are here. */
+    unsigned long spin;
+    for (spin = 0; idx < 2 && spin < 1000000000UL && s_pipeline.setup_cnt < (unsigned)idx + 2; spin++)
+    {
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_FIXTURE_THREAD_SAFE(pipeline);
+
+TEST_FIXTURE_SETUP(pipeline)
+{
+    unsigned idx = s_pipeline.setup_cnt;
+    s_pipeline.slots[idx] = (int)idx + 1;
+    cutest_fixture_set_data(&s_pipeline.slots[idx]);
+    s_pipeline.setup_cnt = idx + 1;
+}
+
+TEST_FIXTURE_TEARDOWN(pipeline)
+{
+    int* data = cutest_fixture_get_data();
+    s_pipeline.teardown_data[s_pipeline.teardown_cnt++] = *data;
+}
+
+TEST_F(pipeline, a)
+{
+    _pipeline_body(0);
+}
+
+TEST_F(pipeline, b)
+{
+    _pipeline_body(1);
+}
+
+TEST_F(pipeline, c)
+{
+    _pipeline_body(2);
+}
+
+TEST_FIXTURE_THREAD_SAFE(pipeline_fail);
+
+TEST_FIXTURE_SETUP(pipeline_fail)
+{
+}
+
+TEST_FIXTURE_TEARDOWN(pipeline_fail)
+{
+    /* Only the first one fails, while `pipeline_fail.y` is running. */
+    ASSERT_NE_UINT(s_pipeline.fail_teardown_cnt++, 0);
+}
+
+TEST_F(pipeline_fail, x)
+{
+}
+
+TEST_F(pipeline_fail, y)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+static void _pipeline_log(const char* fixture, char c)
+{
+    if (strcmp(fixture, "pipeline") == 0 && s_pipeline.hook_log_sz < sizeof(s_pipeline.hook_log) - 1)
+    {
+        s_pipeline.hook_log[s_pipeline.hook_log_sz++] = c;
+    }
+}
+
+static void _on_before_setup(const char* fixture)
+{
+    _pipeline_log(fixture, 'S');
+}
+
+static void _on_after_setup(const char* fixture, int ret)
+{
+    (void)ret;
+    _pipeline_log(fixture, 's');
+}
+
+static void _on_before_test(const char* fixture, const char* test_name)
+{
+    (void)test_name;
+    _pipeline_log(fixture, 'T');
+}
+
+static void _on_after_test(const char* fixture, const char* test_name, int ret)
+{
+    (void)test_name; (void)ret;
+    _pipeline_log(fixture, 't');
+}
+
+static void _on_before_teardown(const char* fixture)
+{
+    _pipeline_log(fixture, 'D');
+}
+
+static void _on_after_teardown(const char* fixture, int ret)
+{
+    (void)ret;
+    _pipeline_log(fixture, 'd');
+}
+
+DEFINE_TEST_SETUP(pipeline)
+{
+    _TEST.hook.before_setup = _on_before_setup;
+    _TEST.hook.after_setup = _on_after_setup;
+    _TEST.hook.before_test = _on_before_test;
+    _TEST.hook.after_test = _on_after_test;
+    _TEST.hook.before_teardown = _on_before_teardown;
+    _TEST.hook.after_teardown = _on_after_teardown;
+
+    memset(&s_pipeline, 0, sizeof(s_pipeline));
+}
+
+DEFINE_TEST_TEARDOWN(pipeline)
+{
+}
+
+DEFINE_TEST_F(pipeline, overlap)
+{
+    /* Only the teardown of `pipeline_fail.x` fails. */
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+
+    TEST_PORTING_ASSERT(s_pipeline.setup_cnt == 3);
+    TEST_PORTING_ASSERT(s_pipeline.teardown_cnt == 3);
+    TEST_PORTING_ASSERT(s_pipeline.body_ok[0] && s_pipeline.body_ok[1] && s_pipeline.body_ok[2]);
+    TEST_PORTING_ASSERT(s_pipeline.teardown_data[0] == 1);
+    TEST_PORTING_ASSERT(s_pipeline.teardown_data[1] == 2);
+    TEST_PORTING_ASSERT(s_pipeline.teardown_data[2] == 3);
+
+    /* `after_teardown` is called when the teardown is collected. */
+    ASSERT_STRING_EQ(s_pipeline.hook_log, "SsTtD" "SsTtdD" "SsTtdD" "d");
+
+    /* One result for each case, right after its own `[ RUN      ]` line. */
+    static const char* s_expect[] = {
+        "[ RUN      ] pipeline.a",
+        "[       OK ] pipeline.a",
+        "[ RUN      ] pipeline.b",
+        "[       OK ] pipeline.b",
+        "[ RUN      ] pipeline.c",
+        "[       OK ] pipeline.c",
+        "[ RUN      ] pipeline_fail.x",
+        "failure",
+        "[  FAILED  ] pipeline_fail.x",
+        "[ RUN      ] pipeline_fail.y",
+        "[       OK ] pipeline_fail.y",
+        "[  PASSED  ] 4 tests.",
+        "[  FAILED  ] 1 test, listed below:",
+    };
+    size_t expect_idx = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz && expect_idx < sizeof(s_expect) / sizeof(s_expect[0]); i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strstr(line, s_expect[expect_idx]) != NULL)
+        {
+            expect_idx++;
+        }
+        else
+        {
+            /* No other result or start of these cases in between. */
+            TEST_PORTING_ASSERT(line[0] != '[' || strstr(line, "] pipeline") == NULL);
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(expect_idx == sizeof(s_expect) / sizeof(s_expect[0]));
+}
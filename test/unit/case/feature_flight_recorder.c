@@ -0,0 +1,125 @@
+#include "test.h"
+
+#define FLIGHT_RECORDER_PATH    "feature_flight_recorder.flight"
+
+/**
+ * @brief Read recorder as `cutest_top --flight` does.
+ */
+static int _flight_read_recorder(cutest_flight_recorder_t* recorder)
+{
+    FILE* file = fopen(FLIGHT_RECORDER_PATH, "rb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    size_t n = fread(recorder, sizeof(*recorder), 1, file);
+    fclose(file);
+    return n == 1 ? 0 : -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+static int s_failure_line;
+
+TEST(flight, failure)
+{
+    s_failure_line = __LINE__ + 1;
+    ASSERT_EQ_INT(0, 1);
+}
+
+TEST(flight, running)
+{
+#if defined(__linux__)
+    static cutest_flight_recorder_t recorder;
+    ASSERT_EQ_INT(_flight_read_recorder(&recorder), 0);
+
+    /* Latest events are case begin and body of us. */
+    const cutest_flight_event_t* event = &recorder.events[(recorder.head - 2) % CUTEST_FLIGHT_EVENTS];
+    ASSERT_EQ_ULONG(event->type, (unsigned long)CUTEST_FLIGHT_CASE_BEGIN);
+    ASSERT_EQ_STR(event->name, "flight.running");
+    event = &recorder.events[(recorder.head - 1) % CUTEST_FLIGHT_EVENTS];
+    ASSERT_EQ_ULONG(event->type, (unsigned long)CUTEST_FLIGHT_BODY);
+#endif
+}
+
+static void _flight_parallel_assert(void* arg, unsigned idx, unsigned long iterations)
+{
+    (void)arg; (void)idx;
+
+    unsigned long i;
+    for (i = 0; i < iterations; i++)
+    {
+        ASSERT_NE_ULONG(i, iterations);
+    }
+}
+
+TEST(flight_parallel, assert)
+{
+    cutest_benchmark_parallel(_flight_parallel_assert, NULL, 4);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(flight, 0, "--test_flight_recorder=" FLIGHT_RECORDER_PATH, "--test_filter=flight.*")
+{
+    /* Only `flight.failure` fails. */
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+
+#if defined(__linux__)
+    static cutest_flight_recorder_t recorder;
+    TEST_PORTING_ASSERT(_flight_read_recorder(&recorder) == 0);
+    remove(FLIGHT_RECORDER_PATH);
+
+    TEST_PORTING_ASSERT(recorder.magic == CUTEST_FLIGHT_MAGIC);
+    TEST_PORTING_ASSERT(recorder.version == CUTEST_FLIGHT_VERSION);
+    TEST_PORTING_ASSERT(recorder.head > 0 && recorder.head < CUTEST_FLIGHT_EVENTS);
+
+    /* Last event is the end of run with one failure. */
+    const cutest_flight_event_t* event = &recorder.events[recorder.head - 1];
+    TEST_PORTING_ASSERT(event->type == CUTEST_FLIGHT_RUN_END);
+    TEST_PORTING_ASSERT(event->data == 1);
+
+    int found_failure = 0, found_case = 0;
+    long i;
+    for (i = 0; i < recorder.head; i++)
+    {
+        event = &recorder.events[i];
+        TEST_PORTING_ASSERT(event->seq == (unsigned long)i + 1);
+
+        if (event->type == CUTEST_FLIGHT_FAILURE)
+        {
+            TEST_PORTING_ASSERT(strstr(event->name, "feature_flight_recorder.c") != NULL);
+            TEST_PORTING_ASSERT(event->data == (unsigned long)s_failure_line);
+            found_failure++;
+        }
+        else if (event->type == CUTEST_FLIGHT_CASE_END)
+        {
+            TEST_PORTING_ASSERT(event->data == (strcmp(event->name, "flight.failure") == 0 ? 1UL : 0UL));
+            found_case++;
+        }
+    }
+    TEST_PORTING_ASSERT(found_failure == 1);
+    TEST_PORTING_ASSERT(found_case == 2);
+#endif
+}
+
+DEFINE_TEST(flight, 1, "--test_flight_recorder=" FLIGHT_RECORDER_PATH,
+    "--test_filter=flight_parallel.*", "--test_benchmark_min_time=1")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+#if defined(__linux__)
+    static cutest_flight_recorder_t recorder;
+    TEST_PORTING_ASSERT(_flight_read_recorder(&recorder) == 0);
+    remove(FLIGHT_RECORDER_PATH);
+
+    /* Threads asserting at the same time leave no write half done. */
+    TEST_PORTING_ASSERT((recorder.last_assert.seq & 1) == 0);
+    TEST_PORTING_ASSERT(strstr(recorder.last_assert.file, "feature_flight_recorder.c") != NULL);
+#endif
+}
@@ -0,0 +1,112 @@
+#define CUTEST_GUARD_MALLOC_OVERRIDE
+#include "test.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(guard_malloc, normal)
+{
+    char* p = malloc(16);
+    ASSERT_NE_PTR(p, NULL);
+    memset(p, 1, 16);
+
+    p = realloc(p, 32);
+    ASSERT_NE_PTR(p, NULL);
+    ASSERT_EQ_INT(p[15], 1);
+
+    int* q = calloc(4, sizeof(int));
+    ASSERT_NE_PTR(q, NULL);
+    ASSERT_EQ_INT(q[3], 0);
+
+    free(q);
+    free(p);
+}
+
+TEST(guard_malloc, overflow)
+{
+    volatile char* p = malloc(16);
+    p[16] = 1;
+}
+
+TEST(guard_malloc, use_after_free)
+{
+    volatile char* p = malloc(8);
+    free((void*)p);
+    ASSERT_EQ_INT(p[0], 0);
+}
+
+TEST(guard_malloc, double_free)
+{
+    void* p = malloc(8);
+    free(p);
+    free(p);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(guard_malloc, 0, "--test_guard_malloc=1")
+{
+    if (_TEST.rret == 0)
+    {
+        /* Not supported on this platform. */
+        return;
+    }
+    TEST_PORTING_ASSERT(_TEST.rret == 3);
+
+    int found_overflow = 0, found_uaf = 0, found_double_free = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strstr(line, "heap-buffer-overflow: ") != NULL && strstr(line, " is 0 bytes after 16-byte region ") != NULL)
+        {
+            found_overflow = 1;
+        }
+        if (strstr(line, "heap-use-after-free: ") != NULL && strstr(line, " is 0 bytes inside of 8-byte region ") != NULL)
+        {
+            found_uaf = 1;
+        }
+        if (strstr(line, "attempting double-free: ") != NULL)
+        {
+            found_double_free = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_overflow);
+    TEST_PORTING_ASSERT(found_uaf);
+    TEST_PORTING_ASSERT(found_double_free);
+}
+
+/* Without a value the flag must not swallow the next argument. */
+DEFINE_TEST(guard_malloc, 1, "--test_guard_malloc", "--test_filter=guard_malloc.normal")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found_rate = 0, found_passed = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strcmp(line, "[ $PARAME. ] --test_guard_malloc=100") == 0
+            || strstr(line, "Guard malloc is not available") != NULL)
+        {
+            found_rate = 1;
+        }
+        if (strcmp(line, "[  PASSED  ] 1 test.") == 0)
+        {
+            found_passed = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_rate);
+    TEST_PORTING_ASSERT(found_passed);
+}
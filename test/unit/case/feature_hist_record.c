@@ -0,0 +1,58 @@
+#include "test.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(hist, record)
+{
+    unsigned long i;
+    for (i = 1; i <= 1000; i++)
+    {
+        cutest_hist_record(i);
+    }
+}
+
+TEST(hist, empty)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+static int _hist_near(unsigned long actual, unsigned long expect)
+{
+    /* Relative error is less than 1/32. */
+    return actual >= expect && actual <= expect + expect / 32;
+}
+
+DEFINE_TEST(hist, record)
+{
+    unsigned long p50, p90, p99, p999, max, count;
+    int found = 0;
+
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        TEST_PORTING_ASSERT(strstr(line, "hist.empty p50") == NULL);
+
+        if (sscanf(line, "[ HIST     ] hist.record p50=%lu p90=%lu p99=%lu p99.9=%lu max=%lu (%lu samples)",
+            &p50, &p90, &p99, &p999, &max, &count) == 6)
+        {
+            found = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found);
+    TEST_PORTING_ASSERT(count == 1000);
+    TEST_PORTING_ASSERT(max == 1000);
+    TEST_PORTING_ASSERT(_hist_near(p50, 500));
+    TEST_PORTING_ASSERT(_hist_near(p90, 900));
+    TEST_PORTING_ASSERT(_hist_near(p99, 990));
+    TEST_PORTING_ASSERT(_hist_near(p999, 999));
+}
@@ -0,0 +1,111 @@
+#include "test.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(load, same_name)
+{
+}
+
+TEST_FIXTURE_SETUP(load_complexity) {}
+TEST_FIXTURE_TEARDOWN(load_complexity) {}
+
+TEST_PARAMETERIZED_DEFINE(load_complexity, fit, unsigned long, 1, 2);
+TEST_P(load_complexity, fit)
+{
+    cutest_benchmark_set_complexity_n(TEST_GET_PARAM());
+    TEST_BENCHMARK_LOOP
+    {
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(load, 0, "--test_load=" LOAD_MODULE_PATH)
+{
+    /* Cases of same name in host and module both run. */
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found_host = 0, found_module = 0, found_only = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strstr(line, "[       OK ] load.same_name") != NULL)
+        {
+            found_host = 1;
+        }
+        if (strstr(line, "[       OK ] feature_load_module.load.same_name") != NULL)
+        {
+            found_module = 1;
+        }
+        if (strstr(line, "[       OK ] feature_load_module.load.module_only") != NULL)
+        {
+            found_only = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_host);
+    TEST_PORTING_ASSERT(found_module);
+    TEST_PORTING_ASSERT(found_only);
+}
+
+DEFINE_TEST(load, 1, "--test_load=" LOAD_MODULE_PATH, "--test_list_tests")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found_host = 0, found_module = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strcmp(line, "load.") == 0)
+        {
+            found_host = 1;
+        }
+        if (strcmp(line, "feature_load_module.load.") == 0)
+        {
+            found_module = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_host);
+    TEST_PORTING_ASSERT(found_module);
+}
+
+DEFINE_TEST(load, 2, "--test_load=" LOAD_MODULE_PATH, "--test_filter=*load_complexity.*",
+    "--test_benchmark_min_time=1")
+{
+    /* A family of the same name in host and module is fitted separately. */
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found_host = 0, found_module = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strstr(line, "[ BIG-O    ] load_complexity.fit O(") != NULL)
+        {
+            found_host++;
+        }
+        if (strstr(line, "[ BIG-O    ] feature_load_module.load_complexity.fit O(") != NULL)
+        {
+            found_module++;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_host == 1);
+    TEST_PORTING_ASSERT(found_module == 1);
+}
@@ -0,0 +1,23 @@
+#include "cutest.h"
+
+/* Same fixture and case name as the one built in the host. */
+TEST(load, same_name)
+{
+}
+
+TEST(load, module_only)
+{
+}
+
+/* Same family as the one built in the host, fitted on its own. */
+TEST_FIXTURE_SETUP(load_complexity) {}
+TEST_FIXTURE_TEARDOWN(load_complexity) {}
+
+TEST_PARAMETERIZED_DEFINE(load_complexity, fit, unsigned long, 1, 2);
+TEST_P(load_complexity, fit)
+{
+    cutest_benchmark_set_complexity_n(TEST_GET_PARAM());
+    TEST_BENCHMARK_LOOP
+    {
+    }
+}
@@ -0,0 +1,64 @@
+#include "test.h"
+
+#define MONITOR_BOARD_PATH  "feature_monitor.board"
+
+/**
+ * @brief Writes to a shared mapping are visible to read(), no need to map it.
+ */
+static int _monitor_read_board(cutest_monitor_board_t* board)
+{
+    FILE* file = fopen(MONITOR_BOARD_PATH, "rb");
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    size_t n = fread(board, sizeof(*board), 1, file);
+    fclose(file);
+    return n == 1 ? 0 : -1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(monitor, failure)
+{
+    ASSERT_EQ_INT(0, 1);
+}
+
+TEST(monitor, running)
+{
+#if defined(__linux__)
+    static cutest_monitor_board_t board;
+    ASSERT_EQ_INT(_monitor_read_board(&board), 0);
+    ASSERT_EQ_STR(board.workers[0].name, "monitor.running");
+    ASSERT_EQ_ULONG(board.failed, 1);
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(monitor, 0, "--test_monitor=" MONITOR_BOARD_PATH)
+{
+    /* Only `monitor.failure` fails. */
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+
+#if defined(__linux__)
+    static cutest_monitor_board_t board;
+    TEST_PORTING_ASSERT(_monitor_read_board(&board) == 0);
+    remove(MONITOR_BOARD_PATH);
+
+    TEST_PORTING_ASSERT(board.magic == CUTEST_MONITOR_MAGIC);
+    TEST_PORTING_ASSERT(board.finished == 1);
+    TEST_PORTING_ASSERT(board.total == 2);
+    TEST_PORTING_ASSERT(board.success == 1);
+    TEST_PORTING_ASSERT(board.failed == 1);
+    TEST_PORTING_ASSERT(board.failure_cnt == 1);
+    ASSERT_STRING_EQ(board.failures[0].name, "monitor.failure");
+    TEST_PORTING_ASSERT(board.workers[0].name[0] == '\0');
+    TEST_PORTING_ASSERT(board.slowest[1].name[0] != '\0');
+#endif
+}
@@ -0,0 +1,170 @@
+#include "test.h"
+
+#define PARAM_SAMPLE_COVER_HISTORY  "feature_param_sample.cover.history"
+#define PARAM_SAMPLE_FLAKY_HISTORY  "feature_param_sample.flaky.history"
+
+/**
+ * @brief Bit N is set if instance N ran.
+ */
+static unsigned s_param_sample_ran = 0;
+
+static unsigned _param_sample_count(unsigned bits)
+{
+    unsigned cnt = 0;
+    for (; bits != 0; bits &= bits - 1)
+    {
+        cnt++;
+    }
+    return cnt;
+}
+
+/**
+ * @brief Run again in the same process, as the next run of CI does.
+ */
+static int _param_sample_run(const char* filter, const char* sample, const char* history)
+{
+    char* argv[] = { _TEST.argv[0], (char*)filter, (char*)sample, (char*)history, NULL };
+    return cutest_run_tests(4, argv, _TEST.out, &_TEST.hook);
+}
+
+/**
+ * @brief Sample 3 of param_sample.cover with \p seed.
+ * @return Bits of instances that ran.
+ */
+static unsigned _param_sample_with_seed(const char* seed)
+{
+    s_param_sample_ran = 0;
+    TEST_PORTING_ASSERT(_param_sample_run("--test_filter=param_sample.cover/*", "--test_param_sample=3", seed) == 0);
+    return s_param_sample_ran;
+}
+
+/**
+ * @brief Whether \p bits is 3 successive instances of 10.
+ */
+static int _param_sample_contiguous(unsigned bits)
+{
+    unsigned i;
+    for (i = 0; i < 10; i++)
+    {
+        if (bits == (((7U << i) | (7U >> (10 - i))) & ((1U << 10) - 1)))
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_FIXTURE_SETUP(param_sample) {}
+TEST_FIXTURE_TEARDOWN(param_sample) {}
+
+TEST_PARAMETERIZED_DEFINE(param_sample, cover, int, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+TEST_P(param_sample, cover)
+{
+    s_param_sample_ran |= 1U << TEST_GET_PARAM();
+}
+
+TEST_PARAMETERIZED_DEFINE(param_sample, flaky, int, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+TEST_P(param_sample, flaky)
+{
+    s_param_sample_ran |= 1U << TEST_GET_PARAM();
+    ASSERT_NE_INT(TEST_GET_PARAM(), 7);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(param_sample, count, "--test_filter=param_sample.cover/*", "--test_param_sample=3")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+    TEST_PORTING_ASSERT(_param_sample_count(s_param_sample_ran) == 3);
+    s_param_sample_ran = 0;
+}
+
+DEFINE_TEST(param_sample, percent, "--test_filter=param_sample.cover/*", "--test_param_sample=50%",
+    "--test_param_sample_shard=1/2")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+    TEST_PORTING_ASSERT(_param_sample_count(s_param_sample_ran) == 5);
+    s_param_sample_ran = 0;
+}
+
+DEFINE_TEST(param_sample, coverage, "--test_filter=param_sample.cover/*", "--test_param_sample=3",
+    "--test_param_history=" PARAM_SAMPLE_COVER_HISTORY)
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    /* Any 4 successive runs of 3 instances cover all 10 instances. */
+    int i;
+    for (i = 1; i < 4; i++)
+    {
+        TEST_PORTING_ASSERT(_param_sample_run("--test_filter=param_sample.cover/*", "--test_param_sample=3",
+            "--test_param_history=" PARAM_SAMPLE_COVER_HISTORY) == 0);
+    }
+    TEST_PORTING_ASSERT(s_param_sample_ran == (1U << 10) - 1);
+
+    remove(PARAM_SAMPLE_COVER_HISTORY);
+    s_param_sample_ran = 0;
+}
+
+DEFINE_TEST(param_sample, seed, "--test_filter=param_sample.cover/*", "--test_param_sample=3",
+    "--test_random_seed=1")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+    unsigned first = s_param_sample_ran;
+
+    /* The same seed takes the same sample, which is not a contiguous window. */
+    TEST_PORTING_ASSERT(_param_sample_with_seed("--test_random_seed=1") == first);
+    TEST_PORTING_ASSERT(!_param_sample_contiguous(first));
+
+    /* Other seeds take other samples. */
+    int i, differ = 0;
+    char seed[32];
+    for (i = 2; i < 10; i++)
+    {
+        snprintf(seed, sizeof(seed), "--test_random_seed=%d", i);
+        unsigned bits = _param_sample_with_seed(seed);
+        TEST_PORTING_ASSERT(_param_sample_count(bits) == 3);
+        TEST_PORTING_ASSERT(!_param_sample_contiguous(bits));
+        differ += bits != first;
+    }
+    TEST_PORTING_ASSERT(differ != 0);
+    s_param_sample_ran = 0;
+}
+
+DEFINE_TEST(param_sample, recent, "--test_filter=param_sample.flaky/*", "--test_param_sample=1",
+    "--test_param_history=" PARAM_SAMPLE_FLAKY_HISTORY)
+{
+    /* Instance 7 is sampled within 10 runs. */
+    int i, ret = _TEST.rret;
+    for (i = 0; ret == 0 && i < 10; i++)
+    {
+        ret = _param_sample_run("--test_filter=param_sample.flaky/*", "--test_param_sample=1",
+            "--test_param_history=" PARAM_SAMPLE_FLAKY_HISTORY);
+    }
+    TEST_PORTING_ASSERT(ret == 1);
+
+    /* Then it is always sampled, along with the regular sample. */
+    s_param_sample_ran = 0;
+    TEST_PORTING_ASSERT(_param_sample_run("--test_filter=param_sample.flaky/*", "--test_param_sample=1",
+        "--test_param_history=" PARAM_SAMPLE_FLAKY_HISTORY) == 1);
+    TEST_PORTING_ASSERT(s_param_sample_ran & (1U << 7));
+    TEST_PORTING_ASSERT(_param_sample_count(s_param_sample_ran) == 2);
+
+    remove(PARAM_SAMPLE_FLAKY_HISTORY);
+    s_param_sample_ran = 0;
+}
+
+DEFINE_TEST(param_sample, invalid_percent, "--test_param_sample=101%")
+{
+    TEST_PORTING_ASSERT(_TEST.rret != 0);
+}
+
+DEFINE_TEST(param_sample, invalid_shard, "--test_param_sample=1", "--test_param_sample_shard=2/2")
+{
+    TEST_PORTING_ASSERT(_TEST.rret != 0);
+}
@@ -0,0 +1,87 @@
+#include "test.h"
+
+static unsigned s_repeat_counter = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(repeat_until_fail, flaky)
+{
+    /* With seed 0, the 8th iteration is the first with seed 55433. */
+    s_repeat_counter++;
+    ASSERT_NE_ULONG(cutest_random_seed() % 10, 3);
+}
+
+TEST(repeat_until_fail, stable)
+{
+    s_repeat_counter++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(repeat_until_fail, 0, "--test_filter=repeat_until_fail.flaky", "--test_random_seed=0",
+    "--test_repeat_until_fail=100", "--test_repeat_jobs=2")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 1);
+
+#if defined(__linux__)
+    /* Iterations run in child processes. */
+    TEST_PORTING_ASSERT(s_repeat_counter == 0);
+#endif
+
+    int found_failure = 0, found_seed = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strcmp(line, "[  FAILED  ] repeat_until_fail.flaky") == 0)
+        {
+            found_failure = 1;
+        }
+        if (strncmp(line, "[  FAILED  ] iteration 8 failed after ", 38) == 0)
+        {
+            TEST_PORTING_ASSERT(strstr(line, "reproduce with --test_random_seed=55433") != NULL);
+            found_seed = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_failure);
+    TEST_PORTING_ASSERT(found_seed);
+}
+
+DEFINE_TEST(repeat_until_fail, 1, "--test_filter=repeat_until_fail.stable",
+    "--test_repeat_until_fail=20", "--test_repeat_jobs=4")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found_passed = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        if (strcmp(string_matrix_access(matrix, i, 0), "[  PASSED  ] 20 iterations.") == 0)
+        {
+            found_passed = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_passed);
+}
+
+DEFINE_TEST(repeat_until_fail, invalid_count, "--test_repeat_until_fail=0")
+{
+    TEST_PORTING_ASSERT(_TEST.rret != 0);
+}
+
+DEFINE_TEST(repeat_until_fail, invalid_jobs, "--test_repeat_until_fail=1", "--test_repeat_jobs=0")
+{
+    TEST_PORTING_ASSERT(_TEST.rret != 0);
+}
@@ -0,0 +1,76 @@
+#include "test.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+static const cutest_resource_t* s_resource;
+
+TEST(resource, map)
+{
+    const cutest_resource_t* resource = cutest_resource_map(__FILE__);
+    ASSERT_NE_PTR(resource, NULL);
+    ASSERT_GT_SIZE(resource->size, 0);
+    ASSERT_EQ_INT(memcmp(resource->data, "#include", 8), 0);
+
+    /* Mapped only once. */
+    ASSERT_EQ_PTR(cutest_resource_map(__FILE__), resource);
+    s_resource = resource;
+}
+
+TEST(resource, shared)
+{
+    ASSERT_EQ_PTR(cutest_resource_map(__FILE__), s_resource);
+}
+
+TEST(resource, missing)
+{
+    ASSERT_EQ_PTR(cutest_resource_map("no_such_dir/no_such_file"), NULL);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief The number of users in the last `[ RESOURCE ]` line, -1 if none.
+ */
+static int _resource_users(FILE* out)
+{
+    int users = -1;
+    string_matrix_t* matrix = string_matrix_create_from_file(out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        const char* pos = strstr(line, "used by ");
+        if (strstr(line, "[ RESOURCE ]") != NULL && pos != NULL)
+        {
+            sscanf(pos, "used by %d", &users);
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    return users;
+}
+
+DEFINE_TEST(resource, 0)
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+    TEST_PORTING_ASSERT(_resource_users(_TEST.out) == 2);
+}
+
+DEFINE_TEST(resource, 1, "--test_resource_preload=" __FILE__, "--test_resource_prefetch",
+    "--test_filter=resource.shared")
+{
+    /* Preloaded before the case, so it is the same view. */
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+}
+
+DEFINE_TEST(resource, 2, "--test_repeat=2")
+{
+    /* Cases map it again in the second round, but each is counted once. */
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+    TEST_PORTING_ASSERT(_resource_users(_TEST.out) == 2);
+}
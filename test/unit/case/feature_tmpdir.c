@@ -0,0 +1,79 @@
+#include "test.h"
+#include <stdlib.h>
+#include <sys/stat.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+static char s_tmpdir[4096];
+
+TEST_FIXTURE_SETUP(tmpdir)
+{
+    /* Same directory in setup and test body. */
+    snprintf(s_tmpdir, sizeof(s_tmpdir), "%s", cutest_tmpdir());
+}
+
+TEST_FIXTURE_TEARDOWN(tmpdir)
+{
+}
+
+TEST_F(tmpdir, create)
+{
+    ASSERT_EQ_STR(cutest_tmpdir(), s_tmpdir);
+
+    char path[4200];
+    snprintf(path, sizeof(path), "%s/sub", s_tmpdir);
+    ASSERT_EQ_INT(mkdir(path, 0700), 0);
+
+    snprintf(path, sizeof(path), "%s/sub/file", s_tmpdir);
+    FILE* file = fopen(path, "w");
+    ASSERT_NE_PTR(file, NULL);
+    fputs("hello", file);
+    fclose(file);
+}
+
+TEST_F(tmpdir, failure)
+{
+    ASSERT_EQ_INT(0, 1);
+}
+
+TEST(tmpdir, memfile)
+{
+    FILE* file = cutest_memfile("memfile");
+    ASSERT_NE_PTR(file, NULL);
+
+    char buf[16] = { 0 };
+    fputs("hello", file);
+    rewind(file);
+    ASSERT_NE_PTR(fgets(buf, sizeof(buf), file), NULL);
+    ASSERT_EQ_STR(buf, "hello");
+    fclose(file);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(tmpdir, 0, "--test_filter=tmpdir.create")
+{
+    /* Directory is removed after teardown. */
+    struct stat st;
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+    TEST_PORTING_ASSERT(s_tmpdir[0] != '\0');
+    TEST_PORTING_ASSERT(stat(s_tmpdir, &st) != 0);
+}
+
+DEFINE_TEST(tmpdir, 1, "--test_filter=tmpdir.failure")
+{
+    /* Even if the case failed. */
+    struct stat st;
+    TEST_PORTING_ASSERT(_TEST.rret != 0);
+    TEST_PORTING_ASSERT(s_tmpdir[0] != '\0');
+    TEST_PORTING_ASSERT(stat(s_tmpdir, &st) != 0);
+}
+
+DEFINE_TEST(tmpdir, 2, "--test_filter=tmpdir.memfile")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+}
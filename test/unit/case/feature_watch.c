@@ -0,0 +1,222 @@
+#include "test.h"
+
+#if defined(WATCH_MODULE_V1) && defined(__linux__)
+#include <pthread.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WATCH_DIR           "feature_watch.dir"
+#define WATCH_MODULE        WATCH_DIR "/feature_watch_module.so"
+#define WATCH_WAITING       "[ WATCH    ] waiting for changes"
+
+static struct
+{
+    pthread_t           main;
+    pthread_t           thread;
+    volatile int        done;       /**< Set once the run returned. */
+    struct sigaction    old_act;
+} s_watch;
+
+static void _watch_on_signal(int sig)
+{
+    (void)sig;
+}
+
+static int _watch_copy(const char* src, const char* dst)
+{
+    char buf[4096];
+    size_t n;
+    int ret = -1;
+
+    /* Rename into place, like linkers do. */
+    FILE* in = fopen(src, "rb");
+    FILE* out = fopen(WATCH_DIR "/tmp", "wb");
+    if (in != NULL && out != NULL)
+    {
+        while ((n = fread(buf, 1, sizeof(buf), in)) > 0)
+        {
+            fwrite(buf, 1, n, out);
+        }
+        ret = 0;
+    }
+    if (in != NULL)
+    {
+        fclose(in);
+    }
+    if (out != NULL)
+    {
+        fclose(out);
+    }
+    return ret == 0 ? rename(WATCH_DIR "/tmp", dst) : -1;
+}
+
+/**
+ * @brief Wait until the output says \p count times that it is waiting.
+ */
+static void _watch_wait_idle(int count)
+{
+    static char buf[64 * 1024];
+    int fd = fileno(_TEST.out);
+
+    int retry;
+    for (retry = 0; retry < 1000; retry++)
+    {
+        ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+        buf[n > 0 ? n : 0] = '\0';
+
+        int found = 0;
+        const char* pos = buf;
+        while ((pos = strstr(pos, WATCH_WAITING)) != NULL)
+        {
+            found++;
+            pos++;
+        }
+        if (found >= count)
+        {
+            return;
+        }
+
+        struct timespec ts = { 0, 10 * 1000 * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+/**
+ * @brief Replace the module once the first run is done, then interrupt the
+ *   wait for next change, which ends the watch.
+ */
+static void* _watch_thread(void* arg)
+{
+    (void)arg;
+    _watch_wait_idle(1);
+    _watch_copy(WATCH_MODULE_V2, WATCH_MODULE);
+    _watch_wait_idle(2);
+
+    /* poll() is never restarted. Keep trying in case it was not entered yet. */
+    while (!s_watch.done)
+    {
+        pthread_kill(s_watch.main, SIGUSR1);
+
+        struct timespec ts = { 0, 10 * 1000 * 1000 };
+        nanosleep(&ts, NULL);
+    }
+    return NULL;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(watch, builtin)
+{
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(watch, 0, "--test_watch=no_such_dir/no_such_module.so")
+{
+    /* Built in cases still run, and there is nothing to wait for. */
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found_load = 0, found_watch = 0, found_run = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strstr(line, "[ WARNING  ] Can not load `no_such_dir/no_such_module.so'") != NULL)
+        {
+            found_load = 1;
+        }
+        if (strstr(line, "[ WARNING  ] Can not watch `no_such_dir/no_such_module.so'") != NULL)
+        {
+            found_watch = 1;
+        }
+        if (strstr(line, "[       OK ] watch.builtin") != NULL)
+        {
+            found_run = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found_load);
+    TEST_PORTING_ASSERT(found_watch);
+    TEST_PORTING_ASSERT(found_run);
+}
+
+#if defined(WATCH_MODULE_V1) && defined(__linux__)
+
+DEFINE_TEST_SETUP(watch)
+{
+    /* Other system calls are restarted. */
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    sigemptyset(&act.sa_mask);
+    act.sa_handler = _watch_on_signal;
+    act.sa_flags = SA_RESTART;
+    TEST_PORTING_ASSERT(sigaction(SIGUSR1, &act, &s_watch.old_act) == 0);
+
+    mkdir(WATCH_DIR, 0755);
+    TEST_PORTING_ASSERT(_watch_copy(WATCH_MODULE_V1, WATCH_MODULE) == 0);
+
+    s_watch.done = 0;
+    s_watch.main = pthread_self();
+    TEST_PORTING_ASSERT(pthread_create(&s_watch.thread, NULL, _watch_thread, NULL) == 0);
+}
+
+DEFINE_TEST_TEARDOWN(watch)
+{
+    s_watch.done = 1;
+    pthread_join(s_watch.thread, NULL);
+    sigaction(SIGUSR1, &s_watch.old_act, NULL);
+
+    remove(WATCH_MODULE);
+    rmdir(WATCH_DIR);
+}
+
+DEFINE_TEST_F(watch, reload, "--test_filter=feature_watch_module.*", "--test_watch=" WATCH_MODULE)
+{
+    /* Each run reports its own result. */
+    int old_run = 0, new_run = 0, reloaded = 0;
+    long fixed_line = -1, new_line = -1;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        const char* line = string_matrix_access(matrix, i, 0);
+        if (strstr(line, "[ WATCH    ] " WATCH_MODULE " changed, reloading.") != NULL)
+        {
+            reloaded = 1;
+        }
+        else if (strstr(line, "[ RUN      ] feature_watch_module.watch.old") != NULL)
+        {
+            TEST_PORTING_ASSERT(!reloaded);
+            old_run++;
+        }
+        else if (reloaded && strstr(line, "[       OK ] feature_watch_module.watch.z_fixed") != NULL)
+        {
+            fixed_line = (long)i;
+        }
+        else if (reloaded && strstr(line, "[       OK ] feature_watch_module.watch.a_new") != NULL)
+        {
+            new_line = (long)i;
+            new_run++;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    /* Cases of the old build are gone, and the one failed last time runs first. */
+    TEST_PORTING_ASSERT(reloaded);
+    TEST_PORTING_ASSERT(old_run == 1);
+    TEST_PORTING_ASSERT(new_run == 1);
+    TEST_PORTING_ASSERT(fixed_line >= 0 && fixed_line < new_line);
+}
+
+#endif
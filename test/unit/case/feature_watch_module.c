@@ -0,0 +1,26 @@
+#include "cutest.h"
+
+/* Built twice, the second version replaces the first one under `--test_watch`. */
+#if WATCH_MODULE_VERSION == 1
+
+TEST(watch, old)
+{
+}
+
+TEST(watch, z_fixed)
+{
+    ASSERT_EQ_INT(WATCH_MODULE_VERSION, 2);
+}
+
+#else
+
+TEST(watch, a_new)
+{
+}
+
+TEST(watch, z_fixed)
+{
+    ASSERT_EQ_INT(WATCH_MODULE_VERSION, 2);
+}
+
+#endif
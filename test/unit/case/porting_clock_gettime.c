@@ -1,11 +1,47 @@
 #include "test.h"
 
+static cutest_porting_timespec_t s_now = { 1, 900000000 };
+
 ///////////////////////////////////////////////////////////////////////////////
 // Porting
 ///////////////////////////////////////////////////////////////////////////////
 
 void cutest_porting_clock_gettime(cutest_porting_timespec_t* tp)
 {
-    tp->tv_nsec = 0;
-    tp->tv_sec = 0;
+    *tp = s_now;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(clock, borrow)
+{
+    /* Nanosecond part of end time is less than the one of start time. */
+    s_now.tv_sec = 2;
+    s_now.tv_nsec = 100000000;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(clock, 0, "--test_filter=clock.borrow")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    int found = 0;
+    string_matrix_t* matrix = string_matrix_create_from_file(_TEST.out, "\n");
+
+    size_t i;
+    for (i = 0; i < matrix->line_sz; i++)
+    {
+        if (strcmp(string_matrix_access(matrix, i, 0), "[       OK ] clock.borrow (200 ms)") == 0)
+        {
+            found = 1;
+        }
+    }
+    string_matrix_destroy(matrix);
+
+    TEST_PORTING_ASSERT(found);
 }
@@ -0,0 +1,100 @@
+#include "test.h"
+#include <pthread.h>
+#include <sched.h>
+
+static volatile long s_thread_created = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// Porting
+///////////////////////////////////////////////////////////////////////////////
+
+typedef struct porting_thread
+{
+    pthread_t   handle;
+    void        (*fn)(void* arg);
+    void*       arg;
+} porting_thread_t;
+
+static void* _porting_thread_proxy(void* arg)
+{
+    porting_thread_t* thr = arg;
+    thr->fn(thr->arg);
+    return NULL;
+}
+
+void* cutest_porting_thread_create(void (*fn)(void* arg), void* arg)
+{
+    porting_thread_t* thr = malloc(sizeof(*thr));
+    thr->fn = fn;
+    thr->arg = arg;
+    if (pthread_create(&thr->handle, NULL, _porting_thread_proxy, thr) != 0)
+    {
+        free(thr);
+        return NULL;
+    }
+    __atomic_add_fetch(&s_thread_created, 1, __ATOMIC_SEQ_CST);
+    return thr;
+}
+
+void cutest_porting_thread_join(void* thr)
+{
+    pthread_join(((porting_thread_t*)thr)->handle, NULL);
+    free(thr);
+}
+
+void cutest_porting_thread_yield(void)
+{
+    sched_yield();
+}
+
+unsigned cutest_porting_thread_cpu_count(void)
+{
+    return 2;
+}
+
+long cutest_porting_thread_atomic_add(volatile long* dst, long val)
+{
+    return __atomic_add_fetch(dst, val, __ATOMIC_SEQ_CST);
+}
+
+int cutest_porting_thread_atomic_cas(volatile long* dst, long expect, long val)
+{
+    return __atomic_compare_exchange_n(dst, &expect, val, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Watchpoint
+///////////////////////////////////////////////////////////////////////////////
+
+static unsigned long s_thread_iterations[2 * 16];
+
+static void _porting_thread_body(void* arg, unsigned idx, unsigned long iterations)
+{
+    volatile unsigned long* counters = arg;
+    TEST_PORTING_ASSERT(idx < 2);
+
+    unsigned long i;
+    for (i = 0; i < iterations; i++)
+    {
+        counters[idx * 16]++;
+    }
+}
+
+TEST(thread, parallel)
+{
+    cutest_benchmark_parallel(_porting_thread_body, s_thread_iterations, 2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Verify
+///////////////////////////////////////////////////////////////////////////////
+
+DEFINE_TEST(thread, 0, "--test_filter=thread.parallel", "--test_benchmark_min_time=1")
+{
+    TEST_PORTING_ASSERT(_TEST.rret == 0);
+
+    /* Threads of the benchmark are created by the porting functions. */
+    TEST_PORTING_ASSERT(s_thread_created != 0);
+    TEST_PORTING_ASSERT(s_thread_iterations[0] != 0);
+    TEST_PORTING_ASSERT(s_thread_iterations[16] != 0);
+}
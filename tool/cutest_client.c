@@ -0,0 +1,263 @@
+/**
+ * @file
+ * Run tests in a daemon started with `--test_daemon=PATH`.
+ *
+ * ```
+ * ./test --test_daemon=/tmp/test.sock &
+ * cutest_client --daemon=/tmp/test.sock -- --test_filter=foo.*
+ * cutest_client --daemon=/tmp/test.sock --stop
+ * ```
+ *
+ * Output of the tests goes to stdout of the client, and the client exits with
+ * the exit code of the tests.
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static const char* s_help =
+"cutest_client --daemon=PATH [--wait=MS] [--stop] [-- TEST_ARGS...]\n"
+"\n"
+"--daemon=PATH\n"
+"    Unix domain socket, same as `--test_daemon=PATH' of the test.\n"
+"--wait=MS\n"
+"    Wait up to MS milliseconds for the daemon to start (default 0).\n"
+"--stop\n"
+"    Stop the daemon instead of running tests.\n"
+"--help\n"
+"    Show this help and exit.\n";
+
+typedef struct client_ctx
+{
+    const char*             daemon_path;
+    unsigned long           wait_ms;
+    int                     stop;
+    char**                  test_argv;
+    int                     test_argc;
+} client_ctx_t;
+
+static client_ctx_t g_ctx;
+
+static void _setup(int argc, char* argv[])
+{
+    int i;
+    const char* opt;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            g_ctx.test_argv = argv + i + 1;
+            g_ctx.test_argc = argc - i - 1;
+            break;
+        }
+
+        opt = "--daemon=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.daemon_path = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--wait=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            char* end = NULL;
+            g_ctx.wait_ms = strtoul(argv[i] + strlen(opt), &end, 10);
+            if (*end != '\0')
+            {
+                fprintf(stderr, "invalid argument `%s'.\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            continue;
+        }
+
+        if (strcmp(argv[i], "--stop") == 0)
+        {
+            g_ctx.stop = 1;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            printf("%s", s_help);
+            exit(0);
+        }
+
+        fprintf(stderr, "unknown argument `%s'.\n", argv[i]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (g_ctx.daemon_path == NULL)
+    {
+        fprintf(stderr, "missing argument `--daemon='.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static int _connect(void)
+{
+    struct sockaddr_un addr;
+    if (strlen(g_ctx.daemon_path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "path too long: %s.\n", g_ctx.daemon_path);
+        exit(EXIT_FAILURE);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, g_ctx.daemon_path);
+
+    unsigned long waited_ms = 0;
+    for (;;)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0)
+        {
+            return fd;
+        }
+        int err = errno;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+
+        /* The daemon may still be doing global setup. */
+        if (waited_ms >= g_ctx.wait_ms || (err != ENOENT && err != ECONNREFUSED))
+        {
+            fprintf(stderr, "cannot connect to %s: %d.\n", g_ctx.daemon_path, err);
+            exit(EXIT_FAILURE);
+        }
+        struct timespec tv = { 0, 100 * 1000 * 1000 };
+        nanosleep(&tv, NULL);
+        waited_ms += 100;
+    }
+}
+
+/**
+ * @brief Send command and arguments as NUL terminated strings, ending with an
+ *   empty string. Our stdout goes along, so the daemon writes to it directly.
+ */
+static void _send_request(int fd)
+{
+    size_t size = strlen("STOP") + 2;
+    int i;
+    for (i = 0; i < g_ctx.test_argc; i++)
+    {
+        size += strlen(g_ctx.test_argv[i]) + 1;
+    }
+
+    char* buf = malloc(size);
+    if (buf == NULL)
+    {
+        fprintf(stderr, "out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t len = 0;
+    const char* command = g_ctx.stop ? "STOP" : "RUN";
+    memcpy(buf + len, command, strlen(command) + 1);
+    len += strlen(command) + 1;
+    for (i = 0; i < g_ctx.test_argc && !g_ctx.stop; i++)
+    {
+        /* Empty string ends the request. */
+        if (g_ctx.test_argv[i][0] == '\0')
+        {
+            continue;
+        }
+        memcpy(buf + len, g_ctx.test_argv[i], strlen(g_ctx.test_argv[i]) + 1);
+        len += strlen(g_ctx.test_argv[i]) + 1;
+    }
+    buf[len++] = '\0';
+
+    union
+    {
+        struct cmsghdr      hdr;
+        char                buf[CMSG_SPACE(sizeof(int))];
+    } ctl;
+    memset(&ctl, 0, sizeof(ctl));
+
+    int out_fd = STDOUT_FILENO;
+    fflush(stdout);
+
+    size_t sent = 0;
+    while (sent < len)
+    {
+        struct iovec iov = { buf + sent, len - sent };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (sent == 0)
+        {
+            msg.msg_control = ctl.buf;
+            msg.msg_controllen = sizeof(ctl.buf);
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            memcpy(CMSG_DATA(cmsg), &out_fd, sizeof(int));
+        }
+
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            fprintf(stderr, "cannot send request: %d.\n", errno);
+            exit(EXIT_FAILURE);
+        }
+        sent += (size_t)n;
+    }
+    free(buf);
+}
+
+/**
+ * @return Exit code of the tests.
+ */
+static int _wait_reply(int fd)
+{
+    char buf[32];
+    size_t len = 0;
+    ssize_t n;
+    while (len < sizeof(buf) - 1 && (n = read(fd, buf + len, sizeof(buf) - 1 - len)) != 0)
+    {
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            break;
+        }
+        len += (size_t)n;
+    }
+    buf[len] = '\0';
+
+    int code;
+    if (sscanf(buf, "%d", &code) != 1)
+    {
+        fprintf(stderr, "daemon exited without reply.\n");
+        return EXIT_FAILURE;
+    }
+    return code;
+}
+
+int main(int argc, char* argv[])
+{
+    _setup(argc, argv);
+
+    int fd = _connect();
+    _send_request(fd);
+    int code = _wait_reply(fd);
+    close(fd);
+
+    return code;
+}
@@ -0,0 +1,503 @@
+/**
+ * @file
+ * Convert a file into C source defining a #cutest_embed_t, optionally LZ4
+ * compressed. Used by `cutest_embed_file()` of CMakeLists.txt.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/**
+ * @brief Bytes in each line of array initializer.
+ */
+#define LINE_BYTES          32
+
+/**
+ * @brief Parameters of LZ4 block format.
+ */
+#define LZ4_MIN_MATCH       4
+#define LZ4_HASH_BITS       16
+#define LZ4_MAX_OFFSET      65535
+#define LZ4_LAST_LITERALS   5
+#define LZ4_MF_LIMIT        12
+
+static const char* s_help =
+"Generate C source that embeds a file, to be accessed by cutest_embed_data().\n"
+"\n"
+"--input=PATH\n"
+"    Path to input file.\n"
+"--output=PATH\n"
+"    Path to output C source.\n"
+"--name=STRING\n"
+"    Name of cutest_embed_t variable.\n"
+"--mode=incbin|embed|hex\n"
+"    How to embed the file. `incbin' uses the `.incbin' assembler directive\n"
+"    of GCC and Clang, `embed' uses C23 `#embed', `hex' writes an array\n"
+"    initializer that every compiler accepts (default).\n"
+"--compress\n"
+"    Store the file LZ4 compressed. It is decompressed on first access. For\n"
+"    `incbin' and `embed', the compressed file is written to OUTPUT.lz4.\n"
+"--help\n"
+"    Show this help and exit.\n";
+
+typedef enum embed_mode
+{
+    EMBED_MODE_HEX,
+    EMBED_MODE_INCBIN,
+    EMBED_MODE_EMBED,
+} embed_mode_t;
+
+typedef struct embed_ctx
+{
+    const char*     input_path;
+    const char*     output_path;
+    const char*     name;
+    embed_mode_t    mode;
+    int             compress;
+
+    unsigned char*  raw;            /**< Content of input file. */
+    size_t          raw_size;
+    unsigned char*  data;           /**< Bytes to store, maybe compressed. */
+    size_t          data_size;
+    char*           data_path;      /**< File of stored bytes, for `incbin' and `embed'. */
+
+    FILE*           output_file;
+} embed_ctx_t;
+
+static embed_ctx_t g_ctx;
+
+#if !defined(_WIN32)
+static int fopen_s(FILE** out, const char* path, const char* mode)
+{
+    if ((*out = fopen(path, mode)) == NULL)
+    {
+        return errno;
+    }
+    return 0;
+}
+#endif
+
+static void _setup(int argc, char* argv[])
+{
+    int i;
+    const char* opt;
+
+    for (i = 1; i < argc; i++)
+    {
+        opt = "--input=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.input_path = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--output=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.output_path = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--name=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.name = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--mode=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            const char* mode = argv[i] + strlen(opt);
+            if (strcmp(mode, "incbin") == 0)
+            {
+                g_ctx.mode = EMBED_MODE_INCBIN;
+            }
+            else if (strcmp(mode, "embed") == 0)
+            {
+                g_ctx.mode = EMBED_MODE_EMBED;
+            }
+            else if (strcmp(mode, "hex") == 0)
+            {
+                g_ctx.mode = EMBED_MODE_HEX;
+            }
+            else
+            {
+                fprintf(stderr, "unknown mode `%s'.\n", mode);
+                exit(EXIT_FAILURE);
+            }
+            continue;
+        }
+
+        if (strcmp(argv[i], "--compress") == 0)
+        {
+            g_ctx.compress = 1;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            printf("%s", s_help);
+            exit(0);
+        }
+
+        fprintf(stderr, "unknown argument `%s'.\n", argv[i]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (g_ctx.input_path == NULL)
+    {
+        fprintf(stderr, "missing argument `--input='.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (g_ctx.output_path == NULL)
+    {
+        fprintf(stderr, "missing argument `--output='.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (g_ctx.name == NULL)
+    {
+        fprintf(stderr, "missing argument `--name='.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void _at_exit(void)
+{
+    if (g_ctx.output_file != NULL)
+    {
+        fclose(g_ctx.output_file);
+        g_ctx.output_file = NULL;
+    }
+    if (g_ctx.data != g_ctx.raw)
+    {
+        free(g_ctx.data);
+    }
+    g_ctx.data = NULL;
+    free(g_ctx.raw);
+    g_ctx.raw = NULL;
+    free(g_ctx.data_path);
+    g_ctx.data_path = NULL;
+}
+
+static void _read_input(void)
+{
+    FILE* file;
+    int ret;
+    if ((ret = fopen_s(&file, g_ctx.input_path, "rb")) != 0)
+    {
+        fprintf(stderr, "cannot open %s: %d.\n", g_ctx.input_path, ret);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t cap = 0;
+    for (;;)
+    {
+        if (g_ctx.raw_size == cap)
+        {
+            cap = cap != 0 ? cap * 2 : 64 * 1024;
+            unsigned char* tmp = realloc(g_ctx.raw, cap);
+            if (tmp == NULL)
+            {
+                fprintf(stderr, "out of memory.\n");
+                exit(EXIT_FAILURE);
+            }
+            g_ctx.raw = tmp;
+        }
+
+        size_t nread = fread(g_ctx.raw + g_ctx.raw_size, 1, cap - g_ctx.raw_size, file);
+        if (nread == 0)
+        {
+            break;
+        }
+        g_ctx.raw_size += nread;
+    }
+
+    if (ferror(file))
+    {
+        fprintf(stderr, "error when reading %s.\n", g_ctx.input_path);
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+}
+
+static unsigned long _lz4_read32(const unsigned char* p)
+{
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8)
+        | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static size_t _lz4_write_len(unsigned char* dst, size_t len)
+{
+    size_t n = 0;
+    for (; len >= 255; len -= 255)
+    {
+        dst[n++] = 255;
+    }
+    dst[n++] = (unsigned char)len;
+    return n;
+}
+
+static size_t _lz4_write_sequence(unsigned char* dst, const unsigned char* literals,
+    size_t lit_len, size_t offset, size_t match_len)
+{
+    size_t n = 0;
+    size_t token_pos = n++;
+    unsigned token = (unsigned)(lit_len < 15 ? lit_len : 15) << 4;
+    if (lit_len >= 15)
+    {
+        n += _lz4_write_len(dst + n, lit_len - 15);
+    }
+    memcpy(dst + n, literals, lit_len);
+    n += lit_len;
+
+    if (match_len != 0)
+    {
+        dst[n++] = (unsigned char)(offset & 0xFF);
+        dst[n++] = (unsigned char)(offset >> 8);
+
+        size_t len = match_len - LZ4_MIN_MATCH;
+        token |= (unsigned)(len < 15 ? len : 15);
+        if (len >= 15)
+        {
+            n += _lz4_write_len(dst + n, len - 15);
+        }
+    }
+
+    dst[token_pos] = (unsigned char)token;
+    return n;
+}
+
+/**
+ * @brief Greedy LZ4 block compression. Fast enough for build time, the
+ *   decompressor does not care how matches are found.
+ */
+static void _compress(void)
+{
+    static size_t s_table[1 << LZ4_HASH_BITS];
+    const unsigned char* src = g_ctx.raw;
+    size_t size = g_ctx.raw_size;
+
+    unsigned char* dst = malloc(size + size / 255 + 16);
+    if (dst == NULL)
+    {
+        fprintf(stderr, "out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t out = 0, anchor = 0, pos = 0;
+    while (size >= LZ4_MF_LIMIT && pos <= size - LZ4_MF_LIMIT)
+    {
+        unsigned long seq = _lz4_read32(src + pos);
+        size_t hash = (size_t)(((seq * 2654435761UL) & 0xFFFFFFFFUL) >> (32 - LZ4_HASH_BITS));
+        size_t ref = s_table[hash];
+        s_table[hash] = pos + 1;
+
+        if (ref == 0 || pos - (ref - 1) > LZ4_MAX_OFFSET || _lz4_read32(src + ref - 1) != seq)
+        {
+            pos++;
+            continue;
+        }
+        ref--;
+
+        size_t match_len = LZ4_MIN_MATCH;
+        size_t max_len = size - LZ4_LAST_LITERALS - pos;
+        while (match_len < max_len && src[ref + match_len] == src[pos + match_len])
+        {
+            match_len++;
+        }
+
+        out += _lz4_write_sequence(dst + out, src + anchor, pos - anchor, pos - ref, match_len);
+        pos += match_len;
+        anchor = pos;
+    }
+    out += _lz4_write_sequence(dst + out, src + anchor, size - anchor, 0, 0);
+
+    g_ctx.data = dst;
+    g_ctx.data_size = out;
+}
+
+static void _write_data_file(void)
+{
+    size_t len = strlen(g_ctx.output_path);
+    if ((g_ctx.data_path = malloc(len + 5)) == NULL)
+    {
+        fprintf(stderr, "out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(g_ctx.data_path, g_ctx.output_path, len);
+    memcpy(g_ctx.data_path + len, ".lz4", 5);
+
+    FILE* file;
+    int ret;
+    if ((ret = fopen_s(&file, g_ctx.data_path, "wb")) != 0)
+    {
+        fprintf(stderr, "cannot open %s: %d.\n", g_ctx.data_path, ret);
+        exit(EXIT_FAILURE);
+    }
+    if (fwrite(g_ctx.data, 1, g_ctx.data_size, file) != g_ctx.data_size)
+    {
+        fprintf(stderr, "error when writing %s.\n", g_ctx.data_path);
+        fclose(file);
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+}
+
+/**
+ * @brief Write \p path as string literal. Backslashes become slashes, which
+ *   both assemblers and compilers accept on Windows.
+ */
+static void _write_path(const char* path)
+{
+    fputc('"', g_ctx.output_file);
+    for (; *path != '\0'; path++)
+    {
+        fputc(*path == '\\' ? '/' : *path, g_ctx.output_file);
+    }
+    fputc('"', g_ctx.output_file);
+}
+
+static void _write_incbin(void)
+{
+    fprintf(g_ctx.output_file,
+        "#if defined(__APPLE__)\n"
+        "#   define CUTEST_EMBED_SECTION \".const_data\"\n"
+        "#elif defined(_WIN32)\n"
+        "#   define CUTEST_EMBED_SECTION \".section .rdata,\\\"dr\\\"\"\n"
+        "#else\n"
+        "#   define CUTEST_EMBED_SECTION \".section .rodata\"\n"
+        "#endif\n"
+        "#define CUTEST_EMBED_STR2(x) #x\n"
+        "#define CUTEST_EMBED_STR(x) CUTEST_EMBED_STR2(x)\n"
+        "#define CUTEST_EMBED_SYM CUTEST_EMBED_STR(__USER_LABEL_PREFIX__) \"cutest_embed_%s_data\"\n"
+        "\n"
+        "__asm__(\n"
+        "    CUTEST_EMBED_SECTION \"\\n\"\n"
+        "    \".globl \" CUTEST_EMBED_SYM \"\\n\"\n"
+        "    \".balign 16\\n\"\n"
+        "    CUTEST_EMBED_SYM \":\\n\"\n"
+        "    \".incbin \\\"", g_ctx.name);
+
+    /* Path inside an assembler string inside a C string. */
+    const char* path;
+    for (path = g_ctx.data_path; *path != '\0'; path++)
+    {
+        fputc(*path == '\\' ? '/' : *path, g_ctx.output_file);
+    }
+    fprintf(g_ctx.output_file, "\\\"\\n\"\n"
+        "    \".byte 0\\n\"\n"
+        "    \".text\\n\"\n"
+        ");\n"
+        "extern const unsigned char cutest_embed_%s_data[];\n", g_ctx.name);
+}
+
+static void _write_embed(void)
+{
+    fprintf(g_ctx.output_file, "static const unsigned char cutest_embed_%s_data[] = {\n", g_ctx.name);
+    if (g_ctx.data_size != 0)
+    {
+        fprintf(g_ctx.output_file, "#embed ");
+        _write_path(g_ctx.data_path);
+        fprintf(g_ctx.output_file, "\n,");
+    }
+    fprintf(g_ctx.output_file, "0 };\n");
+}
+
+static void _write_hex(void)
+{
+    static const char* s_digits = "0123456789abcdef";
+    fprintf(g_ctx.output_file, "static const unsigned char cutest_embed_%s_data[] = {\n", g_ctx.name);
+
+    /* One line at a time, stdio is slow on single bytes. */
+    char line[LINE_BYTES * 5 + 2];
+    size_t i;
+    for (i = 0; i < g_ctx.data_size; i += LINE_BYTES)
+    {
+        size_t j, n = 0;
+        for (j = i; j < g_ctx.data_size && j < i + LINE_BYTES; j++)
+        {
+            line[n++] = '0';
+            line[n++] = 'x';
+            line[n++] = s_digits[g_ctx.data[j] >> 4];
+            line[n++] = s_digits[g_ctx.data[j] & 0x0F];
+            line[n++] = ',';
+        }
+        line[n++] = '\n';
+        fwrite(line, 1, n, g_ctx.output_file);
+    }
+    fprintf(g_ctx.output_file, "0x00 };\n");
+}
+
+static void _write_output(void)
+{
+    int ret;
+    if ((ret = fopen_s(&g_ctx.output_file, g_ctx.output_path, "wb")) != 0)
+    {
+        fprintf(stderr, "cannot open %s: %d.\n", g_ctx.output_path, ret);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(g_ctx.output_file,
+        "/* Generated by cutest_embed from %s, do not edit. */\n"
+        "#include \"cutest.h\"\n"
+        "\n", g_ctx.input_path);
+
+    switch (g_ctx.mode)
+    {
+    case EMBED_MODE_INCBIN:
+        _write_incbin();
+        break;
+    case EMBED_MODE_EMBED:
+        _write_embed();
+        break;
+    default:
+        _write_hex();
+        break;
+    }
+
+    fprintf(g_ctx.output_file,
+        "\n"
+        "cutest_embed_t %s = {\n"
+        "    cutest_embed_%s_data, %lu, %lu, %d, NULL, 0, NULL\n"
+        "};\n", g_ctx.name, g_ctx.name,
+        (unsigned long)g_ctx.data_size, (unsigned long)g_ctx.raw_size, g_ctx.data != g_ctx.raw);
+}
+
+int main(int argc, char* argv[])
+{
+    atexit(_at_exit);
+    _setup(argc, argv);
+
+    _read_input();
+    g_ctx.data = g_ctx.raw;
+    g_ctx.data_size = g_ctx.raw_size;
+
+    /* Empty file can not be compressed. */
+    if (g_ctx.compress && g_ctx.raw_size != 0)
+    {
+        _compress();
+    }
+
+    if (g_ctx.mode != EMBED_MODE_HEX)
+    {
+        if (g_ctx.data != g_ctx.raw)
+        {
+            _write_data_file();
+        }
+        else if ((g_ctx.data_path = malloc(strlen(g_ctx.input_path) + 1)) != NULL)
+        {
+            memcpy(g_ctx.data_path, g_ctx.input_path, strlen(g_ctx.input_path) + 1);
+        }
+        else
+        {
+            fprintf(stderr, "out of memory.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    _write_output();
+    return 0;
+}
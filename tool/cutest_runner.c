@@ -0,0 +1,2756 @@
+/**
+ * @file
+ * Run cases of many cutest binaries over one pool of job slots.
+ *
+ * Every binary is asked for its cases by `--test_list_tests`, then cases from
+ * all binaries are scheduled longest first, by their durations in previous
+ * runs. Short cases of the same binary are batched into one process to save
+ * the cost of process creation. Output of each process is printed as a whole
+ * when it exits, followed by one merged summary.
+ *
+ * When started by `make -jN` or another jobserver, every test process after
+ * the first one takes a token from the jobserver, so tests share the build's
+ * CPU budget instead of adding to it.
+ *
+ * To spread cases over machines, start one coordinator with the binaries,
+ * and any number of workers with the same binaries at the same paths:
+ *
+ * ```
+ * cutest_runner --coordinator=0.0.0.0:7000 build/test
+ * cutest_runner --worker=coordinator-host:7000 build/test
+ * ```
+ *
+ * Workers pull batches of cases whenever they have a free slot, and send back
+ * results and output. Cases in flight on a lost worker are queued again. A
+ * worker only runs binaries found in its own PATH arguments, or without them,
+ * any file that looks like a cutest binary.
+ *
+ * To measure an optimization, give the binary built before it to `--compare`,
+ * and the one built after it as PATH:
+ *
+ * ```
+ * cutest_runner --compare=build-old/test build-new/test
+ * ```
+ *
+ * Benchmarks found in both are run in turn on one pinned CPU, and the delta
+ * of each is reported with its 95% confidence interval.
+ */
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <math.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/**
+ * @brief A string only found in cutest binaries.
+ */
+#define RUNNER_BINARY_MARKER    "--test_list_tests"
+
+/**
+ * @brief Weight of the newest duration in history.
+ */
+#define RUNNER_HISTORY_WEIGHT   0.5
+
+/**
+ * @brief Workers wait this long before asking again when nothing is pending.
+ */
+#define RUNNER_RETRY_MS         200
+
+/**
+ * @brief Workers keep trying to connect for this long.
+ */
+#define RUNNER_CONNECT_MS       10000
+
+/**
+ * @brief Upper bound of cases in one batch, so workers can reject bogus sizes.
+ */
+#define RUNNER_MAX_BATCH        1024
+
+static const char* s_help =
+"cutest_runner [OPTIONS] PATH... [-- TEST_ARGS...]\n"
+"\n"
+"cutest_runner --worker=ADDRESS [OPTIONS] [PATH...] [-- TEST_ARGS...]\n"
+"\n"
+"cutest_runner --compare=BINARY_A [OPTIONS] BINARY_B [-- TEST_ARGS...]\n"
+"\n"
+"PATH is a cutest binary, or a directory to search for cutest binaries.\n"
+"ADDRESS is `HOST:PORT' for TCP, or `unix:PATH' for a Unix domain socket.\n"
+"TEST_ARGS are passed to every test process, except `--test_filter' which is\n"
+"used by cutest_runner itself.\n"
+"\n"
+"--jobs=N\n"
+"    Run at most N test processes at the same time (default is the number\n"
+"    of CPUs).\n"
+"--name=GLOB\n"
+"    Only use binaries whose file name matches GLOB when searching\n"
+"    directories (default \"*\").\n"
+"--filter=POSITIVE_PATTERNS[-NEGATIVE_PATTERNS]\n"
+"    Only run matching cases, same as `--test_filter' of cutest.\n"
+"--history=PATH\n"
+"    Durations of previous runs, used to start long cases first (default\n"
+"    \"cutest_runner.history\"). Use an empty PATH to disable.\n"
+"--coordinator=ADDRESS\n"
+"    Do not run cases, but serve them to workers connected to ADDRESS.\n"
+"--worker=ADDRESS\n"
+"    Run cases served by the coordinator at ADDRESS, with --jobs slots. If\n"
+"    PATH is given, only binaries found there are run, otherwise any cutest\n"
+"    binary the coordinator names.\n"
+"--no_jobserver\n"
+"    Ignore the jobserver in MAKEFLAGS, and only use --jobs.\n"
+"--batch=MS\n"
+"    Run cases of the same binary known to be shorter than MS milliseconds\n"
+"    in one process, up to MS milliseconds in total (default 50).\n"
+"--compare=BINARY_A\n"
+"    Do not run tests, but compare benchmarks of the same name in BINARY_A\n"
+"    and BINARY_B. Each round runs every benchmark once in each binary, one\n"
+"    after another on the same CPU, and the delta of B to A is reported\n"
+"    with its 95% confidence interval.\n"
+"--rounds=N\n"
+"    Run N rounds in --compare (default 10).\n"
+"--cpu=N\n"
+"    Pin all processes of --compare to CPU N (default the last allowed).\n"
+"--help\n"
+"    Show this help and exit.\n";
+
+typedef enum runner_result
+{
+    RUNNER_RESULT_NONE,         /**< No result yet. */
+    RUNNER_RESULT_OK,           /**< Passed. */
+    RUNNER_RESULT_SKIPPED,      /**< Skipped by itself. */
+    RUNNER_RESULT_FAILED,       /**< Failed or crashed. */
+    RUNNER_RESULT_MISSING,      /**< Process finished without running it. */
+} runner_result_t;
+
+typedef enum runner_state
+{
+    RUNNER_STATE_PENDING,       /**< Waiting for a slot. */
+    RUNNER_STATE_RUNNING,       /**< Running in a job. */
+    RUNNER_STATE_DONE,          /**< Finished. */
+} runner_state_t;
+
+typedef struct runner_case
+{
+    size_t                  binary;         /**< Index of binary. */
+    char*                   name;           /**< `fixture.case` or `fixture.case/idx`. */
+    double                  estimate_ms;    /**< Duration in previous runs, negative if unknown. */
+    runner_state_t          state;
+    runner_result_t         result;
+    int                     started;        /**< Whether `[ RUN      ]` is seen. */
+    int                     alone;          /**< Must run in a process of its own. */
+    double                  elapsed_ms;     /**< Duration of this run, negative if unknown. */
+} runner_case_t;
+
+typedef struct runner_job
+{
+    pid_t                   pid;            /**< Process ID, 0 if slot is free. */
+    int                     token;          /**< Jobserver token held, -1 if none. */
+    unsigned long           batch;          /**< Batch ID from coordinator. */
+    FILE*                   output;         /**< Output of process. */
+    size_t*                 cases;          /**< Indexes of cases in this job. */
+    size_t                  case_sz;
+    struct timespec         tv_beg;
+} runner_job_t;
+
+typedef struct runner_history
+{
+    char*                   binary;
+    char*                   name;
+    double                  duration_ms;
+} runner_history_t;
+
+/**
+ * @brief Cases sent to a worker.
+ */
+typedef struct runner_batch
+{
+    unsigned long           id;
+    int                     fd;             /**< Connection of worker, -1 if batch is finished. */
+    size_t*                 cases;
+    size_t                  case_sz;
+    struct timespec         tv_beg;
+} runner_batch_t;
+
+/**
+ * @brief Connection to a worker.
+ */
+typedef struct runner_peer
+{
+    int                     fd;             /**< -1 if closed. */
+    char*                   buf;            /**< Received but not handled. */
+    size_t                  buf_sz;
+    size_t                  buf_cap;
+} runner_peer_t;
+
+/**
+ * @brief A case found in both binaries of `--compare`.
+ */
+typedef struct runner_compare
+{
+    const char*             name;
+    double*                 samples[2];     /**< ns/op of A and B in each round. */
+    size_t                  sample_sz;      /**< 0 if not a benchmark. */
+    int                     failed;
+} runner_compare_t;
+
+typedef struct runner_ctx
+{
+    /* Options */
+    unsigned                jobs;
+    const char*             name_glob;
+    const char*             filter;
+    const char*             history_path;
+    double                  batch_ms;
+    char**                  test_argv;
+    int                     test_argc;
+
+    char**                  binaries;
+    size_t                  binary_sz;
+
+    runner_case_t*          cases;
+    size_t                  case_sz;
+    size_t*                 order;          /**< Cases in scheduling order. */
+    size_t                  next;           /**< Scan position in #runner_ctx_t::order. */
+
+    runner_history_t*       history;
+    size_t                  history_sz;
+
+    runner_job_t*           slots;
+    unsigned                running;
+    unsigned                max_running;    /**< The maximum number of concurrent jobs. */
+    double                  busy_ms;        /**< Sum of wall time of all jobs. */
+
+    struct
+    {
+        int                 disabled;       /**< `--no_jobserver` */
+        int                 rfd;            /**< Non-blocking read end, -1 if no jobserver. */
+        int                 wfd;            /**< Write end. */
+    } jobserver;
+
+    int                     wakeup[2];      /**< Written on SIGCHLD, so poll() returns. -1 if not used. */
+
+    struct
+    {
+        const char*         coordinator;    /**< `--coordinator` */
+        const char*         worker;         /**< `--worker` */
+        runner_batch_t*     batches;
+        size_t              batch_sz;
+        unsigned long       batch_id;       /**< ID of next batch. */
+        runner_peer_t*      peers;
+        size_t              peer_sz;
+        unsigned            workers;        /**< The number of workers ever connected. */
+        size_t              allowed;        /**< Binaries given to `--worker`, 0 to allow any cutest binary. */
+    } net;
+
+    struct
+    {
+        const char*         binary;         /**< `--compare` */
+        unsigned            rounds;         /**< `--rounds` */
+        int                 cpu;            /**< `--cpu`, -1 to choose one. */
+        runner_compare_t*   benchmarks;
+        size_t              benchmark_sz;
+    } compare;
+} runner_ctx_t;
+
+static runner_ctx_t g_ctx;
+
+static void* _xrealloc(void* ptr, size_t size)
+{
+    void* ret = realloc(ptr, size);
+    if (ret == NULL)
+    {
+        fprintf(stderr, "out of memory.\n");
+        exit(EXIT_FAILURE);
+    }
+    return ret;
+}
+
+static char* _xstrdup(const char* str)
+{
+    size_t len = strlen(str);
+    char* ret = _xrealloc(NULL, len + 1);
+    memcpy(ret, str, len + 1);
+    return ret;
+}
+
+static double _elapsed_ms(const struct timespec* beg)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - beg->tv_sec) * 1000.0 + (now.tv_nsec - beg->tv_nsec) / 1000000.0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Discovery
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Check file content instead of running unknown programs.
+ */
+static int _is_cutest_binary(const char* path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 || access(path, X_OK) != 0)
+    {
+        return 0;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    void* addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return 0;
+    }
+
+    int ret = memmem(addr, (size_t)st.st_size, RUNNER_BINARY_MARKER, strlen(RUNNER_BINARY_MARKER)) != NULL;
+    munmap(addr, (size_t)st.st_size);
+    return ret;
+}
+
+static void _add_binary(const char* path)
+{
+    char real[PATH_MAX];
+    if (realpath(path, real) == NULL)
+    {
+        fprintf(stderr, "cannot resolve %s: %d.\n", path, errno);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t i;
+    for (i = 0; i < g_ctx.binary_sz; i++)
+    {
+        if (strcmp(g_ctx.binaries[i], real) == 0)
+        {
+            return;
+        }
+    }
+
+    g_ctx.binaries = _xrealloc(g_ctx.binaries, sizeof(char*) * (g_ctx.binary_sz + 1));
+    g_ctx.binaries[g_ctx.binary_sz++] = _xstrdup(real);
+}
+
+static void _search_directory(const char* path)
+{
+    DIR* dir = opendir(path);
+    if (dir == NULL)
+    {
+        fprintf(stderr, "cannot open %s: %d.\n", path, errno);
+        exit(EXIT_FAILURE);
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        /* Skip hidden files and CMake internal directories. */
+        if (entry->d_name[0] == '.' || strcmp(entry->d_name, "CMakeFiles") == 0)
+        {
+            continue;
+        }
+
+        char child[PATH_MAX];
+        if ((size_t)snprintf(child, sizeof(child), "%s/%s", path, entry->d_name) >= sizeof(child))
+        {
+            continue;
+        }
+
+        struct stat st;
+        if (stat(child, &st) != 0)
+        {
+            continue;
+        }
+        if (S_ISDIR(st.st_mode))
+        {
+            _search_directory(child);
+        }
+        else if (fnmatch(g_ctx.name_glob, entry->d_name, 0) == 0 && _is_cutest_binary(child))
+        {
+            _add_binary(child);
+        }
+    }
+    closedir(dir);
+}
+
+static int _compare_string(const void* a, const void* b)
+{
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Process
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Start \p binary with \p arg and user arguments, writing to \p fd.
+ */
+static pid_t _spawn(const char* binary, const char* arg, int fd)
+{
+    char** argv = _xrealloc(NULL, sizeof(char*) * (g_ctx.test_argc + 3));
+    int argc = 0;
+    argv[argc++] = (char*)binary;
+    if (arg != NULL)
+    {
+        argv[argc++] = (char*)arg;
+    }
+    int i;
+    for (i = 0; i < g_ctx.test_argc; i++)
+    {
+        argv[argc++] = g_ctx.test_argv[i];
+    }
+    argv[argc] = NULL;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        fprintf(stderr, "fork() failed: %d.\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0)
+    {
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        execv(binary, argv);
+        _exit(127);
+    }
+
+    free(argv);
+    return pid;
+}
+
+static int _wait(pid_t pid)
+{
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+    return status;
+}
+
+/**
+ * @brief Read one line, without line break.
+ * @return The line, or NULL at end of file.
+ */
+static char* _read_line(FILE* file, char** buf, size_t* size)
+{
+    ssize_t len = getline(buf, size, file);
+    if (len < 0)
+    {
+        return NULL;
+    }
+    while (len > 0 && ((*buf)[len - 1] == '\n' || (*buf)[len - 1] == '\r'))
+    {
+        (*buf)[--len] = '\0';
+    }
+    return *buf;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Jobserver
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Find the last `--jobserver-auth=` (or `--jobserver-fds=` of old make)
+ *   in MAKEFLAGS.
+ * @return The value, or NULL if not found. Must be freed.
+ */
+static char* _jobserver_find_auth(void)
+{
+    const char* flags = getenv("MAKEFLAGS");
+    if (flags == NULL)
+    {
+        return NULL;
+    }
+
+    static const char* s_opts[] = { "--jobserver-auth=", "--jobserver-fds=" };
+    const char* found = NULL;
+    const char* pos;
+    size_t i;
+    for (i = 0; i < sizeof(s_opts) / sizeof(s_opts[0]); i++)
+    {
+        for (pos = flags; (pos = strstr(pos, s_opts[i])) != NULL; pos++)
+        {
+            if (found == NULL || pos > found)
+            {
+                found = pos + strlen(s_opts[i]);
+            }
+        }
+    }
+    if (found == NULL)
+    {
+        return NULL;
+    }
+
+    size_t len = strcspn(found, " ");
+    char* ret = _xrealloc(NULL, len + 1);
+    memcpy(ret, found, len);
+    ret[len] = '\0';
+    return ret;
+}
+
+/**
+ * @brief Open our own non-blocking description of the read end.
+ *
+ * Setting O_NONBLOCK on the inherited descriptor would affect make and
+ * every other client, so reopen it. For a pipe, /proc gives a new
+ * description of the same pipe.
+ */
+static int _jobserver_open_read(const char* path)
+{
+    return open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+}
+
+static void _on_sigchld(int sig)
+{
+    (void)sig;
+    int saved = errno;
+    if (write(g_ctx.wakeup[1], "", 1) < 0)
+    {
+        /* Pipe is full, poll() returns anyway. */
+    }
+    errno = saved;
+}
+
+/**
+ * @brief Make poll() on `g_ctx.wakeup[0]` return when a child exits.
+ */
+static void _wakeup_setup(void)
+{
+    if (g_ctx.wakeup[0] >= 0)
+    {
+        return;
+    }
+
+    if (pipe(g_ctx.wakeup) != 0)
+    {
+        fprintf(stderr, "pipe() failed: %d.\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    int i;
+    for (i = 0; i < 2; i++)
+    {
+        fcntl(g_ctx.wakeup[i], F_SETFL, fcntl(g_ctx.wakeup[i], F_GETFL) | O_NONBLOCK);
+        fcntl(g_ctx.wakeup[i], F_SETFD, FD_CLOEXEC);
+    }
+
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    sigemptyset(&act.sa_mask);
+    act.sa_handler = _on_sigchld;
+    act.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+    sigaction(SIGCHLD, &act, NULL);
+}
+
+static void _wakeup_drain(void)
+{
+    char buf[64];
+    while (read(g_ctx.wakeup[0], buf, sizeof(buf)) > 0)
+    {
+    }
+}
+
+/**
+ * @brief Return tokens of running jobs. Only async-signal-safe calls here.
+ */
+static void _jobserver_release_all(void)
+{
+    unsigned i;
+    for (i = 0; g_ctx.slots != NULL && i < g_ctx.jobs; i++)
+    {
+        runner_job_t* job = &g_ctx.slots[i];
+        if (job->token >= 0)
+        {
+            char c = (char)job->token;
+            job->token = -1;
+            if (write(g_ctx.jobserver.wfd, &c, 1) < 0)
+            {
+                /* Nothing we can do. */
+            }
+        }
+    }
+}
+
+static void _on_terminate(int sig)
+{
+    _jobserver_release_all();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+/**
+ * @brief Connect to jobserver given by MAKEFLAGS, which is either
+ *   `fifo:PATH` (make 4.4 and later) or `R,W` file descriptors of a pipe.
+ */
+static void _jobserver_setup(void)
+{
+    g_ctx.jobserver.rfd = -1;
+    g_ctx.jobserver.wfd = -1;
+
+    char* auth = g_ctx.jobserver.disabled ? NULL : _jobserver_find_auth();
+    if (auth == NULL)
+    {
+        return;
+    }
+
+    int rfd = -1, wfd = -1;
+    if (strncmp(auth, "fifo:", 5) == 0)
+    {
+        rfd = _jobserver_open_read(auth + 5);
+        wfd = rfd >= 0 ? open(auth + 5, O_WRONLY | O_CLOEXEC) : -1;
+    }
+    else
+    {
+        int r, w;
+        char path[64];
+        /* The descriptors are closed if make does not consider us a sub-make. */
+        if (sscanf(auth, "%d,%d", &r, &w) == 2 && r >= 0 && w >= 0
+            && fcntl(r, F_GETFD) >= 0 && fcntl(w, F_GETFD) >= 0)
+        {
+            snprintf(path, sizeof(path), "/proc/self/fd/%d", r);
+            rfd = _jobserver_open_read(path);
+            wfd = w;
+        }
+    }
+
+    if (rfd < 0 || wfd < 0)
+    {
+        fprintf(stderr, "jobserver `%s' is not accessible, use --jobs=%u instead.\n", auth, g_ctx.jobs);
+        if (rfd >= 0)
+        {
+            close(rfd);
+        }
+        free(auth);
+        return;
+    }
+    free(auth);
+
+    _wakeup_setup();
+    g_ctx.jobserver.rfd = rfd;
+    g_ctx.jobserver.wfd = wfd;
+
+    struct sigaction act;
+    memset(&act, 0, sizeof(act));
+    sigemptyset(&act.sa_mask);
+    act.sa_handler = _on_terminate;
+    act.sa_flags = 0;
+    sigaction(SIGINT, &act, NULL);
+    sigaction(SIGTERM, &act, NULL);
+    sigaction(SIGHUP, &act, NULL);
+}
+
+/**
+ * @brief Get permission to start one more job. The first job runs on the
+ *   token make gave to us.
+ * @return 0 if acquired, -1 if need to wait.
+ */
+static int _jobserver_acquire(runner_job_t* job)
+{
+    job->token = -1;
+    if (g_ctx.jobserver.rfd < 0 || g_ctx.running == 0)
+    {
+        return 0;
+    }
+
+    unsigned char c;
+    if (read(g_ctx.jobserver.rfd, &c, 1) == 1)
+    {
+        job->token = c;
+        return 0;
+    }
+    return -1;
+}
+
+static void _jobserver_release(runner_job_t* job)
+{
+    if (job->token < 0)
+    {
+        return;
+    }
+
+    /* Give back the same token, make may check it. */
+    char c = (char)job->token;
+    job->token = -1;
+    while (write(g_ctx.jobserver.wfd, &c, 1) < 0 && errno == EINTR)
+    {
+    }
+}
+
+/**
+ * @brief Wait until a child exits, or a token may be available if
+ *   \p want_token.
+ */
+static void _jobserver_wait(int want_token)
+{
+    struct pollfd fds[2];
+    fds[0].fd = g_ctx.wakeup[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = g_ctx.jobserver.rfd;
+    fds[1].events = POLLIN;
+
+    /* A child may have exited before SIGCHLD handler is installed. */
+    if (poll(fds, want_token ? 2 : 1, 100) > 0 && (fds[0].revents & POLLIN))
+    {
+        _wakeup_drain();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Case list
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Check if \p name matches any of `:` separated patterns in [\p beg, \p end).
+ */
+static int _match_patterns(const char* beg, const char* end, const char* name)
+{
+    while (beg < end)
+    {
+        const char* sep = memchr(beg, ':', (size_t)(end - beg));
+        size_t len = sep != NULL ? (size_t)(sep - beg) : (size_t)(end - beg);
+
+        char pattern[256];
+        if (len < sizeof(pattern))
+        {
+            memcpy(pattern, beg, len);
+            pattern[len] = '\0';
+            if (fnmatch(pattern, name, 0) == 0)
+            {
+                return 1;
+            }
+        }
+        beg += len + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Same rule as `--test_filter`.
+ */
+static int _match_filter(const char* name)
+{
+    const char* filter = g_ctx.filter;
+    if (filter == NULL)
+    {
+        return 1;
+    }
+
+    const char* neg = strchr(filter, '-');
+    const char* pos_end = neg != NULL ? neg : filter + strlen(filter);
+    if (pos_end != filter && !_match_patterns(filter, pos_end, name))
+    {
+        return 0;
+    }
+    return neg == NULL || !_match_patterns(neg + 1, neg + strlen(neg), name);
+}
+
+static void _add_case(size_t binary, const char* fixture, const char* name, size_t name_len)
+{
+    size_t fixture_len = strlen(fixture);
+    char* full = _xrealloc(NULL, fixture_len + name_len + 1);
+    memcpy(full, fixture, fixture_len);
+    memcpy(full + fixture_len, name, name_len);
+    full[fixture_len + name_len] = '\0';
+
+    if (!_match_filter(full))
+    {
+        free(full);
+        return;
+    }
+
+    g_ctx.cases = _xrealloc(g_ctx.cases, sizeof(runner_case_t) * (g_ctx.case_sz + 1));
+    runner_case_t* item = &g_ctx.cases[g_ctx.case_sz++];
+    memset(item, 0, sizeof(*item));
+    item->binary = binary;
+    item->name = full;
+    item->estimate_ms = -1;
+    item->elapsed_ms = -1;
+}
+
+/**
+ * @brief Parse output of `--test_list_tests`:
+ *
+ * ```
+ * fixture.
+ *   case
+ *   case/0  # <int> 1
+ * ```
+ */
+static void _list_cases(size_t binary)
+{
+    FILE* output = tmpfile();
+    if (output == NULL)
+    {
+        fprintf(stderr, "tmpfile() failed: %d.\n", errno);
+        exit(EXIT_FAILURE);
+    }
+
+    /* Listing does not need user arguments. */
+    int saved_argc = g_ctx.test_argc;
+    g_ctx.test_argc = 0;
+    pid_t pid = _spawn(g_ctx.binaries[binary], "--test_list_tests", fileno(output));
+    g_ctx.test_argc = saved_argc;
+
+    int status = _wait(pid);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        fprintf(stderr, "%s: cannot list tests, skipped.\n", g_ctx.binaries[binary]);
+        fclose(output);
+        return;
+    }
+    rewind(output);
+
+    char* fixture = _xstrdup("");
+    char* buf = NULL;
+    size_t buf_sz = 0;
+    const char* line;
+    while ((line = _read_line(output, &buf, &buf_sz)) != NULL)
+    {
+        size_t len = strlen(line);
+        if (len > 2 && line[0] == ' ' && line[1] == ' ')
+        {
+            const char* name = line + 2;
+            size_t name_len = strcspn(name, " \t");
+
+            /* Disabled cases do not run anyway. */
+            if (strncmp(name, "DISABLED_", 9) != 0)
+            {
+                _add_case(binary, fixture, name, name_len);
+            }
+        }
+        else if (len > 0 && line[len - 1] == '.')
+        {
+            free(fixture);
+            fixture = _xstrdup(line);
+        }
+    }
+
+    free(buf);
+    free(fixture);
+    fclose(output);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// History
+///////////////////////////////////////////////////////////////////////////////
+
+static int _compare_history(const void* a, const void* b)
+{
+    const runner_history_t* h1 = a;
+    const runner_history_t* h2 = b;
+    int ret = strcmp(h1->binary, h2->binary);
+    return ret != 0 ? ret : strcmp(h1->name, h2->name);
+}
+
+static runner_history_t* _find_history(const char* binary, const char* name)
+{
+    runner_history_t key;
+    key.binary = (char*)binary;
+    key.name = (char*)name;
+    return bsearch(&key, g_ctx.history, g_ctx.history_sz, sizeof(runner_history_t), _compare_history);
+}
+
+/**
+ * @brief Load history. Each line is `DURATION_MS<TAB>BINARY<TAB>CASE`.
+ */
+static void _load_history(void)
+{
+    if (g_ctx.history_path == NULL || g_ctx.history_path[0] == '\0')
+    {
+        return;
+    }
+
+    FILE* file = fopen(g_ctx.history_path, "r");
+    if (file == NULL)
+    {
+        return;
+    }
+
+    char* buf = NULL;
+    size_t buf_sz = 0;
+    char* line;
+    while ((line = _read_line(file, &buf, &buf_sz)) != NULL)
+    {
+        char* binary = strchr(line, '\t');
+        char* name = binary != NULL ? strchr(binary + 1, '\t') : NULL;
+        if (name == NULL)
+        {
+            continue;
+        }
+        *binary++ = '\0';
+        *name++ = '\0';
+
+        g_ctx.history = _xrealloc(g_ctx.history, sizeof(runner_history_t) * (g_ctx.history_sz + 1));
+        runner_history_t* item = &g_ctx.history[g_ctx.history_sz++];
+        item->duration_ms = strtod(line, NULL);
+        item->binary = _xstrdup(binary);
+        item->name = _xstrdup(name);
+    }
+    free(buf);
+    fclose(file);
+
+    qsort(g_ctx.history, g_ctx.history_sz, sizeof(runner_history_t), _compare_history);
+
+    size_t i;
+    for (i = 0; i < g_ctx.case_sz; i++)
+    {
+        runner_case_t* item = &g_ctx.cases[i];
+        runner_history_t* record = _find_history(g_ctx.binaries[item->binary], item->name);
+        if (record != NULL)
+        {
+            item->estimate_ms = record->duration_ms;
+        }
+    }
+}
+
+/**
+ * @brief Blend durations of this run into history, and keep records of cases
+ *   not run this time.
+ */
+static void _save_history(void)
+{
+    if (g_ctx.history_path == NULL || g_ctx.history_path[0] == '\0')
+    {
+        return;
+    }
+
+    size_t i;
+    for (i = 0; i < g_ctx.case_sz; i++)
+    {
+        runner_case_t* item = &g_ctx.cases[i];
+        if (item->elapsed_ms < 0)
+        {
+            continue;
+        }
+
+        runner_history_t* record = _find_history(g_ctx.binaries[item->binary], item->name);
+        if (record != NULL)
+        {
+            record->duration_ms = record->duration_ms * (1 - RUNNER_HISTORY_WEIGHT)
+                + item->elapsed_ms * RUNNER_HISTORY_WEIGHT;
+            continue;
+        }
+
+        /* Keep it sorted for following lookups. */
+        g_ctx.history = _xrealloc(g_ctx.history, sizeof(runner_history_t) * (g_ctx.history_sz + 1));
+        record = &g_ctx.history[g_ctx.history_sz++];
+        record->binary = _xstrdup(g_ctx.binaries[item->binary]);
+        record->name = _xstrdup(item->name);
+        record->duration_ms = item->elapsed_ms;
+        qsort(g_ctx.history, g_ctx.history_sz, sizeof(runner_history_t), _compare_history);
+    }
+
+    FILE* file = fopen(g_ctx.history_path, "w");
+    if (file == NULL)
+    {
+        fprintf(stderr, "cannot write %s: %d.\n", g_ctx.history_path, errno);
+        return;
+    }
+    for (i = 0; i < g_ctx.history_sz; i++)
+    {
+        fprintf(file, "%.3f\t%s\t%s\n", g_ctx.history[i].duration_ms,
+            g_ctx.history[i].binary, g_ctx.history[i].name);
+    }
+    fclose(file);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Schedule
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Longest first. Unknown cases may be long, so they go first.
+ */
+static int _compare_order(const void* a, const void* b)
+{
+    const runner_case_t* c1 = &g_ctx.cases[*(const size_t*)a];
+    const runner_case_t* c2 = &g_ctx.cases[*(const size_t*)b];
+
+    double e1 = c1->estimate_ms < 0 ? HUGE_VAL : c1->estimate_ms;
+    double e2 = c2->estimate_ms < 0 ? HUGE_VAL : c2->estimate_ms;
+    if (e1 != e2)
+    {
+        return e1 > e2 ? -1 : 1;
+    }
+
+    /* Stable order for equal estimates: by binary, then by listing. */
+    if (c1->binary != c2->binary)
+    {
+        return c1->binary < c2->binary ? -1 : 1;
+    }
+    return *(const size_t*)a < *(const size_t*)b ? -1 : 1;
+}
+
+static int _is_batchable(const runner_case_t* item)
+{
+    return !item->alone && item->estimate_ms >= 0 && item->estimate_ms < g_ctx.batch_ms;
+}
+
+static int _has_pending(void)
+{
+    size_t i;
+    for (i = g_ctx.next; i < g_ctx.case_sz; i++)
+    {
+        if (g_ctx.cases[g_ctx.order[i]].state == RUNNER_STATE_PENDING)
+        {
+            return 1;
+        }
+    }
+
+    /* Requeued cases. */
+    for (i = 0; i < g_ctx.next && i < g_ctx.case_sz; i++)
+    {
+        if (g_ctx.cases[g_ctx.order[i]].state == RUNNER_STATE_PENDING)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Take the next pending cases for a job.
+ * @param[out] cases - Indexes of cases taken, large enough for all cases.
+ * @return The number of cases taken, 0 if nothing pending.
+ */
+static size_t _take_cases(size_t* cases)
+{
+    while (g_ctx.next < g_ctx.case_sz && g_ctx.cases[g_ctx.order[g_ctx.next]].state != RUNNER_STATE_PENDING)
+    {
+        g_ctx.next++;
+    }
+
+    /* Requeued cases may be anywhere, so look from the beginning. */
+    size_t pos = g_ctx.next;
+    if (pos >= g_ctx.case_sz)
+    {
+        for (pos = 0; pos < g_ctx.case_sz && g_ctx.cases[g_ctx.order[pos]].state != RUNNER_STATE_PENDING; pos++)
+        {
+        }
+        if (pos >= g_ctx.case_sz)
+        {
+            return 0;
+        }
+    }
+
+    size_t head = g_ctx.order[pos];
+    runner_case_t* first = &g_ctx.cases[head];
+    size_t case_sz = 1;
+    cases[0] = head;
+    first->state = RUNNER_STATE_RUNNING;
+    if (!_is_batchable(first))
+    {
+        return case_sz;
+    }
+
+    double total = first->estimate_ms;
+    for (pos++; pos < g_ctx.case_sz && total < g_ctx.batch_ms && case_sz < RUNNER_MAX_BATCH; pos++)
+    {
+        runner_case_t* item = &g_ctx.cases[g_ctx.order[pos]];
+        if (item->state != RUNNER_STATE_PENDING || item->binary != first->binary || !_is_batchable(item))
+        {
+            continue;
+        }
+
+        cases[case_sz++] = g_ctx.order[pos];
+        item->state = RUNNER_STATE_RUNNING;
+        total += item->estimate_ms;
+    }
+    return case_sz;
+}
+
+static void _start_job(runner_job_t* job)
+{
+    size_t len = strlen("--test_filter=") + 1;
+    size_t i;
+    for (i = 0; i < job->case_sz; i++)
+    {
+        len += strlen(g_ctx.cases[job->cases[i]].name) + 1;
+    }
+
+    char* filter = _xrealloc(NULL, len);
+    strcpy(filter, "--test_filter=");
+    for (i = 0; i < job->case_sz; i++)
+    {
+        if (i != 0)
+        {
+            strcat(filter, ":");
+        }
+        strcat(filter, g_ctx.cases[job->cases[i]].name);
+    }
+
+    if ((job->output = tmpfile()) == NULL)
+    {
+        fprintf(stderr, "tmpfile() failed: %d.\n", errno);
+        exit(EXIT_FAILURE);
+    }
+
+    const char* binary = g_ctx.binaries[g_ctx.cases[job->cases[0]].binary];
+    clock_gettime(CLOCK_MONOTONIC, &job->tv_beg);
+    job->pid = _spawn(binary, filter, fileno(job->output));
+    g_ctx.running++;
+    if (g_ctx.running > g_ctx.max_running)
+    {
+        g_ctx.max_running = g_ctx.running;
+    }
+    free(filter);
+}
+
+static runner_case_t* _find_job_case(runner_job_t* job, const char* name, size_t name_len)
+{
+    size_t i;
+    for (i = 0; i < job->case_sz; i++)
+    {
+        runner_case_t* item = &g_ctx.cases[job->cases[i]];
+        if (strncmp(item->name, name, name_len) == 0 && item->name[name_len] == '\0')
+        {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Update case from one line of test output.
+ */
+static void _parse_result_line(runner_job_t* job, const char* line)
+{
+    static const struct
+    {
+        const char*     tag;
+        runner_result_t result;
+    } s_tags[] = {
+        { "[ RUN      ] ", RUNNER_RESULT_NONE },
+        { "[       OK ] ", RUNNER_RESULT_OK },
+        { "[   SKIP   ] ", RUNNER_RESULT_SKIPPED },
+        { "[  FAILED  ] ", RUNNER_RESULT_FAILED },
+    };
+
+    size_t i;
+    for (i = 0; i < sizeof(s_tags) / sizeof(s_tags[0]); i++)
+    {
+        size_t tag_len = strlen(s_tags[i].tag);
+        if (strncmp(line, s_tags[i].tag, tag_len) != 0)
+        {
+            continue;
+        }
+
+        const char* name = line + tag_len;
+        size_t name_len = strcspn(name, " ");
+        runner_case_t* item = _find_job_case(job, name, name_len);
+        if (item == NULL)
+        {
+            return;
+        }
+
+        if (s_tags[i].result == RUNNER_RESULT_NONE)
+        {
+            item->started = 1;
+            return;
+        }
+
+        /* Failure in late teardown, or the summary, may follow the result. */
+        if (item->result == RUNNER_RESULT_NONE || s_tags[i].result == RUNNER_RESULT_FAILED)
+        {
+            item->result = s_tags[i].result;
+        }
+
+        unsigned long ms;
+        if (item->elapsed_ms < 0 && sscanf(name + name_len, " (%lu ms)", &ms) == 1)
+        {
+            item->elapsed_ms = (double)ms;
+        }
+        return;
+    }
+}
+
+/**
+ * @brief Print output of test process, without its own banner and summary.
+ */
+static void _print_job_output(runner_job_t* job, FILE* out)
+{
+    const char* binary = g_ctx.binaries[g_ctx.cases[job->cases[0]].binary];
+    fprintf(out, "[----------] %s\n", binary);
+
+    rewind(job->output);
+
+    char* buf = NULL;
+    size_t buf_sz = 0;
+    const char* line;
+    while ((line = _read_line(job->output, &buf, &buf_sz)) != NULL)
+    {
+        if (strncmp(line, "[ $", 3) == 0 || strncmp(line, "[==========] total ", 19) == 0)
+        {
+            continue;
+        }
+        if (strncmp(line, "[==========] ", 13) == 0)
+        {
+            break;
+        }
+
+        _parse_result_line(job, line);
+        fprintf(out, "%s\n", line);
+    }
+    free(buf);
+}
+
+/**
+ * @brief Collect result of finished job, and write its output to \p out.
+ */
+static void _finish_job(runner_job_t* job, int status, FILE* out)
+{
+    double wall_ms = _elapsed_ms(&job->tv_beg);
+    g_ctx.busy_ms += wall_ms;
+
+    _print_job_output(job, out);
+    fclose(job->output);
+    job->output = NULL;
+
+    int crashed = !WIFEXITED(status);
+    if (crashed)
+    {
+        fprintf(out, "[  FAILED  ] %s terminated by signal %d\n",
+            g_ctx.binaries[g_ctx.cases[job->cases[0]].binary], WTERMSIG(status));
+    }
+
+    size_t i;
+    for (i = 0; i < job->case_sz; i++)
+    {
+        runner_case_t* item = &g_ctx.cases[job->cases[i]];
+        if (item->result != RUNNER_RESULT_NONE)
+        {
+            item->state = RUNNER_STATE_DONE;
+        }
+        else if (item->started)
+        {
+            /* Crashed in the middle of it. */
+            item->result = RUNNER_RESULT_FAILED;
+            item->state = RUNNER_STATE_DONE;
+        }
+        else if (crashed && job->case_sz > 1)
+        {
+            /* Victim of another case in the batch, try again alone. */
+            item->state = RUNNER_STATE_PENDING;
+            item->alone = 1;
+            continue;
+        }
+        else
+        {
+            item->result = crashed ? RUNNER_RESULT_FAILED : RUNNER_RESULT_MISSING;
+            item->state = RUNNER_STATE_DONE;
+        }
+
+        if (item->elapsed_ms < 0 && job->case_sz == 1)
+        {
+            item->elapsed_ms = wall_ms;
+        }
+    }
+
+    _jobserver_release(job);
+    job->pid = 0;
+    job->case_sz = 0;
+    g_ctx.running--;
+}
+
+static runner_job_t* _find_job(pid_t pid)
+{
+    unsigned i;
+    for (i = 0; i < g_ctx.jobs; i++)
+    {
+        if (g_ctx.slots[i].pid == pid)
+        {
+            return &g_ctx.slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void _run_all(void)
+{
+    size_t i;
+    unsigned j;
+
+    g_ctx.order = _xrealloc(NULL, sizeof(size_t) * (g_ctx.case_sz + 1));
+    for (i = 0; i < g_ctx.case_sz; i++)
+    {
+        g_ctx.order[i] = i;
+    }
+    qsort(g_ctx.order, g_ctx.case_sz, sizeof(size_t), _compare_order);
+
+    runner_job_t* slots = _xrealloc(NULL, sizeof(runner_job_t) * g_ctx.jobs);
+    memset(slots, 0, sizeof(runner_job_t) * g_ctx.jobs);
+    for (j = 0; j < g_ctx.jobs; j++)
+    {
+        slots[j].token = -1;
+        slots[j].cases = _xrealloc(NULL, sizeof(size_t) * (g_ctx.case_sz + 1));
+    }
+    g_ctx.slots = slots;
+
+    for (;;)
+    {
+        int want_token = 0;
+        for (j = 0; j < g_ctx.jobs; j++)
+        {
+            runner_job_t* job = &g_ctx.slots[j];
+            if (job->pid != 0 || !_has_pending())
+            {
+                continue;
+            }
+            if (_jobserver_acquire(job) != 0)
+            {
+                want_token = 1;
+                break;
+            }
+
+            job->case_sz = _take_cases(job->cases);
+            _start_job(job);
+        }
+
+        if (g_ctx.running == 0)
+        {
+            break;
+        }
+
+        int status = 0;
+        pid_t pid;
+        if (g_ctx.jobserver.rfd >= 0)
+        {
+            /* Also wake up when a token is available. */
+            while ((pid = waitpid(-1, &status, WNOHANG)) == 0)
+            {
+                _jobserver_wait(want_token);
+                if (want_token)
+                {
+                    break;
+                }
+            }
+            if (pid == 0)
+            {
+                continue;
+            }
+        }
+        else
+        {
+            pid = waitpid(-1, &status, 0);
+        }
+
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "waitpid() failed: %d.\n", errno);
+            exit(EXIT_FAILURE);
+        }
+
+        runner_job_t* job = _find_job(pid);
+        if (job != NULL)
+        {
+            _finish_job(job, status, stdout);
+        }
+    }
+
+    g_ctx.slots = NULL;
+    for (j = 0; j < g_ctx.jobs; j++)
+    {
+        free(slots[j].cases);
+    }
+    free(slots);
+    free(g_ctx.order);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Network
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Coordinator and workers talk in lines:
+ *
+ * ```
+ * worker                          coordinator
+ * HELLO <slots>               ->
+ * PULL                        ->
+ *                             <-  BATCH <id> <n>, binary, then n case names
+ *                             <-  WAIT (nothing pending now) or DONE
+ * OUTPUT <id> <len>, raw output ->
+ * RESULT <id> <result> <ms> <name> ->
+ * REQUEUE <id> <name>         ->
+ * END <id>                    ->
+ * ```
+ */
+
+/**
+ * @brief Resolve `unix:PATH` or `HOST:PORT`.
+ * @return Socket of proper family, or -1 if failed.
+ */
+static int _net_address(const char* addr, struct sockaddr_storage* sa, socklen_t* sa_len)
+{
+    memset(sa, 0, sizeof(*sa));
+    if (strncmp(addr, "unix:", 5) == 0)
+    {
+        struct sockaddr_un* un = (struct sockaddr_un*)sa;
+        if (strlen(addr + 5) >= sizeof(un->sun_path))
+        {
+            return -1;
+        }
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, addr + 5);
+        *sa_len = sizeof(*un);
+        return socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    }
+
+    const char* colon = strrchr(addr, ':');
+    if (colon == NULL)
+    {
+        return -1;
+    }
+    char* host = _xrealloc(NULL, (size_t)(colon - addr) + 1);
+    memcpy(host, addr, (size_t)(colon - addr));
+    host[colon - addr] = '\0';
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    int ret = getaddrinfo(host[0] != '\0' ? host : NULL, colon + 1, &hints, &res);
+    free(host);
+    if (ret != 0 || res == NULL)
+    {
+        return -1;
+    }
+
+    memcpy(sa, res->ai_addr, res->ai_addrlen);
+    *sa_len = res->ai_addrlen;
+    int fd = socket(res->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    freeaddrinfo(res);
+    return fd;
+}
+
+static void _net_send(int fd, const void* data, size_t size)
+{
+    const char* pos = data;
+    while (size > 0)
+    {
+        ssize_t len = send(fd, pos, size, MSG_NOSIGNAL);
+        if (len < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (len <= 0)
+        {
+            /* Peer is gone, which is noticed by the next read. */
+            return;
+        }
+        pos += len;
+        size -= (size_t)len;
+    }
+}
+
+static void _net_printf(int fd, const char* fmt, ...)
+{
+    char buf[PATH_MAX + 128];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (len > 0)
+    {
+        _net_send(fd, buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+    }
+}
+
+/**
+ * @brief Read what is available from \p peer.
+ * @return 0 if success, -1 if connection is closed.
+ */
+static int _net_receive(runner_peer_t* peer)
+{
+    if (peer->buf_cap - peer->buf_sz < 4096)
+    {
+        peer->buf_cap = peer->buf_cap * 2 + 4096;
+        peer->buf = _xrealloc(peer->buf, peer->buf_cap);
+    }
+
+    ssize_t len = recv(peer->fd, peer->buf + peer->buf_sz, peer->buf_cap - peer->buf_sz, 0);
+    if (len < 0 && (errno == EINTR || errno == EAGAIN))
+    {
+        return 0;
+    }
+    if (len <= 0)
+    {
+        return -1;
+    }
+    peer->buf_sz += (size_t)len;
+    return 0;
+}
+
+/**
+ * @brief Take one line from received data.
+ * @param[out] line - The line without line break, valid until next call.
+ * @param[in] extra - Also require this many bytes after the line.
+ * @return Size consumed, 0 if not complete yet.
+ */
+static size_t _net_line(runner_peer_t* peer, char** line, size_t extra)
+{
+    char* end = memchr(peer->buf, '\n', peer->buf_sz);
+    if (end == NULL || (size_t)(end + 1 - peer->buf) + extra > peer->buf_sz)
+    {
+        return 0;
+    }
+    *end = '\0';
+    *line = peer->buf;
+    return (size_t)(end + 1 - peer->buf);
+}
+
+static void _net_consume(runner_peer_t* peer, size_t size)
+{
+    memmove(peer->buf, peer->buf + size, peer->buf_sz - size);
+    peer->buf_sz -= size;
+}
+
+static void _net_close(runner_peer_t* peer)
+{
+    close(peer->fd);
+    peer->fd = -1;
+    free(peer->buf);
+    peer->buf = NULL;
+    peer->buf_sz = 0;
+    peer->buf_cap = 0;
+}
+
+/**
+ * @brief Find batch \p id sent to \p peer. A worker may only report on its
+ *   own batches.
+ */
+static runner_batch_t* _coordinator_find_batch(const runner_peer_t* peer, unsigned long id)
+{
+    size_t i;
+    for (i = 0; i < g_ctx.net.batch_sz; i++)
+    {
+        if (g_ctx.net.batches[i].id == id && g_ctx.net.batches[i].fd == peer->fd)
+        {
+            return &g_ctx.net.batches[i];
+        }
+    }
+    return NULL;
+}
+
+static runner_case_t* _coordinator_find_case(runner_batch_t* batch, const char* name)
+{
+    size_t i;
+    for (i = 0; batch != NULL && i < batch->case_sz; i++)
+    {
+        runner_case_t* item = &g_ctx.cases[batch->cases[i]];
+        if (strcmp(item->name, name) == 0)
+        {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void _coordinator_end_batch(runner_batch_t* batch)
+{
+    if (batch->fd < 0)
+    {
+        return;
+    }
+
+    /* Whatever is not reported goes back to the queue. */
+    size_t i;
+    for (i = 0; i < batch->case_sz; i++)
+    {
+        runner_case_t* item = &g_ctx.cases[batch->cases[i]];
+        if (item->state == RUNNER_STATE_RUNNING)
+        {
+            item->state = RUNNER_STATE_PENDING;
+            item->result = RUNNER_RESULT_NONE;
+            item->started = 0;
+            item->elapsed_ms = -1;
+        }
+    }
+
+    g_ctx.busy_ms += _elapsed_ms(&batch->tv_beg);
+    batch->fd = -1;
+    g_ctx.running--;
+}
+
+static void _coordinator_serve(runner_peer_t* peer)
+{
+    if (!_has_pending())
+    {
+        size_t i;
+        for (i = 0; i < g_ctx.case_sz && g_ctx.cases[i].state == RUNNER_STATE_DONE; i++)
+        {
+        }
+        _net_printf(peer->fd, "%s\n", i == g_ctx.case_sz ? "DONE" : "WAIT");
+        return;
+    }
+
+    g_ctx.net.batches = _xrealloc(g_ctx.net.batches, sizeof(runner_batch_t) * (g_ctx.net.batch_sz + 1));
+    runner_batch_t* batch = &g_ctx.net.batches[g_ctx.net.batch_sz++];
+    batch->id = g_ctx.net.batch_id++;
+    batch->fd = peer->fd;
+    batch->cases = _xrealloc(NULL, sizeof(size_t) * (g_ctx.case_sz + 1));
+    batch->case_sz = _take_cases(batch->cases);
+    clock_gettime(CLOCK_MONOTONIC, &batch->tv_beg);
+
+    g_ctx.running++;
+    if (g_ctx.running > g_ctx.max_running)
+    {
+        g_ctx.max_running = g_ctx.running;
+    }
+
+    _net_printf(peer->fd, "BATCH %lu %zu\n%s\n", batch->id, batch->case_sz,
+        g_ctx.binaries[g_ctx.cases[batch->cases[0]].binary]);
+    size_t i;
+    for (i = 0; i < batch->case_sz; i++)
+    {
+        _net_printf(peer->fd, "%s\n", g_ctx.cases[batch->cases[i]].name);
+    }
+}
+
+/**
+ * @brief Handle complete messages from \p peer.
+ */
+static void _coordinator_handle(runner_peer_t* peer)
+{
+    char* line;
+    size_t size;
+    while ((size = _net_line(peer, &line, 0)) != 0)
+    {
+        unsigned long id, len;
+        int result, name_pos = 0;
+        double ms;
+
+        if (sscanf(line, "OUTPUT %lu %lu", &id, &len) == 2)
+        {
+            /* Wait for the whole payload. */
+            line[size - 1] = '\n';
+            if (_net_line(peer, &line, len) == 0)
+            {
+                return;
+            }
+            fwrite(peer->buf + size, 1, len, stdout);
+            fflush(stdout);
+            size += len;
+        }
+        else if (strcmp(line, "PULL") == 0)
+        {
+            _coordinator_serve(peer);
+        }
+        else if (sscanf(line, "RESULT %lu %d %lf %n", &id, &result, &ms, &name_pos) == 3 && name_pos != 0)
+        {
+            runner_case_t* item = _coordinator_find_case(_coordinator_find_batch(peer, id), line + name_pos);
+            if (item != NULL && item->state == RUNNER_STATE_RUNNING
+                && result > RUNNER_RESULT_NONE && result <= RUNNER_RESULT_MISSING)
+            {
+                item->result = (runner_result_t)result;
+                item->elapsed_ms = ms;
+                item->state = RUNNER_STATE_DONE;
+            }
+        }
+        else if (sscanf(line, "REQUEUE %lu %n", &id, &name_pos) == 1 && name_pos != 0)
+        {
+            runner_case_t* item = _coordinator_find_case(_coordinator_find_batch(peer, id), line + name_pos);
+            if (item != NULL && item->state == RUNNER_STATE_RUNNING)
+            {
+                item->state = RUNNER_STATE_PENDING;
+                item->alone = 1;
+            }
+        }
+        else if (sscanf(line, "END %lu", &id) == 1)
+        {
+            runner_batch_t* batch = _coordinator_find_batch(peer, id);
+            if (batch != NULL)
+            {
+                _coordinator_end_batch(batch);
+            }
+        }
+        else if (strncmp(line, "HELLO ", 6) == 0)
+        {
+            g_ctx.net.workers++;
+        }
+
+        _net_consume(peer, size);
+    }
+}
+
+static void _coordinator_drop(runner_peer_t* peer)
+{
+    size_t i;
+    for (i = 0; i < g_ctx.net.batch_sz; i++)
+    {
+        if (g_ctx.net.batches[i].fd == peer->fd)
+        {
+            _coordinator_end_batch(&g_ctx.net.batches[i]);
+        }
+    }
+    _net_close(peer);
+}
+
+static int _coordinator_listen(void)
+{
+    struct sockaddr_storage sa;
+    socklen_t sa_len = 0;
+    int fd = _net_address(g_ctx.net.coordinator, &sa, &sa_len);
+    if (fd < 0)
+    {
+        fprintf(stderr, "invalid address `%s'.\n", g_ctx.net.coordinator);
+        exit(EXIT_FAILURE);
+    }
+
+    if (sa.ss_family == AF_UNIX)
+    {
+        unlink(((struct sockaddr_un*)&sa)->sun_path);
+    }
+    else
+    {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    }
+
+    if (bind(fd, (struct sockaddr*)&sa, sa_len) != 0 || listen(fd, 64) != 0)
+    {
+        fprintf(stderr, "cannot listen on %s: %d.\n", g_ctx.net.coordinator, errno);
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+/**
+ * @brief Serve all cases to workers, and print their output.
+ */
+static void _coordinator_run(void)
+{
+    size_t i;
+    int listener = _coordinator_listen();
+
+    g_ctx.order = _xrealloc(NULL, sizeof(size_t) * (g_ctx.case_sz + 1));
+    for (i = 0; i < g_ctx.case_sz; i++)
+    {
+        g_ctx.order[i] = i;
+    }
+    qsort(g_ctx.order, g_ctx.case_sz, sizeof(size_t), _compare_order);
+
+    struct pollfd* fds = NULL;
+    for (;;)
+    {
+        size_t done;
+        for (done = 0; done < g_ctx.case_sz && g_ctx.cases[done].state == RUNNER_STATE_DONE; done++)
+        {
+        }
+        if (done == g_ctx.case_sz && g_ctx.running == 0)
+        {
+            break;
+        }
+
+        fds = _xrealloc(fds, sizeof(struct pollfd) * (g_ctx.net.peer_sz + 1));
+        fds[0].fd = listener;
+        fds[0].events = POLLIN;
+        for (i = 0; i < g_ctx.net.peer_sz; i++)
+        {
+            fds[i + 1].fd = g_ctx.net.peers[i].fd;
+            fds[i + 1].events = POLLIN;
+            fds[i + 1].revents = 0;
+        }
+        if (poll(fds, g_ctx.net.peer_sz + 1, 1000) <= 0)
+        {
+            continue;
+        }
+
+        for (i = 0; i < g_ctx.net.peer_sz; i++)
+        {
+            runner_peer_t* peer = &g_ctx.net.peers[i];
+            if (peer->fd < 0 || fds[i + 1].revents == 0)
+            {
+                continue;
+            }
+            if (_net_receive(peer) != 0)
+            {
+                _coordinator_drop(peer);
+                continue;
+            }
+            _coordinator_handle(peer);
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            int fd = accept(listener, NULL, NULL);
+            if (fd >= 0)
+            {
+                fcntl(fd, F_SETFD, FD_CLOEXEC);
+                g_ctx.net.peers = _xrealloc(g_ctx.net.peers, sizeof(runner_peer_t) * (g_ctx.net.peer_sz + 1));
+                runner_peer_t* peer = &g_ctx.net.peers[g_ctx.net.peer_sz++];
+                memset(peer, 0, sizeof(*peer));
+                peer->fd = fd;
+            }
+        }
+    }
+    free(fds);
+
+    for (i = 0; i < g_ctx.net.peer_sz; i++)
+    {
+        if (g_ctx.net.peers[i].fd >= 0)
+        {
+            _net_printf(g_ctx.net.peers[i].fd, "DONE\n");
+            _net_close(&g_ctx.net.peers[i]);
+        }
+    }
+    close(listener);
+    if (strncmp(g_ctx.net.coordinator, "unix:", 5) == 0)
+    {
+        unlink(g_ctx.net.coordinator + 5);
+    }
+
+    for (i = 0; i < g_ctx.net.batch_sz; i++)
+    {
+        free(g_ctx.net.batches[i].cases);
+    }
+    free(g_ctx.net.batches);
+    free(g_ctx.net.peers);
+    free(g_ctx.order);
+}
+
+static int _worker_connect(void)
+{
+    struct timespec tv_beg;
+    clock_gettime(CLOCK_MONOTONIC, &tv_beg);
+
+    for (;;)
+    {
+        struct sockaddr_storage sa;
+        socklen_t sa_len = 0;
+        int fd = _net_address(g_ctx.net.worker, &sa, &sa_len);
+        if (fd < 0)
+        {
+            fprintf(stderr, "invalid address `%s'.\n", g_ctx.net.worker);
+            exit(EXIT_FAILURE);
+        }
+        if (connect(fd, (struct sockaddr*)&sa, sa_len) == 0)
+        {
+            return fd;
+        }
+        close(fd);
+
+        /* The coordinator may still be listing cases. */
+        if (_elapsed_ms(&tv_beg) > RUNNER_CONNECT_MS)
+        {
+            fprintf(stderr, "cannot connect to %s: %d.\n", g_ctx.net.worker, errno);
+            exit(EXIT_FAILURE);
+        }
+        usleep(RUNNER_RETRY_MS * 1000);
+    }
+}
+
+/**
+ * @brief Find or add binary named by coordinator.
+ * @return Index of binary, or `(size_t)-1` if it must not be run.
+ */
+static size_t _worker_find_binary(const char* path)
+{
+    size_t i;
+    for (i = 0; i < g_ctx.binary_sz; i++)
+    {
+        if (strcmp(g_ctx.binaries[i], path) == 0)
+        {
+            return i;
+        }
+    }
+    if (g_ctx.net.allowed != 0 || !_is_cutest_binary(path))
+    {
+        return (size_t)-1;
+    }
+    g_ctx.binaries = _xrealloc(g_ctx.binaries, sizeof(char*) * (g_ctx.binary_sz + 1));
+    g_ctx.binaries[g_ctx.binary_sz] = _xstrdup(path);
+    return g_ctx.binary_sz++;
+}
+
+/**
+ * @brief Send output and results of finished \p job.
+ */
+static void _worker_finish_job(int fd, runner_job_t* job, int status)
+{
+    char* text = NULL;
+    size_t text_sz = 0;
+    FILE* out = open_memstream(&text, &text_sz);
+    if (out == NULL)
+    {
+        fprintf(stderr, "open_memstream() failed: %d.\n", errno);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t case_sz = job->case_sz;
+    unsigned long batch = job->batch;
+    _finish_job(job, status, out);
+    fclose(out);
+
+    _net_printf(fd, "OUTPUT %lu %zu\n", batch, text_sz);
+    _net_send(fd, text, text_sz);
+    free(text);
+
+    size_t i;
+    for (i = 0; i < case_sz; i++)
+    {
+        runner_case_t* item = &g_ctx.cases[job->cases[i]];
+        if (item->state == RUNNER_STATE_PENDING)
+        {
+            _net_printf(fd, "REQUEUE %lu %s\n", batch, item->name);
+        }
+        else
+        {
+            _net_printf(fd, "RESULT %lu %d %.0f %s\n", batch, (int)item->result, item->elapsed_ms, item->name);
+        }
+    }
+    _net_printf(fd, "END %lu\n", batch);
+}
+
+/**
+ * @brief Answer a batch that is not run, with \p n case names in \p names.
+ * @param[in] binary - The binary refused, or NULL to requeue the cases.
+ */
+static void _worker_reject_batch(int fd, unsigned long batch, const char* binary, const char* names, size_t n)
+{
+    if (binary != NULL)
+    {
+        char text[PATH_MAX + 64];
+        int len = snprintf(text, sizeof(text), "[ RUNNER   ] worker refuses to run `%s'.\n", binary);
+        _net_printf(fd, "OUTPUT %lu %d\n", batch, len);
+        _net_send(fd, text, (size_t)len);
+    }
+
+    size_t i;
+    for (i = 0; i < n; i++)
+    {
+        if (binary != NULL)
+        {
+            _net_printf(fd, "RESULT %lu %d 0 %s\n", batch, (int)RUNNER_RESULT_FAILED, names);
+        }
+        else
+        {
+            _net_printf(fd, "REQUEUE %lu %s\n", batch, names);
+        }
+        names += strlen(names) + 1;
+    }
+    _net_printf(fd, "END %lu\n", batch);
+}
+
+/**
+ * @brief Run batches from coordinator until it says done.
+ */
+static void _worker_run(void)
+{
+    unsigned j;
+    runner_peer_t peer;
+    memset(&peer, 0, sizeof(peer));
+    peer.fd = _worker_connect();
+    _wakeup_setup();
+
+    g_ctx.slots = _xrealloc(NULL, sizeof(runner_job_t) * g_ctx.jobs);
+    memset(g_ctx.slots, 0, sizeof(runner_job_t) * g_ctx.jobs);
+    for (j = 0; j < g_ctx.jobs; j++)
+    {
+        g_ctx.slots[j].token = -1;
+    }
+
+    _net_printf(peer.fd, "HELLO %u\n", g_ctx.jobs);
+
+    unsigned pulling = 0;           /* PULL without reply. */
+    int done = 0;
+    struct timespec tv_wait = { 0, 0 };
+    double wait_ms = 0;
+    while (!done || g_ctx.running != 0)
+    {
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            runner_job_t* job = _find_job(pid);
+            if (job != NULL)
+            {
+                _worker_finish_job(peer.fd, job, status);
+            }
+        }
+
+        while (!done && g_ctx.running + pulling < g_ctx.jobs && _elapsed_ms(&tv_wait) >= wait_ms)
+        {
+            _net_printf(peer.fd, "PULL\n");
+            pulling++;
+        }
+
+        struct pollfd fds[2];
+        fds[0].fd = g_ctx.wakeup[0];
+        fds[0].events = POLLIN;
+        fds[1].fd = peer.fd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        if (poll(fds, done ? 1 : 2, RUNNER_RETRY_MS) <= 0)
+        {
+            continue;
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            _wakeup_drain();
+        }
+        if (done || fds[1].revents == 0)
+        {
+            continue;
+        }
+        if (_net_receive(&peer) != 0)
+        {
+            done = 1;
+            continue;
+        }
+
+        char* line;
+        size_t size;
+        while (!done && (size = _net_line(&peer, &line, 0)) != 0)
+        {
+            unsigned long id;
+            size_t case_sz;
+            if (strcmp(line, "DONE") == 0)
+            {
+                done = 1;
+            }
+            else if (strcmp(line, "WAIT") == 0)
+            {
+                if (pulling > 0)
+                {
+                    pulling--;
+                }
+                clock_gettime(CLOCK_MONOTONIC, &tv_wait);
+                wait_ms = RUNNER_RETRY_MS;
+            }
+            else if (sscanf(line, "BATCH %lu %zu", &id, &case_sz) == 2)
+            {
+                if (case_sz == 0 || case_sz > RUNNER_MAX_BATCH)
+                {
+                    fprintf(stderr, "invalid batch of %zu cases from coordinator.\n", case_sz);
+                    done = 1;
+                    break;
+                }
+
+                /* Binary and case names follow, wait for all of them. */
+                size_t total = size, i;
+                char* item;
+                for (i = 0; i <= case_sz; i++)
+                {
+                    runner_peer_t rest = peer;
+                    rest.buf += total;
+                    rest.buf_sz -= total;
+                    size_t item_sz = _net_line(&rest, &item, 0);
+                    if (item_sz == 0)
+                    {
+                        break;
+                    }
+                    total += item_sz;
+                }
+                if (i <= case_sz)
+                {
+                    /* Restore line breaks consumed so far, and read more. */
+                    size_t k;
+                    for (k = 0; k < total; k++)
+                    {
+                        if (peer.buf[k] == '\0')
+                        {
+                            peer.buf[k] = '\n';
+                        }
+                    }
+                    break;
+                }
+
+                const char* path = peer.buf + size;
+                const char* pos = path + strlen(path) + 1;
+                if (pulling > 0)
+                {
+                    pulling--;
+                }
+
+                /* More batches than asked for are given back. */
+                runner_job_t* job = _find_job(0);
+                size_t binary = job != NULL ? _worker_find_binary(path) : (size_t)-1;
+                if (binary == (size_t)-1)
+                {
+                    _worker_reject_batch(peer.fd, id, job != NULL ? path : NULL, pos, case_sz);
+                    size = total;
+                    _net_consume(&peer, size);
+                    continue;
+                }
+
+                job->batch = id;
+                job->cases = _xrealloc(job->cases, sizeof(size_t) * (case_sz + 1));
+                job->case_sz = 0;
+                for (i = 0; i < case_sz; i++)
+                {
+                    job->cases[job->case_sz++] = g_ctx.case_sz;
+                    _add_case(binary, "", pos, strlen(pos));
+                    pos += strlen(pos) + 1;
+                }
+
+                _start_job(job);
+                size = total;
+            }
+            _net_consume(&peer, size);
+        }
+    }
+
+    _net_close(&peer);
+    for (j = 0; j < g_ctx.jobs; j++)
+    {
+        free(g_ctx.slots[j].cases);
+    }
+    free(g_ctx.slots);
+    g_ctx.slots = NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Compare
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Pin the runner, and so every test process it starts, to one CPU.
+ * @return The CPU.
+ */
+static int _compare_pin(void)
+{
+    cpu_set_t cpuset;
+    if (sched_getaffinity(0, sizeof(cpuset), &cpuset) != 0)
+    {
+        fprintf(stderr, "sched_getaffinity() failed: %d.\n", errno);
+        exit(EXIT_FAILURE);
+    }
+
+    int cpu = g_ctx.compare.cpu;
+    if (cpu < 0)
+    {
+        /* The last allowed CPU, as CPU 0 usually takes most interrupts. */
+        for (cpu = CPU_SETSIZE - 1; cpu > 0 && !CPU_ISSET(cpu, &cpuset); cpu--)
+        {
+        }
+    }
+    else if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &cpuset))
+    {
+        fprintf(stderr, "CPU %d is not allowed.\n", cpu);
+        exit(EXIT_FAILURE);
+    }
+
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    if (sched_setaffinity(0, sizeof(cpuset), &cpuset) != 0)
+    {
+        fprintf(stderr, "sched_setaffinity() failed: %d.\n", errno);
+        exit(EXIT_FAILURE);
+    }
+    return cpu;
+}
+
+/**
+ * @brief Pair cases of the same name in both binaries.
+ */
+static void _compare_match(void)
+{
+    size_t i, j;
+    for (i = 0; i < g_ctx.case_sz; i++)
+    {
+        if (g_ctx.cases[i].binary != 0)
+        {
+            continue;
+        }
+        for (j = 0; j < g_ctx.case_sz; j++)
+        {
+            if (g_ctx.cases[j].binary == 1 && strcmp(g_ctx.cases[i].name, g_ctx.cases[j].name) == 0)
+            {
+                break;
+            }
+        }
+        if (j == g_ctx.case_sz)
+        {
+            continue;
+        }
+
+        g_ctx.compare.benchmarks = _xrealloc(g_ctx.compare.benchmarks,
+            sizeof(runner_compare_t) * (g_ctx.compare.benchmark_sz + 1));
+        runner_compare_t* item = &g_ctx.compare.benchmarks[g_ctx.compare.benchmark_sz++];
+        memset(item, 0, sizeof(*item));
+        item->name = g_ctx.cases[i].name;
+        item->samples[0] = _xrealloc(NULL, sizeof(double) * g_ctx.compare.rounds);
+        item->samples[1] = _xrealloc(NULL, sizeof(double) * g_ctx.compare.rounds);
+    }
+}
+
+/**
+ * @brief Run \p item once in binary \p side.
+ * @return ns/op, or negative if it did not report one.
+ */
+static double _compare_once(runner_compare_t* item, size_t side)
+{
+    FILE* output = tmpfile();
+    if (output == NULL)
+    {
+        fprintf(stderr, "tmpfile() failed: %d.\n", errno);
+        exit(EXIT_FAILURE);
+    }
+
+    const char* binary = g_ctx.binaries[side];
+    char* filter = _xrealloc(NULL, strlen("--test_filter=") + strlen(item->name) + 1);
+    strcpy(filter, "--test_filter=");
+    strcat(filter, item->name);
+    int status = _wait(_spawn(binary, filter, fileno(output)));
+    free(filter);
+    rewind(output);
+
+    double ns_per_op = -1;
+    size_t name_len = strlen(item->name);
+    char* buf = NULL;
+    size_t buf_sz = 0;
+    const char* line;
+    while ((line = _read_line(output, &buf, &buf_sz)) != NULL)
+    {
+        const char* tag = "[ BENCH    ] ";
+        if (strncmp(line, tag, strlen(tag)) != 0)
+        {
+            continue;
+        }
+        line += strlen(tag);
+        if (strncmp(line, item->name, name_len) == 0 && line[name_len] == ' ')
+        {
+            sscanf(line + name_len, " %lf ns/op", &ns_per_op);
+        }
+    }
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        /* Show why, it is not a fair comparison any more. */
+        printf("[----------] %s\n", binary);
+        rewind(output);
+        while ((line = _read_line(output, &buf, &buf_sz)) != NULL)
+        {
+            printf("%s\n", line);
+        }
+        printf("[  FAILED  ] %s: %s\n", binary, item->name);
+        item->failed = 1;
+        ns_per_op = -1;
+    }
+
+    free(buf);
+    fclose(output);
+    return ns_per_op;
+}
+
+/**
+ * @brief Delta of candidate to baseline, as a ratio of geometric means.
+ * @param[out] lo   Lower bound of 95% confidence interval, or NAN if unknown.
+ * @param[out] hi   Upper bound of 95% confidence interval, or NAN if unknown.
+ */
+static double _compare_delta(const runner_compare_t* item, double* lo, double* hi)
+{
+    /* Two-sided 97.5% quantile of Student's t distribution, by degrees of freedom. */
+    static const double s_t_table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    };
+
+    /* Rounds are paired, so drift between rounds cancels out in each log ratio. */
+    double mean = 0, m2 = 0;
+    size_t i;
+    for (i = 0; i < item->sample_sz; i++)
+    {
+        double ratio = log(item->samples[1][i] / item->samples[0][i]);
+        double delta = ratio - mean;
+        mean += delta / (i + 1);
+        m2 += delta * (ratio - mean);
+    }
+
+    *lo = NAN;
+    *hi = NAN;
+    if (item->sample_sz >= 2)
+    {
+        size_t df = item->sample_sz - 1;
+        double t = df <= sizeof(s_t_table) / sizeof(s_t_table[0]) ? s_t_table[df - 1] : df <= 30 ? 2.042 : 1.960;
+        double half = t * sqrt(m2 / df / item->sample_sz);
+        *lo = (exp(mean - half) - 1) * 100;
+        *hi = (exp(mean + half) - 1) * 100;
+    }
+    return (exp(mean) - 1) * 100;
+}
+
+static double _compare_median(double* samples, size_t sample_sz)
+{
+    double* sorted = _xrealloc(NULL, sizeof(double) * sample_sz);
+    memcpy(sorted, samples, sizeof(double) * sample_sz);
+
+    /* Insertion sort, rounds are few. */
+    size_t i, j;
+    for (i = 1; i < sample_sz; i++)
+    {
+        double val = sorted[i];
+        for (j = i; j > 0 && sorted[j - 1] > val; j--)
+        {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = val;
+    }
+
+    double ret = sample_sz % 2 ? sorted[sample_sz / 2] : (sorted[sample_sz / 2 - 1] + sorted[sample_sz / 2]) / 2;
+    free(sorted);
+    return ret;
+}
+
+/**
+ * @return The number of failed benchmarks.
+ */
+static size_t _compare_report(int cpu, double wall_ms)
+{
+    size_t cnt[3] = { 0 }; /* faster, slower, failed */
+    size_t compared = 0;
+    size_t i;
+    for (i = 0; i < g_ctx.compare.benchmark_sz; i++)
+    {
+        runner_compare_t* item = &g_ctx.compare.benchmarks[i];
+        if (item->failed)
+        {
+            cnt[2]++;
+            continue;
+        }
+        if (item->sample_sz == 0)
+        {
+            continue;
+        }
+        compared++;
+
+        double lo, hi;
+        double delta = _compare_delta(item, &lo, &hi);
+        const char* verdict = "";
+        if (lo > 0)
+        {
+            verdict = ", slower";
+            cnt[1]++;
+        }
+        else if (hi < 0)
+        {
+            verdict = ", faster";
+            cnt[0]++;
+        }
+
+        printf("[ COMPARE  ] %s: A %.2f ns/op, B %.2f ns/op, %+.1f%%",
+            item->name, _compare_median(item->samples[0], item->sample_sz),
+            _compare_median(item->samples[1], item->sample_sz), delta);
+        if (!isnan(lo))
+        {
+            printf(" [%+.1f%%, %+.1f%%]", lo, hi);
+        }
+        printf("%s\n", verdict);
+    }
+
+    printf("[==========] %zu benchmark%s compared in %u round%s on CPU %d. (%.0f ms total)\n",
+        compared, compared != 1 ? "s" : "", g_ctx.compare.rounds, g_ctx.compare.rounds != 1 ? "s" : "",
+        cpu, wall_ms);
+    if (cnt[0] != 0)
+    {
+        printf("[  FASTER  ] %zu benchmark%s.\n", cnt[0], cnt[0] > 1 ? "s" : "");
+    }
+    if (cnt[1] != 0)
+    {
+        printf("[  SLOWER  ] %zu benchmark%s.\n", cnt[1], cnt[1] > 1 ? "s" : "");
+    }
+    if (cnt[2] != 0)
+    {
+        printf("[  FAILED  ] %zu benchmark%s, listed below:\n", cnt[2], cnt[2] > 1 ? "s" : "");
+        for (i = 0; i < g_ctx.compare.benchmark_sz; i++)
+        {
+            if (g_ctx.compare.benchmarks[i].failed)
+            {
+                printf("[  FAILED  ] %s\n", g_ctx.compare.benchmarks[i].name);
+            }
+        }
+    }
+    return cnt[2];
+}
+
+/**
+ * @brief Run benchmarks of the same name in binary A and B, one after another
+ *   on the same CPU, so drift of the machine hits both alike.
+ *
+ * Every round runs each benchmark once in A and once in B. Which one goes
+ * first alternates between rounds (AB BA AB ...), so neither binary always
+ * inherits the state left by the other.
+ *
+ * @return The number of failed benchmarks.
+ */
+static size_t _compare_run(void)
+{
+    size_t i, j;
+    unsigned round;
+
+    int cpu = _compare_pin();
+    printf("[ COMPARE  ] A: %s\n", g_ctx.binaries[0]);
+    printf("[ COMPARE  ] B: %s\n", g_ctx.binaries[1]);
+    _list_cases(0);
+    _list_cases(1);
+    _compare_match();
+
+    struct timespec tv_beg;
+    clock_gettime(CLOCK_MONOTONIC, &tv_beg);
+
+    for (round = 0; round < g_ctx.compare.rounds; round++)
+    {
+        printf("[----------] round %u/%u\n", round + 1, g_ctx.compare.rounds);
+        fflush(stdout);
+
+        for (i = 0; i < g_ctx.compare.benchmark_sz; i++)
+        {
+            runner_compare_t* item = &g_ctx.compare.benchmarks[i];
+            /* Not a benchmark, known since the first round. */
+            if (item->failed || (round != 0 && item->sample_sz == 0))
+            {
+                continue;
+            }
+
+            double ns_per_op[2];
+            for (j = 0; j < 2; j++)
+            {
+                size_t side = (j + round) % 2;
+                ns_per_op[side] = _compare_once(item, side);
+            }
+            if (item->failed || ns_per_op[0] <= 0 || ns_per_op[1] <= 0)
+            {
+                continue;
+            }
+            item->samples[0][item->sample_sz] = ns_per_op[0];
+            item->samples[1][item->sample_sz] = ns_per_op[1];
+            item->sample_sz++;
+        }
+    }
+
+    size_t failed = _compare_report(cpu, _elapsed_ms(&tv_beg));
+    for (i = 0; i < g_ctx.compare.benchmark_sz; i++)
+    {
+        free(g_ctx.compare.benchmarks[i].samples[0]);
+        free(g_ctx.compare.benchmarks[i].samples[1]);
+    }
+    free(g_ctx.compare.benchmarks);
+    return failed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Report
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @return The number of failed cases.
+ */
+static size_t _show_report(double wall_ms)
+{
+    size_t cnt[RUNNER_RESULT_MISSING + 1] = { 0 };
+    size_t i;
+    for (i = 0; i < g_ctx.case_sz; i++)
+    {
+        cnt[g_ctx.cases[i].result]++;
+    }
+
+    char source[64] = "";
+    if (g_ctx.net.coordinator != NULL)
+    {
+        snprintf(source, sizeof(source), " from %u worker%s", g_ctx.net.workers, g_ctx.net.workers > 1 ? "s" : "");
+    }
+    else if (g_ctx.jobserver.rfd >= 0)
+    {
+        snprintf(source, sizeof(source), " from jobserver");
+    }
+
+    size_t ran = g_ctx.case_sz - cnt[RUNNER_RESULT_MISSING];
+    printf("[==========] %zu/%zu test case%s from %zu binar%s ran with %u job%s%s. (%.0f ms total, %.0f ms busy)\n",
+        ran, g_ctx.case_sz, g_ctx.case_sz > 1 ? "s" : "",
+        g_ctx.binary_sz, g_ctx.binary_sz > 1 ? "ies" : "y",
+        g_ctx.max_running, g_ctx.max_running > 1 ? "s" : "",
+        source, wall_ms, g_ctx.busy_ms);
+
+    if (cnt[RUNNER_RESULT_MISSING] != 0)
+    {
+        printf("[ DISABLED ] %zu test%s.\n", cnt[RUNNER_RESULT_MISSING], cnt[RUNNER_RESULT_MISSING] > 1 ? "s" : "");
+    }
+    if (cnt[RUNNER_RESULT_SKIPPED] != 0)
+    {
+        printf("[ BYPASSED ] %zu test%s.\n", cnt[RUNNER_RESULT_SKIPPED], cnt[RUNNER_RESULT_SKIPPED] > 1 ? "s" : "");
+    }
+    if (cnt[RUNNER_RESULT_OK] != 0)
+    {
+        printf("[  PASSED  ] %zu test%s.\n", cnt[RUNNER_RESULT_OK], cnt[RUNNER_RESULT_OK] > 1 ? "s" : "");
+    }
+
+    if (cnt[RUNNER_RESULT_FAILED] == 0)
+    {
+        return 0;
+    }
+
+    printf("[  FAILED  ] %zu test%s, listed below:\n",
+        cnt[RUNNER_RESULT_FAILED], cnt[RUNNER_RESULT_FAILED] > 1 ? "s" : "");
+    for (i = 0; i < g_ctx.case_sz; i++)
+    {
+        if (g_ctx.cases[i].result == RUNNER_RESULT_FAILED)
+        {
+            printf("[  FAILED  ] %s: %s\n", g_ctx.binaries[g_ctx.cases[i].binary], g_ctx.cases[i].name);
+        }
+    }
+    return cnt[RUNNER_RESULT_FAILED];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Main
+///////////////////////////////////////////////////////////////////////////////
+
+static unsigned long _parse_ulong(const char* str, const char* opt)
+{
+    char* end = NULL;
+    unsigned long val = strtoul(str, &end, 10);
+    if (end == str || *end != '\0')
+    {
+        fprintf(stderr, "invalid argument `%s%s'.\n", opt, str);
+        exit(EXIT_FAILURE);
+    }
+    return val;
+}
+
+static void _setup(int argc, char* argv[])
+{
+    int i;
+    const char* opt;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    g_ctx.jobs = cpus > 0 ? (unsigned)cpus : 1;
+    g_ctx.name_glob = "*";
+    g_ctx.history_path = "cutest_runner.history";
+    g_ctx.batch_ms = 50;
+    g_ctx.wakeup[0] = -1;
+    g_ctx.wakeup[1] = -1;
+    g_ctx.compare.rounds = 10;
+    g_ctx.compare.cpu = -1;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--") == 0)
+        {
+            g_ctx.test_argv = argv + i + 1;
+            g_ctx.test_argc = argc - i - 1;
+            break;
+        }
+
+        opt = "--jobs=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.jobs = (unsigned)_parse_ulong(argv[i] + strlen(opt), opt);
+            continue;
+        }
+
+        opt = "--name=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.name_glob = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--filter=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.filter = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--history=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.history_path = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--batch=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.batch_ms = (double)_parse_ulong(argv[i] + strlen(opt), opt);
+            continue;
+        }
+
+        opt = "--coordinator=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.net.coordinator = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--worker=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.net.worker = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--compare=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.compare.binary = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--rounds=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.compare.rounds = (unsigned)_parse_ulong(argv[i] + strlen(opt), opt);
+            continue;
+        }
+
+        opt = "--cpu=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.compare.cpu = (int)_parse_ulong(argv[i] + strlen(opt), opt);
+            continue;
+        }
+
+        if (strcmp(argv[i], "--no_jobserver") == 0)
+        {
+            g_ctx.jobserver.disabled = 1;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            printf("%s", s_help);
+            exit(0);
+        }
+
+        if (strncmp(argv[i], "--", 2) == 0)
+        {
+            fprintf(stderr, "unknown argument `%s'.\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+
+        struct stat st;
+        if (stat(argv[i], &st) != 0)
+        {
+            fprintf(stderr, "cannot access %s: %d.\n", argv[i], errno);
+            exit(EXIT_FAILURE);
+        }
+        if (S_ISDIR(st.st_mode))
+        {
+            _search_directory(argv[i]);
+        }
+        else
+        {
+            _add_binary(argv[i]);
+        }
+    }
+
+    if (g_ctx.jobs == 0)
+    {
+        g_ctx.jobs = 1;
+    }
+    if (g_ctx.net.worker != NULL)
+    {
+        /* Cases come from the coordinator, PATH only limits what it may run. */
+        if (g_ctx.net.coordinator != NULL || g_ctx.compare.binary != NULL || g_ctx.filter != NULL)
+        {
+            fprintf(stderr, "--worker does not take --coordinator, --compare or --filter.\n");
+            exit(EXIT_FAILURE);
+        }
+        g_ctx.net.allowed = g_ctx.binary_sz;
+        return;
+    }
+    if (g_ctx.binary_sz == 0)
+    {
+        fprintf(stderr, "no test binary found.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (g_ctx.compare.binary != NULL)
+    {
+        if (g_ctx.net.coordinator != NULL || g_ctx.binary_sz != 1)
+        {
+            fprintf(stderr, "--compare takes exactly one binary, and no --coordinator.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (g_ctx.compare.rounds == 0)
+        {
+            g_ctx.compare.rounds = 1;
+        }
+
+        /* Not by _add_binary(), A and B may be the same file to measure noise. */
+        char real[PATH_MAX];
+        if (realpath(g_ctx.compare.binary, real) == NULL)
+        {
+            fprintf(stderr, "cannot resolve %s: %d.\n", g_ctx.compare.binary, errno);
+            exit(EXIT_FAILURE);
+        }
+        g_ctx.binaries = _xrealloc(g_ctx.binaries, sizeof(char*) * 2);
+        g_ctx.binaries[1] = g_ctx.binaries[0];
+        g_ctx.binaries[0] = _xstrdup(real);
+        g_ctx.binary_sz = 2;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    _setup(argc, argv);
+
+    if (g_ctx.net.worker != NULL)
+    {
+        /* Slots are given by --jobs, the jobserver of this host is not ours to share. */
+        g_ctx.jobserver.disabled = 1;
+        _jobserver_setup();
+        _worker_run();
+        return EXIT_SUCCESS;
+    }
+
+    if (g_ctx.compare.binary != NULL)
+    {
+        return _compare_run() != 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    /* Same binaries, same order, so output is comparable between runs. */
+    qsort(g_ctx.binaries, g_ctx.binary_sz, sizeof(char*), _compare_string);
+
+    size_t i;
+    for (i = 0; i < g_ctx.binary_sz; i++)
+    {
+        _list_cases(i);
+    }
+    _load_history();
+    if (g_ctx.net.coordinator != NULL)
+    {
+        g_ctx.jobserver.disabled = 1;
+    }
+    _jobserver_setup();
+
+    struct timespec tv_beg;
+    clock_gettime(CLOCK_MONOTONIC, &tv_beg);
+    if (g_ctx.net.coordinator != NULL)
+    {
+        _coordinator_run();
+    }
+    else
+    {
+        _run_all();
+    }
+    size_t failed = _show_report(_elapsed_ms(&tv_beg));
+
+    _save_history();
+    return failed != 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,395 @@
+/**
+ * @file
+ * Watch a test run started with `--test_monitor=PATH`, or decode the flight
+ * recorder of `--test_flight_recorder=PATH`.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include "cutest.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+static const char* s_help =
+"cutest_top --board=PATH [--interval=MS] [--slow=MS] [--once]\n"
+"\n"
+"cutest_top --flight=PATH\n"
+"\n"
+"--board=PATH\n"
+"    Path to status board, same as `--test_monitor=PATH' of the test.\n"
+"--interval=MS\n"
+"    Refresh interval in milliseconds (default 1000).\n"
+"--slow=MS\n"
+"    Mark cases running longer than MS milliseconds (default 10000).\n"
+"--once\n"
+"    Print current status once and exit.\n"
+"--flight=PATH\n"
+"    Print events kept by `--test_flight_recorder=PATH' of the test and exit,\n"
+"    even if the test died.\n"
+"--help\n"
+"    Show this help and exit.\n";
+
+typedef struct top_ctx
+{
+    const char*                     board_path;
+    const char*                     flight_path;
+    unsigned long                   interval_ms;
+    unsigned long                   slow_ms;
+    int                             once;
+
+    const cutest_monitor_board_t*   board;
+    cutest_monitor_board_t          snapshot;
+} top_ctx_t;
+
+static top_ctx_t g_ctx = { NULL, NULL, 1000, 10000, 0, NULL, { 0 } };
+
+static unsigned long _parse_ulong(const char* str, const char* opt)
+{
+    char* end = NULL;
+    unsigned long val = strtoul(str, &end, 10);
+    if (end == str || *end != '\0')
+    {
+        fprintf(stderr, "invalid argument `%s%s'.\n", opt, str);
+        exit(EXIT_FAILURE);
+    }
+    return val;
+}
+
+static void _setup(int argc, char* argv[])
+{
+    int i;
+    const char* opt;
+
+    for (i = 1; i < argc; i++)
+    {
+        opt = "--board=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.board_path = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--flight=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.flight_path = argv[i] + strlen(opt);
+            continue;
+        }
+
+        opt = "--interval=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.interval_ms = _parse_ulong(argv[i] + strlen(opt), opt);
+            continue;
+        }
+
+        opt = "--slow=";
+        if (strncmp(argv[i], opt, strlen(opt)) == 0)
+        {
+            g_ctx.slow_ms = _parse_ulong(argv[i] + strlen(opt), opt);
+            continue;
+        }
+
+        if (strcmp(argv[i], "--once") == 0)
+        {
+            g_ctx.once = 1;
+            continue;
+        }
+
+        if (strcmp(argv[i], "--help") == 0)
+        {
+            printf("%s", s_help);
+            exit(0);
+        }
+
+        fprintf(stderr, "unknown argument `%s'.\n", argv[i]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (g_ctx.board_path == NULL && g_ctx.flight_path == NULL)
+    {
+        fprintf(stderr, "missing argument `--board='.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void _attach(void)
+{
+    int fd = open(g_ctx.board_path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "cannot open %s: %d.\n", g_ctx.board_path, errno);
+        exit(EXIT_FAILURE);
+    }
+
+    void* addr = mmap(NULL, sizeof(cutest_monitor_board_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "cannot map %s: %d.\n", g_ctx.board_path, errno);
+        exit(EXIT_FAILURE);
+    }
+
+    g_ctx.board = addr;
+    if (g_ctx.board->magic != CUTEST_MONITOR_MAGIC || g_ctx.board->version != CUTEST_MONITOR_VERSION)
+    {
+        fprintf(stderr, "%s is not a status board of this version.\n", g_ctx.board_path);
+        exit(EXIT_FAILURE);
+    }
+}
+
+/**
+ * @brief Copy \p size bytes guarded by seqlock \p seq. The runner never waits
+ *   for us, so retry until we get a consistent copy.
+ */
+static void _read_consistent(void* dst, const volatile void* src, size_t size,
+    const volatile unsigned long* seq)
+{
+    for (;;)
+    {
+        unsigned long beg = *seq;
+        if (beg & 1)
+        {
+            sched_yield();
+            continue;
+        }
+
+        __sync_synchronize();
+        memcpy(dst, (const void*)src, size);
+        __sync_synchronize();
+
+        if (*seq == beg)
+        {
+            return;
+        }
+    }
+}
+
+static void _take_snapshot(void)
+{
+    const cutest_monitor_board_t* board = g_ctx.board;
+    cutest_monitor_board_t* snapshot = &g_ctx.snapshot;
+
+    _read_consistent(snapshot, board, sizeof(*board), &board->seq);
+
+    unsigned i;
+    for (i = 0; i < CUTEST_MONITOR_WORKERS; i++)
+    {
+        _read_consistent(&snapshot->workers[i], &board->workers[i],
+            sizeof(board->workers[i]), &board->workers[i].seq);
+    }
+}
+
+static void _show_snapshot(void)
+{
+    const cutest_monitor_board_t* snapshot = &g_ctx.snapshot;
+
+    struct timespec tv_now;
+    clock_gettime(CLOCK_MONOTONIC, &tv_now);
+
+    if (!g_ctx.once)
+    {
+        /* Clear screen and move cursor to top left. */
+        printf("\033[H\033[2J");
+    }
+
+    const char* state = snapshot->finished ? "finished" : "running";
+    if (!snapshot->finished && kill((pid_t)snapshot->pid, 0) != 0 && errno == ESRCH)
+    {
+        state = "exited abnormally";
+    }
+
+    /* The counter goes past the last loop when finished. */
+    unsigned long loop = snapshot->repeated < snapshot->repeat ? snapshot->repeated + 1 : snapshot->repeat;
+    printf("cutest_top - %s, pid %lu, %s, loop %lu/%lu\n", g_ctx.board_path,
+        snapshot->pid, state, loop, snapshot->repeat);
+    printf("total %lu, success %lu, failed %lu, skipped %lu, disabled %lu\n\n",
+        snapshot->total, snapshot->success, snapshot->failed, snapshot->skipped,
+        snapshot->disabled);
+
+    printf("%-6s  %-8s  %10s  %s\n", "WORKER", "PID", "ELAPSED", "CASE");
+    unsigned i;
+    for (i = 0; i < CUTEST_MONITOR_WORKERS; i++)
+    {
+        const cutest_monitor_worker_t* worker = &snapshot->workers[i];
+        if (worker->pid == 0)
+        {
+            continue;
+        }
+        if (worker->name[0] == '\0')
+        {
+            printf("%-6u  %-8lu  %10s  (idle)\n", i, worker->pid, "-");
+            continue;
+        }
+
+        double elapsed_ms = (tv_now.tv_sec - (double)worker->tv_sec) * 1000.0
+            + (tv_now.tv_nsec - (double)worker->tv_nsec) / 1000000.0;
+        printf("%-6u  %-8lu  %8.1fs%c  %s\n", i, worker->pid, elapsed_ms / 1000.0,
+            elapsed_ms > g_ctx.slow_ms ? '*' : ' ', worker->name);
+    }
+
+    if (snapshot->failure_cnt != 0)
+    {
+        printf("\nLatest failures:\n");
+        unsigned long cnt = snapshot->failure_cnt < CUTEST_MONITOR_RECORDS ? snapshot->failure_cnt : CUTEST_MONITOR_RECORDS;
+        unsigned long n;
+        for (n = 0; n < cnt; n++)
+        {
+            const cutest_monitor_record_t* record =
+                &snapshot->failures[(snapshot->failure_cnt - 1 - n) % CUTEST_MONITOR_RECORDS];
+            printf("  %s (%lu ms)\n", record->name, record->elapsed_ms);
+        }
+    }
+
+    if (snapshot->slowest[0].name[0] != '\0')
+    {
+        printf("\nSlowest:\n");
+        for (i = 0; i < CUTEST_MONITOR_RECORDS && snapshot->slowest[i].name[0] != '\0'; i++)
+        {
+            printf("  %s (%lu ms)\n", snapshot->slowest[i].name, snapshot->slowest[i].elapsed_ms);
+        }
+    }
+
+    fflush(stdout);
+}
+
+/**
+ * @brief Print events of flight recorder, oldest first. Events being written
+ *   when the runner died are skipped.
+ */
+static void _show_flight(void)
+{
+    static const char* s_type_names[] = {
+        "?", "run begin", "run end", "case begin", "case end",
+        "setup", "body", "teardown", "failure",
+    };
+    static const char* s_results[] = { "success", "failed", "skipped" };
+
+    int fd = open(g_ctx.flight_path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "cannot open %s: %d.\n", g_ctx.flight_path, errno);
+        exit(EXIT_FAILURE);
+    }
+    void* addr = mmap(NULL, sizeof(cutest_flight_recorder_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "cannot map %s: %d.\n", g_ctx.flight_path, errno);
+        exit(EXIT_FAILURE);
+    }
+
+    const cutest_flight_recorder_t* recorder = addr;
+    if (recorder->magic != CUTEST_FLIGHT_MAGIC || recorder->version != CUTEST_FLIGHT_VERSION)
+    {
+        fprintf(stderr, "%s is not a flight recorder of this version.\n", g_ctx.flight_path);
+        exit(EXIT_FAILURE);
+    }
+
+    __sync_synchronize();
+    unsigned long head = (unsigned long)recorder->head;
+    unsigned long beg = head > CUTEST_FLIGHT_EVENTS ? head - CUTEST_FLIGHT_EVENTS : 0;
+
+    /* Times are relative to the latest event. */
+    const cutest_flight_event_t* last = head != 0 ? &recorder->events[(head - 1) % CUTEST_FLIGHT_EVENTS] : NULL;
+    const char* state = kill((pid_t)recorder->pid, 0) == 0 ? "running" : "exited";
+    if (last != NULL && last->seq == head && last->type == CUTEST_FLIGHT_RUN_END)
+    {
+        state = "finished";
+    }
+    printf("cutest_top - %s, pid %lu, %s, %lu events\n\n", g_ctx.flight_path, recorder->pid, state, head);
+
+    printf("%12s  %-10s  %s\n", "TIME", "EVENT", "DETAIL");
+    for (; beg < head; beg++)
+    {
+        const cutest_flight_event_t* event = &recorder->events[beg % CUTEST_FLIGHT_EVENTS];
+        if (event->seq != beg + 1)
+        {
+            continue;
+        }
+
+        double ms = 0;
+        if (last != NULL && last->seq == head)
+        {
+            ms = ((double)event->tv_sec - (double)last->tv_sec) * 1000.0
+                + ((double)event->tv_nsec - (double)last->tv_nsec) / 1000000.0;
+        }
+        const char* type = event->type < sizeof(s_type_names) / sizeof(s_type_names[0]) ?
+            s_type_names[event->type] : s_type_names[0];
+        printf("%10.3fms  %-10s  %s", ms, type, event->name);
+        if (event->type == CUTEST_FLIGHT_FAILURE)
+        {
+            printf(":%lu", event->data);
+        }
+        else if (event->type == CUTEST_FLIGHT_CASE_END && event->data < 3)
+        {
+            printf(" (%s)", s_results[event->data]);
+        }
+        else if (event->type == CUTEST_FLIGHT_RUN_END)
+        {
+            printf(" (%lu failed)", event->data);
+        }
+        else if (event->type == CUTEST_FLIGHT_RUN_BEGIN)
+        {
+            printf(" (pid %lu)", event->data);
+        }
+        printf("\n");
+    }
+
+    /* The test may have died while writing it, so do not wait forever. */
+    cutest_flight_assert_t last_assert;
+    int retry;
+    for (retry = 0; retry < 100; retry++)
+    {
+        long seq = recorder->last_assert.seq;
+        __sync_synchronize();
+        memcpy(&last_assert, (const void*)&recorder->last_assert, sizeof(last_assert));
+        __sync_synchronize();
+        if ((seq & 1) == 0 && seq == recorder->last_assert.seq)
+        {
+            break;
+        }
+        sched_yield();
+    }
+    if (retry < 100 && last_assert.file[0] != '\0')
+    {
+        printf("\nLast assertion: %s:%lu\n", last_assert.file, last_assert.line);
+    }
+    munmap(addr, sizeof(cutest_flight_recorder_t));
+}
+
+int main(int argc, char* argv[])
+{
+    _setup(argc, argv);
+    if (g_ctx.flight_path != NULL)
+    {
+        _show_flight();
+        return 0;
+    }
+    _attach();
+
+    for (;;)
+    {
+        _take_snapshot();
+        _show_snapshot();
+
+        if (g_ctx.once || g_ctx.snapshot.finished)
+        {
+            break;
+        }
+
+        struct timespec tv_sleep;
+        tv_sleep.tv_sec = (time_t)(g_ctx.interval_ms / 1000);
+        tv_sleep.tv_nsec = (long)(g_ctx.interval_ms % 1000) * 1000000;
+        nanosleep(&tv_sleep, NULL);
+    }
+
+    munmap((void*)g_ctx.board, sizeof(cutest_monitor_board_t));
+    return 0;
+}